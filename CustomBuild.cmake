@@ -2,8 +2,10 @@ if(MSVC OR MSVC_IDE)
 	set_target_properties(unionclientlibrary PROPERTIES COMPILE_FLAGS /EHsc)
 endif()
 if(TARGET_OS STREQUAL windows)
-    target_link_libraries(${PROJECT_NAME} PRIVATE ws2_32 iphlpapi psapi)
+    target_link_libraries(${PROJECT_NAME} PRIVATE ws2_32 iphlpapi psapi zlib libssl libcrypto crypt32)
 elseif(TARGET_OS STREQUAL linux)
-    target_link_libraries(${PROJECT_NAME} PRIVATE rt)
+    target_link_libraries(${PROJECT_NAME} PRIVATE rt z ssl crypto)
+else()
+    target_link_libraries(${PROJECT_NAME} PRIVATE z ssl crypto)
 endif()
 
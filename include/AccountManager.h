@@ -12,6 +12,7 @@
 
 class AccountManager: public Manager<UserAccount, UserID>, public NXStatus, public NXAcctInfo {
 friend class UnionBridge;
+friend class SessionRestorer;
 public:
 	AccountManager(RoomManager& roomManager, ClientManager& clientManager, UnionBridge& unionBridge, ILogger& log);
 	virtual ~AccountManager();
@@ -12,6 +12,7 @@
 
 class ClientManager: public Manager<Client, ClientID>, public NotifyClientInfo, public NotifyAddressInfo, public NotifyStatus {
 	friend class UnionBridge;
+	friend class SessionRestorer;
 public:
 	ClientManager(
 			RoomManager& roomManager, AccountManager& accountManager,
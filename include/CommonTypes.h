@@ -26,6 +26,7 @@
 #include <stdint.h>
 //#include <thread>
 #include <mutex>
+#include <chrono>
 
 class RoomManifest;
 class ClientCache;
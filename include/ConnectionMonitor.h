@@ -9,6 +9,7 @@
 #define CONNECTIONMONITOR_H_
 
 #include "UVForwards.h"
+#include "Histogram.h"
 
 class ConnectionMonitor {
 public:
@@ -24,6 +25,19 @@ public:
 	bool IsPingShared() const;
 	void SharePing(bool share) const;
 
+	bool IsTransportPingEnabled() const;
+	void SetTransportPingEnabled(bool enable) const;
+	const RTTStats* GetRTTStats() const;
+	uint64_t GetMinRTT() const;
+	double GetMeanRTT() const;
+	uint64_t GetP99RTT() const;
+	double GetSmoothedRTT() const;
+	double GetRTTVariation() const;
+
+	int GetPingPublishDelta() const;
+	int GetPingPublishInterval() const;
+	void SetPingPublishThreshold(const int deltaMS, const int intervalMS) const;
+
 	int GetAutoReconnectAttemptLimit() const;
 	int GetAutoReconnectFrequency() const;
 	int GetConnectionTimeout() const;
@@ -31,8 +45,30 @@ public:
 	void SetAutoReconnectFrequency(int minMS, int maxMS = -1, bool delayFirstAttempt = false);
 	void SetConnectionTimeout(const int milliseconds);
 
+	std::shared_ptr<ReconnectPolicy> GetReconnectPolicy() const;
+	void SetReconnectPolicy(std::shared_ptr<ReconnectPolicy> policy);
+	int GetStableConnectionPeriod() const;
+	void SetStableConnectionPeriod(const int ms);
+	void SetReconnectHint(const int ms) const;
+
+	/** counts for automatic reconnection. times are in ms */
+	struct ReconnectStats {
+		uint64_t attempts = 0;
+		uint64_t reconnects = 0;
+		Histogram delay;
+		Histogram timeToReconnect;
+	};
+	const ReconnectStats& GetReconnectStats() const;
+	void ResetReconnectStats() const;
+
 	int GetHeartbeatFrequency() const;
 	void SetHeartbeatFrequency(const int ms);
+	bool IsAdaptiveHeartbeat() const;
+	void SetAdaptiveHeartbeat(const bool enable, const int minMS=-1, const int maxMS=-1) const;
+	int GetHeartbeatInterval() const;
+
+	typedef std::function<uint64_t()> Clock;
+	void SetClock(Clock c) const;
 
 	int GetReadyTimeout() const;
 	void SetReadyTimeout(const int ms) const;
@@ -58,6 +94,14 @@ public:
 	static const int kDfltConnectionTimeout = 60000;
 	static const int kDefltARMinMS = 1500;
 	static const int kDefltARMaxMS = 1600;
+	static const int kDfltPingPublishDelta = 20;
+	static const int kDfltPingPublishInterval = 60000;
+	static const int kHeartbeatRing = 64;
+	static const int kDfltAdaptiveStretch = 3;
+	/** how long a connection has to stay up before a drop starts the reconnect backoff from scratch */
+	static const int kDfltStableConnectionPeriod = 30000;
+	/** round trip deviation, in microseconds, too small to count as jitter whatever the round trip */
+	static const int kSteadyRTTVariation = 1000;
 
 	void AddSelfListeners();
 protected:
@@ -69,19 +113,50 @@ protected:
 	void StopReconnect() const;
 	void ScheduleReconnect(const int milliseconds) const;
 	bool DoReconnect() const;
+	void CheckTransportPongs(const RTTStats& rtt) const;
+	void CheckHeartbeatTimeout(const uint64_t now) const;
+	void ClearHeartbeats() const;
+	void ScheduleAdaptiveHeartbeat(const int ms) const;
+	void AdaptiveHeartbeat() const;
+	void AdaptInterval() const;
+	int AdaptiveMaxMS() const;
+	uint64_t Now() const;
+	void PublishPing(const RTTStats& rtt) const;
+
+	/** send time, from uv_hrtime(), of a upc heartbeat */
+	struct HeartbeatStamp {
+		int id;
+		uint64_t sent;
+	};
 
 	bool mutable heartbeatEnabled = false;
 	int mutable heartbeatCounter = 0;
 	bool mutable sharedPing = false;
 	bool mutable disposed = false;
-	time_t mutable oldestHeartbeat = 0;
+	int mutable heartbeatTail = 0;
+	uint64_t mutable oldestHeartbeat = 0;
+	HeartbeatStamp mutable heartbeats[kHeartbeatRing];
+	RTTStats mutable heartbeatRTT;
+	int mutable pingPublishDelta = kDfltPingPublishDelta;
+	int mutable pingPublishInterval = kDfltPingPublishInterval;
+	int mutable publishedPing = 0;
+	uint64_t mutable publishedPingTime = 0;
+
+	bool mutable adaptiveHeartbeat = false;
+	int mutable adaptiveMinMS = kDfltHeartbeatFrequency;
+	int mutable adaptiveMaxMS = kDfltAdaptiveStretch*kDfltHeartbeatFrequency;
+	int mutable heartbeatInterval = kDfltHeartbeatFrequency;
+	uint64_t mutable adaptedRTTCount = 0;
+	uint64_t mutable lastRxBytes = 0;
+	uint64_t mutable lastInbound = 0;
+	bool mutable transportPing = true;
+	uint64_t mutable lastRTTCount = 0;
+	uint64_t mutable oldestTransportPing = 0;
 
 	TimerRef mutable autoReconnectTimeoutRef = nullptr;
 	TimerRef mutable heartbeatTimerRef = nullptr;
 	TimerRef mutable readyTimerRef = nullptr;
 
-	std::unordered_map<int,time_t> mutable heartbeats;
-
 	int mutable heartBeatFrequency = kDfltHeartbeatFrequency;
 	int mutable autoReconnectFrequency = kDfltAutoreconnectFrequency;
 	int mutable autoReconnectAttemptLimit = kDfltAutoreconnectAttemptLimit;
@@ -89,6 +164,13 @@ protected:
 	int mutable autoReconnectMinMS = kDefltARMinMS;
 	int mutable autoReconnectMaxMS = kDefltARMaxMS;
 	bool mutable autoReconnectDelayFirstAttempt = false;
+	std::shared_ptr<ReconnectPolicy> reconnectPolicy;
+	int mutable reconnectAttempt = 0;
+	int mutable reconnectHint = 0;
+	int stableConnectionPeriod = kDfltStableConnectionPeriod;
+	uint64_t mutable readyAt = 0;
+	uint64_t mutable droppedAt = 0;
+	ReconnectStats mutable reconnectStats;
 
 	CBUPCRef readyListener;
 	CBUPCRef closedListener;
@@ -101,6 +183,7 @@ protected:
 	ILogger& log;
 
 	int mutable readyTimeout;
+	Clock mutable clock;
 };
 
 #endif /* CONNECTIONMONITOR_H_ */
@@ -0,0 +1,61 @@
+/*
+ * DNSCache.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#ifndef DNSCACHE_H_
+#define DNSCACHE_H_
+
+#include "UVForwards.h"
+
+typedef std::vector<UVAddress> UVAddresses;
+typedef std::function<void(const UVAddresses& res, int status)> ResolverCB;
+
+class DNSCache {
+public:
+	typedef std::function<void(const std::string host, const std::string service, ResolverCB cb)> Lookup;
+	typedef std::function<uint64_t()> Clock;
+	typedef std::function<void(std::function<void()> f)> Deliver;
+	struct Stats {
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t joined = 0;
+		uint64_t failures = 0;
+	};
+
+	DNSCache(Lookup l=nullptr);
+	virtual ~DNSCache();
+
+	void Resolve(const std::string host, const std::string service, ResolverCB cb);
+	void Forget(const std::string host, const std::string service);
+	void Flush();
+
+	void SetTTL(const int ms) { ttlMS = ms; }
+	int GetTTL() const { return ttlMS; }
+	void SetLookup(Lookup l);
+	void SetClock(Clock c);
+	void SetDeliver(Deliver d);
+	const Stats& GetStats() const { return stats; }
+
+	static const int kDfltTTLMS = 60000;
+protected:
+	struct Entry {
+		UVAddresses addresses;
+		uint64_t expires = 0;
+		bool pending = false;
+		std::vector<ResolverCB> waiters;
+	};
+	void Resolved(const std::string key, const UVAddresses& res, int status);
+
+	Lookup lookup;
+	Clock clock;
+	Deliver deliver;
+	int ttlMS;
+	Stats stats;
+	std::unordered_map<std::string, Entry> entries;
+	std::mutex lock;
+};
+
+#endif /* DNSCACHE_H_ */
@@ -8,22 +8,56 @@
 #ifndef EVENTLOOP_H_
 #define EVENTLOOP_H_
 
-typedef std::function<void()> TimerCB;
-typedef std::function<void()> WorkerCB;
+#include <cstddef>
+#include <stdint.h>
 
+#include "InlineFunction.h"
+
+/**
+ * timer and worker callbacks are held inline in their Timer/Worker records, so scheduling one doesn't need the heap ... a capture that
+ * doesn't fit won't compile
+ */
+typedef InlineFunction<void()> TimerCB;
+typedef InlineFunction<void()> WorkerCB;
+
+/**
+ * timer records may be reused by a later Schedule() once they've fired or been cancelled. the generation moves on each time, so a TimerRef
+ * to an earlier use no longer matches
+ */
 struct Timer {
-	TimerCB* tikCB;
+	TimerCB tikCB;
 	uint64_t delayMS;
 	uint64_t repeatMs;
+	uint64_t generation = 0;
 };
 
 struct Worker {
-	WorkerCB* queuedCB;
-	WorkerCB* apresCB;
+	WorkerCB queuedCB;
+	WorkerCB apresCB;
 };
 
 
-typedef Timer* TimerRef;
+/**
+ * a handle on one use of a timer record. CancelTimer() on a ref that is out of date, eg kept after a one shot has fired, does nothing,
+ * whatever the record is doing now
+ */
+struct TimerRef {
+	TimerRef(std::nullptr_t=nullptr)
+		: timer(nullptr)
+		, generation(0) { }
+	TimerRef(Timer* t)
+		: timer(t)
+		, generation(t? t->generation : 0) { }
+
+	/** true if t is the record, and still on the use this ref was made for */
+	bool Is(const Timer* t) const { return t != nullptr && t == timer && t->generation == generation; }
+	explicit operator bool() const { return timer != nullptr; }
+	bool operator==(std::nullptr_t) const { return timer == nullptr; }
+	bool operator!=(std::nullptr_t) const { return timer != nullptr; }
+
+	Timer* timer;
+	uint64_t generation;
+};
 typedef Worker* WorkerRef;
 
 class Lockable {
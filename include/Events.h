@@ -41,6 +41,10 @@ public:
 	static const int CONNECTION_STATE_CHANGE = CONNECTION_EVENT_ID_BASE+9;
 /** @constant */
 	static const int IO_ERROR = CONNECTION_EVENT_ID_BASE+10;
+/** @constant a connection's send queue has gone over its high watermark */
+	static const int SEND_QUEUE_HIGH = CONNECTION_EVENT_ID_BASE+11;
+/** @constant ... and is back down to its low one */
+	static const int SEND_QUEUE_DRAINED = CONNECTION_EVENT_ID_BASE+12;
 
 //------common upc events---------------------
 	static const int COMMON_EVENT_ID_BASE = 230;
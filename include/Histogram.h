@@ -0,0 +1,77 @@
+/*
+ * Histogram.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+#include <stdint.h>
+
+/**
+ * @class Histogram Histogram.h
+ * cheap fixed size histogram with power of two buckets, for queue depths and latencies. bucket 0 holds zeros, bucket i holds values in
+ * [2^(i-1), 2^i), and the last bucket takes everything bigger. no allocation, so it's fine to feed from the loop thread on every message
+ */
+class Histogram {
+public:
+	static const int kBuckets = 32;
+
+	Histogram() {
+		Reset();
+	}
+
+	void Add(uint64_t v) {
+		int b = 0;
+		while (v >> b && b < kBuckets-1) {
+			b++;
+		}
+		buckets[b]++;
+		count++;
+		sum += v;
+		if (v > max) max = v;
+	}
+
+	void Reset() {
+		for (int i=0; i<kBuckets; i++) buckets[i] = 0;
+		count = 0;
+		sum = 0;
+		max = 0;
+	}
+
+	/** @return the number of values that fell in bucket i */
+	uint64_t GetBucket(int i) const { return i >= 0 && i < kBuckets? buckets[i] : 0; }
+	/** @return the smallest value that lands in bucket i */
+	static uint64_t BucketFloor(int i) { return i <= 0? 0 : ((uint64_t)1) << (i-1); }
+	uint64_t GetCount() const { return count; }
+	uint64_t GetMax() const { return max; }
+	double GetMean() const { return count > 0? (double)sum/count : 0; }
+
+	/**
+	 * @return an upper bound on the p'th percentile (0 < p <= 100), to within the resolution of the buckets
+	 */
+	uint64_t GetPercentile(double p) const {
+		if (count == 0) return 0;
+		uint64_t want = (uint64_t)(count*p/100.0 + 0.5);
+		if (want < 1) want = 1;
+		uint64_t seen = 0;
+		for (int i=0; i<kBuckets; i++) {
+			seen += buckets[i];
+			if (seen >= want) {
+				uint64_t top = i == 0? 0 : (((uint64_t)1) << i) - 1;
+				return top < max? top : max;
+			}
+		}
+		return max;
+	}
+
+protected:
+	uint64_t buckets[kBuckets];
+	uint64_t count;
+	uint64_t sum;
+	uint64_t max;
+};
+
+#endif /* HISTOGRAM_H_ */
@@ -0,0 +1,157 @@
+/*
+ * InlineFunction.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#ifndef INLINEFUNCTION_H_
+#define INLINEFUNCTION_H_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <functional>
+
+/** default inline capacity ... enough for a lambda holding 'this' and a handful of pointers, or a std::bind of a member function */
+static const size_t kInlineFunctionCapacity = 6*sizeof(void*);
+
+template <typename Sig, size_t Capacity=kInlineFunctionCapacity> class InlineFunction;
+
+/**
+ * @class InlineFunction<R(A...), Capacity> InlineFunction.h
+ * a move only replacement for std::function<R(A...)> that keeps the callable in a fixed size buffer inside the object, so constructing, moving
+ * and calling never touch the heap. a callable that won't fit is a compile time error, not a silent allocation ... capture less, capture a
+ * pointer to the state, or bump the Capacity for that particular type
+ *
+ * empty std::function and null function pointers convert to an empty InlineFunction, so 'if (cb)' means the same as it did with std::function
+ */
+template <typename R, typename ... A, size_t Capacity>
+class InlineFunction<R(A...), Capacity> {
+	template <typename F> struct IsCallable {
+		template <typename G> static auto Test(int) ->
+			decltype(static_cast<R>(std::declval<G&>()(std::declval<A>()...)), std::true_type());
+		template <typename G> static std::false_type Test(...);
+		static const bool value = decltype(Test<F>(0))::value;
+	};
+	template <typename F> using EnableIfCallable = typename std::enable_if<
+			!std::is_same<typename std::decay<F>::type, InlineFunction>::value && IsCallable<typename std::decay<F>::type>::value>::type;
+
+public:
+	InlineFunction() noexcept
+		: ops(nullptr) { }
+
+	InlineFunction(std::nullptr_t) noexcept
+		: ops(nullptr) { }
+
+	template <typename F, typename = EnableIfCallable<F>>
+	InlineFunction(F&& f)
+		: ops(nullptr) {
+		Store(std::forward<F>(f));
+	}
+
+	InlineFunction(InlineFunction&& o) noexcept
+		: ops(nullptr) {
+		Take(o);
+	}
+
+	InlineFunction& operator=(InlineFunction&& o) noexcept {
+		if (this != &o) {
+			Reset();
+			Take(o);
+		}
+		return *this;
+	}
+
+	InlineFunction& operator=(std::nullptr_t) noexcept {
+		Reset();
+		return *this;
+	}
+
+	template <typename F, typename = EnableIfCallable<F>>
+	InlineFunction& operator=(F&& f) {
+		Reset();
+		Store(std::forward<F>(f));
+		return *this;
+	}
+
+	InlineFunction(const InlineFunction&) = delete;
+	InlineFunction& operator=(const InlineFunction&) = delete;
+
+	~InlineFunction() {
+		Reset();
+	}
+
+	explicit operator bool() const noexcept {
+		return ops != nullptr;
+	}
+
+	/**
+	 * like std::function, calling an empty one is a bug ... but we don't throw, as nothing in here expects exceptions
+	 */
+	R operator()(A... args) const {
+		return ops->invoke(Storage(), std::forward<A>(args)...);
+	}
+
+	void Reset() noexcept {
+		if (ops != nullptr) {
+			ops->destroy(Storage());
+			ops = nullptr;
+		}
+	}
+
+private:
+	struct Ops {
+		R (*invoke)(void*, A&&...);
+		void (*move)(void* dst, void* src);
+		void (*destroy)(void*);
+	};
+
+	template <typename F> struct OpsFor {
+		static R Invoke(void* p, A&&... args) {
+			return static_cast<R>((*static_cast<F*>(p))(std::forward<A>(args)...));
+		}
+		static void Move(void* dst, void* src) {
+			::new (dst) F(std::move(*static_cast<F*>(src)));
+			static_cast<F*>(src)->~F();
+		}
+		static void Destroy(void* p) {
+			static_cast<F*>(p)->~F();
+		}
+		static const Ops* Get() {
+			static const Ops ops = { &Invoke, &Move, &Destroy };
+			return &ops;
+		}
+	};
+
+	template <typename F> static bool IsNull(const F&) { return false; }
+	template <typename S> static bool IsNull(const std::function<S>& f) { return !f; }
+	template <typename P> static bool IsNull(P* p) { return p == nullptr; }
+
+	template <typename F> void Store(F&& f) {
+		typedef typename std::decay<F>::type Fn;
+		static_assert(sizeof(Fn) <= Capacity, "callable is too big for this InlineFunction ... capture less, or raise its Capacity");
+		static_assert(alignof(Fn) <= alignof(std::max_align_t), "callable is over aligned for InlineFunction");
+		if (IsNull(f)) return;
+		::new (Storage()) Fn(std::forward<F>(f));
+		ops = OpsFor<Fn>::Get();
+	}
+
+	void Take(InlineFunction& o) noexcept {
+		if (o.ops != nullptr) {
+			o.ops->move(Storage(), o.Storage());
+			ops = o.ops;
+			o.ops = nullptr;
+		}
+	}
+
+	void* Storage() const noexcept {
+		return const_cast<void*>(static_cast<const void*>(&storage));
+	}
+
+	const Ops* ops;
+	typename std::aligned_storage<Capacity, alignof(std::max_align_t)>::type storage;
+};
+
+#endif /* INLINEFUNCTION_H_ */
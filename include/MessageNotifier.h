@@ -18,7 +18,7 @@ public:
 	static const char*TO_CLIENTS;
 };
 
-typedef std::function<void(UserMessageID, StringArgs)> CBModMsg;
+typedef std::function<void(const UserMessageID&, const StringArgs&)> CBModMsg;
 typedef std::shared_ptr<CBModMsg> CBModMsgRef;
 
 struct MsgCBR
@@ -26,6 +26,7 @@ struct MsgCBR
 	MsgCBR(UserMessageID message, std::vector<ClientID> clients, std::vector<RoomID> rooms, CBModMsgRef cb)
 		: message(message)
 		, rooms(rooms)
+		, clients(clients)
 		, cb(cb) {	}
 	UserMessageID message;
 	std::vector<RoomID> rooms;
@@ -33,6 +34,21 @@ struct MsgCBR
 	std::weak_ptr<CBModMsg> cb;
 };
 
+typedef std::vector<std::weak_ptr<CBModMsg>> MsgCBList;
+
+/**
+ * the routing index for one message id. every registration is kept in 'listeners', and is also filed under each room and client it asked for,
+ * or in 'anyRoom' if it asked for neither. 'stale' is set once something in it has expired or been removed, and is cleared by a prune
+ */
+struct MsgRoute
+{
+	std::vector<MsgCBR> listeners;
+	MsgCBList anyRoom;
+	std::unordered_map<RoomID, MsgCBList> byRoom;
+	std::unordered_map<ClientID, MsgCBList> byClient;
+	bool stale = false;
+};
+
 class MessageNotifier {
 public:
 	MessageNotifier();
@@ -44,10 +60,13 @@ public:
 	bool HasMessageListener(const UserMessageID message, const CBModMsgRef listener) const;
 
 protected:
-	void NotifyMessageListeners(const UserMessageID message, const std::vector<ClientID> clients, const std::vector<RoomID> rooms, const StringArgs msg) const;
+	void NotifyMessageListeners(const UserMessageID& message, const std::vector<ClientID>& clients, const std::vector<RoomID>& rooms, const StringArgs& msg) const;
+	bool NotifyBucket(MsgCBList& bucket, const UserMessageID& message, const StringArgs& msg, std::vector<CBModMsg*>* delivered) const;
+	void PruneRoute(MsgRoute& route) const;
 
 	std::mutex mutable lock;
-	std::unordered_map<UserMessageID, std::vector<MsgCBR>> mutable msgListeners;
+	int mutable notifying = 0;
+	std::unordered_map<UserMessageID, MsgRoute> mutable msgListeners;
 };
 
 #endif /* MESSAGENOTIFIER_H_ */
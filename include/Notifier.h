@@ -9,11 +9,12 @@
 #define NOTIFIER_H_
 
 #include "CommonTypes.h"
+#include "InlineFunction.h"
 
 /**
  * @class NXR<CBP...> Notifier.h
- *  simple and lightweight notifier patter, storing weak pointer to std:function callbacks. The function<CBP..> has a type NXR<CBP...>::CB and is passed in
- *  a shared pointer.
+ *  simple and lightweight notifier patter, storing weak pointer to function callbacks. The callback has a type NXR<CBP...>::CB and is passed in
+ *  a shared pointer. CB is an InlineFunction rather than a std::function, so the callable lives inside the one block make_shared gives us
  *
  * about as thread safe as std::vector ... which is not especially, at least on push_back ... reading is ok
  *
@@ -23,8 +24,11 @@
  */
 template <typename ... CBP> class NXR {
 public:
-	/** type for our callback */
-	typedef typename std::function<void(EventType, CBP ...)> CB;
+	/**
+	 * type for our callback. parameters go out by const reference, so however many listeners there are, nothing gets copied unless the
+	 * listener itself asks for a copy by taking a parameter by value
+	 */
+	typedef InlineFunction<void(EventType, const CBP& ...)> CB;
 
 	/** type for a tuple of our params */
 	typedef typename std::tuple<CBP ...> CP;
@@ -93,7 +97,7 @@ protected:
 	 *  In most cases, this default implementation is what's wanted ... but if we have multiple event types etc etc maybe we want to
 	 * adjust the parameters ... basic error checking or .... perhaps a virtual
 	 */
-	void Notify(EventType eventType, CB*listener, CBP...args) {
+	void Notify(EventType eventType, CB*listener, const CBP&...args) {
 		(*listener)(eventType, args...);
 	};
 
@@ -102,7 +106,7 @@ public:
 	 * tell any listeners on a particular event that we've found something interesting
 	 * FIXME ... protecting the notifylisteners causes accessibility issues in multiple inheritors
 	 */
-	void NotifyListeners(EventType eventType, CBP...args) {
+	void NotifyListeners(EventType eventType, const CBP&...args) {
 		size_t i = 0;
 		while (i < listeners.size()) {
 			NR iter = listeners[i]; // xxx critical also ... what happens when the undelying data structure is realloc'd
@@ -137,9 +141,10 @@ public:
 	 * @param a callback function, which could (conveniently) be a bound lambda
 	 * @return a reference to the created call back which can be deleted using RemoveListener in the base class
 	 */
-	std::shared_ptr<std::function<void(EventType, CBP ...)>> AddEventListener(const EventType eventType, std::function<void(EventType, CBP ...)> rawListener) const {
-		std::shared_ptr<std::function<void(EventType, CBP ...)>> x =
-				std::make_shared<std::function<void(EventType, CBP ...)>>(rawListener);
+	template <typename F>
+	std::shared_ptr<typename NXR<CBP...>::CB> AddEventListener(const EventType eventType, F&& rawListener) const {
+		std::shared_ptr<typename NXR<CBP...>::CB> x =
+				std::make_shared<typename NXR<CBP...>::CB>(std::forward<F>(rawListener));
 		this->AddListener(eventType, x);
 		return x;
 	}
@@ -165,74 +170,100 @@ template<int ...S>
  * a variation on Notifier<CBP ...> which separates the activity and the call of the notification, so suited for threading the event notification callbacks
  * atm relying on thread safety on std::vector, which is I don't think sufficient for this purpose .. and c++11 threads and mutexes are inconsistent between
  * platforms a big xxx on this, as we for the moment rely on the event loop to provide locking ...
+ *
+ * each dispatch queues its parameters once, however many listeners there are, along with the listeners it had at the time, so one added later
+ * doesn't get it, and one whose handle has gone since doesn't either. the listeners go in one pool shared by the whole queue, so a steady state
+ * doesn't allocate. calls are made in the order they were dispatched
  */
 template <typename ... CBP> class Dispatcher: public Notifier<CBP...> {
 public:
-	typedef std::function<void(EventType, CBP ...)> ECB;
+	typedef typename NXR<CBP...>::CB ECB;
 	struct ER {
-		ER(EventType eventType, std::weak_ptr<ECB> cb, CBP...params)
+		template <typename ... P>
+		ER(EventType eventType, size_t firstListener, size_t nListeners, P&&...params)
 			: eventType(eventType)
-			, cb(cb)
-			, params(params...) { }
+			, params(std::forward<P>(params)...)
+			, queued(std::chrono::steady_clock::now())
+			, firstListener(firstListener)
+			, nListeners(nListeners) { }
 		EventType eventType;
-		std::weak_ptr<ECB> cb;
 		std::tuple<CBP...> params;
+		std::chrono::steady_clock::time_point queued;
+		/** where its listeners are in the queue's pool */
+		size_t firstListener;
+		size_t nListeners;
 	};
 	/**
 	 * pure genius. this is the guts of the unpacking
 	 */
 	template<int ...S>
-		void CallFunc(seq<S...>, ECB* listener, EventType eventType, std::tuple<CBP...> params) {
+		void CallFunc(seq<S...>, ECB* listener, EventType eventType, const std::tuple<CBP...>& params) {
 			(*listener)(eventType, std::get<S>(params) ...);
 		}
 	/**
 	 * dispatch an event ... ie push a call and its parameters onto a queue for execution in another thread ...
 	 * so ... there should be no way that the calling thread will be held up by dodgy callbacks
+	 * the parameters are sinks: they are moved into the queue, so pass temporaries or std::move() anything big
 	 */
 	void DispatchEvent(const EventType eventType, CBP...params) {
-		int i=0;
+		pendingLock.lock();
+		size_t first = pendingListeners.size();
+		size_t i=0;
 		while(i<this->listeners.size()) { // N.B. caution some notifiers might modify the list
-			auto iter = this->listeners[i];
-			std::weak_ptr<ECB> p= iter.cb;
-			if (p.expired()) {
+			if (this->listeners[i].cb.expired()) {
 				this->listeners.erase(this->listeners.begin()+i);
 			} else {
-				if (iter.eventType == eventType) {
-//					std::weak_ptr<ECB> listener = p.lock(); // create a shared_ptr from the weak_ptr
-//					ECB* listener = s_cb.get();
-					pendingLock.lock();
-					pending.push_back(ER(eventType, iter.cb, params...));
-					pendingLock.unlock();
+				if (this->listeners[i].eventType == eventType) {
+					pendingListeners.push_back(this->listeners[i].cb);
 				}
 				++i;
 			}
 		}
+		size_t n = pendingListeners.size() - first;
+		if (n > 0) {
+			pending.emplace_back(eventType, first, n, std::move(params)...);
+		}
+		pendingLock.unlock();
 	}
 
 	/**
 	 * process the array of pending calls
-	 * pending array should be thread safe in the manner we require
+	 * the pending queue is swapped out under the lock, so dispatches made by the callbacks themselves go to the next round
 	 */
 	void ProcessDispatches()
 	{
-		int i=((int)pending.size())-1;
-		while (i>=0) {
-			ER it = pending[i];
-			std::weak_ptr<ECB> p= it.cb;
-			if (!p.expired()) {
-				std::shared_ptr<ECB> s_cb = p.lock(); // create a shared_ptr from the weak_ptr
-				ECB* listener = s_cb.get();
-				CallFunc(typename gens<sizeof...(CBP)>::type(), listener, it.eventType, it.params);
-//				(*listener)(it.eventType, it.params);
+		pendingLock.lock();
+		processing.swap(pending);
+		processingListeners.swap(pendingListeners);
+		pendingLock.unlock();
+		PrepareDispatches(processing);
+		for (const ER& it: processing) {
+			WillDispatch(it);
+			for (size_t i=it.firstListener; i<it.firstListener+it.nListeners; i++) {
+				std::shared_ptr<ECB> s_cb = processingListeners[i].lock(); // create a shared_ptr from the weak_ptr
+				if (s_cb) {
+					CallFunc(typename gens<sizeof...(CBP)>::type(), s_cb.get(), it.eventType, it.params);
+				}
 			}
-			pendingLock.lock();
-			pending.erase(pending.begin()+i);
-			pendingLock.unlock();
-			--i;
 		}
+		processing.clear();
+		processingListeners.clear();
 	}
+
+	/**
+	 * hook for subclasses to trim or reorder a batch after it is taken off the pending queue and before any of it is called. does nothing by default
+	 */
+	virtual void PrepareDispatches(std::vector<ER>& batch) { }
+	/**
+	 * hook for subclasses, called just before the listeners for each queued event
+	 */
+	virtual void WillDispatch(const ER& event) { }
+
 	std::mutex pendingLock;
 	std::vector<ER> mutable pending;
+	std::vector<ER> processing;
+	std::vector<std::weak_ptr<ECB>> pendingListeners;
+	std::vector<std::weak_ptr<ECB>> processingListeners;
 };
 
 #endif /* NOTIFIER_H_ */
@@ -0,0 +1,41 @@
+/*
+ * RTTStats.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#ifndef RTTSTATS_H_
+#define RTTSTATS_H_
+
+#include <stdint.h>
+
+class RTTStats {
+public:
+	static const int kWindow = 256;
+
+	RTTStats();
+
+	void Add(const uint64_t us);
+	void Reset();
+
+	uint64_t GetCount() const;
+	uint64_t GetLast() const;
+	uint64_t GetMin() const;
+	double GetMean() const;
+	uint64_t GetPercentile(const double p) const;
+	uint64_t GetP99() const;
+	double GetSmoothed() const;
+	double GetVariation() const;
+
+protected:
+	uint64_t samples[kWindow];
+	uint64_t count;
+	uint64_t sum;
+	uint64_t min;
+	uint64_t last;
+	double smoothed;
+	double variation;
+};
+
+#endif /* RTTSTATS_H_ */
@@ -0,0 +1,68 @@
+/*
+ * ReconnectPolicy.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#ifndef RECONNECTPOLICY_H_
+#define RECONNECTPOLICY_H_
+
+#include <random>
+
+/**
+ * @interface ReconnectPolicy ReconnectPolicy.h
+ * @brief decides how long the ConnectionMonitor waits between automatic reconnect attempts
+ */
+class ReconnectPolicy {
+public:
+	ReconnectPolicy() {}
+	virtual ~ReconnectPolicy() {}
+
+	/**
+	 * @param minMS, maxMS the range set with ConnectionMonitor::SetAutoReconnectFrequency()
+	 * @param attempt the number of attempts since the connection was last stable, from 0
+	 * @return ms to wait before the next attempt
+	 */
+	virtual int NextDelay(const int minMS, const int maxMS, const int attempt)=0;
+	/** the connection stayed up long enough to count as stable, so the next failure starts from scratch */
+	virtual void Reset() {}
+};
+
+/**
+ * @class UniformReconnectPolicy ReconnectPolicy.h
+ * @brief the original policy ... a delay picked uniformly from [minMS, maxMS] every time
+ */
+class UniformReconnectPolicy: public ReconnectPolicy {
+public:
+	UniformReconnectPolicy(const unsigned seed=std::random_device()());
+
+	virtual int NextDelay(const int minMS, const int maxMS, const int attempt) override;
+
+protected:
+	std::mt19937 rng;
+};
+
+/**
+ * @class BackoffReconnectPolicy ReconnectPolicy.h
+ * @brief exponential backoff with decorrelated jitter
+ */
+class BackoffReconnectPolicy: public ReconnectPolicy {
+public:
+	static const int kDfltCapMS = 30000;
+
+	BackoffReconnectPolicy(const int capMS=kDfltCapMS, const unsigned seed=std::random_device()());
+
+	virtual int NextDelay(const int minMS, const int maxMS, const int attempt) override;
+	virtual void Reset() override;
+
+	int GetCap() const;
+	void SetCap(const int ms);
+
+protected:
+	int capMS;
+	int lastDelay;
+	std::mt19937 rng;
+};
+
+#endif /* RECONNECTPOLICY_H_ */
@@ -14,6 +14,7 @@ using namespace std;
 
 class RoomManager: public Manager<Room, RoomID>, public NotifyInt, public NotifyRoomInfo {
 	friend class UnionBridge;
+	friend class SessionRestorer;
 public:
 	RoomManager(ClientManager& clientManager, AccountManager& accountManager, UnionBridge& UnionBridge, ILogger &log);
 	virtual ~RoomManager();
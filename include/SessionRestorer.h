@@ -0,0 +1,87 @@
+/*
+ * SessionRestorer.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#ifndef SESSIONRESTORER_H_
+#define SESSIONRESTORER_H_
+
+#include "Histogram.h"
+
+class SessionRestorer {
+public:
+	SessionRestorer(RoomManager& roomManager, ClientManager& clientManager, AccountManager& accountManager, ILogger& log);
+
+	bool IsEnabled() const;
+	void SetEnabled(const bool enable);
+	bool IsRestoring() const;
+
+	/** one upc of a restoring burst */
+	struct Request {
+		UPCMessageID messageID;
+		StringArgs args;
+	};
+
+	void WillSend(UPCMessageID messageID, const StringArgs& args);
+	void OnSessionLost();
+	void OnClientDisconnect();
+	void Clear();
+	std::vector<Request> Replay();
+	void OnResult(UPCMessageID messageID, const std::string& key, const UPCStatus status);
+
+	/** counts for restoring lost sessions. times are in ms */
+	struct RestoreStats {
+		uint64_t restores = 0;
+		uint64_t requests = 0;
+		uint64_t failures = 0;
+		Histogram sinceReady;
+		Histogram sinceLost;
+	};
+	const RestoreStats& GetRestoreStats() const;
+	void ResetRestoreStats();
+
+	typedef std::function<uint64_t()> Clock;
+	void SetClock(Clock c);
+
+protected:
+	/** a self client attribute as we last sent it */
+	struct SelfAttribute {
+		AttrName name;
+		AttrScope scope;
+		AttrVal value;
+		unsigned int options;
+	};
+
+	void Expect(UPCMessageID messageID, const std::string& key);
+	void Forget(UPCMessageID messageID, const std::string& key, const UPCStatus status);
+	void Finish();
+	uint64_t Now() const;
+
+	static std::string Key(UPCMessageID messageID, const std::string& key);
+	static std::string AttributeKey(const AttrScope& scope, const AttrName& name);
+
+	bool enabled = true;
+	bool lost = false;
+	bool restoring = false;
+	bool closing = false;
+	uint64_t lostAt = 0;
+	uint64_t readyAt = 0;
+	ClientRef lostSelf;
+	std::unordered_set<std::string> pending;
+	RestoreStats stats;
+
+	std::unordered_map<RoomID, std::string> joinPasswords;
+	std::unordered_map<RoomID, std::string> observePasswords;
+	std::unordered_map<RoomID, std::string> updateLevels;
+	std::unordered_map<std::string, SelfAttribute> selfAttributes;
+
+	RoomManager& roomManager;
+	ClientManager& clientManager;
+	AccountManager& accountManager;
+	ILogger& log;
+	Clock clock;
+};
+
+#endif /* SESSIONRESTORER_H_ */
@@ -20,10 +20,14 @@
 #include "Map.h"
 #include "Set.h"
 #include "UPC.h"
+#include "RTTStats.h"
+#include "EventLoop.h"
+#include "Histogram.h"
 
 #include "connector/AbstractConnector.h"
 #include "connector/CnxLayer.h"
 #include "connector/WSCnxLayer.h"
+#include "connector/ConnectionScorer.h"
 #include "connector/StandardConnector.h"
 #include "connector/Base64.h"
 
@@ -31,7 +31,12 @@
 //#include "AttributeOwner.h"
 #include "Version.h"
 //#include "UVEventLoop.h"
+#include "RTTStats.h"
+#include "ReconnectPolicy.h"
 #include "ConnectionMonitor.h"
+#include "UPCConflator.h"
+#include "UPCScheduler.h"
+#include "SessionRestorer.h"
 #include "UpdateLevels.h"
 #include "ClientManifest.h"
 #include "RoomManifest.h"
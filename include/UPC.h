@@ -177,6 +177,8 @@ public:
 		static const UPCMessageID OBSERVED_ROOM;
 
 		static constexpr int ToCode(const UPCMessageID);
+	private:
+		static constexpr int ToCode(const char* digits, const int n);
 	};
 
 	/**
@@ -216,6 +218,10 @@ public:
 		NO_VALID_CONNECTION_AVAILABLE = CNX_ERROR_BASE + 7,
 		/** @constant */
 		CONNECT_TIMEOUT = CNX_ERROR_BASE + 8,
+		/** @constant */
+		CONNECTION_UPGRADE = CNX_ERROR_BASE + 9,
+		/** @constant */
+		CONNECTION_FAILOVER = CNX_ERROR_BASE + 10,
 		
 		/** @constant */
 		 ACCOUNT_EXISTS = UPC_STATUS_BASE+0,
@@ -326,5 +332,20 @@ public:
 
 
 };
+
+/**
+ * @return the method number of a upc id, eg 4 for JOIN_ROOM's "u4", or -1 if it isn't one
+ */
+constexpr int
+UPC::ID::ToCode(const UPCMessageID id)
+{
+	return id != nullptr && id[0] == 'u' && id[1] >= '0' && id[1] <= '9'? ToCode(id+1, 0) : -1;
+}
+
+constexpr int
+UPC::ID::ToCode(const char* digits, const int n)
+{
+	return *digits >= '0' && *digits <= '9'? ToCode(digits+1, n*10 + (*digits-'0')) : n;
+}
 #endif /* UPC_H_ */
 
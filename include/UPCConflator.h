@@ -0,0 +1,35 @@
+/*
+ * UPCConflator.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#ifndef UPCCONFLATOR_H_
+#define UPCCONFLATOR_H_
+
+class UPCConflator {
+public:
+	UPCConflator();
+
+	void SetThreshold(const size_t n);
+	size_t GetThreshold() const;
+
+	void Conflate(std::vector<DispatchUPC::ER>& batch);
+
+	int GetNumConflated() const;
+	int GetNumConflated(const int method) const;
+	void ResetStats();
+
+	static std::string Key(const int method, const StringArgs& args);
+
+protected:
+	size_t threshold;
+	int numConflated;
+	std::unordered_map<int, int> numConflatedByMethod;
+
+	std::unordered_map<std::string, size_t> latest;
+	std::vector<std::string> keys;
+};
+
+#endif /* UPCCONFLATOR_H_ */
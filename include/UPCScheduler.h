@@ -0,0 +1,55 @@
+/*
+ * UPCScheduler.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#ifndef UPCSCHEDULER_H_
+#define UPCSCHEDULER_H_
+
+#include "Histogram.h"
+
+class UPCScheduler {
+public:
+	/** priority classes, most urgent first */
+	static const int kPriorityControl = 0;
+	static const int kPriorityNormal = 1;
+	static const int kPriorityBulk = 2;
+	static const int kNumPriorities = 3;
+	/** upc methods are numbered below this. anything queued with a bigger event id is a bridge Event, and nothing moves across it */
+	static const int kMaxMethod = 200;
+
+	UPCScheduler();
+
+	void SetPriority(const int method, const int priority);
+	int GetPriority(const int method) const;
+	void ResetPriorities();
+
+	void Schedule(std::vector<DispatchUPC::ER>& batch);
+	void WillDispatch(const DispatchUPC::ER& event);
+
+	const Histogram& GetDepthHistogram(const int priority) const;
+	const Histogram& GetWaitHistogram(const int priority) const;
+	void ResetStats();
+
+	static const std::string* RoomKey(const int method, const StringArgs& args);
+	static const std::string* ClientKey(const int method, const StringArgs& args);
+	static const std::string* UserKey(const int method, const StringArgs& args);
+
+protected:
+	/** what messages are kept in order by: room, client and user */
+	static const int kNumKeys = 3;
+
+	void ScheduleSegment(std::vector<DispatchUPC::ER>& batch, size_t from, size_t to);
+
+	int priority[kMaxMethod];
+	Histogram depth[kNumPriorities];
+	Histogram wait[kNumPriorities];
+
+	std::vector<int> effective;
+	std::unordered_map<std::string, int> keyPriority[kNumKeys];
+	std::vector<DispatchUPC::ER> scheduled;
+};
+
+#endif /* UPCSCHEDULER_H_ */
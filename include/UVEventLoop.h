@@ -11,30 +11,33 @@
 #include "CommonTypes.h"
 #include "UVForwards.h"
 #include "EventLoop.h"
+#include "DNSCache.h"
 
 typedef std::function<void(uv_stream_t *client, ssize_t nread, const uv_buf_t *buf)> ReaderCB;
 typedef std::function<void(uv_connect_t*req, int status)> ConnectCB;
-typedef std::function<void(sockaddr* res, int status)> ResolverCB;
 typedef std::function<void(uv_handle_t *res)> CloserCB;
+/** called on the loop thread when a write has gone, or failed to, with the uv status */
+typedef std::function<void(int status)> WriteCB;
 
+/**
+ * timer and worker records are recycled through a free list in the UVEventLoop rather than deleted, so a steady state of scheduling doesn't
+ * allocate. the uv_timer_t is initialised once, the first time the record is started, and stays attached to the loop while the record is pooled
+ */
 struct UVTimer: public Timer {
-	UVTimer(TimerCB* _cb, uint64_t _delayMS, uint64_t _repeatMs)
-	{
-		tikCB = _cb;
-		delayMS = _delayMS;
-		repeatMs = _repeatMs;
-		disposed = false;
+	UVTimer()
+		: disposed(false)
+		, initialised(false) {
+		delayMS = 0;
+		repeatMs = 0;
 	}
 	mutable bool disposed;
+	bool initialised;
 	uv_timer_t timer;
 };
 
 struct UVWorker: public Worker {
-	UVWorker(WorkerCB* _cb, WorkerCB* _acb) {
-		queuedCB = _cb;
-		apresCB = _acb;
-		disposed = false;
-	}
+	UVWorker()
+		: disposed(false) { }
 	mutable bool disposed;
 	uv_work_t work;
 };
@@ -42,15 +45,18 @@ struct UVWorker: public Worker {
 struct UVWriter {
 	UVWriter(const UVTCPClient *client, const char *msg, const size_t n)
 		: disposed(false)
+		, writing(false)
 		, client(client)
 		, msg(msg)
 		, n(n) { }
 	mutable bool disposed;
+	bool writing;
 	const UVTCPClient *client;
 	uv_buf_t buf;
 	uv_write_t request;
 	const char *msg;
 	const size_t n;
+	WriteCB done;
 };
 
 struct UVReader {
@@ -74,10 +80,9 @@ struct UVReader {
 };
 
 struct UVResolver {
-	UVResolver(const UVTCPClient *client, std::string host, std::string service, ResolverCB*_cb)
+	UVResolver(std::string host, std::string service, ResolverCB*_cb)
 		: disposed(false)
 		, resolving(false)
-		, client(client)
 		, host(host)
 		, service(service) {
 		bindCB = _cb;
@@ -85,7 +90,6 @@ struct UVResolver {
 	mutable bool disposed;
 	mutable bool resolving;
 
-	const UVTCPClient* client;
 	ResolverCB* bindCB;
 	addrinfo dnsHints;
 	uv_getaddrinfo_t resolver;
@@ -130,14 +134,17 @@ public:
 	virtual WorkerRef Worker(WorkerCB, WorkerCB acb=WorkerCB()) override;
 	virtual void CancelWorker(WorkerRef) override;
 
-	void Write(const UVTCPClient *client, const char *msg, const size_t n);
+	void Write(const UVTCPClient *client, const char *msg, const size_t n, WriteCB done=nullptr);
+	void Write(const UVTCPClient *client, const uv_buf_t *bufs, const size_t nbufs, WriteCB done=nullptr);
 	void Connect(const UVTCPClient *client, ConnectCB ocb, ReaderCB cb);
-	void Resolve(const UVTCPClient *client, const std::string host, const std::string service, ResolverCB ocb);
+	void Resolve(const std::string host, const std::string service, ResolverCB ocb);
+	DNSCache& GetDNSCache() { return dns; }
 	void Close(const UVTCPClient *client, CloserCB cb);
 
 	static const int kUVCnxCallError = -1;
 	static const int kUVBindCallError = -2;
 
+	bool IsLoopThread() const;
 	void ForceStopAndClose();
 	bool StartUVRunner();
 	bool StopUVRunner(const bool force, const bool andWait);
@@ -148,6 +155,8 @@ protected:
 	static void OnTick(uv_timer_t* handle);
 	static void OnWork(uv_work_t *req);
 	static void OnAfterWork(uv_work_t *req, int status);
+	void RecycleTimer(UVTimer *t);
+	void RecycleWorker(UVWorker *w);
 
 	static void OnResolved(uv_getaddrinfo_t *resolver, int status, struct addrinfo *res);
 	static void OnConnect(uv_connect_t *req, int status);
@@ -169,10 +178,16 @@ protected:
 	std::vector<UVTimer*> activeTimers;
 	std::vector<UVWorker*> activeWorkers;
 
+	std::vector<UVTimer*> freeTimers;
+	std::vector<UVWorker*> freeWorkers;
+
 	std::vector<UVWriter*> writers;
 	std::vector<UVReader*> readers;
 	std::vector<UVResolver*> resolvers;
 	std::vector<UVCloser*> closers;
+	std::vector<std::function<void()>> deferred;
+
+	DNSCache dns;
 };
 
 #endif /* UVEVENTLOOP_H_ */
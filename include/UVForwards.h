@@ -44,6 +44,23 @@ typedef struct uv_fs_poll_s uv_fs_poll_t;
 typedef struct uv_signal_s uv_signal_t;
 #endif
 
+/**
+ * a socket address of either family, with room for a sockaddr_storage, so it can be passed around by value without the socket headers
+ */
+struct UVAddress
+{
+	UVAddress();
+	UVAddress(const struct sockaddr* a);
+
+	int Family() const;
+	bool IsIP6() const;
+	const struct sockaddr* Get() const { return (const struct sockaddr*) storage; }
+	std::string Name() const;
+	bool operator==(const UVAddress& a) const;
+
+	static const int kStorageSize = 128;
+	alignas(8) unsigned char storage[kStorageSize];
+};
 
 class UVTCPClient
 {
@@ -52,9 +69,15 @@ public:
 	UVTCPClient();
 	virtual ~UVTCPClient();
 	std::string IP4Addr() const;
+	void SetAddress(const UVAddress& a);
+	void UsePipe(const std::string path);
+	/** the stream we read and write, the pipe if there is one, otherwise the tcp socket */
+	uv_stream_t* Stream() const { return pipe? (uv_stream_t*)pipe : (uv_stream_t*)socket; }
 
 protected:
 	uv_tcp_t* socket;
+	uv_pipe_t* pipe = nullptr;
+	std::string pipeName;
 	struct sockaddr* address;
 };
 
@@ -29,7 +29,7 @@ public:
 	void SetConnector(const AbstractConnector &c);
 
 	bool AddUPCListener(const EventType eventType, const CBUPCRef listener) const;
-	CBUPCRef AddUPCListener(const EventType eventType, const CBUPC listener) const;
+	CBUPCRef AddUPCListener(const EventType eventType, CBUPC listener) const;
 	bool RemoveUPCListener(const EventType eventType, const CBUPCRef listener) const;
 
 	void RemoveMessageListenersOnDisconnect(bool enabled);
@@ -38,8 +38,22 @@ public:
 	int GetNumMessagesReceived() const;
 	int GetNumMessagesSent() const;
 	int GetTotalMessages() const;
+	uint64_t GetNumBytesReceived() const;
+
+	void SetConflationThreshold(const size_t n);
+	int GetNumConflated() const;
+	int GetNumConflated(const int method) const;
+
+	void SetUPCPriority(const int method, const int priority);
+	int GetUPCPriority(const int method) const;
+	const Histogram& GetQueueDepthHistogram(const int priority) const;
+	const Histogram& GetQueueWaitHistogram(const int priority) const;
+
+	SessionRestorer& GetSessionRestorer();
 
 	void SendUPC(UPCMessageID messageID, StringArgs args);
+	int SendTransportPing();
+	const RTTStats* GetTransportRTTStats() const;
 
 /* from Server class */
 	Version GetUPCVersion() const;
@@ -88,16 +102,20 @@ protected:
 
 	void SetConnectionState(int);
 
-	void UpcReceivedListener(EventType t, CnxRef cnx, std::string upc, ConnectionStatus status);
-	void UpcSentListener(EventType t, CnxRef cnx, std::string upc, ConnectionStatus status);
-	void DisconnectListener(EventType t, CnxRef cnx, std::string, ConnectionStatus status);
-	void ConnectListener(EventType t, CnxRef cnx, std::string, ConnectionStatus status);
-	void SelectListener(EventType t, CnxRef cnx, std::string, ConnectionStatus status);
-	void IOErrorListener(EventType t, CnxRef cnx, std::string, ConnectionStatus status);
-	void ConnectFailureListener(EventType t, CnxRef cnx, std::string, ConnectionStatus status);
+	void UpcReceivedListener(EventType t, CnxRef cnx, const std::string& upc, ConnectionStatus status);
+	void UpcSentListener(EventType t, CnxRef cnx, const std::string& upc, ConnectionStatus status);
+	void DisconnectListener(EventType t, CnxRef cnx, const std::string&, ConnectionStatus status);
+	void ConnectListener(EventType t, CnxRef cnx, const std::string&, ConnectionStatus status);
+	void SelectListener(EventType t, CnxRef cnx, const std::string&, ConnectionStatus status);
+	void SendQueueListener(EventType t, CnxRef cnx, const std::string&, ConnectionStatus status);
+	void IOErrorListener(EventType t, CnxRef cnx, const std::string&, ConnectionStatus status);
+	void ConnectFailureListener(EventType t, CnxRef cnx, const std::string&, ConnectionStatus status);
 	void CleanupClosedConnection();
+	void RestoreSession();
 
 	void NxBeginConnect();
+	virtual void PrepareDispatches(std::vector<ER>& batch) override;
+	virtual void WillDispatch(const ER& event) override;
 	void NxBeginHandshake();
 	void NxDisconnected();
 	void NxConnectionStateChange();
@@ -105,166 +123,167 @@ protected:
 	void NxProtocolIncompatible(const std::string version);
 	void NxReady();
 	void NxSendData(const std::string data);
-	void NxUPCMethod(const int method, const StringArgs upcArgs);
+	void NxUPCMethod(const int method, StringArgs upcArgs);
 	void NxReceiveData(const std::string data);
 	void NxIOError(std::string err, UPCStatus status);
 
-	void U1(EventType t, std::vector<std::string> args, UPCStatus status); /* SEND_MESSAGE_TO_ROOMS */
-	void U2(EventType t, std::vector<std::string> args, UPCStatus status); /* SEND_MESSAGE_TO_CLIENTS */
-	void U3(EventType t, std::vector<std::string> args, UPCStatus status); /* SET_CLIENT_ATTR */
-	void U4(EventType t, std::vector<std::string> args, UPCStatus status); /* JOIN_ROOM */
-	void U5(EventType t, std::vector<std::string> args, UPCStatus status); /* SET_ROOM_ATTR */
-	void U6(EventType t, std::vector<std::string> args, UPCStatus status); /* JOINED_ROOM */
-	void U7(EventType t, std::vector<std::string> args, UPCStatus status); /* RECEIVE_MESSAGE */
-	void U8(EventType t, std::vector<std::string> args, UPCStatus status); /* CLIENT_ATTR_UPDATE */
-	void U9(EventType t, std::vector<std::string> args, UPCStatus status); /* ROOM_ATTR_UPDATE */
-	void U10(EventType t, std::vector<std::string> args, UPCStatus status); /* LEAVE_ROOM */
-	void U11(EventType t, std::vector<std::string> args, UPCStatus status); /* CREATE_ACCOUNT */
-	void U12(EventType t, std::vector<std::string> args, UPCStatus status); /* REMOVE_ACCOUNT */
-	void U13(EventType t, std::vector<std::string> args, UPCStatus status); /* CHANGE_ACCOUNT_PASSWORD */
-	void U14(EventType t, std::vector<std::string> args, UPCStatus status); /* LOGIN */
-	void U18(EventType t, std::vector<std::string> args, UPCStatus status); /* GET_CLIENTCOUNT_SNAPSHOT */
-	void U19(EventType t, std::vector<std::string> args, UPCStatus status); /* SYNC_TIME */
-	void U21(EventType t, std::vector<std::string> args, UPCStatus status); /* GET_ROOMLIST_SNAPSHOT */
-	void U32(EventType t, std::vector<std::string> args, UPCStatus status); /* CREATE_ROOM_RESULT */
-	void U43(EventType t, std::vector<std::string> args, UPCStatus status); /* STOP_WATCHING_FOR_ROOMS_RESULT */
-	void U24(EventType t, std::vector<std::string> args, UPCStatus status); /* CREATE_ROOM */
-	void U25(EventType t, std::vector<std::string> args, UPCStatus status); /* REMOVE_ROOM */
-	void U29(EventType t, std::vector<std::string> args, UPCStatus status); /* CLIENT_METADATA */
-	void U26(EventType t, std::vector<std::string> args, UPCStatus status); /* WATCH_FOR_ROOMS */
-	void U27(EventType t, std::vector<std::string> args, UPCStatus status); /* STOP_WATCHING_FOR_ROOMS */
-	void U33(EventType t, std::vector<std::string> args, UPCStatus status); /* REMOVE_ROOM_RESULT */
-	void U34(EventType t, std::vector<std::string> args, UPCStatus status); /* CLIENTCOUNT_SNAPSHOT */
-	void U36(EventType t, std::vector<std::string> args, UPCStatus status); /* CLIENT_ADDED_TO_ROOM */
-	void U37(EventType t, std::vector<std::string> args, UPCStatus status); /* CLIENT_REMOVED_FROM_ROOM */
-	void U38(EventType t, std::vector<std::string> args, UPCStatus status); /* ROOMLIST_SNAPSHOT */
-	void U39(EventType t, std::vector<std::string> args, UPCStatus status); /* ROOM_ADDED */
-	void U40(EventType t, std::vector<std::string> args, UPCStatus status); /* ROOM_REMOVED */
-	void U42(EventType t, std::vector<std::string> args, UPCStatus status); /* WATCH_FOR_ROOMS_RESULT */
-	void U44(EventType t, std::vector<std::string> args, UPCStatus status); /* LEFT_ROOM */
-	void U46(EventType t, std::vector<std::string> args, UPCStatus status); /* CHANGE_ACCOUNT_PASSWORD_RESULT */
-	void U47(EventType t, std::vector<std::string> args, UPCStatus status); /* CREATE_ACCOUNT_RESULT */
-	void U48(EventType t, std::vector<std::string> args, UPCStatus status); /* REMOVE_ACCOUNT_RESULT */
-	void U49(EventType t, std::vector<std::string> args, UPCStatus status); /* LOGIN_RESULT */
-	void U50(EventType t, std::vector<std::string> args, UPCStatus status); /* SERVER_TIME_UPDATE */
-	void U54(EventType t, std::vector<std::string> args, UPCStatus status); /* ROOM_SNAPSHOT */
-	void U55(EventType t, std::vector<std::string> args, UPCStatus status); /* GET_ROOM_SNAPSHOT */
-	void U57(EventType t, std::vector<std::string> args, UPCStatus status); /* SEND_MESSAGE_TO_SERVER */
-	void U58(EventType t, std::vector<std::string> args, UPCStatus status); /* OBSERVE_ROOM */
-	void U59(EventType t, std::vector<std::string> args, UPCStatus status); /* OBSERVED_ROOM */
-	void U60(EventType t, std::vector<std::string> args, UPCStatus status); /* GET_ROOM_SNAPSHOT_RESULT */
-	void U61(EventType t, std::vector<std::string> args, UPCStatus status); /* STOP_OBSERVING_ROOM */
-	void U62(EventType t, std::vector<std::string> args, UPCStatus status); /* STOPPED_OBSERVING_ROOM */
-	void U63(EventType t, std::vector<std::string> args, UPCStatus status); /* CLIENT_READY */
-	void U64(EventType t, std::vector<std::string> args, UPCStatus status); /* SET_ROOM_UPDATE_LEVELS */
-	void U65(EventType t, std::vector<std::string> args, UPCStatus status); /* CLIENT_HELLO */
-	void U66(EventType t, std::vector<std::string> args, UPCStatus status); /* SERVER_HELLO */
-	void U67(EventType t, std::vector<std::string> args, UPCStatus status); /* REMOVE_ROOM_ATTR */
-	void U69(EventType t, std::vector<std::string> args, UPCStatus status); /* REMOVE_CLIENT_ATTR */
-	void U70(EventType t, std::vector<std::string> args, UPCStatus status); /* SEND_ROOMMODULE_MESSAGE */
-	void U71(EventType t, std::vector<std::string> args, UPCStatus status); /* SEND_SERVERMODULE_MESSAGE */
-	void U72(EventType t, std::vector<std::string> args, UPCStatus status); /* JOIN_ROOM_RESULT */
-	void U73(EventType t, std::vector<std::string> args, UPCStatus status); /* SET_CLIENT_ATTR_RESULT */
-	void U74(EventType t, std::vector<std::string> args, UPCStatus status); /* SET_ROOM_ATTR_RESULT */
-	void U75(EventType t, std::vector<std::string> args, UPCStatus status); /* GET_CLIENTCOUNT_SNAPSHOT_RESULT */
-	void U76(EventType t, std::vector<std::string> args, UPCStatus status); /* LEAVE_ROOM_RESULT */
-	void U77(EventType t, std::vector<std::string> args, UPCStatus status); /* OBSERVE_ROOM_RESULT */
-	void U78(EventType t, std::vector<std::string> args, UPCStatus status); /* STOP_OBSERVING_ROOM_RESULT */
-	void U79(EventType t, std::vector<std::string> args, UPCStatus status); /* ROOM_ATTR_REMOVED */
-	void U80(EventType t, std::vector<std::string> args, UPCStatus status); /* REMOVE_ROOM_ATTR_RESULT */
-	void U81(EventType t, std::vector<std::string> args, UPCStatus status); /* CLIENT_ATTR_REMOVED */
-	void U82(EventType t, std::vector<std::string> args, UPCStatus status); /* REMOVE_CLIENT_ATTR_RESULT */
-	void U83(EventType t, std::vector<std::string> args, UPCStatus status); /* TERMINATE_SESSION */
-	void U84(EventType t, std::vector<std::string> args, UPCStatus status); /* SESSION_TERMINATED */
-	void U85(EventType t, std::vector<std::string> args, UPCStatus status); /* SESSION_NOT_FOUND */
-	void U86(EventType t, std::vector<std::string> args, UPCStatus status); /* LOGOFF */
-	void U87(EventType t, std::vector<std::string> args, UPCStatus status); /* LOGOFF_RESULT */
-	void U88(EventType t, std::vector<std::string> args, UPCStatus status); /* LOGGED_IN */
-	void U89(EventType t, std::vector<std::string> args, UPCStatus status); /* LOGGED_OFF */
-	void U90(EventType t, std::vector<std::string> args, UPCStatus status); /* ACCOUNT_PASSWORD_CHANGED */
-	void U91(EventType t, std::vector<std::string> args, UPCStatus status); /* GET_CLIENTLIST_SNAPSHOT */
-	void U92(EventType t, std::vector<std::string> args, UPCStatus status); /* WATCH_FOR_CLIENTS */
-	void U93(EventType t, std::vector<std::string> args, UPCStatus status); /* STOP_WATCHING_FOR_CLIENTS */
-	void U94(EventType t, std::vector<std::string> args, UPCStatus status); /* GET_CLIENT_SNAPSHOT */
-	void U95(EventType t, std::vector<std::string> args, UPCStatus status); /* OBSERVE_CLIENT */
-	void U96(EventType t, std::vector<std::string> args, UPCStatus status); /* STOP_OBSERVING_CLIENT */
-	void U97(EventType t, std::vector<std::string> args, UPCStatus status); /* GET_ACCOUNTLIST_SNAPSHOT */
-	void U98(EventType t, std::vector<std::string> args, UPCStatus status); /* WATCH_FOR_ACCOUNTS */
-	void U99(EventType t, std::vector<std::string> args, UPCStatus status); /* STOP_WATCHING_FOR_ACCOUNTS */
-	void U100(EventType t, std::vector<std::string> args, UPCStatus status); /* GET_ACCOUNT_SNAPSHOT */
-	void U101(EventType t, std::vector<std::string> args, UPCStatus status); /* CLIENTLIST_SNAPSHOT */
-	void U102(EventType t, std::vector<std::string> args, UPCStatus status); /* CLIENT_ADDED_TO_SERVER */
-	void U103(EventType t, std::vector<std::string> args, UPCStatus status); /* CLIENT_REMOVED_FROM_SERVER */
-	void U104(EventType t, std::vector<std::string> args, UPCStatus status); /* CLIENT_SNAPSHOT */
-	void U105(EventType t, std::vector<std::string> args, UPCStatus status); /* OBSERVE_CLIENT_RESULT */
-	void U106(EventType t, std::vector<std::string> args, UPCStatus status); /* STOP_OBSERVING_CLIENT_RESULT */
-	void U107(EventType t, std::vector<std::string> args, UPCStatus status); /* WATCH_FOR_CLIENTS_RESULT */
-	void U108(EventType t, std::vector<std::string> args, UPCStatus status); /* STOP_WATCHING_FOR_CLIENTS_RESULT */
-	void U109(EventType t, std::vector<std::string> args, UPCStatus status); /* WATCH_FOR_ACCOUNTS_RESULT */
-	void U110(EventType t, std::vector<std::string> args, UPCStatus status); /* STOP_WATCHING_FOR_ACCOUNTS_RESULT */
-	void U111(EventType t, std::vector<std::string> args, UPCStatus status); /* ACCOUNT_ADDED */
-	void U112(EventType t, std::vector<std::string> args, UPCStatus status); /* ACCOUNT_REMOVED */
-	void U113(EventType t, std::vector<std::string> args, UPCStatus status); /* JOINED_ROOM_ADDED_TO_CLIENT */
-	void U114(EventType t, std::vector<std::string> args, UPCStatus status); /* JOINED_ROOM_REMOVED_FROM_CLIENT */
-	void U115(EventType t, std::vector<std::string> args, UPCStatus status); /* GET_CLIENT_SNAPSHOT_RESULT */
-	void U116(EventType t, std::vector<std::string> args, UPCStatus status); /* GET_ACCOUNT_SNAPSHOT_RESULT */
-	void U117(EventType t, std::vector<std::string> args, UPCStatus status); /* OBSERVED_ROOM_ADDED_TO_CLIENT */
-	void U118(EventType t, std::vector<std::string> args, UPCStatus status); /* OBSERVED_ROOM_REMOVED_FROM_CLIENT */
-	void U119(EventType t, std::vector<std::string> args, UPCStatus status); /* CLIENT_OBSERVED */
-	void U121(EventType t, std::vector<std::string> args, UPCStatus status); /* OBSERVE_ACCOUNT */
-	void U122(EventType t, std::vector<std::string> args, UPCStatus status); /* STOP_OBSERVING_ACCOUNT */
-	void U120(EventType t, std::vector<std::string> args, UPCStatus status); /* STOPPED_OBSERVING_CLIENT */
-	void U123(EventType t, std::vector<std::string> args, UPCStatus status); /* OBSERVE_ACCOUNT_RESULT */
-	void U124(EventType t, std::vector<std::string> args, UPCStatus status); /* ACCOUNT_OBSERVED */
-	void U125(EventType t, std::vector<std::string> args, UPCStatus status); /* STOP_OBSERVING_ACCOUNT_RESULT */
-	void U126(EventType t, std::vector<std::string> args, UPCStatus status); /* STOPPED_OBSERVING_ACCOUNT */
-	void U127(EventType t, std::vector<std::string> args, UPCStatus status); /* ACCOUNT_LIST_UPDATE */
-	void U128(EventType t, std::vector<std::string> args, UPCStatus status); /* UPDATE_LEVELS_UPDATE */
-	void U129(EventType t, std::vector<std::string> args, UPCStatus status); /* CLIENT_OBSERVED_ROOM */
-	void U130(EventType t, std::vector<std::string> args, UPCStatus status); /* CLIENT_STOPPED_OBSERVING_ROOM */
-	void U131(EventType t, std::vector<std::string> args, UPCStatus status); /* ROOM_OCCUPANTCOUNT_UPDATE */
-	void U132(EventType t, std::vector<std::string> args, UPCStatus status); /* ROOM_OBSERVERCOUNT_UPDATE */
-	void U133(EventType t, std::vector<std::string> args, UPCStatus status); /* ADD_ROLE */
-	void U134(EventType t, std::vector<std::string> args, UPCStatus status); /* ADD_ROLE_RESULT */
-	void U135(EventType t, std::vector<std::string> args, UPCStatus status); /* REMOVE_ROLE */
-	void U136(EventType t, std::vector<std::string> args, UPCStatus status); /* REMOVE_ROLE_RESULT */
-	void U137(EventType t, std::vector<std::string> args, UPCStatus status); /* BAN */
-	void U138(EventType t, std::vector<std::string> args, UPCStatus status); /* BAN_RESULT */
-	void U139(EventType t, std::vector<std::string> args, UPCStatus status); /* UNBAN */
-	void U140(EventType t, std::vector<std::string> args, UPCStatus status); /* UNBAN_RESULT */
-	void U141(EventType t, std::vector<std::string> args, UPCStatus status); /* GET_BANNED_LIST_SNAPSHOT */
-	void U142(EventType t, std::vector<std::string> args, UPCStatus status); /* BANNED_LIST_SNAPSHOT */
-	void U143(EventType t, std::vector<std::string> args, UPCStatus status); /* WATCH_FOR_BANNED_ADDRESSES */
-	void U144(EventType t, std::vector<std::string> args, UPCStatus status); /* WATCH_FOR_BANNED_ADDRESSES_RESULT */
-	void U145(EventType t, std::vector<std::string> args, UPCStatus status); /* STOP_WATCHING_FOR_BANNED_ADDRESSES */
-	void U146(EventType t, std::vector<std::string> args, UPCStatus status); /* STOP_WATCHING_FOR_BANNED_ADDRESSES_RESULT */
-	void U147(EventType t, std::vector<std::string> args, UPCStatus status); /* BANNED_ADDRESS_ADDED */
-	void U148(EventType t, std::vector<std::string> args, UPCStatus status); /* BANNED_ADDRESS_REMOVED */
-	void U149(EventType t, std::vector<std::string> args, UPCStatus status); /* KICK_CLIENT */
-	void U150(EventType t, std::vector<std::string> args, UPCStatus status); /* KICK_CLIENT_RESULT */
-	void U151(EventType t, std::vector<std::string> args, UPCStatus status); /* GET_SERVERMODULELIST_SNAPSHOT */
-	void U152(EventType t, std::vector<std::string> args, UPCStatus status); /* SERVERMODULELIST_SNAPSHOT */
-	void U154(EventType t, std::vector<std::string> args, UPCStatus status); /* GET_UPC_STATS_SNAPSHOT */
-	void U155(EventType t, std::vector<std::string> args, UPCStatus status); /* GET_UPC_STATS_SNAPSHOT_RESULT */
-	void U156(EventType t, std::vector<std::string> args, UPCStatus status); /* UPC_STATS_SNAPSHOT */
-	void U157(EventType t, std::vector<std::string> args, UPCStatus status); /* RESET_UPC_STATS */
-	void U160(EventType t, std::vector<std::string> args, UPCStatus status); /* WATCH_FOR_PROCESSED_UPCS_RESULT */
-	void U164(EventType t, std::vector<std::string> args, UPCStatus status); /* CONNECTION_REFUSED */
-	void U165(EventType t, std::vector<std::string> args, UPCStatus status); /* GET_NODELIST_SNAPSHOT */
-	void U153(EventType t, std::vector<std::string> args, UPCStatus status); /* CLEAR_MODULE_CACHE */
-	void U158(EventType t, std::vector<std::string> args, UPCStatus status); /* RESET_UPC_STATS_RESULT */
-	void U159(EventType t, std::vector<std::string> args, UPCStatus status); /* WATCH_FOR_PROCESSED_UPCS */
-	void U161(EventType t, std::vector<std::string> args, UPCStatus status); /* PROCESSED_UPC_ADDED */
-	void U162(EventType t, std::vector<std::string> args, UPCStatus status); /* STOP_WATCHING_FOR_PROCESSED_UPCS */
-	void U163(EventType t, std::vector<std::string> args, UPCStatus status); /* STOP_WATCHING_FOR_PROCESSED_UPCS_RESULT */
-	void U166(EventType t, std::vector<std::string> args, UPCStatus status); /* NODELIST_SNAPSHOT */
-	void U167(EventType t, std::vector<std::string> args, UPCStatus status); /* GET_GATEWAYS_SNAPSHOT */
-	void U168(EventType t, std::vector<std::string> args, UPCStatus status); /* GATEWAYS_SNAPSHOT */
+	void U1(EventType t, const std::vector<std::string>& args, UPCStatus status); /* SEND_MESSAGE_TO_ROOMS */
+	void U2(EventType t, const std::vector<std::string>& args, UPCStatus status); /* SEND_MESSAGE_TO_CLIENTS */
+	void U3(EventType t, const std::vector<std::string>& args, UPCStatus status); /* SET_CLIENT_ATTR */
+	void U4(EventType t, const std::vector<std::string>& args, UPCStatus status); /* JOIN_ROOM */
+	void U5(EventType t, const std::vector<std::string>& args, UPCStatus status); /* SET_ROOM_ATTR */
+	void U6(EventType t, const std::vector<std::string>& args, UPCStatus status); /* JOINED_ROOM */
+	void U7(EventType t, const std::vector<std::string>& args, UPCStatus status); /* RECEIVE_MESSAGE */
+	void U8(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CLIENT_ATTR_UPDATE */
+	void U9(EventType t, const std::vector<std::string>& args, UPCStatus status); /* ROOM_ATTR_UPDATE */
+	void U10(EventType t, const std::vector<std::string>& args, UPCStatus status); /* LEAVE_ROOM */
+	void U11(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CREATE_ACCOUNT */
+	void U12(EventType t, const std::vector<std::string>& args, UPCStatus status); /* REMOVE_ACCOUNT */
+	void U13(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CHANGE_ACCOUNT_PASSWORD */
+	void U14(EventType t, const std::vector<std::string>& args, UPCStatus status); /* LOGIN */
+	void U18(EventType t, const std::vector<std::string>& args, UPCStatus status); /* GET_CLIENTCOUNT_SNAPSHOT */
+	void U19(EventType t, const std::vector<std::string>& args, UPCStatus status); /* SYNC_TIME */
+	void U21(EventType t, const std::vector<std::string>& args, UPCStatus status); /* GET_ROOMLIST_SNAPSHOT */
+	void U32(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CREATE_ROOM_RESULT */
+	void U43(EventType t, const std::vector<std::string>& args, UPCStatus status); /* STOP_WATCHING_FOR_ROOMS_RESULT */
+	void U24(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CREATE_ROOM */
+	void U25(EventType t, const std::vector<std::string>& args, UPCStatus status); /* REMOVE_ROOM */
+	void U29(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CLIENT_METADATA */
+	void U26(EventType t, const std::vector<std::string>& args, UPCStatus status); /* WATCH_FOR_ROOMS */
+	void U27(EventType t, const std::vector<std::string>& args, UPCStatus status); /* STOP_WATCHING_FOR_ROOMS */
+	void U33(EventType t, const std::vector<std::string>& args, UPCStatus status); /* REMOVE_ROOM_RESULT */
+	void U34(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CLIENTCOUNT_SNAPSHOT */
+	void U36(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CLIENT_ADDED_TO_ROOM */
+	void U37(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CLIENT_REMOVED_FROM_ROOM */
+	void U38(EventType t, const std::vector<std::string>& args, UPCStatus status); /* ROOMLIST_SNAPSHOT */
+	void U39(EventType t, const std::vector<std::string>& args, UPCStatus status); /* ROOM_ADDED */
+	void U40(EventType t, const std::vector<std::string>& args, UPCStatus status); /* ROOM_REMOVED */
+	void U42(EventType t, const std::vector<std::string>& args, UPCStatus status); /* WATCH_FOR_ROOMS_RESULT */
+	void U44(EventType t, const std::vector<std::string>& args, UPCStatus status); /* LEFT_ROOM */
+	void U46(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CHANGE_ACCOUNT_PASSWORD_RESULT */
+	void U47(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CREATE_ACCOUNT_RESULT */
+	void U48(EventType t, const std::vector<std::string>& args, UPCStatus status); /* REMOVE_ACCOUNT_RESULT */
+	void U49(EventType t, const std::vector<std::string>& args, UPCStatus status); /* LOGIN_RESULT */
+	void U50(EventType t, const std::vector<std::string>& args, UPCStatus status); /* SERVER_TIME_UPDATE */
+	void U54(EventType t, const std::vector<std::string>& args, UPCStatus status); /* ROOM_SNAPSHOT */
+	void U55(EventType t, const std::vector<std::string>& args, UPCStatus status); /* GET_ROOM_SNAPSHOT */
+	void U57(EventType t, const std::vector<std::string>& args, UPCStatus status); /* SEND_MESSAGE_TO_SERVER */
+	void U58(EventType t, const std::vector<std::string>& args, UPCStatus status); /* OBSERVE_ROOM */
+	void U59(EventType t, const std::vector<std::string>& args, UPCStatus status); /* OBSERVED_ROOM */
+	void U60(EventType t, const std::vector<std::string>& args, UPCStatus status); /* GET_ROOM_SNAPSHOT_RESULT */
+	void U61(EventType t, const std::vector<std::string>& args, UPCStatus status); /* STOP_OBSERVING_ROOM */
+	void U62(EventType t, const std::vector<std::string>& args, UPCStatus status); /* STOPPED_OBSERVING_ROOM */
+	void U63(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CLIENT_READY */
+	void U64(EventType t, const std::vector<std::string>& args, UPCStatus status); /* SET_ROOM_UPDATE_LEVELS */
+	void U65(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CLIENT_HELLO */
+	void U66(EventType t, const std::vector<std::string>& args, UPCStatus status); /* SERVER_HELLO */
+	void U67(EventType t, const std::vector<std::string>& args, UPCStatus status); /* REMOVE_ROOM_ATTR */
+	void U69(EventType t, const std::vector<std::string>& args, UPCStatus status); /* REMOVE_CLIENT_ATTR */
+	void U70(EventType t, const std::vector<std::string>& args, UPCStatus status); /* SEND_ROOMMODULE_MESSAGE */
+	void U71(EventType t, const std::vector<std::string>& args, UPCStatus status); /* SEND_SERVERMODULE_MESSAGE */
+	void U72(EventType t, const std::vector<std::string>& args, UPCStatus status); /* JOIN_ROOM_RESULT */
+	void U73(EventType t, const std::vector<std::string>& args, UPCStatus status); /* SET_CLIENT_ATTR_RESULT */
+	void U74(EventType t, const std::vector<std::string>& args, UPCStatus status); /* SET_ROOM_ATTR_RESULT */
+	void U75(EventType t, const std::vector<std::string>& args, UPCStatus status); /* GET_CLIENTCOUNT_SNAPSHOT_RESULT */
+	void U76(EventType t, const std::vector<std::string>& args, UPCStatus status); /* LEAVE_ROOM_RESULT */
+	void U77(EventType t, const std::vector<std::string>& args, UPCStatus status); /* OBSERVE_ROOM_RESULT */
+	void U78(EventType t, const std::vector<std::string>& args, UPCStatus status); /* STOP_OBSERVING_ROOM_RESULT */
+	void U79(EventType t, const std::vector<std::string>& args, UPCStatus status); /* ROOM_ATTR_REMOVED */
+	void U80(EventType t, const std::vector<std::string>& args, UPCStatus status); /* REMOVE_ROOM_ATTR_RESULT */
+	void U81(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CLIENT_ATTR_REMOVED */
+	void U82(EventType t, const std::vector<std::string>& args, UPCStatus status); /* REMOVE_CLIENT_ATTR_RESULT */
+	void U83(EventType t, const std::vector<std::string>& args, UPCStatus status); /* TERMINATE_SESSION */
+	void U84(EventType t, const std::vector<std::string>& args, UPCStatus status); /* SESSION_TERMINATED */
+	void U85(EventType t, const std::vector<std::string>& args, UPCStatus status); /* SESSION_NOT_FOUND */
+	void U86(EventType t, const std::vector<std::string>& args, UPCStatus status); /* LOGOFF */
+	void U87(EventType t, const std::vector<std::string>& args, UPCStatus status); /* LOGOFF_RESULT */
+	void U88(EventType t, const std::vector<std::string>& args, UPCStatus status); /* LOGGED_IN */
+	void U89(EventType t, const std::vector<std::string>& args, UPCStatus status); /* LOGGED_OFF */
+	void U90(EventType t, const std::vector<std::string>& args, UPCStatus status); /* ACCOUNT_PASSWORD_CHANGED */
+	void U91(EventType t, const std::vector<std::string>& args, UPCStatus status); /* GET_CLIENTLIST_SNAPSHOT */
+	void U92(EventType t, const std::vector<std::string>& args, UPCStatus status); /* WATCH_FOR_CLIENTS */
+	void U93(EventType t, const std::vector<std::string>& args, UPCStatus status); /* STOP_WATCHING_FOR_CLIENTS */
+	void U94(EventType t, const std::vector<std::string>& args, UPCStatus status); /* GET_CLIENT_SNAPSHOT */
+	void U95(EventType t, const std::vector<std::string>& args, UPCStatus status); /* OBSERVE_CLIENT */
+	void U96(EventType t, const std::vector<std::string>& args, UPCStatus status); /* STOP_OBSERVING_CLIENT */
+	void U97(EventType t, const std::vector<std::string>& args, UPCStatus status); /* GET_ACCOUNTLIST_SNAPSHOT */
+	void U98(EventType t, const std::vector<std::string>& args, UPCStatus status); /* WATCH_FOR_ACCOUNTS */
+	void U99(EventType t, const std::vector<std::string>& args, UPCStatus status); /* STOP_WATCHING_FOR_ACCOUNTS */
+	void U100(EventType t, const std::vector<std::string>& args, UPCStatus status); /* GET_ACCOUNT_SNAPSHOT */
+	void U101(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CLIENTLIST_SNAPSHOT */
+	void U102(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CLIENT_ADDED_TO_SERVER */
+	void U103(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CLIENT_REMOVED_FROM_SERVER */
+	void U104(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CLIENT_SNAPSHOT */
+	void U105(EventType t, const std::vector<std::string>& args, UPCStatus status); /* OBSERVE_CLIENT_RESULT */
+	void U106(EventType t, const std::vector<std::string>& args, UPCStatus status); /* STOP_OBSERVING_CLIENT_RESULT */
+	void U107(EventType t, const std::vector<std::string>& args, UPCStatus status); /* WATCH_FOR_CLIENTS_RESULT */
+	void U108(EventType t, const std::vector<std::string>& args, UPCStatus status); /* STOP_WATCHING_FOR_CLIENTS_RESULT */
+	void U109(EventType t, const std::vector<std::string>& args, UPCStatus status); /* WATCH_FOR_ACCOUNTS_RESULT */
+	void U110(EventType t, const std::vector<std::string>& args, UPCStatus status); /* STOP_WATCHING_FOR_ACCOUNTS_RESULT */
+	void U111(EventType t, const std::vector<std::string>& args, UPCStatus status); /* ACCOUNT_ADDED */
+	void U112(EventType t, const std::vector<std::string>& args, UPCStatus status); /* ACCOUNT_REMOVED */
+	void U113(EventType t, const std::vector<std::string>& args, UPCStatus status); /* JOINED_ROOM_ADDED_TO_CLIENT */
+	void U114(EventType t, const std::vector<std::string>& args, UPCStatus status); /* JOINED_ROOM_REMOVED_FROM_CLIENT */
+	void U115(EventType t, const std::vector<std::string>& args, UPCStatus status); /* GET_CLIENT_SNAPSHOT_RESULT */
+	void U116(EventType t, const std::vector<std::string>& args, UPCStatus status); /* GET_ACCOUNT_SNAPSHOT_RESULT */
+	void U117(EventType t, const std::vector<std::string>& args, UPCStatus status); /* OBSERVED_ROOM_ADDED_TO_CLIENT */
+	void U118(EventType t, const std::vector<std::string>& args, UPCStatus status); /* OBSERVED_ROOM_REMOVED_FROM_CLIENT */
+	void U119(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CLIENT_OBSERVED */
+	void U121(EventType t, const std::vector<std::string>& args, UPCStatus status); /* OBSERVE_ACCOUNT */
+	void U122(EventType t, const std::vector<std::string>& args, UPCStatus status); /* STOP_OBSERVING_ACCOUNT */
+	void U120(EventType t, const std::vector<std::string>& args, UPCStatus status); /* STOPPED_OBSERVING_CLIENT */
+	void U123(EventType t, const std::vector<std::string>& args, UPCStatus status); /* OBSERVE_ACCOUNT_RESULT */
+	void U124(EventType t, const std::vector<std::string>& args, UPCStatus status); /* ACCOUNT_OBSERVED */
+	void U125(EventType t, const std::vector<std::string>& args, UPCStatus status); /* STOP_OBSERVING_ACCOUNT_RESULT */
+	void U126(EventType t, const std::vector<std::string>& args, UPCStatus status); /* STOPPED_OBSERVING_ACCOUNT */
+	void U127(EventType t, const std::vector<std::string>& args, UPCStatus status); /* ACCOUNT_LIST_UPDATE */
+	void U128(EventType t, const std::vector<std::string>& args, UPCStatus status); /* UPDATE_LEVELS_UPDATE */
+	void U129(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CLIENT_OBSERVED_ROOM */
+	void U130(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CLIENT_STOPPED_OBSERVING_ROOM */
+	void U131(EventType t, const std::vector<std::string>& args, UPCStatus status); /* ROOM_OCCUPANTCOUNT_UPDATE */
+	void U132(EventType t, const std::vector<std::string>& args, UPCStatus status); /* ROOM_OBSERVERCOUNT_UPDATE */
+	void U133(EventType t, const std::vector<std::string>& args, UPCStatus status); /* ADD_ROLE */
+	void U134(EventType t, const std::vector<std::string>& args, UPCStatus status); /* ADD_ROLE_RESULT */
+	void U135(EventType t, const std::vector<std::string>& args, UPCStatus status); /* REMOVE_ROLE */
+	void U136(EventType t, const std::vector<std::string>& args, UPCStatus status); /* REMOVE_ROLE_RESULT */
+	void U137(EventType t, const std::vector<std::string>& args, UPCStatus status); /* BAN */
+	void U138(EventType t, const std::vector<std::string>& args, UPCStatus status); /* BAN_RESULT */
+	void U139(EventType t, const std::vector<std::string>& args, UPCStatus status); /* UNBAN */
+	void U140(EventType t, const std::vector<std::string>& args, UPCStatus status); /* UNBAN_RESULT */
+	void U141(EventType t, const std::vector<std::string>& args, UPCStatus status); /* GET_BANNED_LIST_SNAPSHOT */
+	void U142(EventType t, const std::vector<std::string>& args, UPCStatus status); /* BANNED_LIST_SNAPSHOT */
+	void U143(EventType t, const std::vector<std::string>& args, UPCStatus status); /* WATCH_FOR_BANNED_ADDRESSES */
+	void U144(EventType t, const std::vector<std::string>& args, UPCStatus status); /* WATCH_FOR_BANNED_ADDRESSES_RESULT */
+	void U145(EventType t, const std::vector<std::string>& args, UPCStatus status); /* STOP_WATCHING_FOR_BANNED_ADDRESSES */
+	void U146(EventType t, const std::vector<std::string>& args, UPCStatus status); /* STOP_WATCHING_FOR_BANNED_ADDRESSES_RESULT */
+	void U147(EventType t, const std::vector<std::string>& args, UPCStatus status); /* BANNED_ADDRESS_ADDED */
+	void U148(EventType t, const std::vector<std::string>& args, UPCStatus status); /* BANNED_ADDRESS_REMOVED */
+	void U149(EventType t, const std::vector<std::string>& args, UPCStatus status); /* KICK_CLIENT */
+	void U150(EventType t, const std::vector<std::string>& args, UPCStatus status); /* KICK_CLIENT_RESULT */
+	void U151(EventType t, const std::vector<std::string>& args, UPCStatus status); /* GET_SERVERMODULELIST_SNAPSHOT */
+	void U152(EventType t, const std::vector<std::string>& args, UPCStatus status); /* SERVERMODULELIST_SNAPSHOT */
+	void U154(EventType t, const std::vector<std::string>& args, UPCStatus status); /* GET_UPC_STATS_SNAPSHOT */
+	void U155(EventType t, const std::vector<std::string>& args, UPCStatus status); /* GET_UPC_STATS_SNAPSHOT_RESULT */
+	void U156(EventType t, const std::vector<std::string>& args, UPCStatus status); /* UPC_STATS_SNAPSHOT */
+	void U157(EventType t, const std::vector<std::string>& args, UPCStatus status); /* RESET_UPC_STATS */
+	void U160(EventType t, const std::vector<std::string>& args, UPCStatus status); /* WATCH_FOR_PROCESSED_UPCS_RESULT */
+	void U164(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CONNECTION_REFUSED */
+	void U165(EventType t, const std::vector<std::string>& args, UPCStatus status); /* GET_NODELIST_SNAPSHOT */
+	void U153(EventType t, const std::vector<std::string>& args, UPCStatus status); /* CLEAR_MODULE_CACHE */
+	void U158(EventType t, const std::vector<std::string>& args, UPCStatus status); /* RESET_UPC_STATS_RESULT */
+	void U159(EventType t, const std::vector<std::string>& args, UPCStatus status); /* WATCH_FOR_PROCESSED_UPCS */
+	void U161(EventType t, const std::vector<std::string>& args, UPCStatus status); /* PROCESSED_UPC_ADDED */
+	void U162(EventType t, const std::vector<std::string>& args, UPCStatus status); /* STOP_WATCHING_FOR_PROCESSED_UPCS */
+	void U163(EventType t, const std::vector<std::string>& args, UPCStatus status); /* STOP_WATCHING_FOR_PROCESSED_UPCS_RESULT */
+	void U166(EventType t, const std::vector<std::string>& args, UPCStatus status); /* NODELIST_SNAPSHOT */
+	void U167(EventType t, const std::vector<std::string>& args, UPCStatus status); /* GET_GATEWAYS_SNAPSHOT */
+	void U168(EventType t, const std::vector<std::string>& args, UPCStatus status); /* GATEWAYS_SNAPSHOT */
 
 
 	bool removeListenersOnDisconnect = true;
 	int numMessagesSent = 0;
 	int numMessagesReceived = 0;
+	uint64_t numBytesReceived = 0;
 
 	int connectionState = ConnectionState::UNKNOWN;
 	int readyCount = 0;
@@ -272,6 +291,9 @@ protected:
 	int connectAttemptCount = 0;
 	int connectFailCount = 0;
 	bool queueNotifications;
+	UPCConflator conflator;
+	UPCScheduler scheduler;
+	SessionRestorer restorer;
 
 	Version mutable serverVersion;
 	Version mutable clientVersion;
@@ -292,6 +314,7 @@ protected:
 	CBConnectionRef disconnectListener;
 	CBConnectionRef connectListener;
 	CBConnectionRef selectListener;
+	CBConnectionRef sendQueueListener;
 	CBConnectionRef ioErrorListener;
 	CBConnectionRef connectFailureListener;
 
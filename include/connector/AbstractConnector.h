@@ -8,8 +8,11 @@
 #ifndef ABSTRACTCONNECTOR_H_
 #define ABSTRACTCONNECTOR_H_
 
+#include "SendQueue.h"
+
 class AbstractConnector;
 class AbstractConnection;
+class EventLoop;
 
 typedef std::unordered_map<std::string, std::string> ConnectionAttributes;
 
@@ -18,6 +21,7 @@ typedef std::unordered_set<ConnectionProperty> ConnectionPropertySet;
 
 #define CONNECTION_PERSISTENT "persistent"
 #define CONNECTION_SECURE "secure"
+#define CONNECTION_LOCAL "local"
 
 /**
  * @class AbstractConnector AbstractConnector.h
@@ -48,6 +52,16 @@ public:
 	 */
 	virtual int Send(const std::string msg)=0;
 
+	/**
+	 * ping at the transport level on the active connection, if it can
+	 * @return less than zero if there is no active connection, or it has no ping of its own
+	 */
+	virtual int SendPing() { return -1; }
+	/**
+	 * @return round trip times from SendPing() on the active connection, or nullptr if it doesn't ping
+	 */
+	virtual const RTTStats* GetRTTStats() const { return nullptr; }
+
 	/**
 	 * virtual method implemented by subclasses to send data along a connection
 	 */
@@ -63,6 +77,15 @@ public:
 	virtual void OnConnectFailure(const CnxRef cr, const int status) {}
 	virtual void OnConnectSucceed(const CnxRef cr) {}
 	virtual void OnDisconnectSucceed(const CnxRef cr) {}
+	/**
+	 * virtual method implemented by subclasses that want to see what their connections report before their listeners do
+	 * @return false if the connector has dealt with it, and listeners shouldn't hear about it
+	 */
+	virtual bool OnConnectionEvent(const EventType e, const CnxRef cr, const std::string& data, const int status) { return true; }
+	/**
+	 * virtual method implemented by subclasses that need timers. UnionBridge passes its loop on
+	 */
+	virtual void SetEventLoop(EventLoop* l) {}
 
 	void NotifyCheckConnectFailure(const CnxRef cr, const std::string msg, const int status);
 
@@ -77,6 +100,8 @@ public:
 	void SetAllConnectionService(std::string service);
 
 protected:
+	void Adopt(CnxRef cr);
+
 	std::vector<CnxRef> connections; // or std::unique_ptr TODO
 	std::string defaultHost;
 	std::string defaultPort;
@@ -107,6 +132,30 @@ public:
 	virtual std::string GetService() const;
 	virtual void SetSessionID(const std::string s) {};
 
+	/**
+	 * overridden by transports with a ping of their own, which the ConnectionMonitor will use instead of upc heartbeats
+	 */
+	virtual int SendPing() { return -1; }
+	virtual const RTTStats* GetRTTStats() const { return nullptr; }
+	/**
+	 * overridden by transports that can have something half sent. false while hanging up now would lose or repeat outbound data
+	 */
+	virtual bool IsIdle() { return true; }
+	/**
+	 * overridden by transports where the server holds what it has for us till we come and get it. starts emptying that out ahead of a
+	 * hang up, or with false, stops
+	 * @return true once hanging up loses nothing either way. by default, IsIdle()
+	 */
+	virtual bool Drain(const bool enable=true) { return IsIdle(); }
+	/**
+	 * overridden by transports that can be kept connected in reserve. a new, unconnected copy of this one, set up the same way
+	 * @return nullptr if we can't, which is the default
+	 */
+	virtual CnxRef NewStandby() { return nullptr; }
+
+	/** the bounded queue that transports with a socket of their own send through */
+	SendQueue& GetSendQueue() { return sendQueue; }
+
 	int GetConnectState();
 	ConnectionPropertySet GetProperties();
 	void SetProperties(ConnectionPropertySet);
@@ -130,6 +179,7 @@ protected:
 	void NxIOError(const std::string msg, const int status);
 	void NxConnectFailure(const CnxRef c, const std::string msg, const int status);
 	void NxServerHangup(const CnxRef c,const  std::string msg, const int status);
+	void NxSendQueue(const bool high, const size_t bytes, const size_t count);
 
 	int nCnxSucceed;
 	int nCnxFail;
@@ -141,6 +191,7 @@ protected:
 
 	ConnectionPropertySet properties;
 	int connectState;
+	SendQueue sendQueue;
 
 	AbstractConnector* c;
 };
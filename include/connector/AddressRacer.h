@@ -0,0 +1,56 @@
+/*
+ * AddressRacer.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#ifndef ADDRESSRACER_H_
+#define ADDRESSRACER_H_
+
+#include "EventLoop.h"
+#include "DNSCache.h"
+
+class AddressRacer {
+public:
+	typedef std::function<void(const UVAddress& a, const int attempt)> StartCB;
+	typedef std::function<void(const int attempt)> AbandonCB;
+	typedef std::function<void(const int status)> FailedCB;
+
+	AddressRacer(EventLoop* l=nullptr);
+	virtual ~AddressRacer();
+
+	static UVAddresses Interleave(const UVAddresses& res, const int firstFamilyCount=1);
+
+	void Race(const UVAddresses& res, StartCB start, AbandonCB abandon, FailedCB failed);
+	bool Succeeded(const int attempt);
+	bool Failed(const int attempt, const int status);
+	void Cancel();
+	bool IsRacing() const { return racing; }
+
+	void SetAttemptDelay(const int ms);
+	int GetAttemptDelay() const { return attemptDelayMS; }
+	void SetEventLoop(EventLoop* l) { loop = l; }
+
+	/** rfc 8305 section 5: the recommended connection attempt delay, and the range it says to keep to */
+	static const int kDfltAttemptDelayMS = 250;
+	static const int kMinAttemptDelayMS = 100;
+	static const int kMaxAttemptDelayMS = 2000;
+protected:
+	void StartNext();
+	void AbandonAll(const int except);
+
+	EventLoop* loop;
+	int attemptDelayMS;
+	UVAddresses order;
+	size_t next = 0;
+	std::vector<bool> inFlight;
+	int lastStatus = 0;
+	bool racing = false;
+	TimerRef delayTimer = nullptr;
+	StartCB start;
+	AbandonCB abandon;
+	FailedCB failed;
+};
+
+#endif /* ADDRESSRACER_H_ */
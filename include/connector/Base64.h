@@ -10,6 +10,9 @@
 
 class Base64 {
 public:
+	/** STRICT takes only canonical, padded rfc 4648. LENIENT skips whitespace, doesn't need the padding, and ignores the spare bits */
+	enum DecodeMode { STRICT, LENIENT };
+
 	static char *Encode(
 			const unsigned char *data,
 			size_t inputLength,
@@ -25,22 +28,29 @@ public:
 					const unsigned char *data,
 					size_t inputLength);
 
+	static size_t Encode(const unsigned char *data, size_t inputLength, char *out);
+	static int Decode(const char *data, size_t inputLength, unsigned char *out, size_t outCapacity, size_t& outputLength, DecodeMode mode=STRICT);
+
+	static size_t EncodedLength(size_t inputLength) { return 4 * ((inputLength + 2) / 3); }
+	static size_t DecodedLength(const char *data, size_t inputLength);
+	static size_t MaxDecodedLength(size_t inputLength) { return (inputLength + 3) / 4 * 3; }
+	static const char *Engine();
+	static bool SetEngine(const std::string name);
+
+	static const int kErrInvalid = -1;
+	static const int kErrNoRoom = -2;
+
 protected:
+	typedef size_t (*EncodeBlocks)(const unsigned char *data, size_t inputLength, char *out);
+	typedef size_t (*DecodeBlocks)(const char *data, size_t inputLength, unsigned char *out, size_t outCapacity);
+
 	Base64();
 	virtual ~Base64();
 
 	static Base64 instance;
 
-	char *_Encode(
-			const unsigned char *data,
-			size_t inputLength,
-			size_t& outputLength);
-	unsigned char *_Decode(
-			const unsigned char *data,
-			size_t inputLength,
-			size_t& outputLength);
-	static char encodingTable[];
-	char *decodingTable = nullptr;
-	static int modTable[];
+	EncodeBlocks encodeBlocks = nullptr;
+	DecodeBlocks decodeBlocks = nullptr;
+	const char *engine = "scalar";
 };
 #endif /* BASE64_H_ */
@@ -33,6 +33,16 @@ public:
 	virtual void OnIOError(const std::string msg, const int status) {}
 	/** lower layer was disconnected by the network */
 	virtual void OnServerDisconnect(const std::string msg, const int status) {}
+	/** lower layer got something written, so there may be room for more */
+	virtual void OnWritten() {}
+};
+
+/**
+ * one piece of a gathered write
+ */
+struct CnxChunk {
+	const char *data;
+	size_t len;
 };
 
 /**
@@ -49,6 +59,10 @@ public:
 	virtual int Close()=0;
 	/** write on this layer, assuming that the data will be pushed through the protocol stack */
 	virtual int Write(const char *data, const size_t len)=0;
+	/** write n pieces as one, as if they were all together in one buffer */
+	virtual int WriteV(const CnxChunk *chunks, const size_t n);
+	/** bytes written to this layer, or the ones under it, that have yet to go out */
+	virtual size_t GetUnsentBytes() const { return lower? lower->GetUnsentBytes() : 0; }
 
 //	int SendHttp(std::string req, std::string host, std::string res, HTTP::Headers headers, std::string body="");
 	void DoIOError(int status, const std::string, ...) const;
@@ -0,0 +1,77 @@
+/*
+ * ConnectionScorer.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#ifndef CONNECTIONSCORER_H_
+#define CONNECTIONSCORER_H_
+
+#include <random>
+
+class ConnectionScorer {
+public:
+	/** what we know about one connection, keyed by its ShortName(), which has the transport, host and port */
+	struct Record {
+		double latency = 0;		// ms from starting a connect to the server first answering, smoothed
+		double failure = 0;		// smoothed over attempts, 1 for a failure, 0 for a success
+		double throughput = 0;	// bytes/s received over whole sessions, smoothed
+		uint64_t attempts = 0;
+		uint64_t failures = 0;
+		uint64_t sessions = 0;
+		uint64_t failureUpdated = 0;
+
+		uint64_t started = 0;	// the attempt, and then session, in progress
+		uint64_t answered = 0;
+		uint64_t bytes = 0;
+		bool active = false;
+	};
+
+	typedef std::function<uint64_t()> Clock;
+
+	static const int kDfltFailurePenaltyMS = 10000;
+	static const int kDfltThroughputCreditMS = 5;
+	static const int kMaxThroughputKBps = 100;
+	static const int kDfltFailureHalfLifeMS = 5*60*1000;
+	static const int kMinSessionMS = 1000;
+	static constexpr double kDfltProbeRate = 0.05;
+	static constexpr double kSmoothing = 0.3;
+
+	ConnectionScorer(const unsigned seed=std::random_device()());
+
+	static std::shared_ptr<ConnectionScorer> Shared();
+
+	void Rank(std::vector<CnxRef>& candidates);
+	double Cost(const std::string& key) const;
+	const Record* Find(const std::string& key) const;
+	void Reset();
+
+	void Begin(const std::string& key);
+	void Received(const std::string& key, const size_t bytes);
+	void Failed(const std::string& key);
+	void Ended(const std::string& key);
+	void Abandon(const std::string& key);
+
+	void SetProbeRate(const double p);
+	double GetProbeRate() const;
+	uint64_t GetProbeCount() const;
+	void SetWeights(const int failurePenaltyMS, const int throughputCreditMS);
+	void SetFailureHalfLife(const int ms);
+	void SetClock(Clock c);
+
+protected:
+	uint64_t Now() const;
+	double DecayedFailure(const Record& r) const;
+
+	std::unordered_map<std::string, Record> records;
+	double probeRate;
+	uint64_t probes;
+	int failurePenaltyMS;
+	int throughputCreditMS;
+	int failureHalfLifeMS;
+	std::mt19937 rng;
+	Clock clock;
+};
+
+#endif /* CONNECTIONSCORER_H_ */
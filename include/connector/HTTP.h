@@ -11,6 +11,8 @@
 #define HTTP_HEADER_CONTENT_TYPE "Content-Type"
 #define HTTP_HEADER_CONTENT_LENGTH "Content-Length"
 #define HTTP_HEADER_HOST "Host"
+#define HTTP_HEADER_ACCEPT_ENCODING "Accept-Encoding"
+#define HTTP_HEADER_CONTENT_ENCODING "Content-Encoding"
 #define HTTP_METHOD_GET "GET"
 #define HTTP_METHOD_POST "POST"
 
@@ -10,6 +10,36 @@
 
 #include "connector/CnxLayer.h"
 
+struct z_stream_s;
+
+/**
+ * @class HTTPRequestBuilder HTTPCnxLayer.h
+ * @brief lays out the requests on one channel as chunks for a gathered write, keeping the headers from one request to the next
+ */
+class HTTPRequestBuilder {
+public:
+	HTTPRequestBuilder();
+
+	void Invalidate() { stale = true; }
+	size_t Build(const std::string& method, const std::string& host, const std::string& resource, const HTTP::Headers& headers,
+			const char *body, const size_t len, CnxChunk *chunks);
+	uint64_t GetHeadBuilds() const { return headBuilds; }
+
+	static std::string Gather(const CnxChunk *chunks, const size_t n);
+
+	/** room Build() needs in chunks */
+	static const size_t kMaxChunks = 4;
+protected:
+	void MakeHead(const std::string& method, const std::string& host, const std::string& resource, const HTTP::Headers& headers);
+
+	bool stale;
+	bool hasContentLength;
+	std::string head;
+	std::string bodyHead;
+	char length[32];
+	uint64_t headBuilds;
+};
+
 class HTTPCnxLayer: public CnxLayer, public CnxLayerUpper {
 public:
 	HTTPCnxLayer(CnxLayerUpper* upper, CnxLayer* lower);
@@ -21,6 +51,33 @@ public:
 	void SetHeaders(const HTTP::Headers m) const;
 	HTTP::Response& GetResponse() const;
 
+	/**
+	 * response body counters. wire bytes are the body as it came, raw bytes the body after any Content-Encoding is undone, and the time
+	 * is spent in zlib on the io thread
+	 */
+	struct CompressionStats {
+		uint64_t responses = 0;
+		uint64_t responsesInflated = 0;
+		uint64_t rawBytesIn = 0;
+		uint64_t wireBytesIn = 0;
+		uint64_t inflateNanos = 0;
+
+		void Add(const CompressionStats& s);
+		double GetRatioIn() const { return rawBytesIn > 0? (double)wireBytesIn/rawBytesIn : 1; }
+	};
+
+	void SetCompression(const bool enable) const;
+	bool IsCompressing() const { return compression; }
+	const CompressionStats& GetCompressionStats() const;
+	void SetMaxBodySize(const size_t bytes) const;
+
+	static const char* kAcceptEncoding;
+	static const size_t kInflateChunk = 16*1024;
+	static const size_t kDefaultMaxBodySize = 16*1024*1024;
+
+	static const int kErrContentEncoding = -5;
+	static const int kErrBodyTooBig = -6;
+
 // from CnxLayerUpper
 	virtual int Receive(const char *data, const size_t len) override;
 
@@ -37,11 +94,17 @@ public:
 
 protected:
 	int ProcessHTTPResponseHeaders(const std::string rh, HTTP::Response& r);
+	void FailResponse(const int status, const std::string msg);
+	int StartBody();
+	int TakeBody(const char *data, const size_t len);
+	int Inflate(const char *data, const size_t len);
+	void EndInflate();
 
 	std::string mutable host;
 	std::string mutable resource;
 	std::string mutable method;
 	HTTP::Headers mutable headers;
+	HTTPRequestBuilder mutable builder;
 
 	std::string mutable messageBody;
 	std::string mutable responseMsg;
@@ -51,6 +114,15 @@ protected:
 	bool waitingResponseMessageBody;
 	bool hasFullResponse;
 
+	bool mutable compression;
+	enum { kIdentity, kGzip, kDeflate } bodyEncoding;
+	size_t bodyWireBytes;
+	bool rawDeflate;
+	bool inflateEnded;
+	struct z_stream_s *inflater;
+	size_t mutable maxBodySize;
+	CompressionStats stats;
+
 	int id=0;
 };
 
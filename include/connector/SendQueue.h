@@ -0,0 +1,123 @@
+/*
+ * SendQueue.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#ifndef SENDQUEUE_H_
+#define SENDQUEUE_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+
+#include "Histogram.h"
+
+class SendQueue {
+public:
+	/** priority classes for outbound upcs, most urgent first */
+	static const int kPriorityControl = 0;
+	static const int kPriorityNormal = 1;
+	static const int kPriorityBulk = 2;
+	static const int kNumPriorities = 3;
+	/** upc methods are numbered below this */
+	static const int kMaxMethod = 200;
+
+	/** what to do with a message that would take the queue over its cap */
+	static const int kPolicyReject = 0;
+	static const int kPolicyDropOldest = 1;
+	static const int kPolicyBlock = 2;
+
+	static const size_t kDfltMaxBytes = 4*1024*1024;
+	static const size_t kDfltMaxCount = 8192;
+	static const size_t kDfltWriteWindow = 64*1024;
+	static const int kDfltBlockMS = 2000;
+
+	static const int kErrQueueFull = -110;
+
+	/** hands a message to the transport */
+	typedef std::function<int(const std::string& msg)> Writer;
+	/** bytes the transport has been given that haven't gone yet */
+	typedef std::function<size_t()> Unsent;
+	/** told when the queue goes over its high watermark (true), and when it is back under its low one (false) */
+	typedef std::function<void(const bool high, const size_t bytes, const size_t count)> WatermarkCB;
+
+	SendQueue();
+
+	void Attach(Writer w, Unsent u);
+	void SetLimits(const size_t maxBytes, const size_t maxCount);
+	void SetWatermarks(const double high, const double low);
+	void SetWriteWindow(const size_t bytes);
+	void SetPolicy(const int priority, const int policy, const int blockMS=kDfltBlockMS);
+	void SetPriority(const int method, const int priority);
+	int GetPriority(const int method) const;
+	void SetWatermarkCallback(WatermarkCB cb);
+	void SetLoopThreadCheck(std::function<bool()> check);
+
+	int Send(const std::string& msg);
+	void Flush();
+	void Clear();
+
+	size_t GetBytes() const;
+	size_t GetCount() const;
+	bool IsHigh() const;
+
+	/** counts for the queue. blocked waits are in ms */
+	struct Stats {
+		uint64_t queued = 0;
+		uint64_t sent = 0;
+		uint64_t rejected = 0;
+		uint64_t dropped = 0;
+		uint64_t blocked = 0;
+		uint64_t highs = 0;
+		size_t peakBytes = 0;
+		size_t peakCount = 0;
+		Histogram blockedMS;
+	};
+	Stats GetStats() const;
+	void ResetStats();
+
+	static int Method(const std::string& msg);
+
+protected:
+	/** a message waiting for the transport */
+	struct Queued {
+		std::string msg;
+		int priority;
+	};
+
+	bool Fits(const size_t len) const;
+	bool DropOldest(const size_t len);
+	void Took(const size_t len);
+	void Gave(const size_t len);
+	int Watermark();
+	void Notify(const int mark, const size_t b, const size_t c);
+
+	std::recursive_mutex mutable lock;
+	std::condition_variable_any room;
+	std::deque<Queued> queue;
+	size_t bytes = 0;
+	int flushing = 0;
+	uint64_t epoch = 0;
+	bool high = false;
+
+	size_t maxBytes = kDfltMaxBytes;
+	size_t maxCount = kDfltMaxCount;
+	double highMark = 0.75;
+	double lowMark = 0.25;
+	size_t writeWindow = kDfltWriteWindow;
+	int policy[kNumPriorities];
+	int blockMS[kNumPriorities];
+	int priority[kMaxMethod];
+
+	Writer writer;
+	Unsent unsent;
+	WatermarkCB onWatermark;
+	std::function<bool()> onLoopThread;
+	Stats stats;
+};
+
+#endif /* SENDQUEUE_H_ */
@@ -9,9 +9,23 @@
 #define STANDARDCONNECTOR_H_
 class UVWSConnection;
 class UPCHTTPConnection;
+class ConnectionScorer;
 
 class StandardConnector: public AbstractConnector {
 public:
+	typedef std::function<uint64_t()> Clock;
+	struct UpgradeStats {
+		uint64_t probes = 0;
+		uint64_t probeFailures = 0;
+		uint64_t upgrades = 0;
+	};
+	struct StandbyStats {
+		uint64_t starts = 0;
+		uint64_t failures = 0;
+		uint64_t refreshes = 0;
+		uint64_t promotions = 0;
+	};
+
 	StandardConnector(std::string dfltHost="", std::string dfltPort="");
 	virtual ~StandardConnector();
 
@@ -20,6 +34,8 @@ public:
 	virtual int Connect() override;
 	virtual int Disconnect() override;
 	virtual int Send(const std::string msg) override;
+	virtual int SendPing() override;
+	virtual const RTTStats* GetRTTStats() const override;
 
 	virtual void SetActiveConnectionSessionID(std::string) override;
 	virtual void SetConnectionAffinity(std::string affinityAddress, int durationSec) override;
@@ -27,16 +43,131 @@ public:
 	virtual void OnConnectFailure(const CnxRef cr, const int status) override;
 	virtual void OnConnectSucceed(const CnxRef cr) override;
 	virtual void OnDisconnectSucceed(const CnxRef cr) override;
+	virtual bool OnConnectionEvent(const EventType e, const CnxRef cr, const std::string& data, const int status) override;
+	virtual void SetEventLoop(EventLoop* l) override;
 
 	void SetConnectionPriorities(std::vector<ConnectionPropertySet> pri);
 	int GetConnectionFailLimit() { return connectionFailLimit;  }
 	void SetConnectionFailLimit(int n) { connectionFailLimit = n; }
+
+	void SetRacing(const bool enable, const int staggerMS=kDfltRaceStaggerMS);
+	bool IsRacing() const { return racing; }
+	int GetRaceStagger() const { return raceStaggerMS; }
+	const Histogram& GetTimeToReady(const int strategy) const;
+	void ResetStats();
+
+	void SetScorer(std::shared_ptr<ConnectionScorer> s);
+	std::shared_ptr<ConnectionScorer> GetScorer() const;
+
+	void SetUpgradeProbe(const int intervalMS=kDfltUpgradeProbeMS);
+	int GetUpgradeProbe() const { return upgradeProbeMS; }
+	const UpgradeStats& GetUpgradeStats() const { return upgradeStats; }
+	uint64_t GetConnectedTime(const std::string shortName) const;
+	void SetClock(Clock c);
+
+	void SetWarmStandby(const bool enable, const int refreshMS=kDfltStandbyRefreshMS);
+	bool IsWarmStandby() const { return standbyRefreshMS > 0; }
+	bool IsStandbyReady() const { return standbyReady; }
+	const StandbyStats& GetStandbyStats() const { return standbyStats; }
+	const Histogram& GetFailoverGap(const bool warm) const;
+
+	static const int kDfltRaceStaggerMS = 250;
+	static const int kDfltUpgradeProbeMS = 60000;
+	/** most the probe interval is multiplied by after failed probes */
+	static const int kMaxUpgradeBackoff = 8;
+	/** how often to look for a gap in the traffic, once there is somewhere better to go */
+	static const int kUpgradeRetryMS = 100;
+	/** how many kUpgradeRetryMS a connection we've left gets to see its TERMINATE_SESSION off, before we hang up regardless */
+	static const int kMaxRetireTries = 20;
+	/** how long a warm standby is kept before it is hung up and made again, so it doesn't go stale in a nat or proxy table */
+	static const int kDfltStandbyRefreshMS = 45000;
+	/** how a connection was arrived at, for GetTimeToReady() */
+	static const int kStrategySequential = 0;
+	static const int kStrategyRace = 1;
+	static const int kNumStrategies = 2;
 protected:
+	std::vector<CnxRef> Candidates();
+	int ConnectRace(const std::vector<CnxRef>& candidates);
+	void StartNextRacer();
+	bool RacerFailed(const CnxRef cr);
+	void CommitRacer(const CnxRef cr);
+	void AbortRace(const CnxRef keep);
+	void NoteReady();
+	void Score(const EventType e, const CnxRef cr, const std::string& data);
+	CnxRef UpgradeCandidate();
+	void ScheduleUpgradeProbe();
+	void StartUpgradeProbe();
+	bool ProbeEvent(const EventType e, const CnxRef cr);
+	void TryUpgrade();
+	void CancelUpgrade();
+	void Retire(const CnxRef cr, const int tries=0);
+	void StopRetiring();
+	void EndSession();
+	CnxRef Spare(const CnxRef cr);
+	void StartStandby();
+	void ScheduleStandby(const int delayMS);
+	bool StandbyEvent(const EventType e, const CnxRef cr);
+	void StopStandby();
+	bool Failover(const CnxRef from, const std::string& msg);
+	int ConnectPromoted();
+	/**
+	 * the standby to has been swapped in for from, in the connection list. for subclasses that keep their own pointers to either
+	 */
+	virtual void OnStandbyPromoted(const CnxRef from, const CnxRef to) {}
+
 	std::vector<ConnectionPropertySet> connectionPriorities;
 	AbstractConnection* activeConnection;
 	int connectionFailLimit;
 	std::unordered_set<CnxRef> attempted;
 	std::unordered_set<CnxRef> failedSinceConnect;
+
+	EventLoop* loop = nullptr;
+	bool racing = false;
+	int raceStaggerMS = kDfltRaceStaggerMS;
+	std::vector<CnxRef> racers;
+	size_t nextRacer = 0;
+	std::unordered_set<CnxRef> raceFailed;
+	std::unordered_set<CnxRef> losers;
+	std::vector<std::string> firstFlight;
+	bool raceConnected = false;
+	CnxRef raceFrom = nullptr;
+	TimerRef staggerTimer = nullptr;
+
+	bool awaitingReady = false;
+	int connectStrategy = kStrategySequential;
+	uint64_t connectStart = 0;
+	Histogram timeToReady[kNumStrategies];
+
+	std::shared_ptr<ConnectionScorer> scorer;
+
+	int upgradeProbeMS = 0;
+	int upgradeBackoff = 1;
+	CnxRef probing = nullptr;
+	bool probeClosing = false;
+	CnxRef upgradeTo = nullptr;
+	CnxRef preferred = nullptr;
+	TimerRef upgradeTimer = nullptr;
+	UpgradeStats upgradeStats;
+	CnxRef retiring = nullptr;
+	TimerRef retireTimer = nullptr;
+
+	CnxRef sessionCnx = nullptr;
+	uint64_t sessionStart = 0;
+	std::unordered_map<std::string, uint64_t> connectedTime;
+	Clock clock;
+
+	int standbyRefreshMS = 0;
+	std::vector<CnxRef> spares;
+	CnxRef standby = nullptr;
+	bool standbyReady = false;
+	bool standbyClosing = false;
+	TimerRef standbyTimer = nullptr;
+	CnxRef promoted = nullptr;
+	TimerRef promoteTimer = nullptr;
+	StandbyStats standbyStats;
+	uint64_t failoverAt = 0;
+	bool failoverWarm = false;
+	Histogram failoverGap[2];
 };
 
 class StandardUVConnector: public StandardConnector {
@@ -44,9 +175,13 @@ public:
 	StandardUVConnector(std::string dfltHost="", std::string dfltPort="");
 	virtual ~StandardUVConnector();
 	virtual void SetConnectionAffinity(std::string host, int durationSec);
+	UVWSConnection* AddLocalConnection(const std::string path);
 protected:
+	virtual void OnStandbyPromoted(const CnxRef from, const CnxRef to) override;
+
 	UVWSConnection* wsConnection;
 	UPCHTTPConnection* httpConnection;
+	UVWSConnection* localConnection = nullptr;
 };
 
 #endif /* STANDARDCONNECTOR_H_ */
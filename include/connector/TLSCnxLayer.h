@@ -0,0 +1,129 @@
+/*
+ * TLSCnxLayer.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#ifndef TLSCNXLAYER_H_
+#define TLSCNXLAYER_H_
+
+#include "CnxLayer.h"
+#include "Histogram.h"
+
+struct ssl_st;
+struct ssl_ctx_st;
+struct ssl_session_st;
+struct bio_st;
+
+/**
+ * @class TLSContext TLSCnxLayer.h
+ * @brief the SSL_CTX, trust settings and session cache that TLSCnxLayers share
+ */
+class TLSContext {
+public:
+	typedef std::function<uint64_t()> Clock;
+	struct Stats {
+		uint64_t handshakes = 0;
+		uint64_t resumed = 0;
+		uint64_t failures = 0;
+		Histogram fullMicros;
+		Histogram resumedMicros;
+
+		double GetResumptionRate() const { return handshakes > 0? (double)resumed/handshakes : 0; }
+	};
+
+	TLSContext();
+	virtual ~TLSContext();
+
+	static std::shared_ptr<TLSContext> Shared();
+
+	bool AddTrustedCertificate(const std::string pem);
+	void SetVerifyPeer(const bool verify) { verifyPeer = verify; }
+	bool GetVerifyPeer() const { return verifyPeer; }
+	void SetSessionResumption(const bool enable);
+	bool GetSessionResumption() const { return resumption; }
+	void FlushSessions();
+	size_t GetSessionCount();
+
+	const Stats& GetStats() const { return stats; }
+	void ResetStats();
+	void SetClock(Clock c) { clock = c; }
+	uint64_t NowMicros() const { return clock(); }
+
+	ssl_ctx_st* Get() const { return ctx; }
+	ssl_session_st* FindSession(const std::string key);
+	void StoreSession(const std::string key, ssl_session_st* s);
+	void NoteHandshake(const bool resumed, const uint64_t micros);
+	void NoteFailure() { stats.failures++; }
+
+protected:
+	static int OnNewSession(ssl_st* ssl, ssl_session_st* s);
+
+	ssl_ctx_st* ctx;
+	bool verifyPeer;
+	bool resumption;
+	Stats stats;
+	Clock clock;
+	std::unordered_map<std::string, ssl_session_st*> sessions;
+	std::mutex lock;
+};
+
+/**
+ * @class TLSCnxLayer TLSCnxLayer.h
+ * @brief tls between a socket layer and a protocol layer, done in memory with OpenSSL bios
+ */
+class TLSCnxLayer: public CnxLayer, public CnxLayerUpper
+{
+public:
+	TLSCnxLayer(CnxLayerUpper* upper, CnxLayer* lower, std::shared_ptr<TLSContext> c=TLSContext::Shared());
+	virtual ~TLSCnxLayer();
+
+	virtual int Open() override;
+	virtual int Write(const char *data, const size_t len) override;
+	virtual int WriteV(const CnxChunk *chunks, const size_t n) override;
+	virtual int Close() override;
+
+	virtual int Receive(const char *data, const size_t len) override;
+	virtual void OnOpen() override;
+	virtual void OnClose() override;
+	virtual void OnOpenFailure(const std::string msg, const int status) override;
+	virtual void OnIOError(const std::string msg, const int status) override;
+	virtual void OnServerDisconnect(const std::string msg, const int status) override;
+	virtual void OnWritten() override { if (upper) upper->OnWritten(); }
+
+	void SetHost(const std::string h) const;
+	void SetService(const std::string s) const;
+	void SetContext(std::shared_ptr<TLSContext> c);
+	std::shared_ptr<TLSContext> GetContext() const { return context; }
+	bool IsResumed() const { return resumed; }
+	std::string SessionKey() const { return host + ":" + service; }
+
+	static const int kErrHandshake = -201;
+	static const int kErrTLS = -202;
+	static const size_t kReadChunk = 16*1024;
+
+protected:
+	bool Start();
+	void Handshake();
+	void ReadPlain();
+	void Flush();
+	void Reset();
+	std::string LastError() const;
+
+	std::shared_ptr<TLSContext> context;
+	ssl_st* ssl;
+	bio_st* rbio;
+	bio_st* wbio;
+	bool handshaking;
+	bool resumed;
+	bool failed;
+	uint64_t handshakeStart;
+	std::string pending;
+	std::string gathered;
+
+	std::string mutable host;
+	std::string mutable service;
+};
+
+#endif /* TLSCNXLAYER_H_ */
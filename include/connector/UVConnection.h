@@ -11,13 +11,51 @@
 #include "AbstractConnector.h"
 #include "connector/CnxLayer.h"
 #include "connector/HTTPCnxLayer.h"
+#include "connector/AddressRacer.h"
+#include "connector/TLSCnxLayer.h"
 
 #include <stdint.h>
+#include <atomic>
+#include <deque>
+#include <functional>
 #include <list>
+#include <map>
+#include <memory>
+#include <mutex>
 
 #include "UVForwards.h"
 
 
+/**
+ * what a layer's write completions reach it through. the layer cancels it as it goes, so a completion that turns up later finds nobody
+ * to tell
+ */
+class WriteCompletions {
+public:
+	typedef std::function<void(const size_t n)> WrittenCB;
+	WriteCompletions(WrittenCB w);
+
+	void Done(const size_t n);
+	void Cancel();
+protected:
+	std::recursive_mutex lock;
+	WrittenCB written;
+};
+
+/**
+ * the same, for a layer waiting on the DNSCache
+ */
+class ResolveWaiter {
+public:
+	ResolveWaiter(ResolverCB r);
+
+	void Done(const UVAddresses& res, int status);
+	void Cancel();
+protected:
+	std::recursive_mutex lock;
+	ResolverCB resolved;
+};
+
 class UVCnxLayer: public CnxLayer, public UVTCPClient
 {
 public:
@@ -26,19 +64,64 @@ public:
 
 	virtual int Open() override;
 	virtual int Write(const char *data, const size_t len) override;
+	virtual int WriteV(const CnxChunk *chunks, const size_t n) override;
 	virtual int Close() override;
+	virtual size_t GetUnsentBytes() const override { return unsent; }
 
 	void SetHost(const std::string h) const;
 	void SetService(const std::string s) const;
+	void SetAttemptDelay(const int ms) { racer.SetAttemptDelay(ms); }
+
+	/** most pieces a WriteV() hands to the loop as they are */
+	static const size_t kMaxGather = 8;
 protected:
-	int	DoConnection();
+	int	DoConnection(const UVAddresses& res);
+	void StartAttempt(const UVAddress& a, const int attempt);
+	void Abandon(UVTCPClient* c);
+	void Dispose(UVTCPClient* c);
+	void Written(const size_t n);
 
 	std::string mutable host;
 	std::string mutable service;
 
 	int id;
 
-	bool mutable hasResolvedAddress=false;
+	AddressRacer racer;
+	std::vector<UVTCPClient*> attempts;
+	UVTCPClient* live;
+	std::atomic<size_t> unsent;
+	std::shared_ptr<WriteCompletions> completions;
+	std::shared_ptr<ResolveWaiter> resolving;
+};
+
+class UVPipeCnxLayer: public CnxLayer, public UVTCPClient
+{
+public:
+	UVPipeCnxLayer(CnxLayerUpper* upper, std::string p="");
+	virtual ~UVPipeCnxLayer();
+
+	virtual int Open() override;
+	virtual int Write(const char *data, const size_t len) override;
+	virtual int WriteV(const CnxChunk *chunks, const size_t n) override;
+	virtual int Close() override;
+	virtual size_t GetUnsentBytes() const override { return unsent; }
+
+	void SetPath(const std::string p) const;
+	const std::string& GetPath() const { return path; }
+
+	static bool IsPipeEndpoint(const std::string host);
+	static std::string PipePath(const std::string host);
+	/** what a host starts with to say it is a unix domain socket, eg unix:/var/run/union.sock */
+	static const char* kUnixScheme;
+	/** the Host: header sent over a pipe */
+	static const char* kPipeHostHeader;
+protected:
+	void Written(const size_t n);
+
+	std::string mutable path;
+	int id;
+	std::atomic<size_t> unsent;
+	std::shared_ptr<WriteCompletions> completions;
 };
 
 
@@ -47,6 +130,19 @@ public:
 	UVWSConnection(std::string service="", std::string host="");
 	~UVWSConnection();
 
+	void SetCompression(const bool enable, const size_t threshold=WSCnxLayer::kDefaultDeflateThreshold);
+	const WSCnxLayer::CompressionStats& GetCompressionStats() const;
+	void SetFastOpen(const bool enable) { ws.SetFastOpen(enable); }
+	bool IsFastOpen() const { return ws.IsFastOpen(); }
+	/** bytes handed to the socket that haven't gone yet. the send queue holds anything past its write window */
+	size_t GetUnsentBytes() const { return ws.GetUnsentBytes(); }
+	void SetSecure(const bool enable, std::shared_ptr<TLSContext> c=TLSContext::Shared());
+	bool IsSecure() const { return secure; }
+
+	virtual int SendPing() override;
+	virtual const RTTStats* GetRTTStats() const override;
+	virtual CnxRef NewStandby() override;
+
 protected:
 	virtual int Connect()override;
 	virtual int Disconnect()override;
@@ -64,14 +160,23 @@ protected:
 	virtual void OnOpenFailure(const std::string msg, const int status) override;
 	virtual void OnIOError(const std::string msg, const int status) override;
 	virtual void OnServerDisconnect(const std::string msg, const int status) override;
+	virtual void OnWritten() override;
+
+	void Relink();
 
 	WSCnxLayer ws;
 	UVCnxLayer uv;
+	TLSCnxLayer tls;
+	UVPipeCnxLayer pipe;
+	bool secure = false;
 };
 
 class UVHTTPCnxUpper: public CnxLayer, public CnxLayerUpper
 {
 public:
+	/** lays a run of batched pieces out as a request body, onto the end of request */
+	typedef std::function<void(std::string& request, const std::string& batch)> Framer;
+
 	UVHTTPCnxUpper(CnxLayerUpper* upper, const std::string host="",  const std::string resource="", const std::string service="");
 	virtual ~UVHTTPCnxUpper();
 
@@ -79,12 +184,29 @@ public:
 	virtual int Write(const char *data, const size_t len) override;
 	virtual int Close() override;
 
+	int WriteBatched(const char *data, const size_t len);
+	int WriteBatched(std::string&& piece);
+	void SetBatching(Framer f, const size_t maxBody=kDfltMaxBatchBytes);
+	void SetEventLoop(EventLoop* l);
+	void SetTransport(CnxLayer* t);
+	void SetSecure(const bool enable, std::shared_ptr<TLSContext> c=TLSContext::Shared());
+	uint64_t GetRequestCount() const { return requestCount; }
+	void SetCompression(const bool enable) const { http.SetCompression(enable); }
+	const HTTPCnxLayer::CompressionStats& GetCompressionStats() const { return http.GetCompressionStats(); }
+
 	void SetHost(const std::string host) const;
 	void SetResource(const std::string resource) const;
 	void SetMethod(const std::string m) const;
 	void SetService(const std::string service) const;
 
 	void SetNotifyReceipt(bool);
+	bool IsIdle() const;
+	virtual size_t GetUnsentBytes() const override;
+
+	static const size_t kDfltMaxBatchBytes = 64*1024;
+	static const int kRetryMS = 250;
+	static const int kMaxRetryMS = 8000;
+	static const int kMaxRetries = 6;
 protected:
 	virtual int Receive(const char *data, const size_t len) override;
 	virtual void OnOpen() override;
@@ -94,20 +216,61 @@ protected:
 	virtual void OnServerDisconnect(const std::string msg, const int status) override;
 
 	int CheckQAndWrite();
+	int SendRequest();
+	void RetryRequest(const std::string msg, const int status);
+	void Relink();
 
 	UVCnxLayer uv;
 	HTTPCnxLayer http;
+	TLSCnxLayer tls;
+	UVPipeCnxLayer pipe;
+	bool secure = false;
+	CnxLayer* transport = nullptr;
+	std::string mutable host;
 
 	class UVLock *queueLock;
-	std::list<std::string> messageQueue;
+	std::deque<std::string> messageQueue;
+	std::deque<std::string> batchQueue;
+	std::string request;
+	std::string batch;
+	bool busy = false;
+
+	Framer framer;
+	size_t maxBatch = kDfltMaxBatchBytes;
 
-	int mutable retryDelay;
+	EventLoop* loop;
+	TimerRef retryTimer = nullptr;
+	int retries = 0;
+	int retryMS = kRetryMS;
+	uint64_t requestCount = 0;
 
 	bool notifyReceipt;
 };
 
+class UPCHTTPConnection;
+
+class UPCHTTPPoll: public CnxLayerUpper
+{
+public:
+	UPCHTTPPoll(UPCHTTPConnection* cnx);
+	virtual ~UPCHTTPPoll();
+
+	virtual int Receive(const char *data, const size_t len) override;
+	virtual void OnOpenFailure(const std::string msg, const int status) override;
+	virtual void OnIOError(const std::string msg, const int status) override;
+	virtual void OnServerDisconnect(const std::string msg, const int status) override;
+
+	UPCHTTPConnection* cnx;
+	UVHTTPCnxUpper* http;
+	/** the request out on this one, 0 if none */
+	int rid = 0;
+	/** times in a row that request has failed */
+	int errors = 0;
+};
+
 class UPCHTTPConnection: public AbstractConnection, public CnxLayerUpper
 {
+	friend class UPCHTTPPoll;
 public:
 	UPCHTTPConnection(const std::string host="",  const std::string resource="", const std::string service="");
 	virtual ~UPCHTTPConnection();
@@ -116,7 +279,19 @@ public:
 	void SetResource(const std::string) const;
 	virtual void SetHost(const std::string host) const override;
 	virtual void SetService(const std::string service) const override;
-
+	virtual bool IsIdle() override;
+	virtual bool Drain(const bool enable=true) override;
+
+	void SetPollDepth(const int n);
+	int GetPollDepth() const { return pollDepth; }
+	void SetMaxSendBatch(const size_t bytes);
+	void SetSecure(const bool enable, std::shared_ptr<TLSContext> c=TLSContext::Shared());
+	bool IsSecure() const { return secure; }
+	void SetCompression(const bool enable);
+	HTTPCnxLayer::CompressionStats GetCompressionStats() const;
+
+	static const int kMaxPollDepth = 4;
+	static const int kMaxPollRetries = 3;
 protected:
 	virtual int Connect()override;
 	virtual int Disconnect()override;
@@ -130,18 +305,36 @@ protected:
 	virtual void OnOpenFailure(const std::string msg, const int status) override;
 	virtual void OnIOError(const std::string msg, const int status) override;
 	virtual void OnServerDisconnect(const std::string msg, const int status) override;
+	virtual void OnWritten() override;
 
-	int ModeCRequest();
+	int Transmit(const std::string& msg);
+	virtual UVHTTPCnxUpper* NewPollLayer(CnxLayerUpper* poll);
+	int PollReceive(UPCHTTPPoll* poll, const char *data, const size_t len);
+	void PollIOError(UPCHTTPPoll* poll, const std::string msg, const int status);
+	void ClosePolls();
+	void FillPolls();
+	int ModeCRequest(UPCHTTPPoll* poll, const int rid=0);
 
 	bool initialRequest = true;
 
 	int sRequestIndex;
 	int cRequestIndex;
 
-	UVHTTPCnxUpper httpRx;
+	std::vector<UPCHTTPPoll*> polls;
+	int pollDepth = 1;
+	size_t maxSendBatch = UVHTTPCnxUpper::kDfltMaxBatchBytes;
+	bool pollIdle = false;
+	bool draining = false;
+	bool drained = false;
+	int nextPollRid = 1;
+	std::map<int, std::string> pollEarly;
 	UVHTTPCnxUpper httpTx;
+	bool secure = false;
+	bool compression = true;
+	std::shared_ptr<TLSContext> tlsContext;
 
 	std::string mutable sessionID;
+	std::string mutable resource;
 };
 
 #endif /* UVCONNECTOR_H_ */
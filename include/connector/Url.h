@@ -15,6 +15,11 @@ public:
 			size_t inputLength,
 			size_t& outputLength);
 	static std::string Encode(std::string);
+	static size_t Encode(const char *data, size_t inputLength, char *out);
+	static void AppendEncoded(std::string& out, const char *data, size_t inputLength);
+	static void AppendEncoded(std::string& out, const std::string& s) { AppendEncoded(out, s.data(), s.size()); }
+	/** room Encode() needs for inputLength bytes, at worst */
+	static size_t MaxEncodedLength(size_t inputLength) { return inputLength*3; }
 	static char *Decode(
 			const char* data,
 			size_t inputLength,
@@ -22,6 +27,7 @@ public:
 	static std::string Decode(std::string);
 protected:
 	static Url instance;
+	static const char kSafe[256];
 
 	Url();
 	virtual ~Url();
@@ -10,6 +10,8 @@
 
 #include "CnxLayer.h"
 
+struct z_stream_s;
+
 class WSCnxLayer: public CnxLayer, public CnxLayerUpper
 {
 public:
@@ -26,15 +28,55 @@ public:
 	virtual void OnOpenFailure(const std::string msg, const int status) override;
 	virtual void OnIOError(const std::string msg, const int status) override;
 	virtual void OnServerDisconnect(const std::string msg, const int status) override;
+	virtual void OnWritten() override { if (upper) upper->OnWritten(); }
 
 	void SetHost(const std::string h) const;
 	void SetResource(const std::string r) const;
 
+	/**
+	 * permessage-deflate counters. the ratios are wire bytes over raw bytes for the messages that went through zlib, and the times are
+	 * the wall clock spent in zlib on the io thread, which is as near to cpu time as makes no difference
+	 */
+	struct CompressionStats {
+		uint64_t messagesDeflated = 0;
+		uint64_t messagesInflated = 0;
+		uint64_t messagesUnderThreshold = 0;
+		uint64_t rawBytesOut = 0;
+		uint64_t wireBytesOut = 0;
+		uint64_t rawBytesIn = 0;
+		uint64_t wireBytesIn = 0;
+		uint64_t deflateNanos = 0;
+		uint64_t inflateNanos = 0;
+
+		double GetRatioOut() const { return rawBytesOut > 0? (double)wireBytesOut/rawBytesOut : 1; }
+		double GetRatioIn() const { return rawBytesIn > 0? (double)wireBytesIn/rawBytesIn : 1; }
+	};
+
+	void SetCompression(const bool enable, const size_t threshold=kDefaultDeflateThreshold);
+	void SetCompressionWindowBits(const int bits);
+	void SetNoContextTakeover(const bool client, const bool server);
+	void SetMaxMessageSize(const size_t bytes);
+	bool IsCompressing() const;
+	const CompressionStats& GetCompressionStats() const;
+	void CopySettings(const WSCnxLayer& from);
+
+	void SetFastOpen(const bool enable);
+	bool IsFastOpen() const;
+
+	int SendPing();
+	const RTTStats& GetRTTStats() const;
+
 	static const char* WSGUID;
 
+	static const size_t kDefaultDeflateThreshold = 128;
+	static const size_t kDefaultMaxMessageSize = 16*1024*1024;
+
 	static const int kErrFrameTooShort = -101;
 	static const int kErrBadOpcode = -102;
 	static const int kErrWebsocketNotAccepted = -103;
+	static const int kErrInflate = -104;
+	static const int kErrBadControlFrame = -105;
+	static const int kErrMessageTooBig = -106;
 
 protected:
 	static const unsigned kWSContinue = 0x0;
@@ -43,13 +85,26 @@ protected:
 	static const unsigned kWSCnxClose = 0x8;
 	static const unsigned kWSPing = 0x9;
 	static const unsigned kWSPong = 0xa;
+	static const unsigned kWSRsv1 = 0x40;
+	static const unsigned kWSMaxControlPayload = 125;
+	static const uint16_t kWSCloseNormal = 1000;
+	static const uint16_t kWSCloseProtocolError = 1002;
+	static const uint16_t kWSCloseMessageTooBig = 1009;
 
-	void ProcessHTTPResponse(const std::string& response);
+	int ProcessHTTPResponse(const std::string& response);
 	int ProcessWSRxFrame(char *msgBytes, const uint64_t msgLen);
-	int DoWSWrite(const int msgType, const char *msg, const uint64_t len, const bool doMask);
+	int DoWSWrite(const int msgType, const char *msg, const uint64_t len, const bool doMask, const bool compressed=false);
+	int DoWSClose(const uint16_t status);
+	void OnPong(const char *data, const uint64_t len);
 
 	std::string MakeWSKey() const;
 
+	std::string DeflateOffer() const;
+	void NegotiateDeflate(const HTTP::Response& r);
+	bool Deflate(const char *data, const size_t len);
+	int Inflate(const char *data, const size_t len);
+	void EndDeflate();
+
 	std::string mutable host;
 
 	std::string mutable key;
@@ -60,6 +115,31 @@ protected:
 	std::vector<char> stashedBytes;
 	std::vector<char> rxData;
 	int rxType;
+	bool rxCompressed;
+
+	bool deflateRequested;
+	size_t deflateThreshold;
+	int deflateWindowBits;
+	size_t maxMessageSize;
+	bool requestClientNoContextTakeover;
+	bool requestServerNoContextTakeover;
+
+	bool deflateActive;
+	bool deflateOutbound;
+	bool clientNoContextTakeover;
+	bool serverNoContextTakeover;
+	struct z_stream_s *deflater;
+	struct z_stream_s *inflater;
+	std::vector<char> deflated;
+	std::vector<char> inflated;
+
+	CompressionStats stats;
+
+	RTTStats rtt;
+	uint64_t firstPingSent;
+
+	bool fastOpen;
+	bool speculative;
 };
 
 
@@ -20,10 +20,10 @@ AttributeManager::AttributeManager(/*AttributeOwner&owner, UnionBridge& unionBri
 {
 	DEBUG_OUT("AttributeManager::AttributeManager()");
 
-	updateAttributeListener = std::make_shared<CBAttrInfo>([this](EventType t, AttrName n, AttrVal v, AttrScope s, AttrVal ov, ClientRef c, UPCStatus status) {
+	updateAttributeListener = std::make_shared<CBAttrInfo>([this](EventType t, const AttrName& n, const AttrVal& v, const AttrScope& s, const AttrVal& ov, const ClientRef& c, UPCStatus status) {
 		NotifyListeners(t, n, v, s, ov, c, status);
 	});
-	deleteAttributeListener = std::make_shared<CBAttrInfo>([this](EventType t, AttrName n, AttrVal v, AttrScope s, AttrVal ov, ClientRef c, UPCStatus status) {
+	deleteAttributeListener = std::make_shared<CBAttrInfo>([this](EventType t, const AttrName& n, const AttrVal& v, const AttrScope& s, const AttrVal& ov, const ClientRef& c, UPCStatus status) {
 		NotifyListeners(t, n, v, s, ov, c, status);
 	});
 	RegisterAttributeListeners();
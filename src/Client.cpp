@@ -268,7 +268,8 @@ Client::Synchronize(const ClientManifest &clientManifest) const
 }
 
 /**
- * adds a room specific message listener to the UnionBridge notifiers
+ * adds a client specific message listener to the UnionBridge notifiers ... it hears messages sent by this client, as well as
+ * messages with no particular target
  */
 CBModMsgRef
 Client::AddMessageListener(const UserMessageID message, const CBModMsg listener) const {
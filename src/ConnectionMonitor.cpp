@@ -12,6 +12,7 @@
 #include <climits>
 #include <cstdlib>
 #include <random>
+#include <algorithm>
 
 #include "UCUpperHeaders.h"
 
@@ -21,13 +22,24 @@ const UserMessageID ConnectionMonitor::kClientHeartbeat = "CLIENT_HEARTBEAT";
 /**
  * @class ConnectionMonitor ConnectionMonitor.h
  * @brief Handles the heartbeat, connection timeout and reconnection logic
+ *
+ * if the connection has a ping of its own (websocket does), the heartbeat uses that rather than a CLIENT_HEARTBEAT round trip through the
+ * server's message handling. otherwise, upc heartbeats are stamped with uv_hrtime() in a small ring, and the server has to answer them in order
+ *
+ * _PING is the smoothed round trip, in ms. every write of it goes out to everyone watching us, so it is only published when it has moved by
+ * more than the publish delta, or it hasn't been sent for the publish interval
+ *
+ * the wait between automatic reconnect attempts comes from a ReconnectPolicy. the default backs off, with jitter, so that a server coming back
+ * up isn't met by every client it lost at once. the backoff only starts over once a connection has stayed up for the stable connection period
  */
 ConnectionMonitor::ConnectionMonitor(ClientManager& clientManager, UnionBridge& bridge, ILogger& l)
-	: clientManager(clientManager)
+	: reconnectPolicy(std::make_shared<BackoffReconnectPolicy>())
+	, clientManager(clientManager)
 	, unionBridge(bridge)
 	, loop(nullptr)
 	, log(l)
 	, readyTimeout(5000)
+	, clock([]() { return uv_hrtime(); })
 {
 	DEBUG_OUT("ConnectionMonitor::ConnectionMonitor()");
 }
@@ -36,29 +48,31 @@ void
 ConnectionMonitor::AddSelfListeners()
 {
 	beginCnxListener = unionBridge.AddUPCListener(Event::BEGIN_CONNECT,
-			[this](EventType t,  StringArgs a, UPCStatus status) {
+			[this](EventType t, const StringArgs& a, UPCStatus status) {
 		log.Debug("ConnectionMonitor::beginCnxListener()");
 		StartReadyTimer();
 	});
 
 	readyListener = unionBridge.AddUPCListener(Event::READY,
-			[this](EventType e, StringArgs args, UPCStatus s) {
+			[this](EventType e, const StringArgs& args, UPCStatus s) {
 		log.Debug("ConnectionMonitor::readyListener()");
+		readyAt = Now();
+		if (droppedAt != 0) {
+			reconnectStats.reconnects++;
+			reconnectStats.timeToReconnect.Add((readyAt - droppedAt)/1000000);
+			droppedAt = 0;
+		}
 		StartHeartbeat();
 		CancelReadyTimer();
 		StopReconnect();
 		log.Debug("ConnectionMonitor::readyListener() done");
 	});
 	heartbeatMessageListener = unionBridge.AddMessageListener(kClientHeartbeat,
-			[this] (UserMessageID mid, StringArgs a) {
-		if (a.size() < 1) return;
-		int id = atoi(a[0].c_str());
-		int ping = (int)(std::time(nullptr) - heartbeats[id]);
-		GetSelf()->SetAttribute("_PING", std_to_string(ping),"", sharedPing);
-		heartbeats.erase(id);
+			[this] (const UserMessageID& mid, const StringArgs& a) {
+		HeartbeatMessageListener(mid, a);
 	});
 	closedListener = unionBridge.AddUPCListener(Event::CONNECT_FAILURE,
-			[this](EventType e, StringArgs args, UPCStatus s) {
+			[this](EventType e, const StringArgs& args, UPCStatus s) {
 		log.Debug("ConnectionMonitor caught the disconnection");
 		StopHeartbeat();
 		if (unionBridge.GetConnectionState() == ConnectionState::DISCONNECTION_IN_PROGRESS) {
@@ -67,10 +81,28 @@ ConnectionMonitor::AddSelfListeners()
 		if (s == UPC::Status::NO_VALID_CONNECTION_AVAILABLE) {
 			return;
 		}
-		int numAttempts = unionBridge.GetConnectAttemptCount();
-		if (numAttempts == 0) {
-			SelectReconnectFrequency();
+		if (readyAt != 0) {
+			uint64_t now = Now();
+			if (now - readyAt >= (uint64_t)stableConnectionPeriod*1000000) {
+				reconnectPolicy->Reset();
+				reconnectAttempt = 0;
+			}
+			readyAt = 0;
+			droppedAt = now;
 		}
+		if (s == UPC::Status::CONNECTION_FAILOVER) { // the connector has somewhere to go already, so straight back, whatever the reconnect settings
+			if (!disposed && loop != nullptr) {
+				StopReconnect();
+				autoReconnectTimeoutRef = loop->Schedule(0, 0, [this]() {
+					autoReconnectTimeoutRef = nullptr;
+					if (unionBridge.GetConnectionState() == ConnectionState::NOT_CONNECTED) {
+						unionBridge.Connect();
+					}
+				});
+			}
+			return;
+		}
+		int numAttempts = unionBridge.GetConnectAttemptCount();
 		log.Debug("scheduling reconnect frequency "+std_to_string(autoReconnectFrequency));
 		if (autoReconnectFrequency > -1) {
 			if (!autoReconnectTimeoutRef) {
@@ -80,6 +112,7 @@ ConnectionMonitor::AddSelfListeners()
 					if (autoReconnectDelayFirstAttempt
 							&& (	(numAttempts == 0)
 									||	(numAttempts == 1 && unionBridge.GetReadyCount() == 0))) {
+						SelectReconnectFrequency();
 						ScheduleReconnect(autoReconnectFrequency);
 					} else {
 						if (!DoReconnect()) {
@@ -129,6 +162,98 @@ ConnectionMonitor::IsPingShared() const {
 	return sharedPing;
 }
 
+/**
+ * @return true if the heartbeat will use transport level pings, where the connection supports them
+ */
+bool
+ConnectionMonitor::IsTransportPingEnabled() const {
+	return transportPing;
+}
+
+/**
+ * @param enable use transport level pings where possible (the default), or always send upc heartbeats
+ */
+void
+ConnectionMonitor::SetTransportPingEnabled(bool enable) const {
+	transportPing = enable;
+}
+
+/**
+ * @return round trip times, in microseconds, from whatever the heartbeat is using: transport pings on the current connection if it can,
+ * otherwise upc heartbeats
+ */
+const RTTStats*
+ConnectionMonitor::GetRTTStats() const {
+	const RTTStats* rtt = transportPing? unionBridge.GetTransportRTTStats() : nullptr;
+	return rtt != nullptr? rtt : &heartbeatRTT;
+}
+
+/**
+ * @return the smallest round trip, in microseconds, 0 if there's nothing to go on
+ */
+uint64_t
+ConnectionMonitor::GetMinRTT() const {
+	return GetRTTStats()->GetMin();
+}
+
+/**
+ * @return the mean round trip, in microseconds
+ */
+double
+ConnectionMonitor::GetMeanRTT() const {
+	return GetRTTStats()->GetMean();
+}
+
+/**
+ * @return the 99th percentile of recent round trips, in microseconds
+ */
+uint64_t
+ConnectionMonitor::GetP99RTT() const {
+	return GetRTTStats()->GetP99();
+}
+
+/**
+ * @return the smoothed round trip, in microseconds, which is what goes in _PING
+ */
+double
+ConnectionMonitor::GetSmoothedRTT() const {
+	return GetRTTStats()->GetSmoothed();
+}
+
+/**
+ * @return the smoothed mean deviation of the round trip, in microseconds
+ */
+double
+ConnectionMonitor::GetRTTVariation() const {
+	return GetRTTStats()->GetVariation();
+}
+
+/**
+ * @return the change in ms of the smoothed round trip that gets a new _PING published
+ */
+int
+ConnectionMonitor::GetPingPublishDelta() const {
+	return pingPublishDelta;
+}
+
+/**
+ * @return the longest, in ms, that _PING goes without being republished
+ */
+int
+ConnectionMonitor::GetPingPublishInterval() const {
+	return pingPublishInterval;
+}
+
+/**
+ * @param deltaMS publish _PING when the smoothed round trip moves by more than this many ms
+ * @param intervalMS ... or when it hasn't been published for this long. 0 publishes on every heartbeat, as it used to be done
+ */
+void
+ConnectionMonitor::SetPingPublishThreshold(const int deltaMS, const int intervalMS) const {
+	pingPublishDelta = deltaMS < 0? 0 : deltaMS;
+	pingPublishInterval = intervalMS < 0? 0 : intervalMS;
+}
+
 void
 ConnectionMonitor::SetEventLoop(EventLoop *l)
 {
@@ -183,18 +308,23 @@ ConnectionMonitor::StartHeartbeat() const {
 	}
 
 	StopHeartbeat();
-	heartbeats.clear();
 	if (loop != nullptr) {
-		heartbeatTimerRef = loop->Schedule(heartBeatFrequency, heartBeatFrequency, [this] () {
-			Heartbeat();
-		});
+		if (adaptiveHeartbeat) {
+			heartbeatInterval = std::min(std::max(heartBeatFrequency, adaptiveMinMS), AdaptiveMaxMS());
+			lastRxBytes = unionBridge.GetNumBytesReceived();
+			lastInbound = Now();
+			ScheduleAdaptiveHeartbeat(heartbeatInterval);
+		} else {
+			heartbeatTimerRef = loop->Schedule(heartBeatFrequency, heartBeatFrequency, [this] () {
+				Heartbeat();
+			});
+		}
 	}
 
 }
 
 void
 ConnectionMonitor::StopHeartbeat() const {
-	return;
 	log.Debug("stopping heartbeat ");
 	if (heartbeatTimerRef != nullptr) {
 		if (loop != nullptr) {
@@ -202,10 +332,20 @@ ConnectionMonitor::StopHeartbeat() const {
 		}
 		heartbeatTimerRef = nullptr;
 	}
-	heartbeats.clear();
+	ClearHeartbeats();
 	log.Debug("stopped heartbeat " );
 }
 
+/**
+ * adaptive mode runs on one shot timers, as the next tick depends on what came in since the last
+ */
+void
+ConnectionMonitor::ScheduleAdaptiveHeartbeat(const int ms) const {
+	heartbeatTimerRef = loop->Schedule((unsigned)ms, 0, [this] () {
+		heartbeatTimerRef = nullptr; // one shot
+		AdaptiveHeartbeat();
+	});
+}
 
 void
 ConnectionMonitor::Heartbeat() const
@@ -218,38 +358,245 @@ ConnectionMonitor::Heartbeat() const
 	}
 	log.Debug("ConnectionMonitor::Heartbeat() IsReady!!");
 
-	time_t timeSinceOldestHeartbeat;
-	time_t now = std::time(nullptr);
-
-	heartbeats[heartbeatCounter] = now;
-	unionBridge.SendUPC("u2", {
-			kClientHeartbeat,
-			clientManager.Self()->GetClientID(),
-			"",
-			std_to_string(heartbeatCounter)
-	});
-	heartbeatCounter++;
-	log.Debug("sent!" );
+	uint64_t now = Now();
+	const RTTStats* rtt = transportPing? unionBridge.GetTransportRTTStats() : nullptr;
+	if (rtt != nullptr && unionBridge.SendTransportPing() >= 0) {
+		CheckTransportPongs(*rtt);
+		if (oldestTransportPing == 0) {
+			oldestTransportPing = now;
+		}
+	} else {
+		if (oldestHeartbeat == 0) {
+			oldestHeartbeat = now;
+		}
+		// if the ring is full, the stamp going out is for a heartbeat that's still unanswered. oldestHeartbeat keeps its time
+		HeartbeatStamp& stamp = heartbeats[heartbeatCounter % kHeartbeatRing];
+		stamp.id = heartbeatCounter;
+		stamp.sent = now;
+		unionBridge.SendUPC("u2", {
+				kClientHeartbeat,
+				clientManager.Self()->GetClientID(),
+				"",
+				std_to_string(heartbeatCounter)
+		});
+		heartbeatCounter++;
+		log.Debug("sent!" );
+	}
+	CheckHeartbeatTimeout(now);
+	log.Debug("done");
+}
 
-	// Assign the oldest heartbeat
-	if (heartbeats.size() == 1) {
-		oldestHeartbeat = now;
+/**
+ * the heartbeat tick in adaptive mode. anything coming in from the server shows the link is alive as well as a heartbeat reply would, so
+ * a heartbeat only goes out once nothing has arrived for the current interval. the interval itself stretches while the round trip is
+ * steady, and comes back in quickly if it starts to wander. timeouts are checked on every tick, as in the fixed mode
+ */
+void
+ConnectionMonitor::AdaptiveHeartbeat() const
+{
+	if (!unionBridge.IsReady()) {
+		log.Info("[CONNECTION_MONITOR] Orbiter is not connected. Stopping heartbeat.");
+		StopHeartbeat();
+		return;
+	}
+	uint64_t now = Now();
+	uint64_t rx = unionBridge.GetNumBytesReceived();
+	if (rx != lastRxBytes) { // we only look on the tick, so the traffic might be a little older than this
+		lastRxBytes = rx;
+		lastInbound = now;
+	}
+	AdaptInterval();
+	int silentMS = (int)((now - lastInbound)/1000000);
+	int next = heartbeatInterval;
+	if (silentMS >= heartbeatInterval) {
+		Heartbeat();
 	} else {
-		oldestHeartbeat = UINT_MAX;
-		for (auto it: heartbeats) {
-			if (it.second < oldestHeartbeat) {
-				oldestHeartbeat = it.second;
-			}
+		const RTTStats* rtt = transportPing? unionBridge.GetTransportRTTStats() : nullptr;
+		if (rtt != nullptr) {
+			CheckTransportPongs(*rtt);
 		}
+		CheckHeartbeatTimeout(now);
+		next = heartbeatInterval - silentMS;
+	}
+	if (loop != nullptr && heartbeatEnabled && heartbeatTimerRef == nullptr && unionBridge.IsReady()) {
+		ScheduleAdaptiveHeartbeat(next);
+	}
+}
+
+/**
+ * stretch the adaptive interval by a quarter for a steady round trip, halve it for a jittery one. only once per new round trip sample
+ */
+void
+ConnectionMonitor::AdaptInterval() const
+{
+	const RTTStats* rtt = GetRTTStats();
+	if (rtt->GetCount() == adaptedRTTCount) {
+		return;
+	}
+	adaptedRTTCount = rtt->GetCount();
+	double variation = rtt->GetVariation();
+	if (variation < kSteadyRTTVariation || variation*4 <= rtt->GetSmoothed()) {
+		heartbeatInterval = std::min(heartbeatInterval + heartbeatInterval/4, AdaptiveMaxMS());
+	} else if (variation*2 > rtt->GetSmoothed()) {
+		heartbeatInterval = std::max(heartbeatInterval/2, adaptiveMinMS);
+	}
+}
+
+/**
+ * @return the upper bound on the adaptive interval, which is kept to half the connection timeout so a dead link is still noticed in time
+ */
+int
+ConnectionMonitor::AdaptiveMaxMS() const
+{
+	return std::max(adaptiveMinMS, std::min(adaptiveMaxMS, connectionTimeout/2));
+}
+
+/**
+ * close the connection if the oldest unanswered heartbeat or ping has been waiting longer than the connection timeout
+ */
+void
+ConnectionMonitor::CheckHeartbeatTimeout(const uint64_t now) const
+{
+	uint64_t oldest = oldestHeartbeat;
+	if (oldestTransportPing != 0 && (oldest == 0 || oldestTransportPing < oldest)) {
+		oldest = oldestTransportPing;
+	}
+	if (oldest == 0) {
+		return;
 	}
 	// Close connection if too much time has passed since the last response
-	timeSinceOldestHeartbeat = now - oldestHeartbeat;
-	if (timeSinceOldestHeartbeat > connectionTimeout) {
+	uint64_t timeSinceOldestHeartbeat = (now - oldest)/1000000;
+	if (timeSinceOldestHeartbeat > (uint64_t)connectionTimeout) {
 		log.Warn("[CONNECTION_MONITOR] No response from server in " +
 				std_to_string((int)timeSinceOldestHeartbeat) + "ms. Starting automatic disconnect.");
 		unionBridge.Disconnect();
 	}
-	log.Debug("done");
+}
+
+/**
+ * the server's answer to one of our heartbeats. these come back in the order they went, so once one is in, anything before it that
+ * hasn't turned up isn't going to
+ */
+void
+ConnectionMonitor::HeartbeatMessageListener(UserMessageID mid, StringArgs a)
+{
+	if (a.size() < 1) return;
+	int id = atoi(a[0].c_str());
+	if (id < heartbeatTail || id >= heartbeatCounter) { // from before the heartbeat was last restarted, or just nonsense
+		return;
+	}
+	uint64_t now = Now();
+	const HeartbeatStamp& stamp = heartbeats[id % kHeartbeatRing];
+	if (stamp.id == id) {
+		heartbeatRTT.Add((now - stamp.sent)/1000);
+	}
+	heartbeatTail = id+1;
+	if (heartbeatTail == heartbeatCounter) {
+		oldestHeartbeat = 0;
+	} else { // if the next one has fallen out of the ring, the oldest one still in it is the best we have
+		int next = std::max(heartbeatTail, heartbeatCounter - kHeartbeatRing);
+		oldestHeartbeat = heartbeats[next % kHeartbeatRing].sent;
+	}
+	// the reply is traffic too, and we know exactly when it came, so the adaptive tick needn't count it again
+	lastRxBytes = unionBridge.GetNumBytesReceived();
+	lastInbound = now;
+	PublishPing(heartbeatRTT);
+}
+
+/**
+ * forget outstanding heartbeats. the counter carries on, so late answers to them are recognized and ignored. a new connection is a new
+ * session as far as the server is concerned, so _PING goes out again on its first round trip
+ */
+void
+ConnectionMonitor::ClearHeartbeats() const
+{
+	heartbeatTail = heartbeatCounter;
+	oldestHeartbeat = 0;
+	oldestTransportPing = 0;
+	publishedPingTime = 0;
+}
+
+/**
+ * set _PING to the smoothed round trip, if it's worth telling everyone about
+ */
+void
+ConnectionMonitor::PublishPing(const RTTStats& rtt) const
+{
+	uint64_t now = Now();
+	int ping = (int)((rtt.GetSmoothed() + 500)/1000);
+	if (publishedPingTime != 0 && pingPublishInterval > 0
+			&& std::abs(ping - publishedPing) <= pingPublishDelta
+			&& (now - publishedPingTime)/1000000 < (uint64_t)pingPublishInterval) {
+		return;
+	}
+	ClientRef self = GetSelf();
+	if (!self) {
+		return;
+	}
+	self->SetAttribute("_PING", std_to_string(ping), "", sharedPing);
+	publishedPing = ping;
+	publishedPingTime = now;
+}
+
+/**
+ * pongs to transport pings come back between ticks, so publish the latest round trip if there has been one since we last looked. any
+ * pong at all means nothing is outstanding but the ping we are about to send
+ */
+void
+ConnectionMonitor::CheckTransportPongs(const RTTStats& rtt) const
+{
+	if (rtt.GetCount() != lastRTTCount) {
+		lastRTTCount = rtt.GetCount();
+		oldestTransportPing = 0;
+		PublishPing(rtt);
+	}
+}
+
+/**
+ * switch between a heartbeat every GetHeartbeatFrequency() ms, and one only after the link has been quiet for the adaptive interval
+ * @param enable adaptive mode on or off
+ * @param minMS shortest interval, defaults to the heartbeat frequency
+ * @param maxMS longest interval, defaults to kDfltAdaptiveStretch times minMS, and is in any case no more than half the connection timeout
+ */
+void
+ConnectionMonitor::SetAdaptiveHeartbeat(const bool enable, const int minMS, const int maxMS) const {
+	adaptiveHeartbeat = enable;
+	adaptiveMinMS = minMS > 0? std::max(minMS, (int)kDfltMinHeartbeatFrequency) : heartBeatFrequency;
+	adaptiveMaxMS = maxMS > 0? std::max(maxMS, adaptiveMinMS) : kDfltAdaptiveStretch*adaptiveMinMS;
+	log.Info("[CONNECTION_MONITOR] Adaptive heartbeat " + std::string(enable? "enabled" : "disabled") + ": [minMS: "
+			+ std_to_string(adaptiveMinMS) + ", maxMS: " + std_to_string(adaptiveMaxMS) + "].");
+	if (heartbeatEnabled && unionBridge.IsReady()) {
+		StartHeartbeat();
+	}
+}
+
+/**
+ * @return true if the heartbeat only runs when the link is quiet
+ */
+bool
+ConnectionMonitor::IsAdaptiveHeartbeat() const {
+	return adaptiveHeartbeat;
+}
+
+/**
+ * @return the current heartbeat interval in ms ... the heartbeat frequency, or in adaptive mode wherever the interval has got to
+ */
+int
+ConnectionMonitor::GetHeartbeatInterval() const {
+	return adaptiveHeartbeat? heartbeatInterval : heartBeatFrequency;
+}
+
+/**
+ * replace the monotonic nanosecond clock used for timestamps, which is uv_hrtime() by default. for tests
+ */
+void
+ConnectionMonitor::SetClock(Clock c) const {
+	clock = c;
+}
+
+uint64_t
+ConnectionMonitor::Now() const {
+	return clock();
 }
 
 void
@@ -322,7 +669,9 @@ ConnectionMonitor::SetAutoReconnectFrequency(int minMS, int maxMS, bool delayFir
 				+ std_to_string((float)floor((1000/minMS)*10)/10)
 				+ " reconnection attempts per second.");
 	}
-	SelectReconnectFrequency();
+	autoReconnectFrequency = minMS;
+	reconnectAttempt = 0;
+	reconnectPolicy->Reset();
 }
 
 /**
@@ -355,6 +704,7 @@ ConnectionMonitor::StartReadyTimer() const {
 	}
 	if (loop != nullptr) {
 		readyTimerRef = loop->Schedule((unsigned)readyTimeout, 0, [this] () {
+			readyTimerRef = nullptr; // one shot
 			unionBridge.NxConnectFailure("Connection failed while waiting for ready", UPC::Status::CONNECT_TIMEOUT);
 		});
 	}
@@ -373,7 +723,7 @@ ConnectionMonitor::CancelReadyTimer() const {
 }
 
 /**
- * @return the auto reconnect frequency in ms
+ * @return the delay, in ms, picked for the latest reconnect attempt
  */
 int
 ConnectionMonitor::GetAutoReconnectFrequency() const {
@@ -381,21 +731,84 @@ ConnectionMonitor::GetAutoReconnectFrequency() const {
 }
 
 /**
- * calaculates a reconnect rate
+ * asks the reconnect policy for the wait before the next attempt, unless the server has told us how long to stay away
  */
 void
 ConnectionMonitor::SelectReconnectFrequency() const {
 	if (autoReconnectMinMS == -1) {
 		autoReconnectFrequency = -1;
-	} else if (autoReconnectMinMS == autoReconnectMaxMS) {
-		autoReconnectFrequency = autoReconnectMinMS;
-	} else {
+		return;
+	}
+	if (reconnectHint > 0) {
 		std::mt19937 eng((std::random_device())());
-		std::uniform_int_distribution<> randomInt(autoReconnectMinMS,autoReconnectMaxMS);
-		autoReconnectFrequency = randomInt(eng);
-		log.Info("[CONNECTION_MONITOR] Random auto-reconnect frequency selected: [" +
-				std_to_string(autoReconnectFrequency) + "] ms.");
+		std::uniform_int_distribution<> randomInt(0, reconnectHint/4);
+		autoReconnectFrequency = reconnectHint + randomInt(eng);
+		reconnectHint = 0;
+	} else {
+		autoReconnectFrequency = reconnectPolicy->NextDelay(autoReconnectMinMS, autoReconnectMaxMS, reconnectAttempt);
 	}
+	reconnectAttempt++;
+	reconnectStats.delay.Add(autoReconnectFrequency);
+	log.Info("[CONNECTION_MONITOR] Auto-reconnect delay selected: [" +
+			std_to_string(autoReconnectFrequency) + "] ms.");
+}
+
+/**
+ * @return the policy that picks the wait between reconnect attempts
+ */
+std::shared_ptr<ReconnectPolicy>
+ConnectionMonitor::GetReconnectPolicy() const {
+	return reconnectPolicy;
+}
+
+/**
+ * @param policy picks the wait between reconnect attempts. UniformReconnectPolicy gives the old behaviour, a fresh pick in the
+ * SetAutoReconnectFrequency() range each time. nullptr goes back to the default backoff
+ */
+void
+ConnectionMonitor::SetReconnectPolicy(std::shared_ptr<ReconnectPolicy> policy) {
+	reconnectPolicy = policy? policy : std::make_shared<BackoffReconnectPolicy>();
+	reconnectAttempt = 0;
+}
+
+/**
+ * @return ms a connection has to stay up before the reconnect backoff is reset
+ */
+int
+ConnectionMonitor::GetStableConnectionPeriod() const {
+	return stableConnectionPeriod;
+}
+
+void
+ConnectionMonitor::SetStableConnectionPeriod(const int ms) {
+	stableConnectionPeriod = ms > 0? ms : 0;
+}
+
+/**
+ * the server has told us when to come back, eg with a retry time in a refusal or a maintenance notice. the next reconnect waits that long,
+ * plus up to a quarter again so that everyone told the same thing doesn't turn up together, whatever the policy would have picked
+ * @param ms the wait, or 0 to drop a hint that hasn't been used yet
+ */
+void
+ConnectionMonitor::SetReconnectHint(const int ms) const {
+	reconnectHint = ms > 0? ms : 0;
+}
+
+/**
+ * @return reconnect attempts and successes, with histograms of the delays picked and of the time from losing a ready connection to having
+ * one again
+ */
+const ConnectionMonitor::ReconnectStats&
+ConnectionMonitor::GetReconnectStats() const {
+	return reconnectStats;
+}
+
+void
+ConnectionMonitor::ResetReconnectStats() const {
+	reconnectStats.attempts = 0;
+	reconnectStats.reconnects = 0;
+	reconnectStats.delay.Reset();
+	reconnectStats.timeToReconnect.Reset();
 }
 
 void
@@ -460,7 +873,9 @@ ConnectionMonitor::DoReconnect() const {
 		return false;
 	}
 
+	SelectReconnectFrequency();
 	ScheduleReconnect(autoReconnectFrequency);
+	reconnectStats.attempts++;
 
 	log.Warn("[CONNECTION_MONITOR] Attempting automatic reconnect. (Next attempt in "
 			+ std_to_string(autoReconnectFrequency) + "ms.)");
@@ -0,0 +1,158 @@
+/*
+ * DNSCache.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#include "CommonTypes.h"
+#include "DNSCache.h"
+
+const int DNSCache::kDfltTTLMS;
+
+/**
+ * @class DNSCache DNSCache.h
+ * @brief remembers what host:service pairs resolved to, for ttlMS, and shares lookups in progress
+ *
+ * a UVEventLoop has one, so every layer on that loop connecting to the same place does one lookup between them. getaddrinfo doesn't
+ * tell us the record's own ttl, so it is one figure for everything. failures aren't kept, so the next try asks again. the lookup itself is
+ * a std::function, so a test can answer without a network
+ *
+ * callbacks are made on whatever thread the answer comes in on. one we can give without asking, a hit, goes through the Deliver hook if
+ * there is one, which for the loop's cache puts it on the loop thread, with the answers to the lookups. otherwise it's the caller's
+ */
+DNSCache::DNSCache(Lookup l)
+	: lookup(l)
+	, clock([]() {
+		return (uint64_t) std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	})
+	, ttlMS(kDfltTTLMS)
+{
+}
+
+DNSCache::~DNSCache()
+{
+}
+
+void
+DNSCache::SetLookup(Lookup l)
+{
+	lookup = l;
+}
+
+void
+DNSCache::SetClock(Clock c)
+{
+	clock = c;
+}
+
+/**
+ * how answers we have to hand are passed on, rather than straight back to the caller
+ */
+void
+DNSCache::SetDeliver(Deliver d)
+{
+	deliver = d;
+}
+
+/**
+ * calls back with the addresses for host:service, straight away if we have them and they are still good, otherwise when the lookup
+ * that is already going, or the one we start, comes back
+ */
+void
+DNSCache::Resolve(const std::string host, const std::string service, ResolverCB cb)
+{
+	std::string key = host + ":" + service;
+	lock.lock();
+	Entry& e = entries[key];
+	if (e.pending) {
+		stats.joined++;
+		e.waiters.push_back(cb);
+		lock.unlock();
+		return;
+	}
+	if (e.addresses.size() > 0 && clock() < e.expires) {
+		stats.hits++;
+		UVAddresses res = e.addresses;
+		Deliver d = deliver;
+		lock.unlock();
+		if (!cb) {
+			return;
+		}
+		if (d) {
+			d([cb, res]() { cb(res, 0); });
+		} else {
+			cb(res, 0);
+		}
+		return;
+	}
+	stats.misses++;
+	e.pending = true;
+	e.waiters.push_back(cb);
+	Lookup l = lookup;
+	Deliver d = deliver;
+	lock.unlock();
+	if (!l) {
+		if (d) {
+			d([this, key]() { Resolved(key, UVAddresses(), -1); });
+		} else {
+			Resolved(key, UVAddresses(), -1);
+		}
+		return;
+	}
+	l(host, service, [this, key](const UVAddresses& res, int status) {
+		Resolved(key, res, status);
+	});
+}
+
+void
+DNSCache::Resolved(const std::string key, const UVAddresses& res, int status)
+{
+	lock.lock();
+	auto it = entries.find(key);
+	if (it == entries.end()) {
+		lock.unlock();
+		return;
+	}
+	std::vector<ResolverCB> waiters;
+	waiters.swap(it->second.waiters);
+	it->second.pending = false;
+	if (status < 0 || res.size() == 0) {
+		stats.failures++;
+		entries.erase(it);
+		if (status >= 0) status = -1;
+	} else {
+		it->second.addresses = res;
+		it->second.expires = clock() + ttlMS;
+	}
+	lock.unlock();
+	for (auto& cb: waiters) {
+		if (cb) cb(res, status);
+	}
+}
+
+/**
+ * drop what we have for host:service, eg when it stopped answering. a lookup in progress still gets to its waiters
+ */
+void
+DNSCache::Forget(const std::string host, const std::string service)
+{
+	std::lock_guard<std::mutex> g(lock);
+	auto it = entries.find(host + ":" + service);
+	if (it != entries.end() && !it->second.pending) {
+		entries.erase(it);
+	}
+}
+
+void
+DNSCache::Flush()
+{
+	std::lock_guard<std::mutex> g(lock);
+	for (auto it=entries.begin(); it!=entries.end(); ) {
+		if (it->second.pending) {
+			++it;
+		} else {
+			it = entries.erase(it);
+		}
+	}
+}
@@ -5,6 +5,8 @@
  *      Author: dak
  */
 
+#include <algorithm>
+
 #include <MessageNotifier.h>
 
 const char* RxMsgBroadcastType::TO_SERVER = "0";
@@ -29,37 +31,118 @@ MessageNotifier::AddMessageListener(const UserMessageID message, const CBModMsg
 	return AddMessageListener(message, {}, {}, listener);
 }
 
+/**
+ * add a listener for the given message, filed under each of the rooms and clients it is interested in. with no rooms and no clients it hears
+ * everything sent with that message id
+ * @return the handle for the listener ... it goes quiet as soon as the caller lets go of this
+ */
 CBModMsgRef
 MessageNotifier::AddMessageListener(const UserMessageID message, const std::vector<ClientID> clients, const std::vector<RoomID> rooms, const CBModMsg listener) const
 {
 	std::shared_ptr<CBModMsg> x = std::make_shared<CBModMsg>(listener);
 	lock.lock();
-	auto it = msgListeners.find(message);
-	if (it == msgListeners.end()) {
-		msgListeners[message].push_back(MsgCBR(message, clients, rooms, x));
-	} else {
-		it->second.push_back(MsgCBR(message, clients, rooms, x));
+	MsgRoute& route = msgListeners[message];
+	route.listeners.push_back(MsgCBR(message, clients, rooms, x));
+	if (rooms.size() == 0 && clients.size() == 0) {
+		route.anyRoom.push_back(x);
+	}
+	for (auto &it: rooms) {
+		route.byRoom[it].push_back(x);
+	}
+	for (auto &it: clients) {
+		route.byClient[it].push_back(x);
 	}
 	lock.unlock();
 	return x;
 }
 
+/**
+ * take the given listener, and anything that has expired, out of a routing bucket
+ */
+static void
+PruneBucket(MsgCBList& bucket, const CBModMsgRef& listener)
+{
+	auto it = bucket.begin();
+	while (it != bucket.end()) {
+		CBModMsgRef scb = it->lock();
+		if (!scb || scb == listener) {
+			it = bucket.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+/**
+ * drop everything that has expired from a route, and the room and client keys left with nothing under them. called with the lock held, and
+ * never while a notification is under way, as that may be walking the buckets
+ */
+void
+MessageNotifier::PruneRoute(MsgRoute& route) const
+{
+	auto jt = route.listeners.begin();
+	while (jt != route.listeners.end()) {
+		if (jt->cb.expired()) {
+			jt = route.listeners.erase(jt);
+		} else {
+			++jt;
+		}
+	}
+	PruneBucket(route.anyRoom, nullptr);
+	for (auto bt=route.byRoom.begin(); bt!=route.byRoom.end(); ) {
+		PruneBucket(bt->second, nullptr);
+		if (bt->second.empty()) {
+			bt = route.byRoom.erase(bt);
+		} else {
+			++bt;
+		}
+	}
+	for (auto bt=route.byClient.begin(); bt!=route.byClient.end(); ) {
+		PruneBucket(bt->second, nullptr);
+		if (bt->second.empty()) {
+			bt = route.byClient.erase(bt);
+		} else {
+			++bt;
+		}
+	}
+	route.stale = false;
+}
+
+/**
+ * remove a listener from the index, and prune the route. if a notification is walking it, the prune waits for that to finish
+ */
 void
 MessageNotifier::RemoveMessageListener(const UserMessageID message, const CBModMsgRef listener) const
 {
+	lock.lock();
 	auto it = msgListeners.find(message);
-	if (it == msgListeners.end()) return;
-	auto listeners = it->second;
-	auto jt = listeners.begin();
-	while (jt < listeners.end()) {
-		if (!jt->cb.expired()) {
-			CBModMsgRef scb = jt->cb.lock();
-			if (scb == listener) {
-				jt->cb.reset();
+	if (it != msgListeners.end()) {
+		MsgRoute& route = it->second;
+		auto jt = route.listeners.begin();
+		while (jt != route.listeners.end()) {
+			if (jt->cb.lock() == listener) {
+				if (jt->rooms.size() == 0 && jt->clients.size() == 0) {
+					PruneBucket(route.anyRoom, listener);
+				}
+				for (auto &rt: jt->rooms) {
+					auto bt = route.byRoom.find(rt);
+					if (bt != route.byRoom.end()) PruneBucket(bt->second, listener);
+				}
+				for (auto &ct: jt->clients) {
+					auto bt = route.byClient.find(ct);
+					if (bt != route.byClient.end()) PruneBucket(bt->second, listener);
+				}
+				jt = route.listeners.erase(jt);
+			} else {
+				++jt;
 			}
 		}
-		++jt;
+		route.stale = true;
+		if (notifying == 0) {
+			PruneRoute(route);
+		}
 	}
+	lock.unlock();
 }
 
 bool
@@ -67,68 +150,97 @@ MessageNotifier::HasMessageListener(const UserMessageID message, const CBModMsgR
 {
 	auto it = msgListeners.find(message);
 	if (it == msgListeners.end()) return false;
-	auto listeners = it->second;
-	auto jt = listeners.begin();
-	while (jt < listeners.end()) {
-		if (!jt->cb.expired()) {
-			CBModMsgRef scb = jt->cb.lock();
-			if (scb == listener) {
-				return true;
-			}
+	for (auto &jt: it->second.listeners) {
+		if (!jt.cb.expired() && jt.cb.lock() == listener) {
+			return true;
 		}
-		++jt;
 	}
 	return false;
 }
 
-void
-MessageNotifier::NotifyMessageListeners(const UserMessageID message, const std::vector<ClientID> clients, const std::vector<RoomID> rooms, const StringArgs msg) const {
-	unsigned i=0;
-	auto it = msgListeners.find(message);
-	if (it == msgListeners.end()) return;
-	auto listeners = it->second;
-	while(i<listeners.size()) { // N.B. caution some notifiers might modify the list
-		auto iter = listeners[i];
-		std::weak_ptr<CBModMsg> p= iter.cb;
-		if (p.expired()) {
+/**
+ * call the live listeners in one bucket, clearing out any that have expired. if 'delivered' is given, it's used to make sure a listener
+ * that is filed under more than one of the matching keys only hears the message once
+ * @return true if anything had expired
+ */
+bool
+MessageNotifier::NotifyBucket(MsgCBList& bucket, const UserMessageID& message, const StringArgs& msg, std::vector<CBModMsg*>* delivered) const
+{
+	bool expired = false;
+	size_t i=0;
+	while (i<bucket.size()) { // N.B. caution some notifiers might modify the list, so the entry is looked up by index each time round
+		std::shared_ptr<CBModMsg> s_cb = bucket[i].lock(); // create a shared_ptr from the weak_ptr
+		if (!s_cb) {
 			lock.lock();
-			listeners.erase(listeners.begin() + i);
+			bucket.erase(bucket.begin() + i);
 			lock.unlock();
-		} else {
-			std::shared_ptr<CBModMsg> s_cb = p.lock(); // create a shared_ptr from the weak_ptr
-			if (clients.size() == 0 && rooms.size() == 0) { // message is for everybody ... or system message for self
-//				DEBUG_OUT("NotifyMessageListeners room wildcard match");
-				(*s_cb)(message, msg);
-			} else if (iter.clients.size() == 0 && iter.rooms.size() == 0) { // interested in all messages
-				(*s_cb)(message, msg);
-			} else {
-				bool match = false;
-				for (auto it: iter.rooms) {
-					for (auto jt: rooms) {
-						if (it == jt) {
-							match = true;
-							break;
-						}
-					}
-				}
-				if (!match) {
-					for (auto it: iter.clients) {
-						for (auto jt: clients) {
-							if (it == jt) {
-								match = true;
-								break;
-							}
-						}
-					}
-				}
-				if (match) {
-					(*s_cb)(message, msg);
-				}
+			expired = true;
+			continue;
+		}
+		++i;
+		if (delivered != nullptr) {
+			if (std::find(delivered->begin(), delivered->end(), s_cb.get()) != delivered->end()) {
+				continue;
 			}
-			i++;
+			delivered->push_back(s_cb.get());
 		}
+		(*s_cb)(message, msg);
 	}
+	return expired;
 }
 
-
-
+/**
+ * route a message to its listeners. a message with no target rooms or clients goes to everybody listening for it. otherwise it goes to the
+ * unfiltered listeners plus the listeners filed under any of the given rooms or clients ... for a u7, the client is the sender. the body goes
+ * to every listener by reference ... a listener that wants to keep it has to take its own copy
+ *
+ * anything found to have expired on the way marks the route stale, and once the outermost notification is done, the route is pruned, so a
+ * room or client that never hears another message doesn't hang on to its dead entries
+ */
+void
+MessageNotifier::NotifyMessageListeners(const UserMessageID& message, const std::vector<ClientID>& clients, const std::vector<RoomID>& rooms, const StringArgs& msg) const {
+	auto it = msgListeners.find(message);
+	if (it == msgListeners.end()) return;
+	MsgRoute& route = it->second;
+	lock.lock();
+	notifying++;
+	lock.unlock();
+	bool expired = false;
+	if (clients.size() == 0 && rooms.size() == 0) { // message is for everybody ... or system message for self
+		size_t i=0;
+		while (i<route.listeners.size()) {
+			std::shared_ptr<CBModMsg> s_cb = route.listeners[i].cb.lock();
+			++i;
+			if (!s_cb) { // left for the prune, which takes it out of its buckets too
+				expired = true;
+				continue;
+			}
+			(*s_cb)(message, msg);
+		}
+	} else {
+		// a listener can only turn up in more than one of the buckets we look at if we are matching more than one key
+		std::vector<CBModMsg*> delivered;
+		std::vector<CBModMsg*>* dp = (clients.size() + rooms.size() > 1)? &delivered: nullptr;
+		expired = NotifyBucket(route.anyRoom, message, msg, nullptr);
+		for (auto &rt: rooms) {
+			auto bt = route.byRoom.find(rt);
+			if (bt != route.byRoom.end()) {
+				expired |= NotifyBucket(bt->second, message, msg, dp);
+			}
+		}
+		for (auto &ct: clients) {
+			auto bt = route.byClient.find(ct);
+			if (bt != route.byClient.end()) {
+				expired |= NotifyBucket(bt->second, message, msg, dp);
+			}
+		}
+	}
+	lock.lock();
+	if (expired) {
+		route.stale = true;
+	}
+	if (--notifying == 0 && route.stale) {
+		PruneRoute(route);
+	}
+	lock.unlock();
+}
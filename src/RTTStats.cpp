@@ -0,0 +1,134 @@
+/*
+ * RTTStats.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include "RTTStats.h"
+
+/**
+ * @class RTTStats RTTStats.h
+ * round trip time samples, in microseconds. min and mean are over everything since the last Reset(), percentiles over the most
+ * recent kWindow samples, so a bad patch an hour ago doesn't haunt the p99 forever. also keeps the smoothed round trip and its mean
+ * deviation, as tcp does (rfc 6298), for anything that wants to react to the trend rather than to every sample
+ */
+RTTStats::RTTStats()
+{
+	Reset();
+}
+
+void
+RTTStats::Add(const uint64_t us)
+{
+	samples[count % kWindow] = us;
+	count++;
+	sum += us;
+	last = us;
+	if (count == 1 || us < min) {
+		min = us;
+	}
+	if (count == 1) {
+		smoothed = us;
+		variation = us/2.0;
+	} else {
+		double err = us - smoothed;
+		variation += ((err < 0? -err : err) - variation)/4;
+		smoothed += err/8;
+	}
+}
+
+void
+RTTStats::Reset()
+{
+	count = 0;
+	sum = 0;
+	min = 0;
+	last = 0;
+	smoothed = 0;
+	variation = 0;
+}
+
+/**
+ * @return the number of samples since the last reset
+ */
+uint64_t
+RTTStats::GetCount() const
+{
+	return count;
+}
+
+/**
+ * @return the most recent sample, 0 if none
+ */
+uint64_t
+RTTStats::GetLast() const
+{
+	return last;
+}
+
+/**
+ * @return the smallest sample, 0 if none
+ */
+uint64_t
+RTTStats::GetMin() const
+{
+	return min;
+}
+
+/**
+ * @return the mean of all samples, 0 if none
+ */
+double
+RTTStats::GetMean() const
+{
+	return count > 0? (double)sum/count : 0;
+}
+
+/**
+ * @return the p'th percentile (0 < p <= 100) of the recent samples, nearest rank. only called for reporting, so a sort is fine
+ */
+uint64_t
+RTTStats::GetPercentile(const double p) const
+{
+	size_t n = count < (uint64_t)kWindow? (size_t)count : (size_t)kWindow;
+	if (n == 0) {
+		return 0;
+	}
+	std::vector<uint64_t> sorted(samples, samples+n);
+	std::sort(sorted.begin(), sorted.end());
+	size_t rank = (size_t)(p*n/100.0 + 0.999999);
+	if (rank < 1) rank = 1;
+	if (rank > n) rank = n;
+	return sorted[rank-1];
+}
+
+/**
+ * @return the 99th percentile of the recent samples
+ */
+uint64_t
+RTTStats::GetP99() const
+{
+	return GetPercentile(99);
+}
+
+/**
+ * @return the smoothed round trip, an ewma with gain 1/8
+ */
+double
+RTTStats::GetSmoothed() const
+{
+	return smoothed;
+}
+
+/**
+ * @return the smoothed mean deviation of the round trip, an ewma with gain 1/4
+ */
+double
+RTTStats::GetVariation() const
+{
+	return variation;
+}
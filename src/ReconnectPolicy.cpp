@@ -0,0 +1,76 @@
+/*
+ * ReconnectPolicy.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#include <algorithm>
+
+#include "CommonTypes.h"
+#include "UCUpperHeaders.h"
+#include "UCLowerHeaders.h"
+
+const int BackoffReconnectPolicy::kDfltCapMS;
+
+UniformReconnectPolicy::UniformReconnectPolicy(const unsigned seed)
+	: rng(seed)
+{
+}
+
+int
+UniformReconnectPolicy::NextDelay(const int minMS, const int maxMS, const int attempt)
+{
+	if (maxMS <= minMS) {
+		return minMS;
+	}
+	std::uniform_int_distribution<> randomInt(minMS, maxMS);
+	return randomInt(rng);
+}
+
+/**
+ * the first delay after a stable connection is uniform in [minMS, maxMS], as before. each one after that is uniform between minMS and three
+ * times the last, up to the cap. the delays grow about as fast as plain doubling, but each client's sequence wanders off on its own, so a
+ * crowd that all lost the same server at the same moment spreads itself out instead of coming back in lockstep
+ */
+BackoffReconnectPolicy::BackoffReconnectPolicy(const int capMS, const unsigned seed)
+	: capMS(capMS)
+	, lastDelay(0)
+	, rng(seed)
+{
+}
+
+int
+BackoffReconnectPolicy::NextDelay(const int minMS, const int maxMS, const int attempt)
+{
+	int delay;
+	if (attempt == 0 || lastDelay <= 0) {
+		delay = maxMS <= minMS? minMS : std::uniform_int_distribution<>(minMS, maxMS)(rng);
+	} else {
+		int top = lastDelay > capMS/3? capMS : lastDelay*3;
+		delay = top <= minMS? minMS : std::uniform_int_distribution<>(minMS, top)(rng);
+	}
+	lastDelay = std::min(std::max(delay, minMS), std::max(capMS, minMS));
+	return lastDelay;
+}
+
+void
+BackoffReconnectPolicy::Reset()
+{
+	lastDelay = 0;
+}
+
+/**
+ * @return the longest delay we will ever pick
+ */
+int
+BackoffReconnectPolicy::GetCap() const
+{
+	return capMS;
+}
+
+void
+BackoffReconnectPolicy::SetCap(const int ms)
+{
+	capMS = ms;
+}
@@ -45,11 +45,11 @@ Room::Room(RoomID id, RoomManager &roomManager, ClientManager& clientManager, Ac
 	SetRoomID(id);
 
 	updateClientAttributeListener = std::make_shared<CBAttrInfo>(
-		[this](EventType t, AttrName n, AttrVal v, AttrScope s, AttrVal ov, ClientRef c, UPCStatus status) {
+		[this](EventType t, const AttrName& n, const AttrVal& v, const AttrScope& s, const AttrVal& ov, const ClientRef& c, UPCStatus status) {
 		NXAttrInfo::NotifyListeners(Event::UPDATE_CLIENT_ATTRIBUTE, n, v, s, ov, c, status);
 	});
 	deleteClientAttributeListener = std::make_shared<CBAttrInfo>(
-		[this](EventType t, AttrName n, AttrVal v, AttrScope s, AttrVal ov, ClientRef c, UPCStatus status) {
+		[this](EventType t, const AttrName& n, const AttrVal& v, const AttrScope& s, const AttrVal& ov, const ClientRef& c, UPCStatus status) {
 		NXAttrInfo::NotifyListeners(Event::DELETE_CLIENT_ATTRIBUTE, n, v, s, ov, c, status);
 	});
 
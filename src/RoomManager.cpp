@@ -33,20 +33,17 @@ RoomManager::RoomManager(ClientManager& clientManager, AccountManager& accountMa
 	  watchedRooms.addListener(CollectionEvent::REMOVE_ITEM, removeRoomListener);
 */
 
-	watchForRoomsResultListener = std::make_shared<CBRoomInfo>([this](EventType t, RoomQualifier q, RoomID id, RoomRef ref, UPCStatus status) {
+	watchForRoomsResultListener = std::make_shared<CBRoomInfo>([this](EventType t, RoomQualifier q, const RoomID& id, const RoomRef& ref, UPCStatus status) {
 		if (status == UPC::Status::SUCCESS) {
-			if (q != "") {
-				watchedQualifiers.push_back(q);
-			} else if (ref) {
+			if (q == "" && ref) {
 				q = ref->GetQualifier();
-				if (q != "") {
-					watchedQualifiers.push_back(q);
-				}
-
+			}
+			if (q != "" && !IsWatchingQualifier(q)) { // a restored session watches again what it already had
+				watchedQualifiers.push_back(q);
 			}
 		}
 	});
-	stopWatchingForRoomsResultListener = std::make_shared<CBRoomInfo>([this](EventType t, RoomQualifier q, RoomID id, RoomRef ref, UPCStatus status) {
+	stopWatchingForRoomsResultListener = std::make_shared<CBRoomInfo>([this](EventType t, const RoomQualifier& q, const RoomID& id, const RoomRef& ref, UPCStatus status) {
 		if (status == UPC::Status::SUCCESS) {
 			if (q != "") {
 				auto it=watchedQualifiers.begin();
@@ -0,0 +1,370 @@
+/*
+ * SessionRestorer.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#include <uv.h>
+#include <cstring>
+#include <algorithm>
+
+#include "UCUpperHeaders.h"
+
+/**
+ * @class SessionRestorer SessionRestorer.h
+ * puts back what a lost session was subscribed to, as soon as the next one is READY. the room, client and account managers already hold
+ * what we occupy, observe and watch, and nothing there is cleared when the connection goes, so that is what gets replayed. the bridge shows
+ * us every upc it sends, and from those we keep what we'd need to send them again: join and observe passwords, update levels, and the
+ * attributes we've set on our own client.
+ *
+ * the replay is one burst of upcs, sent back to back without waiting on any result, rather than one callback chain per subscription. the
+ * cached rooms aren't wiped in the meantime ... the snapshots that come back with each join or observe reconcile them, and a subscription
+ * the new session refuses is dropped from the managers, with the usual LEAVE or STOP_OBSERVING for its room.
+ *
+ * only a session we lost is put back. one the app ended itself, with a Disconnect(), or by logging off, isn't, and what we kept for it
+ * is dropped.
+ *
+ * time to restored state is from READY, or from losing the session, to the last result for the burst
+ */
+SessionRestorer::SessionRestorer(RoomManager& roomManager, ClientManager& clientManager, AccountManager& accountManager, ILogger& log)
+	: roomManager(roomManager)
+	, clientManager(clientManager)
+	, accountManager(accountManager)
+	, log(log)
+	, clock([]() { return uv_hrtime(); })
+{
+}
+
+/**
+ * @return true if lost sessions are put back on the next READY. the default
+ */
+bool
+SessionRestorer::IsEnabled() const
+{
+	return enabled;
+}
+
+/**
+ * turn restoring on or off. what we're subscribed to is still kept track of while it's off
+ */
+void
+SessionRestorer::SetEnabled(const bool enable)
+{
+	enabled = enable;
+}
+
+/**
+ * @return true between a replay and the last of its results
+ */
+bool
+SessionRestorer::IsRestoring() const
+{
+	return restoring;
+}
+
+/**
+ * called by the bridge with each upc it sends, for the parts of a subscription that the managers don't keep
+ */
+void
+SessionRestorer::WillSend(UPCMessageID messageID, const StringArgs& args)
+{
+	if (strcmp(messageID, UPC::ID::JOIN_ROOM) == 0) {
+		if (args.size() >= 2) joinPasswords[args[0]] = args[1];
+	} else if (strcmp(messageID, UPC::ID::OBSERVE_ROOM) == 0) {
+		if (args.size() >= 2) observePasswords[args[0]] = args[1];
+	} else if (strcmp(messageID, UPC::ID::SET_ROOM_UPDATE_LEVELS) == 0) {
+		if (args.size() >= 2) updateLevels[args[0]] = args[1];
+	} else if (strcmp(messageID, UPC::ID::LEAVE_ROOM) == 0) { // the update levels go once we're neither in the room nor watching it
+		if (args.size() >= 1) {
+			joinPasswords.erase(args[0]);
+			if (observePasswords.count(args[0]) == 0) updateLevels.erase(args[0]);
+		}
+	} else if (strcmp(messageID, UPC::ID::STOP_OBSERVING_ROOM) == 0) {
+		if (args.size() >= 1) {
+			observePasswords.erase(args[0]);
+			if (joinPasswords.count(args[0]) == 0) updateLevels.erase(args[0]);
+		}
+	} else if (strcmp(messageID, UPC::ID::LOGOFF) == 0) {
+		AccountRef account = clientManager.SelfAccount();
+		if (args.size() >= 1 && account && args[0] == account->GetUserID()) {
+			Clear();
+		}
+	} else if (strcmp(messageID, UPC::ID::SET_CLIENT_ATTR) == 0) {
+		ClientRef self = clientManager.Self();
+		if (args.size() >= 6 && self && args[0] == self->GetClientID()) {
+			selfAttributes[AttributeKey(args[4], args[2])] = { args[2], args[4], args[3], (unsigned int) atoi(args[5].c_str()) };
+		}
+	} else if (strcmp(messageID, UPC::ID::REMOVE_CLIENT_ATTR) == 0) {
+		ClientRef self = clientManager.Self();
+		if (args.size() >= 4 && self && args[0] == self->GetClientID()) {
+			selfAttributes.erase(AttributeKey(args[3] == "" ? Token::GLOBAL_ATTR : args[3], args[2]));
+		}
+	}
+}
+
+/**
+ * called by the bridge when the connection closes or fails. only the first call after a READY counts, so that failed reconnects don't
+ * move the time we lost the session, or the self client we lost with it
+ */
+void
+SessionRestorer::OnSessionLost()
+{
+	if (restoring) {
+		pending.clear();
+		restoring = false;
+	}
+	if (lost || closing) return;
+	lost = true;
+	lostAt = Now();
+	lostSelf = clientManager.Self();
+}
+
+/**
+ * called when the app disconnects. the close that follows isn't a lost session, so the next READY has nothing to put back
+ */
+void
+SessionRestorer::OnClientDisconnect()
+{
+	Clear();
+	closing = true;
+}
+
+/**
+ * drop the passwords, update levels and attributes we kept, and any loss we were waiting to put right
+ */
+void
+SessionRestorer::Clear()
+{
+	joinPasswords.clear();
+	observePasswords.clear();
+	updateLevels.clear();
+	selfAttributes.clear();
+	pending.clear();
+	restoring = false;
+	lost = false;
+	lostSelf.reset();
+}
+
+/**
+ * called by the bridge on READY
+ * @return the burst of upcs that puts back what the lost session was subscribed to, empty if there's nothing to do
+ */
+std::vector<SessionRestorer::Request>
+SessionRestorer::Replay()
+{
+	std::vector<Request> burst;
+	bool wasLost = lost;
+	ClientRef previous = lostSelf;
+	lost = false;
+	closing = false;
+	lostSelf.reset();
+	pending.clear();
+	restoring = false;
+	if (!enabled || !wasLost) {
+		return burst;
+	}
+	readyAt = Now();
+
+	// our own attributes first, so they're in place before anyone sees us join
+	ClientRef self = clientManager.Self();
+	if (self) {
+		for (auto it=selfAttributes.begin(); it!=selfAttributes.end(); ++it) {
+			const SelfAttribute& a = it->second;
+			AttrVal value = a.value;
+			unsigned int options = a.options;
+			if (options & Attribute::FLAG_EVALUATE) { // send what it came to, not the expression again
+				if (!previous) continue;
+				value = previous->GetAttribute(a.name, a.scope);
+				options &= ~Attribute::FLAG_EVALUATE;
+			}
+			burst.push_back({ UPC::ID::SET_CLIENT_ATTR, { self->GetClientID(), "", a.name, value, a.scope, std_to_string(options) } });
+			Expect(UPC::ID::SET_CLIENT_ATTR_RESULT, it->first);
+		}
+	}
+
+	std::vector<RoomID> occupied = roomManager.occupiedRooms.GetKeys();
+	for (auto it=occupied.begin(); it!=occupied.end(); ++it) {
+		auto levels = updateLevels.find(*it);
+		if (levels != updateLevels.end()) {
+			burst.push_back({ UPC::ID::SET_ROOM_UPDATE_LEVELS, { *it, levels->second } });
+		}
+		auto password = joinPasswords.find(*it);
+		burst.push_back({ UPC::ID::JOIN_ROOM, { *it, password != joinPasswords.end() ? password->second : "" } });
+		Expect(UPC::ID::JOIN_ROOM_RESULT, *it);
+	}
+	std::vector<RoomID> observed = roomManager.observedRooms.GetKeys();
+	for (auto it=observed.begin(); it!=observed.end(); ++it) {
+		auto levels = updateLevels.find(*it);
+		if (levels != updateLevels.end() && !roomManager.occupiedRooms.Contains(*it)) {
+			burst.push_back({ UPC::ID::SET_ROOM_UPDATE_LEVELS, { *it, levels->second } });
+		}
+		auto password = observePasswords.find(*it);
+		burst.push_back({ UPC::ID::OBSERVE_ROOM, { *it, password != observePasswords.end() ? password->second : "" } });
+		Expect(UPC::ID::OBSERVE_ROOM_RESULT, *it);
+	}
+	for (auto it=roomManager.watchedQualifiers.begin(); it!=roomManager.watchedQualifiers.end(); ++it) {
+		burst.push_back({ UPC::ID::WATCH_FOR_ROOMS, { *it, bool_to_string(*it == "") } });
+		Expect(UPC::ID::WATCH_FOR_ROOMS_RESULT, *it);
+	}
+
+	if (clientManager.isWatchingForClients) {
+		burst.push_back({ UPC::ID::WATCH_FOR_CLIENTS, {} });
+		Expect(UPC::ID::WATCH_FOR_CLIENTS_RESULT, "");
+	}
+	std::vector<ClientID> clients = clientManager.observedClients.GetKeys();
+	for (auto it=clients.begin(); it!=clients.end(); ++it) {
+		burst.push_back({ UPC::ID::OBSERVE_CLIENT, { *it } });
+		Expect(UPC::ID::OBSERVE_CLIENT_RESULT, *it);
+	}
+	if (accountManager.isWatchingForAccounts) {
+		burst.push_back({ UPC::ID::WATCH_FOR_ACCOUNTS, {} });
+		Expect(UPC::ID::WATCH_FOR_ACCOUNTS_RESULT, "");
+	}
+	std::vector<UserID> accounts = accountManager.observedAccounts.GetKeys();
+	for (auto it=accounts.begin(); it!=accounts.end(); ++it) {
+		burst.push_back({ UPC::ID::OBSERVE_ACCOUNT, { *it } });
+		Expect(UPC::ID::OBSERVE_ACCOUNT_RESULT, *it);
+	}
+
+	if (!burst.empty()) {
+		log.Info("[SESSION_RESTORER] Restoring session with " + std::to_string(burst.size()) + " requests.");
+		restoring = true;
+		stats.restores++;
+		stats.requests += burst.size();
+		if (pending.empty()) {
+			Finish();
+		}
+	}
+	return burst;
+}
+
+/**
+ * called by the bridge with each result that might answer part of a replay
+ * @param messageID the result's upc, one of the UPC::ID ..._RESULTs
+ * @param key what the result is about: a room, qualifier, client or account id, or the attribute key, or "" if nothing
+ */
+void
+SessionRestorer::OnResult(UPCMessageID messageID, const std::string& key, const UPCStatus status)
+{
+	if (!restoring || pending.erase(Key(messageID, key)) == 0) {
+		return;
+	}
+	switch (status) {
+	case UPC::Status::SUCCESS:
+	case UPC::Status::ALREADY_IN_ROOM:
+	case UPC::Status::ALREADY_OBSERVING:
+	case UPC::Status::ALREADY_WATCHING:
+		break;
+	default:
+		stats.failures++;
+		Forget(messageID, key, status);
+	}
+	if (pending.empty()) {
+		Finish();
+	}
+}
+
+/**
+ * @return the stats for restoring sessions
+ */
+const SessionRestorer::RestoreStats&
+SessionRestorer::GetRestoreStats() const
+{
+	return stats;
+}
+
+/**
+ * clear the stats for restoring sessions
+ */
+void
+SessionRestorer::ResetRestoreStats()
+{
+	stats = RestoreStats();
+}
+
+/**
+ * replace the monotonic nanosecond clock used for timing restores, which is uv_hrtime() by default. for tests
+ */
+void
+SessionRestorer::SetClock(Clock c)
+{
+	clock = c;
+}
+
+/**
+ * note that the given result is still to come
+ */
+void
+SessionRestorer::Expect(UPCMessageID messageID, const std::string& key)
+{
+	pending.insert(Key(messageID, key));
+}
+
+/**
+ * a subscription the new session wouldn't take ... drop it from the managers, as if it had ended, so the cache stops claiming it
+ */
+void
+SessionRestorer::Forget(UPCMessageID messageID, const std::string& key, const UPCStatus status)
+{
+	log.Warn("[SESSION_RESTORER] Couldn't restore " + std::string(messageID) + " [" + key + "], status: " + UPC::Status::GetStatusString(status));
+	if (strcmp(messageID, UPC::ID::JOIN_ROOM_RESULT) == 0) {
+		WillSend(UPC::ID::LEAVE_ROOM, { key });
+		RoomRef room = roomManager.RemoveOccupiedRoom(key);
+		if (room) room->OnLeave();
+	} else if (strcmp(messageID, UPC::ID::OBSERVE_ROOM_RESULT) == 0) {
+		WillSend(UPC::ID::STOP_OBSERVING_ROOM, { key });
+		RoomRef room = roomManager.RemoveObservedRoom(key);
+		if (room) room->OnStopObserving();
+	} else if (strcmp(messageID, UPC::ID::WATCH_FOR_ROOMS_RESULT) == 0) {
+		std::vector<RoomQualifier>& q = roomManager.watchedQualifiers;
+		q.erase(std::remove(q.begin(), q.end(), key), q.end());
+	} else if (strcmp(messageID, UPC::ID::WATCH_FOR_CLIENTS_RESULT) == 0) {
+		clientManager.SetIsWatchingForClients(false);
+	} else if (strcmp(messageID, UPC::ID::OBSERVE_CLIENT_RESULT) == 0) {
+		clientManager.RemoveObservedClient(key);
+	} else if (strcmp(messageID, UPC::ID::WATCH_FOR_ACCOUNTS_RESULT) == 0) {
+		accountManager.SetIsWatchingForAccounts(false);
+	} else if (strcmp(messageID, UPC::ID::OBSERVE_ACCOUNT_RESULT) == 0) {
+		accountManager.RemoveObservedAccount(key);
+	} else if (strcmp(messageID, UPC::ID::SET_CLIENT_ATTR_RESULT) == 0) {
+		selfAttributes.erase(key);
+	}
+}
+
+/**
+ * the last result of a replay is in
+ */
+void
+SessionRestorer::Finish()
+{
+	restoring = false;
+	uint64_t now = Now();
+	stats.sinceReady.Add((now - readyAt)/1000000);
+	stats.sinceLost.Add((now - lostAt)/1000000);
+	log.Info("[SESSION_RESTORER] Session restored " + std::to_string((now - readyAt)/1000000) + "ms after READY.");
+}
+
+uint64_t
+SessionRestorer::Now() const
+{
+	return clock();
+}
+
+/**
+ * @return the key for a result we're waiting on
+ */
+std::string
+SessionRestorer::Key(UPCMessageID messageID, const std::string& key)
+{
+	return std::string(messageID) + "|" + key;
+}
+
+/**
+ * @return the key for a self attribute, as it is in SET_CLIENT_ATTR_RESULT
+ */
+std::string
+SessionRestorer::AttributeKey(const AttrScope& scope, const AttrName& name)
+{
+	return scope + "|" + name;
+}
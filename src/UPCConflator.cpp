@@ -0,0 +1,136 @@
+/*
+ * UPCConflator.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#include "CommonTypes.h"
+#include "UCUpperHeaders.h"
+#include "UCLowerHeaders.h"
+
+/**
+ * @class UPCConflator UPCConflator.h
+ * collapses a backlog of queued inbound upcs, dropping state updates that a later update in the same batch makes redundant. only idempotent
+ * 'set this to that' updates are touched:
+ * - u8 CLIENT_ATTR_UPDATE, keyed on owner (the account for persistent attributes, otherwise the client), scope and attribute name
+ * - u9 ROOM_ATTR_UPDATE, keyed on room and attribute name
+ * - u131 ROOM_OCCUPANTCOUNT_UPDATE and u132 ROOM_OBSERVERCOUNT_UPDATE, keyed on room
+ * the last update for each key stays where it was in the batch, and everything else keeps its order, so the end state is the same as processing
+ * the lot ... listeners just don't see the intermediate values
+ *
+ * off by default. nothing happens unless the batch is bigger than the threshold, so a loop that is keeping up pays nothing
+ */
+UPCConflator::UPCConflator()
+	: threshold(0)
+	, numConflated(0) {
+}
+
+/**
+ * @param n conflate batches with more than n messages in them. 0 turns conflation off
+ */
+void
+UPCConflator::SetThreshold(const size_t n)
+{
+	threshold = n;
+}
+
+/**
+ * @return the batch size above which we conflate, 0 if off
+ */
+size_t
+UPCConflator::GetThreshold() const
+{
+	return threshold;
+}
+
+/**
+ * @return the conflation key for the given upc, or "" if the message can't be conflated
+ */
+std::string
+UPCConflator::Key(const int method, const StringArgs& args)
+{
+	static const char kSep = '\x1f';
+	switch (method) {
+	case 8: { // CLIENT_ATTR_UPDATE: scope, client, user, name, value, options
+		if (args.size() < 6) return "";
+		if (atoi(args[5].c_str()) & Attribute::FLAG_PERSISTENT) {
+			return "8u" + args[2] + kSep + args[0] + kSep + args[3];
+		}
+		return "8c" + args[1] + kSep + args[0] + kSep + args[3];
+	}
+	case 9: // ROOM_ATTR_UPDATE: room, by client, name, value
+		if (args.size() < 4) return "";
+		return "9" + args[0] + kSep + args[2];
+	case 131: // ROOM_OCCUPANTCOUNT_UPDATE: room, count
+		if (args.size() < 2) return "";
+		return "131" + args[0];
+	case 132: // ROOM_OBSERVERCOUNT_UPDATE: room, count
+		if (args.size() < 2) return "";
+		return "132" + args[0];
+	}
+	return "";
+}
+
+/**
+ * drop superseded updates from the batch, in place, if it is over the threshold. two passes: find the last position of each key, then
+ * compact the batch keeping only those and the unconflatable messages
+ */
+void
+UPCConflator::Conflate(std::vector<DispatchUPC::ER>& batch)
+{
+	if (threshold == 0 || batch.size() <= threshold) {
+		return;
+	}
+	keys.resize(batch.size());
+	for (size_t i=0; i<batch.size(); i++) {
+		keys[i] = Key(batch[i].eventType, std::get<0>(batch[i].params));
+		if (!keys[i].empty()) {
+			latest[keys[i]] = i;
+		}
+	}
+	size_t n=0;
+	for (size_t i=0; i<batch.size(); i++) {
+		if (!keys[i].empty() && latest[keys[i]] != i) {
+			numConflated++;
+			numConflatedByMethod[batch[i].eventType]++;
+			continue;
+		}
+		if (n != i) {
+			batch[n] = std::move(batch[i]);
+		}
+		n++;
+	}
+	batch.erase(batch.begin()+n, batch.end());
+	latest.clear();
+	keys.clear();
+}
+
+/**
+ * @return the total number of messages dropped by conflation
+ */
+int
+UPCConflator::GetNumConflated() const
+{
+	return numConflated;
+}
+
+/**
+ * @return the number of messages of the given upc method dropped by conflation
+ */
+int
+UPCConflator::GetNumConflated(const int method) const
+{
+	auto it = numConflatedByMethod.find(method);
+	return it != numConflatedByMethod.end()? it->second : 0;
+}
+
+/**
+ * zero the counters
+ */
+void
+UPCConflator::ResetStats()
+{
+	numConflated = 0;
+	numConflatedByMethod.clear();
+}
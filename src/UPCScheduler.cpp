@@ -0,0 +1,301 @@
+/*
+ * UPCScheduler.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#include "CommonTypes.h"
+#include "UCUpperHeaders.h"
+#include "UCLowerHeaders.h"
+
+const int UPCScheduler::kPriorityControl;
+const int UPCScheduler::kPriorityNormal;
+const int UPCScheduler::kPriorityBulk;
+const int UPCScheduler::kNumPriorities;
+const int UPCScheduler::kMaxMethod;
+const int UPCScheduler::kNumKeys;
+
+/**
+ * @class UPCScheduler UPCScheduler.h
+ * reorders each batch of queued inbound upcs by priority class, so that handshake, join and login responses aren't stuck behind a few thousand
+ * presence and attribute updates. the class of each upc method comes from a table, which can be overridden with SetPriority()
+ *
+ * ordering guarantees:
+ * - within a class, messages stay in the order they arrived
+ * - messages about the same room stay in the order they arrived. if an urgent message for a room follows bulk traffic for that room, the
+ *   bulk traffic is promoted to go with it, rather than the urgent message being held back
+ * - likewise for messages about the same client (u102, u7 from it, u103), and the same user (u88 LOGGED_IN, then u49 LOGIN_RESULT), as the
+ *   handlers for the later ones expect the earlier ones to have set the client or account up
+ * - bridge Events (connect, disconnect and so on) are barriers, and nothing is moved across them
+ *
+ * also keeps, per class, a histogram of how many messages each batch held and one of how long messages sat in the queue, in microseconds
+ */
+UPCScheduler::UPCScheduler()
+{
+	ResetPriorities();
+}
+
+/**
+ * reset the priority table to the defaults
+ */
+void
+UPCScheduler::ResetPriorities()
+{
+	static const int control[] = {
+		6,	/* JOINED_ROOM */
+		29,	/* CLIENT_METADATA */
+		44,	/* LEFT_ROOM */
+		49,	/* LOGIN_RESULT */
+		50,	/* SERVER_TIME_UPDATE */
+		63,	/* CLIENT_READY */
+		66,	/* SERVER_HELLO */
+		72,	/* JOIN_ROOM_RESULT */
+		76,	/* LEAVE_ROOM_RESULT */
+		84,	/* SESSION_TERMINATED */
+		85,	/* SESSION_NOT_FOUND */
+		87,	/* LOGOFF_RESULT */
+		164	/* CONNECTION_REFUSED */
+	};
+	static const int bulk[] = {
+		8,	/* CLIENT_ATTR_UPDATE */
+		9,	/* ROOM_ATTR_UPDATE */
+		36,	/* CLIENT_ADDED_TO_ROOM */
+		37,	/* CLIENT_REMOVED_FROM_ROOM */
+		79,	/* ROOM_ATTR_REMOVED */
+		81,	/* CLIENT_ATTR_REMOVED */
+		102,	/* CLIENT_ADDED_TO_SERVER */
+		103,	/* CLIENT_REMOVED_FROM_SERVER */
+		113,	/* JOINED_ROOM_ADDED_TO_CLIENT */
+		114,	/* JOINED_ROOM_REMOVED_FROM_CLIENT */
+		117,	/* OBSERVED_ROOM_ADDED_TO_CLIENT */
+		118,	/* OBSERVED_ROOM_REMOVED_FROM_CLIENT */
+		127,	/* ACCOUNT_LIST_UPDATE */
+		129,	/* CLIENT_OBSERVED_ROOM */
+		130,	/* CLIENT_STOPPED_OBSERVING_ROOM */
+		131,	/* ROOM_OCCUPANTCOUNT_UPDATE */
+		132,	/* ROOM_OBSERVERCOUNT_UPDATE */
+		147,	/* BANNED_ADDRESS_ADDED */
+		148,	/* BANNED_ADDRESS_REMOVED */
+		161	/* PROCESSED_UPC_ADDED */
+	};
+	for (int i=0; i<kMaxMethod; i++) {
+		priority[i] = kPriorityNormal;
+	}
+	for (int m: control) {
+		priority[m] = kPriorityControl;
+	}
+	for (int m: bulk) {
+		priority[m] = kPriorityBulk;
+	}
+}
+
+/**
+ * override the priority class of a upc method
+ * @param method upc method number, eg 72 for JOIN_ROOM_RESULT
+ * @param p one of kPriorityControl, kPriorityNormal or kPriorityBulk
+ */
+void
+UPCScheduler::SetPriority(const int method, const int p)
+{
+	if (method < 0 || method >= kMaxMethod || p < 0 || p >= kNumPriorities) {
+		return;
+	}
+	priority[method] = p;
+}
+
+/**
+ * @return the priority class of the given upc method
+ */
+int
+UPCScheduler::GetPriority(const int method) const
+{
+	if (method < 0 || method >= kMaxMethod) {
+		return kPriorityNormal;
+	}
+	return priority[method];
+}
+
+/**
+ * @return a pointer to the room id argument of a room related upc, or nullptr for anything that isn't tied to a room
+ */
+const std::string*
+UPCScheduler::RoomKey(const int method, const StringArgs& args)
+{
+	size_t i;
+	switch (method) {
+	case 6: case 8: case 9: case 36: case 37: case 44: case 59: case 62: case 72: case 76: case 77: case 79:
+	case 129: case 130: case 131: case 132:
+		i = 0; // for u8, this is the attribute scope, which is a room or "" for global
+		break;
+	case 54: case 113: case 114: case 117: case 118:
+		i = 1;
+		break;
+	case 7:
+		i = 3;
+		break;
+	default:
+		return nullptr;
+	}
+	return i < args.size() && !args[i].empty()? &args[i] : nullptr;
+}
+
+/**
+ * @return a pointer to the client id argument of a upc that the client's later upcs depend on, or nullptr
+ */
+const std::string*
+UPCScheduler::ClientKey(const int method, const StringArgs& args)
+{
+	size_t i;
+	switch (method) {
+	case 102: case 103:
+		i = 0;
+		break;
+	case 7:
+		i = 2; // the sender
+		break;
+	default:
+		return nullptr;
+	}
+	return i < args.size() && !args[i].empty()? &args[i] : nullptr;
+}
+
+/**
+ * @return a pointer to the user id argument of a login upc, or nullptr
+ */
+const std::string*
+UPCScheduler::UserKey(const int method, const StringArgs& args)
+{
+	size_t i;
+	switch (method) {
+	case 49:
+		i = 0;
+		break;
+	case 88:
+		i = 1;
+		break;
+	default:
+		return nullptr;
+	}
+	return i < args.size() && !args[i].empty()? &args[i] : nullptr;
+}
+
+/**
+ * reorder the batch, in place. does nothing if everything in it is in the same class
+ */
+void
+UPCScheduler::Schedule(std::vector<DispatchUPC::ER>& batch)
+{
+	int n[kNumPriorities] = {};
+	for (const DispatchUPC::ER& it: batch) {
+		if (it.eventType >= 0 && it.eventType < kMaxMethod) {
+			n[priority[it.eventType]]++;
+		}
+	}
+	int classes = 0;
+	for (int i=0; i<kNumPriorities; i++) {
+		depth[i].Add(n[i]);
+		if (n[i] > 0) classes++;
+	}
+	if (classes < 2) {
+		return;
+	}
+	scheduled.clear();
+	size_t from = 0;
+	for (size_t i=0; i<batch.size(); i++) {
+		if (batch[i].eventType < 0 || batch[i].eventType >= kMaxMethod) {
+			ScheduleSegment(batch, from, i);
+			scheduled.push_back(std::move(batch[i]));
+			from = i+1;
+		}
+	}
+	ScheduleSegment(batch, from, batch.size());
+	batch.swap(scheduled);
+	scheduled.clear();
+}
+
+/**
+ * move batch[from, to), which has no Events in it, into 'scheduled' in priority order. a backward pass works out the class each message
+ * actually goes in: the most urgent of its own and that of anything later for the same room, client or user
+ */
+void
+UPCScheduler::ScheduleSegment(std::vector<DispatchUPC::ER>& batch, size_t from, size_t to)
+{
+	if (from >= to) {
+		return;
+	}
+	effective.resize(to-from);
+	for (int k=0; k<kNumKeys; k++) {
+		keyPriority[k].clear();
+	}
+	for (size_t i=to; i-- > from; ) {
+		const int t = batch[i].eventType;
+		const StringArgs& args = std::get<0>(batch[i].params);
+		const std::string* keys[kNumKeys] = { RoomKey(t, args), ClientKey(t, args), UserKey(t, args) };
+		int p = priority[t];
+		for (int k=0; k<kNumKeys; k++) {
+			if (keys[k] != nullptr) {
+				auto it = keyPriority[k].find(*keys[k]);
+				if (it != keyPriority[k].end() && it->second < p) {
+					p = it->second;
+				}
+			}
+		}
+		for (int k=0; k<kNumKeys; k++) {
+			if (keys[k] != nullptr) {
+				keyPriority[k][*keys[k]] = p;
+			}
+		}
+		effective[i-from] = p;
+	}
+	for (int p=0; p<kNumPriorities; p++) {
+		for (size_t i=from; i<to; i++) {
+			if (effective[i-from] == p) {
+				scheduled.push_back(std::move(batch[i]));
+			}
+		}
+	}
+}
+
+/**
+ * Dispatcher hook ... note the time the message spent queued against its class
+ */
+void
+UPCScheduler::WillDispatch(const DispatchUPC::ER& event)
+{
+	if (event.eventType < 0 || event.eventType >= kMaxMethod) {
+		return;
+	}
+	auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - event.queued).count();
+	wait[priority[event.eventType]].Add(us > 0? us : 0);
+}
+
+/**
+ * @return histogram of the number of messages of the given class in each batch processed
+ */
+const Histogram&
+UPCScheduler::GetDepthHistogram(const int p) const
+{
+	return depth[p >= 0 && p < kNumPriorities? p : kPriorityNormal];
+}
+
+/**
+ * @return histogram of the time, in microseconds, messages of the given class waited between arriving and being handled
+ */
+const Histogram&
+UPCScheduler::GetWaitHistogram(const int p) const
+{
+	return wait[p >= 0 && p < kNumPriorities? p : kPriorityNormal];
+}
+
+/**
+ * clear the histograms
+ */
+void
+UPCScheduler::ResetStats()
+{
+	for (int i=0; i<kNumPriorities; i++) {
+		depth[i].Reset();
+		wait[i].Reset();
+	}
+}
@@ -59,7 +59,13 @@ UVLock::Unlock()
 /**
  * create loop, mutex, and start the thread
  */
-UVEventLoop::UVEventLoop() {
+UVEventLoop::UVEventLoop()
+	: dns([this](const std::string host, const std::string service, ResolverCB cb) {
+		Resolve(host, service, cb);
+	}) {
+	dns.SetDeliver([this](std::function<void()> f) {
+		Schedule(0, 0, [f]() { f(); });
+	});
 	runUV = false;
 	loop = uv_loop_new();
 	if (uv_mutex_init(&mutex) < 0) { // oops
@@ -68,6 +74,19 @@ UVEventLoop::UVEventLoop() {
 	StartUVRunner();
 }
 
+/**
+ * @return true if called from the runner thread, where waiting on anything the loop has to do would be waiting for ever
+ */
+bool
+UVEventLoop::IsLoopThread() const
+{
+	if (!runUV) {
+		return false;
+	}
+	uv_thread_t self = uv_thread_self();
+	return uv_thread_equal(&self, &runner) != 0;
+}
+
 /**
  * shut down uv and cleanup ... and should be the first thing we do when exitting
  * this closes all current connections to uv. if we have multiple instances of the client, that will close their io
@@ -82,19 +101,19 @@ UVEventLoop::ForceStopAndClose()
 	}
 	DEBUG_OUT(readers.size() << " readers");
 	for (auto it : readers) {
-		uv_handle_t *h = (uv_handle_t*)it->client->socket;
+		uv_handle_t *h = (uv_handle_t*)it->client->Stream();
 		if (uv_is_active(h)) uv_close(h, nullptr);
 		it->disposed = true;
 	}
 	DEBUG_OUT(readers.size() << " writers");
 	for (auto it : writers) {
-		uv_handle_t *h = (uv_handle_t*)it->client->socket;
+		uv_handle_t *h = (uv_handle_t*)it->client->Stream();
 		if (uv_is_active(h)) uv_close(h, nullptr);
 		it->disposed = true;
 	}
 	DEBUG_OUT(readers.size() << " closers ");
 	for (auto it : closers) {
-		uv_handle_t *h = (uv_handle_t*)it->client->socket;
+		uv_handle_t *h = (uv_handle_t*)it->client->Stream();
 		if (uv_is_active(h)) uv_close(h, nullptr);
 		it->disposed = true;
 	}
@@ -104,7 +123,10 @@ UVEventLoop::ForceStopAndClose()
 	DEBUG_OUT(readers.size() << " timers ");
 	for (auto it : activeTimers) {
 		uv_handle_t *h = (uv_handle_t*)&it->timer;
-		if (uv_is_active(h)) uv_close(h, nullptr);
+		if (uv_is_active(h)) {
+			uv_close(h, nullptr);
+			it->initialised = false; // closed by the uv_run below, so it needs a fresh uv_timer_init if the record is ever reused
+		}
 	}
 	for (auto it : activeWorkers) { // doesn't get closed
 		it->disposed = true;
@@ -143,6 +165,14 @@ UVEventLoop::~UVEventLoop() {
 		it->disposed = true;
 	}
 	HandleRunnerQueues(); // do the actual cleanup
+	for (auto it: freeTimers) {
+		delete it;
+	}
+	freeTimers.clear();
+	for (auto it: freeWorkers) {
+		delete it;
+	}
+	freeWorkers.clear();
 	uv_mutex_destroy(&mutex);
 	DEBUG_OUT("UVEventLoop::~UVEventLoop() done");
 }
@@ -162,21 +192,21 @@ UVEventLoop::HandleRunnerQueues()
 			bit = resolvers.erase(bit);
 		} else if (!qp->resolving) {
 			qp->resolving = true;
-			qp->dnsHints.ai_family = PF_INET;
+			memset(&qp->dnsHints, 0, sizeof(qp->dnsHints));
+			qp->dnsHints.ai_family = AF_UNSPEC; // both families, in the system's order of preference, for UVCnxLayer to race
 			qp->dnsHints.ai_socktype = SOCK_STREAM;
 			qp->dnsHints.ai_protocol = IPPROTO_TCP;
 			qp->dnsHints.ai_flags = 0;
 			qp->resolver.data = qp;
-			UVTCPClient* client = const_cast<UVTCPClient*>(qp->client);
-			if (client->address == nullptr || client->socket == nullptr) {
-
-			}
 			int r = uv_getaddrinfo(
 					loop, &qp->resolver, OnResolved,
 					qp->host.c_str(), qp->service.c_str(), &qp->dnsHints);
 			if (r<0) {
 				if (qp->bindCB) {
-					(*qp->bindCB)(client->address, kUVBindCallError);
+					ResolverCB cb = *qp->bindCB;
+					deferred.push_back([cb]() {
+						cb(UVAddresses(), kUVBindCallError);
+					});
 				}
 				qp->disposed = true;
 			}
@@ -197,25 +227,32 @@ UVEventLoop::HandleRunnerQueues()
 			rit = readers.erase(rit);
 		} else if (qp->closing) {
 			UVTCPClient* client = const_cast<UVTCPClient*>(qp->client);
-			int r = uv_read_stop((uv_stream_t*)client->socket);
+			int r = uv_read_stop(client->Stream());
 			if (r >= 0) {
-				uv_close((uv_handle_t*)client->socket, OnClose);
+				uv_close((uv_handle_t*)client->Stream(), OnClose);
 			}
 			qp->closing = false; // only try to close once!
 			++rit;
 		} else if (!qp->connected) {
 			qp->connected = true;
 			UVTCPClient *client = const_cast<UVTCPClient*>(qp->client);
-			if (client->socket) {
-				if (client->socket->data) { // should already be deleted
+			if (client->pipe) {
+				uv_pipe_init(loop, client->pipe, 0);
+				client->Stream()->data = qp;
+				qp->request.data = qp;
+				uv_pipe_connect(&qp->request, client->pipe, client->pipeName.c_str(), OnConnect); // failures come back on OnConnect
+			} else if (client->socket) {
+				if (client->Stream()->data) { // should already be deleted
 				}
 				uv_tcp_init(loop, client->socket);
-				client->socket->data = qp;
+				client->Stream()->data = qp;
 				qp->request.data = qp;
 				int r=uv_tcp_connect(&qp->request, client->socket, client->address, OnConnect);
 				if (r<0) {
 					if (qp->connectCB) {
-						(*qp->connectCB)(&qp->request, kUVCnxCallError);
+						deferred.push_back([qp]() {
+							(*qp->connectCB)(&qp->request, kUVCnxCallError);
+						});
 					}
 				}
 			}
@@ -232,13 +269,22 @@ UVEventLoop::HandleRunnerQueues()
 			}
 			delete *writ;
 			writ = writers.erase(writ);
-		} else {
+		} else if (!qp->writing) { // once only: a big one can still be going out on the next pass
+			qp->writing = true;
 			UVTCPClient* client = const_cast<UVTCPClient*>((*writ)->client);
-			int r=uv_write(&qp->request, (uv_stream_t*)client->socket, &qp->buf, 1, OnWrite);
+			int r=uv_write(&qp->request, client->Stream(), &qp->buf, 1, OnWrite);
 			if (r < 0) {
 				qp->disposed = true;
+				if (qp->done) {
+					WriteCB cb = std::move(qp->done);
+					deferred.push_back([cb, r]() {
+						cb(r);
+					});
+				}
 			}
 			++writ;
+		} else {
+			++writ;
 		}
 	}
 	;
@@ -250,12 +296,12 @@ UVEventLoop::HandleRunnerQueues()
 			cit=closers.erase(cit);
 		} else {
 			UVTCPClient* client = const_cast<UVTCPClient*>(qp->client);
-			uv_read_stop((uv_stream_t*)client->socket);
-			if (client->socket->data) {
-				delete static_cast<ReaderCB*>(client->socket->data);
+			uv_read_stop(client->Stream());
+			if (client->Stream()->data) {
+				delete static_cast<ReaderCB*>(client->Stream()->data);
 			}
-			client->socket->data = qp;
-			uv_close((uv_handle_t*)client->socket, OnClose);
+			client->Stream()->data = qp;
+			uv_close((uv_handle_t*)client->Stream(), OnClose);
 			++cit;
 		}
 	}
@@ -263,9 +309,7 @@ UVEventLoop::HandleRunnerQueues()
 	for (auto wit = activeWorkers.begin(); wit != activeWorkers.end();) {
 		auto qp=*wit;
 		if (qp->disposed) {
-			if (qp->queuedCB) delete qp->queuedCB;
-			if (qp->apresCB) delete qp->apresCB;
-			delete qp;
+			RecycleWorker(qp);
 			wit = activeWorkers.erase(wit);
 		} else {
 			int r = uv_queue_work(loop, &qp->work, OnWork, OnAfterWork);
@@ -279,11 +323,13 @@ UVEventLoop::HandleRunnerQueues()
 	for (auto tit = scheduledTimers.begin(); tit != scheduledTimers.end();) {
 		auto qp = *tit;
 		if (qp->disposed) {
-			if (qp->tikCB) delete qp->tikCB;
-			delete qp;
+			RecycleTimer(qp);
 		} else {
 			DEBUG_OUT("UVEventLoop::HandleRunnerQueues() timer started");
-			uv_timer_init(loop, &qp->timer);
+			if (!qp->initialised) {
+				uv_timer_init(loop, &qp->timer);
+				qp->initialised = true;
+			}
 			uv_timer_start(&qp->timer, OnTick, qp->delayMS, qp->repeatMs);
 			activeTimers.push_back(qp);
 		}
@@ -298,8 +344,7 @@ UVEventLoop::HandleRunnerQueues()
 				uv_timer_stop(&qp->timer);
 				++tit;
 			} else {
-				if (qp->tikCB) delete qp->tikCB;
-				delete qp;
+				RecycleTimer(qp);
 				tit = activeTimers.erase(tit);
 			}
 		} else {
@@ -308,6 +353,31 @@ UVEventLoop::HandleRunnerQueues()
 	}
 }
 
+/**
+ * drop the callback, and any captures it holds, and park the record on the free list for the next Schedule(). the new generation leaves
+ * any TimerRef still held for it out of date. called with the queues locked
+ */
+void
+UVEventLoop::RecycleTimer(UVTimer *t)
+{
+	t->tikCB = nullptr;
+	t->disposed = false;
+	t->generation++;
+	freeTimers.push_back(t);
+}
+
+/**
+ * as for RecycleTimer()
+ */
+void
+UVEventLoop::RecycleWorker(UVWorker *w)
+{
+	w->queuedCB = nullptr;
+	w->apresCB = nullptr;
+	w->disposed = false;
+	freeWorkers.push_back(w);
+}
+
 /**
  * the core of the event loop
  */
@@ -320,7 +390,12 @@ UVEventLoop::Runner(void *up)
 	while (l->runUV) {
 		l->Lock();
 		l->HandleRunnerQueues();
+		std::vector<std::function<void()>> deferred;
+		deferred.swap(l->deferred);
 		l->Unlock();
+		for (auto& it: deferred) { // failures found while queues were locked, called back now the callback is free to queue more
+			it();
+		}
 
 		if ((status = uv_run(l->loop, UV_RUN_NOWAIT)) < 0) { // error ... == 0 means all ok ... > 0 all ok but need run again
 		}
@@ -382,13 +457,17 @@ UVEventLoop::StopUVRunner(const bool force, const bool andWait)
  */
 WorkerRef
 UVEventLoop::Worker(WorkerCB _cb, WorkerCB _acb) {
-	WorkerCB *cb = nullptr;
-	WorkerCB *acb = nullptr;
-	if (_cb) cb = new WorkerCB(_cb);
-	if (_acb) acb = new WorkerCB(_acb);
-	UVWorker* r = new UVWorker(cb, acb);
-	r->work.data = r;
+	UVWorker* r = nullptr;
 	Lock();
+	if (freeWorkers.empty()) {
+		r = new UVWorker();
+		r->work.data = r;
+	} else {
+		r = freeWorkers.back();
+		freeWorkers.pop_back();
+	}
+	r->queuedCB = std::move(_cb);
+	r->apresCB = std::move(_acb);
 //	workerLock.lock();
 	activeWorkers.push_back(r);
 //	workerLock.unlock();
@@ -419,20 +498,28 @@ TimerRef
 UVEventLoop::Schedule(const uint64_t delayMs, const uint64_t repeatMs, TimerCB _cb)
 {
 	DEBUG_OUT("UVEventLoop::schedule()!!");
-	TimerCB *cb = nullptr;
-	if (_cb) cb = new TimerCB(_cb);
-	UVTimer *timer = new UVTimer(cb, delayMs, repeatMs);
-	DEBUG_OUT("UVEventLoop::schedule() allocating " << (uint64_t)timer);
-	timer->timer.data = timer;
+	UVTimer *timer = nullptr;
 	Lock();
+	if (freeTimers.empty()) {
+		timer = new UVTimer();
+		timer->timer.data = timer;
+		DEBUG_OUT("UVEventLoop::schedule() allocating " << (uint64_t)timer);
+	} else {
+		timer = freeTimers.back();
+		freeTimers.pop_back();
+	}
+	timer->tikCB = std::move(_cb);
+	timer->delayMS = delayMs;
+	timer->repeatMs = repeatMs;
 	scheduledTimers.push_back(timer);
+	TimerRef ref(timer);
 	Unlock();
 
-	return timer;
+	return ref;
 }
 
 /**
- * cancel the given event
+ * cancel the given event. does nothing if it has already fired, or been cancelled, even if the record has since gone to another timer
  */
 void
 UVEventLoop::CancelTimer(TimerRef cb)
@@ -440,13 +527,13 @@ UVEventLoop::CancelTimer(TimerRef cb)
 	DEBUG_OUT("UVEventLoop::CancelTimer()!!");
 	Lock();
 	for (auto it=scheduledTimers.begin(); it!=scheduledTimers.end(); ++it) {
-		if ((*it) == cb) {
+		if (cb.Is(*it)) {
 			(*it)->disposed = true;
 			break;
 		}
 	}
 	for (auto it=activeTimers.begin(); it!=activeTimers.end(); ++it) {
-		if ((*it) == cb) {
+		if (cb.Is(*it)) {
 			(*it)->disposed = true;
 			break;
 		}
@@ -456,21 +543,47 @@ UVEventLoop::CancelTimer(TimerRef cb)
 
 /**
  * write data to the given UVTCPClient's socket
+ * @param done if given, called on the loop thread once the socket has taken it all, or the write has failed
  */
 void
-UVEventLoop::Write(const UVTCPClient *client, const char *msg, const size_t n)
+UVEventLoop::Write(const UVTCPClient *client, const char *msg, const size_t n, WriteCB done)
 {
 	DEBUG_OUT("UVEventLoop::Write()!!");
 	UVWriter *writer = new UVWriter(client, msg, n);
 	writer->buf = uv_buf_init(new char[writer->n], (unsigned int)writer->n);
 	memcpy(writer->buf.base, msg, n);
 	writer->request.data = writer;
+	writer->done = std::move(done);
 	Lock();
 	writers.push_back(writer);
 	Unlock();
 	DEBUG_OUT("UVEventLoop::Write() done");
 }
 
+/**
+ * a gathered write. the pieces are copied straight into the one buffer that goes out
+ */
+void
+UVEventLoop::Write(const UVTCPClient *client, const uv_buf_t *bufs, const size_t nbufs, WriteCB done)
+{
+	size_t n = 0;
+	for (size_t i=0; i<nbufs; i++) {
+		n += bufs[i].len;
+	}
+	UVWriter *writer = new UVWriter(client, nullptr, n);
+	writer->buf = uv_buf_init(new char[n], (unsigned int)n);
+	char *p = writer->buf.base;
+	for (size_t i=0; i<nbufs; i++) {
+		memcpy(p, bufs[i].base, bufs[i].len);
+		p += bufs[i].len;
+	}
+	writer->request.data = writer;
+	writer->done = std::move(done);
+	Lock();
+	writers.push_back(writer);
+	Unlock();
+}
+
 /**
  * make a connection on the given UVTCP clients socket to the address given in this hadlers sockddr
  */
@@ -494,14 +607,15 @@ UVEventLoop::Connect(const UVTCPClient *client, ConnectCB _ocb, ReaderCB _cb)
 }
 
 /**
- * resolve host:service, and set the UVTCPClient's sockaddr structure
+ * resolve host:service, calling back with every address it has, of either family. this always asks: GetDNSCache() is the one that
+ * remembers
  */
 void
-UVEventLoop::Resolve(const UVTCPClient *client, const std::string host, const std::string service, ResolverCB _cb)
+UVEventLoop::Resolve(const std::string host, const std::string service, ResolverCB _cb)
 {
 	ResolverCB *cb = nullptr;
 	if (_cb) cb = new ResolverCB(_cb);
-	UVResolver* resolver = new UVResolver(client, host, service, cb);
+	UVResolver* resolver = new UVResolver(host, service, cb);
 	Lock();
 	resolvers.push_back(resolver);
 	Unlock();
@@ -523,9 +637,9 @@ UVEventLoop::Close(const UVTCPClient *client, CloserCB _cb)
 	UVReader *qp = nullptr;
 	if (client) {
 		Lock();
-		if (client->socket) {
+		if (client->Stream()) {
 			for (auto it: readers) {
-				if (it == static_cast<UVReader*>(client->socket->data)) {
+				if (it == static_cast<UVReader*>(client->Stream()->data)) {
 					qp = it;
 					break;
 				}
@@ -539,7 +653,7 @@ UVEventLoop::Close(const UVTCPClient *client, CloserCB _cb)
 		if (!qp) {
 			// if not found in the list of active readers, we should assume it's open perhaps ??? xxx not sure how to tell if still valid
 			DEBUG_OUT("UVEventLoop::Close() ... reader to close not found");
-			if (cb) (*cb)((uv_handle_t *)client->socket); // todo ?? change this callback to take a status
+			if (cb) (*cb)((uv_handle_t *)client->Stream()); // todo ?? change this callback to take a status
 			delete cb;
 		}
 	}
@@ -571,7 +685,7 @@ UVEventLoop::OnTick(uv_timer_t* timer)
 	if (timer) {
 		otCBp=static_cast<UVTimer*>(timer->data);
 		if (otCBp) {
-			(*otCBp->tikCB)();
+			if (otCBp->tikCB) otCBp->tikCB();
 			if (!uv_is_active((uv_handle_t*)timer)) { // it's a 1 shot timer!
 				otCBp->disposed = true;
 			}
@@ -585,8 +699,8 @@ UVEventLoop::OnWork(uv_work_t *req)
 	UVWorker* wCBp=nullptr;
 	if (req) {
 		wCBp=static_cast<UVWorker*>(req->data);
-		if (wCBp && wCBp->queuedCB != nullptr) {
-			(*wCBp->queuedCB)();
+		if (wCBp && wCBp->queuedCB) {
+			wCBp->queuedCB();
 		}
 	}
 }
@@ -597,8 +711,8 @@ UVEventLoop::OnAfterWork(uv_work_t *req, int status)
 	UVWorker* wCBp=nullptr;
 	if (req) {
 		wCBp=static_cast<UVWorker*>(req->data);
-		if (wCBp && wCBp->apresCB != nullptr) {
-			(*wCBp->apresCB)();
+		if (wCBp && wCBp->apresCB) {
+			wCBp->apresCB();
 		}
 	}
 }
@@ -617,6 +731,10 @@ UVEventLoop::OnWrite(uv_write_t* req, int status)
 		UVWriter *w = (UVWriter*)req->data;
 		if (w) {
 			w->disposed = true;
+			if (w->done) {
+				WriteCB cb = std::move(w->done);
+				cb(status);
+			}
 		}
 	}
 }
@@ -684,14 +802,14 @@ UVEventLoop::OnConnect(uv_connect_t *req, int status)
 		ocCBp=static_cast<UVReader*>(req->data);
 	}
 	if (ocCBp) {
-		ocCBp->client->socket->data = ocCBp;
+		ocCBp->client->Stream()->data = ocCBp;
 		if (status >= 0) {
-			status = uv_read_start((uv_stream_t*)ocCBp->client->socket, AllocBuffer, OnRead);
+			status = uv_read_start(ocCBp->client->Stream(), AllocBuffer, OnRead);
 		}
 		if (ocCBp->connectCB) {
 			(*ocCBp->connectCB)(req, status);
 		}
-//		ocCBp->client->socket->data = ocCBp->readerCB;
+//		ocCBp->client->Stream()->data = ocCBp->readerCB;
 //		ocCBp->disposed = true;
 	}
 }
@@ -735,17 +853,22 @@ UVEventLoop::OnResolved(uv_getaddrinfo_t *resolver, int status, struct addrinfo
 	if (resolver) {
 		ocCBp=static_cast<UVResolver*>(resolver->data);
 	}
-	sockaddr adr;
-	if (status >= 0 && res->ai_addr) {
-		adr = *res->ai_addr;
-		if (ocCBp && ocCBp->client && ocCBp->client->address) {
-			*ocCBp->client->address = adr;
+	UVAddresses adrs;
+	if (status >= 0) {
+		for (struct addrinfo* ai=res; ai!=nullptr; ai=ai->ai_next) {
+			if (ai->ai_addr == nullptr || (ai->ai_family != AF_INET && ai->ai_family != AF_INET6)) continue;
+			UVAddress a(ai->ai_addr);
+			bool seen = false;
+			for (auto& it: adrs) {
+				if (it == a) seen = true;
+			}
+			if (!seen) adrs.push_back(a);
 		}
 		uv_freeaddrinfo(res);
 	}
 	if (ocCBp) {
 		if (ocCBp->bindCB) {
-			(*ocCBp->bindCB)(&adr, status);
+			(*ocCBp->bindCB)(adrs, status);
 		}
 		ocCBp->disposed = true;
 	}
@@ -758,23 +881,84 @@ UVEventLoop::OnResolved(uv_getaddrinfo_t *resolver, int status, struct addrinfo
 UVTCPClient::UVTCPClient()
 {
 	socket = new uv_tcp_t();
-	address = new sockaddr();
-	DEBUG_OUT("UVTCPClient::UVTCPClient() " << sizeof(uv_tcp_t) << ", " << sizeof(sockaddr));
+	address = (sockaddr*) new sockaddr_storage(); // room for an ipv6 address
+	DEBUG_OUT("UVTCPClient::UVTCPClient() " << sizeof(uv_tcp_t) << ", " << sizeof(sockaddr_storage));
 }
 
 UVTCPClient::~UVTCPClient()
 {
-	DEBUG_OUT("UVTCPClient::~UVTCPClient() " << sizeof(uv_tcp_t) << ", " << sizeof(sockaddr));
+	DEBUG_OUT("UVTCPClient::~UVTCPClient() " << sizeof(uv_tcp_t) << ", " << sizeof(sockaddr_storage));
 	delete socket;
-	delete address;
+	delete pipe;
+	delete (sockaddr_storage*) address;
+}
+
+/**
+ * connect over a unix domain socket (a named pipe on windows) at path, rather than tcp
+ */
+void
+UVTCPClient::UsePipe(const std::string path)
+{
+	if (pipe == nullptr) pipe = new uv_pipe_t();
+	pipeName = path;
 }
 
 std::string
 UVTCPClient::IP4Addr() const
 {
-	std::string s;
-	char addr[17] = {'\0'};
-	uv_ip4_name((struct sockaddr_in*) address, addr, 16);
-	s.assign(addr, strlen(addr));
-	return s;
+	return UVAddress(address).Name();
+}
+
+void
+UVTCPClient::SetAddress(const UVAddress& a)
+{
+	memcpy(address, a.storage, sizeof(sockaddr_storage));
+}
+
+/**
+ * UVAddress UVForwards.h
+ */
+static_assert(sizeof(sockaddr_storage) <= UVAddress::kStorageSize, "UVAddress too small for a sockaddr_storage");
+
+UVAddress::UVAddress()
+{
+	memset(storage, 0, kStorageSize);
+}
+
+UVAddress::UVAddress(const struct sockaddr* a)
+{
+	memset(storage, 0, kStorageSize);
+	if (a == nullptr) return;
+	size_t n = a->sa_family == AF_INET6? sizeof(sockaddr_in6) : a->sa_family == AF_INET? sizeof(sockaddr_in) : sizeof(sockaddr);
+	memcpy(storage, a, n);
+}
+
+int
+UVAddress::Family() const
+{
+	return Get()->sa_family;
+}
+
+bool
+UVAddress::IsIP6() const
+{
+	return Family() == AF_INET6;
+}
+
+std::string
+UVAddress::Name() const
+{
+	char addr[INET6_ADDRSTRLEN+1] = {'\0'};
+	if (IsIP6()) {
+		uv_ip6_name((const struct sockaddr_in6*) storage, addr, INET6_ADDRSTRLEN);
+	} else {
+		uv_ip4_name((const struct sockaddr_in*) storage, addr, INET6_ADDRSTRLEN);
+	}
+	return std::string(addr);
+}
+
+bool
+UVAddress::operator==(const UVAddress& a) const
+{
+	return memcmp(storage, a.storage, kStorageSize) == 0;
 }
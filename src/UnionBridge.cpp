@@ -26,6 +26,10 @@
  * - Event::READY, {}, UPC::Status::SUCCESS ... we're ready to go
  * - Event::DISCONNECTED, {}, UPC::Status::SUCCESS ... we've successfully and totally disconnected from the server
  * - Event::SELECT_CONNECTION, {args}, status ... specific underlying connection is changed
+ *		- UPC::Status::CONNECTION_UPGRADE, {msg} ... mid session, the connector drained a fallback transport and moved to a better one. a new
+ *		session follows, with BEGIN_CONNECT, CONNECTED and READY as for any other, and what the old one was subscribed to is put back
+ * - Event::SEND_QUEUE_HIGH, {bytes}, count ... the connection's send queue is filling up, so ease off
+ * - Event::SEND_QUEUE_DRAINED, {bytes}, count ... and it's back down again
  * - Event::CONNECT_FAILURE, {msg}, status is either an io status (-ve) or one of the following (which are signalled by UPC messages):
  *		- UPC::Status::CONNECT_REFUSED, {reason, description}, UPC::Status::UPC_ERROR ... connection wasn't allowed
  *		- UPC::Status::PROTOCOL_INCOMPATIBLE, {version} ... connection wasn't allowed
@@ -35,6 +39,7 @@
  *		- UPC::Status::CLIENT_KILL_CONNECT, {msg} ... we or our own code cut off
  *		- UPC::Status::NO_VALID_CONNECTION_AVAILABLE, {msg} ... or we ran out of options for connections
  *		- UPC::Status::CONNECT_TIMEOUT, {msg} ... or we timed out
+ *		- UPC::Status::CONNECTION_FAILOVER, {msg} ... the session's transport died, and the connector has a warm standby to reconnect on at once
  * - Event::BEGIN_CONNECT, {}, connectionState ... used by the timeout subsystem
  * - Event::CONNECTED, {}, connectionState ... signalled when we have
  * More detailed info about the connecting and disconnecting are obtained from the following. todo these last 3 of these are completely pointless and redundant implementations of the js client's api.
@@ -45,7 +50,8 @@
  */
 using namespace std::placeholders;
 UnionBridge::UnionBridge(AbstractConnector &c, RoomManager &roomManager, ClientManager& clientManager, AccountManager& accountManager, ILogger &log)
-	: roomManager(roomManager)
+	: restorer(roomManager, clientManager, accountManager, log)
+	, roomManager(roomManager)
 	, clientManager(clientManager)
 	, accountManager(accountManager)
 	, connector(c)
@@ -70,6 +76,7 @@ UnionBridge::UnionBridge(AbstractConnector &c, RoomManager &roomManager, ClientM
 	connectListener = std::make_shared<CBConnection>(std::bind(&UnionBridge::ConnectListener,this, _1, _2, _3, _4));
 	disconnectListener = std::make_shared<CBConnection>(std::bind(&UnionBridge::DisconnectListener,this, _1, _2, _3, _4));
 	selectListener = std::make_shared<CBConnection>(std::bind(&UnionBridge::SelectListener,this, _1, _2, _3, _4));
+	sendQueueListener = std::make_shared<CBConnection>(std::bind(&UnionBridge::SendQueueListener,this, _1, _2, _3, _4));
 	ioErrorListener = std::make_shared<CBConnection>(std::bind(&UnionBridge::IOErrorListener,this, _1, _2, _3, _4));
 	connectFailureListener = std::make_shared<CBConnection>(std::bind(&UnionBridge::ConnectFailureListener,this, _1, _2, _3, _4));
 
@@ -374,6 +381,7 @@ void
 UnionBridge::SetEventLoop(EventLoop *l)
 {
 	loop = l;
+	connector.SetEventLoop(l);
 	if (queueNotifications) {
 		if (loop != nullptr) {
 			loop->Worker([this]() {
@@ -392,6 +400,8 @@ UnionBridge::AddSelfConnectionListeners(const NXConnection& notifier)
 	connector.AddListener(Event::DISCONNECTED, disconnectListener);
 	connector.AddListener(Event::CONNECTED, connectListener);
 	connector.AddListener(Event::SELECT_CONNECTION, selectListener);
+	connector.AddListener(Event::SEND_QUEUE_HIGH, sendQueueListener);
+	connector.AddListener(Event::SEND_QUEUE_DRAINED, sendQueueListener);
 	connector.AddListener(Event::IO_ERROR, ioErrorListener);
 	connector.AddListener(Event::CONNECT_FAILURE, connectFailureListener);
 }
@@ -405,6 +415,8 @@ UnionBridge::RemoveSelfConnectionListeners(const NXConnection& notifier)
 	connector.RemoveListener(Event::DISCONNECTED, disconnectListener);
 	connector.RemoveListener(Event::CONNECTED, connectListener);
 	connector.RemoveListener(Event::SELECT_CONNECTION, selectListener);
+	connector.RemoveListener(Event::SEND_QUEUE_HIGH, sendQueueListener);
+	connector.RemoveListener(Event::SEND_QUEUE_DRAINED, sendQueueListener);
 	connector.RemoveListener(Event::IO_ERROR, ioErrorListener);
 	connector.RemoveListener(Event::CONNECT_FAILURE, connectFailureListener);
 	log.Debug("Done removing listeners");
@@ -444,6 +456,8 @@ UnionBridge::SendUPC(UPCMessageID messageID, StringArgs args)
 		return;
 	}
 
+	restorer.WillSend(messageID, args);
+
 	std::string theUPC = "<U><M>" + msgID + "</M>";
 
 	if (args.size() > 0) {
@@ -464,7 +478,9 @@ UnionBridge::SendUPC(UPCMessageID messageID, StringArgs args)
 
 	numMessagesSent++;
 	log.Debug("[UNION_BRIDGE] UPC sent: " + theUPC);
-	connector.Send(theUPC);
+	if (connector.Send(theUPC) < 0) {
+		log.Warn("[UNION_BRIDGE] UPC not sent: " + msgID);
+	}
 }
 
 /**
@@ -519,6 +535,15 @@ UnionBridge::GetNumMessagesReceived() const {
   return numMessagesReceived;
 }
 
+/**
+ * @return the total bytes of upc received, over all connections. only ever goes up, so the ConnectionMonitor can see if anything has
+ * come in since it last looked
+ */
+uint64_t
+UnionBridge::GetNumBytesReceived() const {
+	return numBytesReceived;
+}
+
 /**
  * @return the total messages sent
  */
@@ -535,6 +560,117 @@ UnionBridge::GetTotalMessages() const {
   return numMessagesSent + numMessagesReceived;
 }
 
+/**
+ * when notifications are queued, and the loop falls more than n messages behind, superseded attribute and occupant count updates in the
+ * backlog are dropped before they are handled. see UPCConflator
+ * @param n backlog size that triggers conflation, 0 (the default) for never
+ */
+void
+UnionBridge::SetConflationThreshold(const size_t n)
+{
+	conflator.SetThreshold(n);
+}
+
+/**
+ * @return the number of inbound messages dropped by conflation
+ */
+int
+UnionBridge::GetNumConflated() const {
+	return conflator.GetNumConflated();
+}
+
+/**
+ * @return the number of inbound messages of the given upc method dropped by conflation
+ */
+int
+UnionBridge::GetNumConflated(const int method) const {
+	return conflator.GetNumConflated(method);
+}
+
+/**
+ * set the priority class of queued notifications for the given upc method. see UPCScheduler
+ * @param method upc method number, eg 72 for JOIN_ROOM_RESULT
+ * @param priority one of UPCScheduler::kPriorityControl, kPriorityNormal or kPriorityBulk
+ */
+void
+UnionBridge::SetUPCPriority(const int method, const int priority)
+{
+	scheduler.SetPriority(method, priority);
+}
+
+/**
+ * @return the priority class of queued notifications for the given upc method
+ */
+int
+UnionBridge::GetUPCPriority(const int method) const {
+	return scheduler.GetPriority(method);
+}
+
+/**
+ * @return histogram of how many messages of the given priority class were in each batch of queued notifications
+ */
+const Histogram&
+UnionBridge::GetQueueDepthHistogram(const int priority) const {
+	return scheduler.GetDepthHistogram(priority);
+}
+
+/**
+ * @return histogram of how long, in microseconds, queued notifications of the given priority class waited to be handled
+ */
+const Histogram&
+UnionBridge::GetQueueWaitHistogram(const int priority) const {
+	return scheduler.GetWaitHistogram(priority);
+}
+
+/**
+ * @return the restorer that puts back our rooms, watches and attributes when a lost session reconnects. see SessionRestorer
+ */
+SessionRestorer&
+UnionBridge::GetSessionRestorer()
+{
+	return restorer;
+}
+
+/**
+ * ping at the transport level, eg a websocket ping frame, if the current connection has such a thing
+ * @return less than zero if it doesn't, or we aren't connected
+ */
+int
+UnionBridge::SendTransportPing() {
+	if (!IsReady()) {
+		return -1;
+	}
+	return connector.SendPing();
+}
+
+/**
+ * @return round trip times from transport level pings, or nullptr if the current connection doesn't do them
+ */
+const RTTStats*
+UnionBridge::GetTransportRTTStats() const {
+	return connector.GetRTTStats();
+}
+
+/**
+ * Dispatcher hook, called on the loop thread with each batch of queued notifications before any are handled. superseded updates go first,
+ * then what's left is put in priority order
+ */
+void
+UnionBridge::PrepareDispatches(std::vector<ER>& batch)
+{
+	conflator.Conflate(batch);
+	scheduler.Schedule(batch);
+}
+
+/**
+ * Dispatcher hook, called as each queued notification is handled
+ */
+void
+UnionBridge::WillDispatch(const ER& event)
+{
+	scheduler.WillDispatch(event);
+}
+
 int
 UnionBridge::GetConnectAttemptCount() const {
 	return connectAttemptCount;
@@ -562,7 +698,7 @@ UnionBridge::GetReadyCount() const
  * @param status io status
  */
 void
-UnionBridge::ConnectListener(EventType t, CnxRef c, std::string args, ConnectionStatus status) {
+UnionBridge::ConnectListener(EventType t, CnxRef c, const std::string& args, ConnectionStatus status) {
 	log.Info("Commencing UPC handshake ...");
 	NxBeginHandshake();
 	SendHelloMessage();
@@ -576,8 +712,25 @@ UnionBridge::ConnectListener(EventType t, CnxRef c, std::string args, Connection
  * @param status io status
  */
 void
-UnionBridge::SelectListener(EventType t, CnxRef c, std::string args, ConnectionStatus status) {
+UnionBridge::SelectListener(EventType t, CnxRef c, const std::string& args, ConnectionStatus status) {
 	NotifyListeners(Event::SELECT_CONNECTION, {args}, status);
+	if (status == UPC::Status::CONNECTION_UPGRADE) { // the old session is gone with its transport, and the new one is on its way
+		restorer.OnSessionLost();
+		NxBeginConnect();
+		SetConnectionState(ConnectionState::CONNECTION_IN_PROGRESS);
+	}
+}
+
+/**
+ * Event::SEND_QUEUE_HIGH and Event::SEND_QUEUE_DRAINED listener
+ * @param t EventType
+ * @param c the connection
+ * @param args bytes queued
+ * @param status messages queued
+ */
+void
+UnionBridge::SendQueueListener(EventType t, CnxRef c, const std::string& args, ConnectionStatus status) {
+	NotifyListeners(t, {args}, status);
 }
 /**
  * Event::DISCONNECTED listener
@@ -587,7 +740,7 @@ UnionBridge::SelectListener(EventType t, CnxRef c, std::string args, ConnectionS
  * @param status io status
  */
 void
-UnionBridge::DisconnectListener(EventType t, CnxRef c, std::string, ConnectionStatus status) {
+UnionBridge::DisconnectListener(EventType t, CnxRef c, const std::string&, ConnectionStatus status) {
 	NxDisconnected();
 	CleanupClosedConnection();
 }
@@ -600,7 +753,7 @@ UnionBridge::DisconnectListener(EventType t, CnxRef c, std::string, ConnectionSt
  * @param status io status
  */
 void
-UnionBridge::ConnectFailureListener(EventType t, CnxRef c, std::string msg, ConnectionStatus status) {
+UnionBridge::ConnectFailureListener(EventType t, CnxRef c, const std::string& msg, ConnectionStatus status) {
 	log.Info("[UNION_BRIDGE] Cleaning up after unfortunate connection failure ...");
 	NxConnectFailure(msg, status);
 	CleanupClosedConnection();
@@ -618,7 +771,7 @@ UnionBridge::ConnectFailureListener(EventType t, CnxRef c, std::string msg, Conn
  * @param status io status
  */
 void
-UnionBridge::IOErrorListener(EventType t, CnxRef c, std::string err, ConnectionStatus status) {
+UnionBridge::IOErrorListener(EventType t, CnxRef c, const std::string& err, ConnectionStatus status) {
 	NxIOError(err, status);
 	log.Error("Connector IO Error "+err);
 }
@@ -631,7 +784,7 @@ UnionBridge::IOErrorListener(EventType t, CnxRef c, std::string err, ConnectionS
  * @param status io status
  */
 void
-UnionBridge::UpcSentListener(EventType t, CnxRef c, std::string upc, ConnectionStatus status) {
+UnionBridge::UpcSentListener(EventType t, CnxRef c, const std::string& upc, ConnectionStatus status) {
 	NxSendData(upc);
 }
 /**
@@ -642,8 +795,9 @@ UnionBridge::UpcSentListener(EventType t, CnxRef c, std::string upc, ConnectionS
  * @param status io status
  */
 void
-UnionBridge::UpcReceivedListener(EventType t, CnxRef c, std::string upc, ConnectionStatus status) {
+UnionBridge::UpcReceivedListener(EventType t, CnxRef c, const std::string& upc, ConnectionStatus status) {
 	numMessagesReceived++;
+	numBytesReceived += upc.size();
 
 	log.Debug("[UNION_BRIDGE] Message received: " + upc );
 
@@ -684,7 +838,7 @@ UnionBridge::UpcReceivedListener(EventType t, CnxRef c, std::string upc, Connect
 					dataElement = dataElement->NextSiblingElement("A");
 				}
 			}
-			NxUPCMethod(method, upcArgs);
+			NxUPCMethod(method, std::move(upcArgs));
 		} else {
 			log.Error("UPC error, not a UPC message");
 		}
@@ -702,6 +856,7 @@ UnionBridge::UpcReceivedListener(EventType t, CnxRef c, std::string upc, Connect
 void
 UnionBridge::CleanupClosedConnection() {
 	SetConnectionState(ConnectionState::NOT_CONNECTED);
+	restorer.OnSessionLost();
 	if (removeListenersOnDisconnect) {
 		log.Info("[UNION_BRIDGE] Removing registered message listeners.");
 		RemoveSelfConnectionListeners(connector);
@@ -710,6 +865,17 @@ UnionBridge::CleanupClosedConnection() {
 	}
 }
 
+/**
+ * on READY, send everything the lost session was subscribed to in one go, without waiting on any of the results
+ */
+void
+UnionBridge::RestoreSession() {
+	std::vector<SessionRestorer::Request> burst = restorer.Replay();
+	for (auto it=burst.begin(); it!=burst.end(); ++it) {
+		SendUPC(it->messageID, it->args);
+	}
+}
+
 /**
  * add the corresponding type of UPC callback ... really we are only interested in the incoming and handshake/system requests
  */
@@ -1211,12 +1377,12 @@ UnionBridge::RemoveUPCListener(const EventType eventType, const CBUPCRef listene
 }
 
 CBUPCRef
-UnionBridge::AddUPCListener(const EventType eventType, const CBUPC listener) const {
+UnionBridge::AddUPCListener(const EventType eventType, CBUPC listener) const {
 	if (queueNotifications && loop != nullptr) {
 		if (loop == nullptr) return CBUPCRef();
 		loop->Lock();
 	}
-	auto r = AddEventListener(eventType, listener);
+	auto r = AddEventListener(eventType, std::move(listener));
 	if (queueNotifications && loop != nullptr) {
 		loop->Unlock();
 	}
@@ -1352,10 +1518,10 @@ UnionBridge::NxConnectRefused(std::string reason, std::string description) {
  * NotifyUPCMessage hook
  */
 void
-UnionBridge::NxUPCMethod(const int method, const StringArgs upcArgs)
+UnionBridge::NxUPCMethod(const int method, StringArgs upcArgs)
 {
 	if (queueNotifications) {
-		DispatchEvent(method, upcArgs, UPC::Status::SUCCESS);
+		DispatchEvent(method, std::move(upcArgs), UPC::Status::SUCCESS); // may be conflated in PrepareDispatches()
 	}
 	else {
 		NotifyListeners(method, upcArgs, UPC::Status::SUCCESS);
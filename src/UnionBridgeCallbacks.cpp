@@ -21,23 +21,23 @@
  * be useful to keep these as entry points to trigger server side actions by message
  */
 void
-UnionBridge::U1(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* SEND_MESSAGE_TO_ROOMS */
+UnionBridge::U1(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* SEND_MESSAGE_TO_ROOMS */
 {
 }
 void
-UnionBridge::U2(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* SEND_MESSAGE_TO_CLIENTS */
+UnionBridge::U2(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* SEND_MESSAGE_TO_CLIENTS */
 {
 }
 void
-UnionBridge::U3(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* SET_CLIENT_ATTR */
+UnionBridge::U3(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* SET_CLIENT_ATTR */
 {
 }
 void
-UnionBridge::U4(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* JOIN_ROOM */
+UnionBridge::U4(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* JOIN_ROOM */
 {
 }
 void
-UnionBridge::U5(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* SET_ROOM_ATTR */
+UnionBridge::U5(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* SET_ROOM_ATTR */
 {
 }
 
@@ -48,7 +48,7 @@ UnionBridge::U5(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
  * @param ioStatus any io event status recieved
  */
 void
-UnionBridge::U6(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* JOINED_ROOM */
+UnionBridge::U6(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* JOINED_ROOM */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] u6, malformed packet, argument mismatch, ignoring");
@@ -77,7 +77,7 @@ UnionBridge::U6(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
  * @param ioStatus any io event status recieved
  */
 void
-UnionBridge::U7(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* RECEIVE_MESSAGE */
+UnionBridge::U7(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* RECEIVE_MESSAGE */
 {
 	if (args.size() < 4)  {
 		log.Error("[UNION BRIDGE] u7, malformed packet, argument mismatch, ignoring");
@@ -122,7 +122,11 @@ UnionBridge::U7(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 		NotifyMessageListeners(messageID, {}, {}, messageBody);
 	} else if (broadcastType == RxMsgBroadcastType::TO_ROOMS){
 		log.Debug("broadcasting to rooms" + roomID);
-		NotifyMessageListeners(messageID, {}, {roomID}, messageBody);
+		if (clientID != "") { // the sender, so that listeners for that client hear it too
+			NotifyMessageListeners(messageID, {clientID}, {roomID}, messageBody);
+		} else {
+			NotifyMessageListeners(messageID, {}, {roomID}, messageBody);
+		}
 
 #ifdef MESSAGE_FILTERS_ON_LISTENERS
 		UPCStatus status = UPC::Status::SUCCESS;
@@ -231,7 +235,7 @@ UnionBridge::U7(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
  * callback for client attribute update
  */
 void
-UnionBridge::U8(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CLIENT_ATTR_UPDATE */
+UnionBridge::U8(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CLIENT_ATTR_UPDATE */
 {
 	if (args.size() < 6)  {
 		log.Error("[UNION BRIDGE] u8, malformed packet, argument mismatch, ignoring");
@@ -270,7 +274,7 @@ UnionBridge::U8(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U9(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* ROOM_ATTR_UPDATE */
+UnionBridge::U9(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* ROOM_ATTR_UPDATE */
 {
 	if (args.size() < 4)  {
 		log.Error("[UNION BRIDGE] u9, malformed packet, argument mismatch, ignoring");
@@ -307,56 +311,56 @@ UnionBridge::U9(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 }
 
 void
-UnionBridge::U10(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* LEAVE_ROOM */
+UnionBridge::U10(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* LEAVE_ROOM */
 {
 }
 void
-UnionBridge::U11(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CREATE_ACCOUNT */
+UnionBridge::U11(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CREATE_ACCOUNT */
 {
 }
 void
-UnionBridge::U12(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* REMOVE_ACCOUNT */
+UnionBridge::U12(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* REMOVE_ACCOUNT */
 {
 }
 void
-UnionBridge::U13(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CHANGE_ACCOUNT_PASSWORD */
+UnionBridge::U13(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CHANGE_ACCOUNT_PASSWORD */
 {
 }
 void
-UnionBridge::U14(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* LOGIN */
+UnionBridge::U14(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* LOGIN */
 {
 }
 void
-UnionBridge::U18(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* GET_CLIENTCOUNT_SNAPSHOT */
+UnionBridge::U18(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* GET_CLIENTCOUNT_SNAPSHOT */
 {
 }
 void
-UnionBridge::U19(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* SYNC_TIME */
+UnionBridge::U19(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* SYNC_TIME */
 {
 }
 void
-UnionBridge::U21(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* GET_ROOMLIST_SNAPSHOT */
+UnionBridge::U21(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* GET_ROOMLIST_SNAPSHOT */
 {
 }
 void
-UnionBridge::U24(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CREATE_ROOM */
+UnionBridge::U24(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CREATE_ROOM */
 {
 }
 void
-UnionBridge::U25(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* REMOVE_ROOM */
+UnionBridge::U25(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* REMOVE_ROOM */
 {
 }
 void
-UnionBridge::U26(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* WATCH_FOR_ROOMS */
+UnionBridge::U26(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* WATCH_FOR_ROOMS */
 {
 }
 void
-UnionBridge::U27(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* STOP_WATCHING_FOR_ROOMS */
+UnionBridge::U27(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* STOP_WATCHING_FOR_ROOMS */
 {
 }
 
 void
-UnionBridge::U29(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CLIENT_METADATA */
+UnionBridge::U29(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CLIENT_METADATA */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] u29, malformed packet, argument mismatch, ignoring");
@@ -369,7 +373,7 @@ UnionBridge::U29(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 }
 
 void
-UnionBridge::U32(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CREATE_ROOM_RESULT */
+UnionBridge::U32(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CREATE_ROOM_RESULT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] u32, malformed packet, argument mismatch, ignoring");
@@ -392,7 +396,7 @@ UnionBridge::U32(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U33(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* REMOVE_ROOM_RESULT */
+UnionBridge::U33(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* REMOVE_ROOM_RESULT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] u33, malformed packet, argument mismatch, ignoring");
@@ -428,7 +432,7 @@ UnionBridge::U33(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U34(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CLIENTCOUNT_SNAPSHOT */
+UnionBridge::U34(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CLIENTCOUNT_SNAPSHOT */
 {
 	if (args.size() < 2) {
 		log.Error("[UNION BRIDGE] u34, malformed packet, argument mismatch, ignoring");
@@ -442,7 +446,7 @@ UnionBridge::U34(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 #endif
 }
 void
-UnionBridge::U36(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CLIENT_ADDED_TO_ROOM */
+UnionBridge::U36(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CLIENT_ADDED_TO_ROOM */
 {
 	if (args.size() < 5) {
 		log.Error("[UNION BRIDGE] u36, malformed packet, argument mismatch, ignoring");
@@ -482,7 +486,7 @@ UnionBridge::U36(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 
 }
 void
-UnionBridge::U37(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CLIENT_REMOVED_FROM_ROOM */
+UnionBridge::U37(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CLIENT_REMOVED_FROM_ROOM */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] u37, malformed packet, argument mismatch, ignoring");
@@ -506,7 +510,7 @@ UnionBridge::U37(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U38(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* ROOMLIST_SNAPSHOT */
+UnionBridge::U38(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* ROOMLIST_SNAPSHOT */
 {
 	if (args.size() < 3)  {
 		log.Error("[UNION BRIDGE] u38, malformed packet, argument mismatch, ignoring");
@@ -545,7 +549,7 @@ UnionBridge::U38(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U39(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* ROOM_ADDED */
+UnionBridge::U39(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* ROOM_ADDED */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] u39, malformed packet, argument mismatch, ignoring");
@@ -557,7 +561,7 @@ UnionBridge::U39(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 
 }
 void
-UnionBridge::U40(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* ROOM_REMOVED */
+UnionBridge::U40(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* ROOM_REMOVED */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] u40, malformed packet, argument mismatch, ignoring");
@@ -571,7 +575,7 @@ UnionBridge::U40(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U42(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* WATCH_FOR_ROOMS_RESULT */
+UnionBridge::U42(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* WATCH_FOR_ROOMS_RESULT */
 {
 	if (args.size() < 3)  {
 		log.Error("[UNION BRIDGE] u42, malformed packet, argument mismatch, ignoring");
@@ -596,9 +600,10 @@ UnionBridge::U42(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 		log.Warn("Unrecognized status code for u42. Room ID Qualifier: [" + roomIdQualifier + "], recursive: ["
 				+ bool_to_string(recursive) + "], status: [" + UPC::Status::GetStatusString(status) + "].");
 	}
+	restorer.OnResult(UPC::ID::WATCH_FOR_ROOMS_RESULT, roomIdQualifier, status);
 }
 void
-UnionBridge::U43(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* STOP_WATCHING_FOR_ROOMS_RESULT */
+UnionBridge::U43(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* STOP_WATCHING_FOR_ROOMS_RESULT */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] u43, malformed packet, argument mismatch, ignoring");
@@ -629,7 +634,7 @@ UnionBridge::U43(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U44(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* LEFT_ROOM */
+UnionBridge::U44(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* LEFT_ROOM */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] u44, malformed packet, argument mismatch, ignoring");
@@ -646,7 +651,7 @@ UnionBridge::U44(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U46(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CHANGE_ACCOUNT_PASSWORD_RESULT */
+UnionBridge::U46(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CHANGE_ACCOUNT_PASSWORD_RESULT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] u46, malformed packet, argument mismatch, ignoring");
@@ -664,7 +669,7 @@ UnionBridge::U46(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 
 }
 void
-UnionBridge::U47(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CREATE_ACCOUNT_RESULT */
+UnionBridge::U47(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CREATE_ACCOUNT_RESULT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] u47, malformed packet, argument mismatch, ignoring");
@@ -686,7 +691,7 @@ UnionBridge::U47(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U48(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* REMOVE_ACCOUNT_RESULT */
+UnionBridge::U48(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* REMOVE_ACCOUNT_RESULT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] u48, malformed packet, argument mismatch, ignoring");
@@ -709,7 +714,7 @@ UnionBridge::U48(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U49(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* LOGIN_RESULT */
+UnionBridge::U49(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* LOGIN_RESULT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] u49, malformed packet, argument mismatch, ignoring");
@@ -733,12 +738,12 @@ UnionBridge::U49(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U50(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* SERVER_TIME_UPDATE */
+UnionBridge::U50(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* SERVER_TIME_UPDATE */
 {
 }
 
 void
-UnionBridge::U54(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* ROOM_SNAPSHOT */
+UnionBridge::U54(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* ROOM_SNAPSHOT */
 {
 	if (args.size() < 5)  {
 		log.Error("[UNION BRIDGE] u54, malformed packet, argument mismatch, ignoring");
@@ -782,19 +787,19 @@ UnionBridge::U54(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U55(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* GET_ROOM_SNAPSHOT */
+UnionBridge::U55(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* GET_ROOM_SNAPSHOT */
 {
 }
 void
-UnionBridge::U57(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* SEND_MESSAGE_TO_SERVER */
+UnionBridge::U57(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* SEND_MESSAGE_TO_SERVER */
 {
 }
 void
-UnionBridge::U58(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* OBSERVE_ROOM */
+UnionBridge::U58(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* OBSERVE_ROOM */
 {
 }
 void
-UnionBridge::U59(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* OBSERVED_ROOM */
+UnionBridge::U59(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* OBSERVED_ROOM */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] u59, malformed packet, argument mismatch, ignoring");
@@ -812,7 +817,7 @@ UnionBridge::U59(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U60(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* GET_ROOM_SNAPSHOT_RESULT */
+UnionBridge::U60(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* GET_ROOM_SNAPSHOT_RESULT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] u60, malformed packet, argument mismatch, ignoring");
@@ -840,11 +845,11 @@ UnionBridge::U60(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 #endif
 }
 void
-UnionBridge::U61(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* STOP_OBSERVING_ROOM */
+UnionBridge::U61(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* STOP_OBSERVING_ROOM */
 {
 }
 void
-UnionBridge::U62(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* STOPPED_OBSERVING_ROOM */
+UnionBridge::U62(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* STOPPED_OBSERVING_ROOM */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] u62, malformed packet, argument mismatch, ignoring");
@@ -863,20 +868,21 @@ UnionBridge::U62(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U63(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CLIENT_READY */
+UnionBridge::U63(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CLIENT_READY */
 {
 	SetConnectionState(ConnectionState::READY);
 	mostRecentConnectAchievedReady = true;
 	readyCount++;
 	connectAttemptCount = 0;
+	RestoreSession();
 	NxReady();
 }
 void
-UnionBridge::U64(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* SET_ROOM_UPDATE_LEVELS */
+UnionBridge::U64(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* SET_ROOM_UPDATE_LEVELS */
 {
 }
 void
-UnionBridge::U65(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CLIENT_HELLO */
+UnionBridge::U65(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CLIENT_HELLO */
 {
 }
 
@@ -887,7 +893,7 @@ UnionBridge::U65(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
  * to do with affinity, and sessionID
  */
 void
-UnionBridge::U66(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* SERVER_HELLO */
+UnionBridge::U66(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* SERVER_HELLO */
 {
 	if (args.size() < 6)  {
 		log.Error("[UNION BRIDGE] u66, malformed packet, argument mismatch, ignoring");
@@ -917,24 +923,24 @@ UnionBridge::U66(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 }
 
 void
-UnionBridge::U67(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* REMOVE_ROOM_ATTR */
+UnionBridge::U67(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* REMOVE_ROOM_ATTR */
 {
 }
 void
-UnionBridge::U69(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* REMOVE_CLIENT_ATTR */
+UnionBridge::U69(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* REMOVE_CLIENT_ATTR */
 {
 }
 void
-UnionBridge::U70(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* SEND_ROOMMODULE_MESSAGE */
+UnionBridge::U70(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* SEND_ROOMMODULE_MESSAGE */
 {
 }
 void
-UnionBridge::U71(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* SEND_SERVERMODULE_MESSAGE */
+UnionBridge::U71(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* SEND_SERVERMODULE_MESSAGE */
 {
 }
 
 void
-UnionBridge::U72(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* JOIN_ROOM_RESULT */
+UnionBridge::U72(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* JOIN_ROOM_RESULT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] u72, malformed packet, argument mismatch, ignoring");
@@ -970,9 +976,10 @@ UnionBridge::U72(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	default:
 		log.Warn("Unrecognized status code for u72. Room ID: [" + roomID + "], status: [" + UPC::Status::GetStatusString(status) + "].");
 	}
+	restorer.OnResult(UPC::ID::JOIN_ROOM_RESULT, roomID, status);
 }
 void
-UnionBridge::U73(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* SET_CLIENT_ATTR_RESULT */
+UnionBridge::U73(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* SET_CLIENT_ATTR_RESULT */
 {
 	log.Debug("doing a client attribute update");
 	if (args.size() < 6)  {
@@ -1017,9 +1024,10 @@ UnionBridge::U73(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 		log.Warn("Unrecognized status received for u73: " + UPC::Status::GetStatusString(status));
 	}
 	log.Debug("done a client attribute update");
+	restorer.OnResult(UPC::ID::SET_CLIENT_ATTR_RESULT, attrScope + "|" + attrName, status);
 }
 void
-UnionBridge::U74(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* SET_ROOM_ATTR_RESULT */
+UnionBridge::U74(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* SET_ROOM_ATTR_RESULT */
 {
 	if (args.size() < 3)  {
 		log.Error("[UNION BRIDGE] u74, malformed packet, argument mismatch, ignoring");
@@ -1055,7 +1063,7 @@ UnionBridge::U74(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U75(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* GET_CLIENTCOUNT_SNAPSHOT_RESULT */
+UnionBridge::U75(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* GET_CLIENTCOUNT_SNAPSHOT_RESULT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] u75, malformed packet, argument mismatch, ignoring");
@@ -1069,7 +1077,7 @@ UnionBridge::U75(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 #endif
 }
 void
-UnionBridge::U76(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* LEAVE_ROOM_RESULT */
+UnionBridge::U76(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* LEAVE_ROOM_RESULT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] u76, malformed packet, argument mismatch, ignoring");
@@ -1101,7 +1109,7 @@ UnionBridge::U76(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U77(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* OBSERVE_ROOM_RESULT */
+UnionBridge::U77(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* OBSERVE_ROOM_RESULT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] u77, malformed packet, argument mismatch, ignoring");
@@ -1133,9 +1141,10 @@ UnionBridge::U77(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	default:
 		log.Warn("Unrecognized status code for u77.  Room ID: [" + roomID + "], status: " + UPC::Status::GetStatusString(status) + ".");
 	}
+	restorer.OnResult(UPC::ID::OBSERVE_ROOM_RESULT, roomID, status);
 }
 void
-UnionBridge::U78(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* STOP_OBSERVING_ROOM_RESULT */
+UnionBridge::U78(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* STOP_OBSERVING_ROOM_RESULT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] u78, malformed packet, argument mismatch, ignoring");
@@ -1167,7 +1176,7 @@ UnionBridge::U78(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U79(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* ROOM_ATTR_REMOVED */
+UnionBridge::U79(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* ROOM_ATTR_REMOVED */
 {
 	if (args.size() < 3)  {
 		log.Error("[UNION BRIDGE] u79, malformed packet, argument mismatch, ignoring");
@@ -1195,7 +1204,7 @@ UnionBridge::U79(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	theRoom->RemoveAttributeLocal(attrName, Token::GLOBAL_ATTR, theClient);
 }
 void
-UnionBridge::U80(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* REMOVE_ROOM_ATTR_RESULT */
+UnionBridge::U80(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* REMOVE_ROOM_ATTR_RESULT */
 {
 	if (args.size() < 3)  {
 		log.Error("[UNION BRIDGE] u80, malformed packet, argument mismatch, ignoring");
@@ -1225,7 +1234,7 @@ UnionBridge::U80(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U81(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CLIENT_ATTR_REMOVED */
+UnionBridge::U81(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CLIENT_ATTR_REMOVED */
 {
 	if (args.size() < 5)  {
 		log.Error("[UNION BRIDGE] u81, malformed packet, argument mismatch, ignoring");
@@ -1252,7 +1261,7 @@ UnionBridge::U81(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U82(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* REMOVE_CLIENT_ATTR_RESULT */
+UnionBridge::U82(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* REMOVE_CLIENT_ATTR_RESULT */
 {
 	if (args.size() < 6)  {
 		log.Error("[UNION BRIDGE] u82, malformed packet, argument mismatch, ignoring");
@@ -1296,11 +1305,11 @@ UnionBridge::U82(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U83(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* TERMINATE_SESSION */
+UnionBridge::U83(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* TERMINATE_SESSION */
 {
 }
 void
-UnionBridge::U84(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* SESSION_TERMINATED */
+UnionBridge::U84(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* SESSION_TERMINATED */
 {
 	log.Debug("server koff");
 	int state = connectionState;
@@ -1314,7 +1323,7 @@ UnionBridge::U84(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 }
 
 void
-UnionBridge::U85(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* SESSION_NOT_FOUND */
+UnionBridge::U85(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* SESSION_NOT_FOUND */
 {
 	log.Debug("server koff++");
 	int state = connectionState;
@@ -1328,11 +1337,11 @@ UnionBridge::U85(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 }
 
 void
-UnionBridge::U86(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* LOGOFF */
+UnionBridge::U86(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* LOGOFF */
 {
 }
 void
-UnionBridge::U87(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* LOGOFF_RESULT */
+UnionBridge::U87(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* LOGOFF_RESULT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] u87, malformed packet, argument mismatch, ignoring");
@@ -1361,7 +1370,7 @@ UnionBridge::U87(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U88(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* LOGGED_IN */
+UnionBridge::U88(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* LOGGED_IN */
 {
 	if (args.size() < 3)  {
 		log.Error("[UNION BRIDGE] u88, malformed packet, argument mismatch, ignoring");
@@ -1399,7 +1408,7 @@ UnionBridge::U88(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U89(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* LOGGED_OFF */
+UnionBridge::U89(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* LOGGED_OFF */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] u89, malformed packet, argument mismatch, ignoring");
@@ -1428,7 +1437,7 @@ UnionBridge::U89(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 	}
 }
 void
-UnionBridge::U90(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* ACCOUNT_PASSWORD_CHANGED */
+UnionBridge::U90(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* ACCOUNT_PASSWORD_CHANGED */
 {
 	AccountRef selfAccount = clientManager.SelfAccount();
 	if (selfAccount) {
@@ -1438,47 +1447,47 @@ UnionBridge::U90(EventType t, std::vector<std::string> args, UPCStatus ioStatus)
 
 }
 void
-UnionBridge::U91(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* GET_CLIENTLIST_SNAPSHOT */
+UnionBridge::U91(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* GET_CLIENTLIST_SNAPSHOT */
 {
 }
 void
-UnionBridge::U92(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* WATCH_FOR_CLIENTS */
+UnionBridge::U92(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* WATCH_FOR_CLIENTS */
 {
 }
 void
-UnionBridge::U93(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* STOP_WATCHING_FOR_CLIENTS */
+UnionBridge::U93(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* STOP_WATCHING_FOR_CLIENTS */
 {
 }
 void
-UnionBridge::U94(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* GET_CLIENT_SNAPSHOT */
+UnionBridge::U94(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* GET_CLIENT_SNAPSHOT */
 {
 }
 void
-UnionBridge::U95(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* OBSERVE_CLIENT */
+UnionBridge::U95(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* OBSERVE_CLIENT */
 {
 }
 void
-UnionBridge::U96(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* STOP_OBSERVING_CLIENT */
+UnionBridge::U96(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* STOP_OBSERVING_CLIENT */
 {
 }
 void
-UnionBridge::U97(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* GET_ACCOUNTLIST_SNAPSHOT */
+UnionBridge::U97(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* GET_ACCOUNTLIST_SNAPSHOT */
 {
 }
 void
-UnionBridge::U98(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* WATCH_FOR_ACCOUNTS */
+UnionBridge::U98(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* WATCH_FOR_ACCOUNTS */
 {
 }
 void
-UnionBridge::U99(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* STOP_WATCHING_FOR_ACCOUNTS */
+UnionBridge::U99(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* STOP_WATCHING_FOR_ACCOUNTS */
 {
 }
 void
-UnionBridge::U100(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* GET_ACCOUNT_SNAPSHOT */
+UnionBridge::U100(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* GET_ACCOUNT_SNAPSHOT */
 {
 }
 void
-UnionBridge::U101(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CLIENTLIST_SNAPSHOT */
+UnionBridge::U101(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CLIENTLIST_SNAPSHOT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] u101, malformed packet, argument mismatch, ignoring");
@@ -1505,7 +1514,7 @@ UnionBridge::U101(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U102(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CLIENT_ADDED_TO_SERVER */
+UnionBridge::U102(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CLIENT_ADDED_TO_SERVER */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] u102, malformed packet, argument mismatch, ignoring");
@@ -1518,7 +1527,7 @@ UnionBridge::U102(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 
 }
 void
-UnionBridge::U103(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CLIENT_REMOVED_FROM_SERVER */
+UnionBridge::U103(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CLIENT_REMOVED_FROM_SERVER */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] u103, malformed packet, argument mismatch, ignoring");
@@ -1548,7 +1557,7 @@ UnionBridge::U103(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U104(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CLIENT_SNAPSHOT */
+UnionBridge::U104(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CLIENT_SNAPSHOT */
 {
 	if (args.size() < 6)  {
 		log.Error("[UNION BRIDGE] u104, malformed packet, argument mismatch, ignoring");
@@ -1602,7 +1611,7 @@ UnionBridge::U104(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U105(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* OBSERVE_CLIENT_RESULT */
+UnionBridge::U105(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* OBSERVE_CLIENT_RESULT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] u105, malformed packet, argument mismatch, ignoring");
@@ -1628,9 +1637,10 @@ UnionBridge::U105(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	default:
 		log.Warn("Unrecognized status code for u105.  Client ID: [" + clientID + "], status: [" + UPC::Status::GetStatusString(status) + "].");
 	}
+	restorer.OnResult(UPC::ID::OBSERVE_CLIENT_RESULT, clientID, status);
 }
 void
-UnionBridge::U106(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* STOP_OBSERVING_CLIENT_RESULT */
+UnionBridge::U106(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* STOP_OBSERVING_CLIENT_RESULT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -1657,7 +1667,7 @@ UnionBridge::U106(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U107(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* WATCH_FOR_CLIENTS_RESULT */
+UnionBridge::U107(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* WATCH_FOR_CLIENTS_RESULT */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -1675,9 +1685,10 @@ UnionBridge::U107(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	default:
 		log.Warn("Unrecognized status code for u107.Status: [" + UPC::Status::GetStatusString(status) + "].");
 	}
+	restorer.OnResult(UPC::ID::WATCH_FOR_CLIENTS_RESULT, "", status);
 }
 void
-UnionBridge::U108(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* STOP_WATCHING_FOR_CLIENTS_RESULT */
+UnionBridge::U108(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* STOP_WATCHING_FOR_CLIENTS_RESULT */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -1699,7 +1710,7 @@ UnionBridge::U108(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U109(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* WATCH_FOR_ACCOUNTS_RESULT */
+UnionBridge::U109(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* WATCH_FOR_ACCOUNTS_RESULT */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -1718,9 +1729,10 @@ UnionBridge::U109(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	default:
 		log.Warn("Unrecognized status code for u109. Status: [" + UPC::Status::GetStatusString(status) + "].");
 	}
+	restorer.OnResult(UPC::ID::WATCH_FOR_ACCOUNTS_RESULT, "", status);
 }
 void
-UnionBridge::U110(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* STOP_WATCHING_FOR_ACCOUNTS_RESULT */
+UnionBridge::U110(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* STOP_WATCHING_FOR_ACCOUNTS_RESULT */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -1743,7 +1755,7 @@ UnionBridge::U110(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U111(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* ACCOUNT_ADDED */
+UnionBridge::U111(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* ACCOUNT_ADDED */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -1755,7 +1767,7 @@ UnionBridge::U111(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 
 }
 void
-UnionBridge::U112(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* ACCOUNT_REMOVED */
+UnionBridge::U112(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* ACCOUNT_REMOVED */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -1774,7 +1786,7 @@ UnionBridge::U112(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 
 }
 void
-UnionBridge::U113(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* JOINED_ROOM_ADDED_TO_CLIENT */
+UnionBridge::U113(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* JOINED_ROOM_ADDED_TO_CLIENT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -1790,7 +1802,7 @@ UnionBridge::U113(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U114(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* JOINED_ROOM_REMOVED_FROM_CLIENT */
+UnionBridge::U114(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* JOINED_ROOM_REMOVED_FROM_CLIENT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -1806,7 +1818,7 @@ UnionBridge::U114(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U115(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* GET_CLIENT_SNAPSHOT_RESULT */
+UnionBridge::U115(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* GET_CLIENT_SNAPSHOT_RESULT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -1821,7 +1833,7 @@ UnionBridge::U115(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 
 }
 void
-UnionBridge::U116(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* GET_ACCOUNT_SNAPSHOT_RESULT */
+UnionBridge::U116(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* GET_ACCOUNT_SNAPSHOT_RESULT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -1835,7 +1847,7 @@ UnionBridge::U116(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 #endif
 }
 void
-UnionBridge::U117(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* OBSERVED_ROOM_ADDED_TO_CLIENT */
+UnionBridge::U117(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* OBSERVED_ROOM_ADDED_TO_CLIENT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -1851,7 +1863,7 @@ UnionBridge::U117(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U118(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* OBSERVED_ROOM_REMOVED_FROM_CLIENT */
+UnionBridge::U118(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* OBSERVED_ROOM_REMOVED_FROM_CLIENT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -1867,7 +1879,7 @@ UnionBridge::U118(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U119(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CLIENT_OBSERVED */
+UnionBridge::U119(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CLIENT_OBSERVED */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -1882,7 +1894,7 @@ UnionBridge::U119(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 
 }
 void
-UnionBridge::U120(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* STOPPED_OBSERVING_CLIENT */
+UnionBridge::U120(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* STOPPED_OBSERVING_CLIENT */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -1897,16 +1909,16 @@ UnionBridge::U120(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U121(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* OBSERVE_ACCOUNT */
+UnionBridge::U121(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* OBSERVE_ACCOUNT */
 {
 
 }
 void
-UnionBridge::U122(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* STOP_OBSERVING_ACCOUNT */
+UnionBridge::U122(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* STOP_OBSERVING_ACCOUNT */
 {
 }
 void
-UnionBridge::U123(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* OBSERVE_ACCOUNT_RESULT */
+UnionBridge::U123(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* OBSERVE_ACCOUNT_RESULT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -1932,9 +1944,10 @@ UnionBridge::U123(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	default:
 		log.Warn("Unrecognized status code for u123. User ID: [" + userID + "], status: [" + UPC::Status::GetStatusString(status) + "].");
 	}
+	restorer.OnResult(UPC::ID::OBSERVE_ACCOUNT_RESULT, userID, status);
 }
 void
-UnionBridge::U124(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* ACCOUNT_OBSERVED */
+UnionBridge::U124(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* ACCOUNT_OBSERVED */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -1948,7 +1961,7 @@ UnionBridge::U124(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 
 }
 void
-UnionBridge::U125(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* STOP_OBSERVING_ACCOUNT_RESULT */
+UnionBridge::U125(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* STOP_OBSERVING_ACCOUNT_RESULT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -1975,7 +1988,7 @@ UnionBridge::U125(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U126(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* STOPPED_OBSERVING_ACCOUNT */
+UnionBridge::U126(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* STOPPED_OBSERVING_ACCOUNT */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -1991,7 +2004,7 @@ UnionBridge::U126(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 
 }
 void
-UnionBridge::U127(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* ACCOUNT_LIST_UPDATE */
+UnionBridge::U127(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* ACCOUNT_LIST_UPDATE */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2023,7 +2036,7 @@ UnionBridge::U127(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U128(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* UPDATE_LEVELS_UPDATE */
+UnionBridge::U128(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* UPDATE_LEVELS_UPDATE */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2053,7 +2066,7 @@ UnionBridge::U128(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U129(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CLIENT_OBSERVED_ROOM */
+UnionBridge::U129(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CLIENT_OBSERVED_ROOM */
 {
 	if (args.size() < 5)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2093,7 +2106,7 @@ UnionBridge::U129(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 		theRoom->AddObserver(theClient);
 }
 void
-UnionBridge::U130(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CLIENT_STOPPED_OBSERVING_ROOM */
+UnionBridge::U130(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CLIENT_STOPPED_OBSERVING_ROOM */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2121,7 +2134,7 @@ UnionBridge::U130(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U131(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* ROOM_OCCUPANTCOUNT_UPDATE */
+UnionBridge::U131(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* ROOM_OCCUPANTCOUNT_UPDATE */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2147,7 +2160,7 @@ UnionBridge::U131(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U132(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* ROOM_OBSERVERCOUNT_UPDATE */
+UnionBridge::U132(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* ROOM_OBSERVERCOUNT_UPDATE */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2175,11 +2188,11 @@ UnionBridge::U132(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U133(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* ADD_ROLE */
+UnionBridge::U133(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* ADD_ROLE */
 {
 }
 void
-UnionBridge::U134(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* ADD_ROLE_RESULT */
+UnionBridge::U134(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* ADD_ROLE_RESULT */
 {
 	if (args.size() < 3)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2209,11 +2222,11 @@ UnionBridge::U134(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U135(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* REMOVE_ROLE */
+UnionBridge::U135(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* REMOVE_ROLE */
 {
 }
 void
-UnionBridge::U136(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* REMOVE_ROLE_RESULT */
+UnionBridge::U136(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* REMOVE_ROLE_RESULT */
 {
 	if (args.size() < 3)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2243,11 +2256,11 @@ UnionBridge::U136(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U137(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* BAN */
+UnionBridge::U137(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* BAN */
 {
 }
 void
-UnionBridge::U138(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* BAN_RESULT */
+UnionBridge::U138(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* BAN_RESULT */
 {
 	if (args.size() < 3)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2272,11 +2285,11 @@ UnionBridge::U138(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U139(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* UNBAN */
+UnionBridge::U139(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* UNBAN */
 {
 }
 void
-UnionBridge::U140(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* UNBAN_RESULT */
+UnionBridge::U140(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* UNBAN_RESULT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2299,11 +2312,11 @@ UnionBridge::U140(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U141(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* GET_BANNED_LIST_SNAPSHOT */
+UnionBridge::U141(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* GET_BANNED_LIST_SNAPSHOT */
 {
 }
 void
-UnionBridge::U142(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* BANNED_LIST_SNAPSHOT */
+UnionBridge::U142(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* BANNED_LIST_SNAPSHOT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2329,11 +2342,11 @@ UnionBridge::U142(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U143(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* WATCH_FOR_BANNED_ADDRESSES */
+UnionBridge::U143(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* WATCH_FOR_BANNED_ADDRESSES */
 {
 }
 void
-UnionBridge::U144(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* WATCH_FOR_BANNED_ADDRESSES_RESULT */
+UnionBridge::U144(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* WATCH_FOR_BANNED_ADDRESSES_RESULT */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2354,11 +2367,11 @@ UnionBridge::U144(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U145(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* STOP_WATCHING_FOR_BANNED_ADDRESSES */
+UnionBridge::U145(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* STOP_WATCHING_FOR_BANNED_ADDRESSES */
 {
 }
 void
-UnionBridge::U146(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* STOP_WATCHING_FOR_BANNED_ADDRESSES_RESULT */
+UnionBridge::U146(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* STOP_WATCHING_FOR_BANNED_ADDRESSES_RESULT */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2378,7 +2391,7 @@ UnionBridge::U146(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U147(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* BANNED_ADDRESS_ADDED */
+UnionBridge::U147(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* BANNED_ADDRESS_ADDED */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2389,7 +2402,7 @@ UnionBridge::U147(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	clientManager.AddWatchedBannedAddress(address);
 }
 void
-UnionBridge::U148(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* BANNED_ADDRESS_REMOVED */
+UnionBridge::U148(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* BANNED_ADDRESS_REMOVED */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2400,11 +2413,11 @@ UnionBridge::U148(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	clientManager.RemoveWatchedBannedAddress(address);
 }
 void
-UnionBridge::U149(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* KICK_CLIENT */
+UnionBridge::U149(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* KICK_CLIENT */
 {
 }
 void
-UnionBridge::U150(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* KICK_CLIENT_RESULT */
+UnionBridge::U150(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* KICK_CLIENT_RESULT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2428,11 +2441,11 @@ UnionBridge::U150(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	}
 }
 void
-UnionBridge::U151(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* GET_SERVERMODULELIST_SNAPSHOT */
+UnionBridge::U151(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* GET_SERVERMODULELIST_SNAPSHOT */
 {
 }
 void
-UnionBridge::U152(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* SERVERMODULELIST_SNAPSHOT */
+UnionBridge::U152(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* SERVERMODULELIST_SNAPSHOT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2460,15 +2473,15 @@ UnionBridge::U152(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 #endif
 }
 void
-UnionBridge::U153(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CLEAR_MODULE_CACHE */
+UnionBridge::U153(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CLEAR_MODULE_CACHE */
 {
 }
 void
-UnionBridge::U154(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* GET_UPC_STATS_SNAPSHOT */
+UnionBridge::U154(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* GET_UPC_STATS_SNAPSHOT */
 {
 }
 void
-UnionBridge::U155(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* GET_UPC_STATS_SNAPSHOT_RESULT */
+UnionBridge::U155(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* GET_UPC_STATS_SNAPSHOT_RESULT */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2481,7 +2494,7 @@ UnionBridge::U155(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 #endif
 }
 void
-UnionBridge::U156(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* UPC_STATS_SNAPSHOT */
+UnionBridge::U156(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* UPC_STATS_SNAPSHOT */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2511,11 +2524,11 @@ UnionBridge::U156(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 #endif
 }
 void
-UnionBridge::U157(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* RESET_UPC_STATS */
+UnionBridge::U157(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* RESET_UPC_STATS */
 {
 }
 void
-UnionBridge::U158(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* RESET_UPC_STATS_RESULT */
+UnionBridge::U158(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* RESET_UPC_STATS_RESULT */
 {
 #ifdef PROCESSING_RECORDS
 	switch (status) {
@@ -2531,11 +2544,11 @@ UnionBridge::U158(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 #endif
 }
 void
-UnionBridge::U159(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* WATCH_FOR_PROCESSED_UPCS */
+UnionBridge::U159(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* WATCH_FOR_PROCESSED_UPCS */
 {
 }
 void
-UnionBridge::U160(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* WATCH_FOR_PROCESSED_UPCS_RESULT */
+UnionBridge::U160(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* WATCH_FOR_PROCESSED_UPCS_RESULT */
 {
 #ifdef PROCESSING_RECORDS
 	switch (status) {
@@ -2553,7 +2566,7 @@ UnionBridge::U160(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 #endif
 }
 void
-UnionBridge::U161(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* PROCESSED_UPC_ADDED */
+UnionBridge::U161(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* PROCESSED_UPC_ADDED */
 {
 	if (args.size() < 7)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2581,11 +2594,11 @@ UnionBridge::U161(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 #endif
 }
 void
-UnionBridge::U162(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* STOP_WATCHING_FOR_PROCESSED_UPCS */
+UnionBridge::U162(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* STOP_WATCHING_FOR_PROCESSED_UPCS */
 {
 }
 void
-UnionBridge::U163(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* STOP_WATCHING_FOR_PROCESSED_UPCS_RESULT */
+UnionBridge::U163(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* STOP_WATCHING_FOR_PROCESSED_UPCS_RESULT */
 {
 	if (args.size() < 1)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2608,7 +2621,7 @@ UnionBridge::U163(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 #endif
 }
 void
-UnionBridge::U164(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* CONNECTION_REFUSED */
+UnionBridge::U164(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* CONNECTION_REFUSED */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2621,12 +2634,12 @@ UnionBridge::U164(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 	NxConnectRefused(reason, description);
 }
 void
-UnionBridge::U165(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* GET_NODELIST_SNAPSHOT */
+UnionBridge::U165(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* GET_NODELIST_SNAPSHOT */
 {
 }
 
 void
-UnionBridge::U166(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* NODELIST_SNAPSHOT */
+UnionBridge::U166(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* NODELIST_SNAPSHOT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
@@ -2647,11 +2660,11 @@ UnionBridge::U166(EventType t, std::vector<std::string> args, UPCStatus ioStatus
 #endif
 }
 void
-UnionBridge::U167(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* GET_GATEWAYS_SNAPSHOT */
+UnionBridge::U167(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* GET_GATEWAYS_SNAPSHOT */
 {
 }
 void
-UnionBridge::U168(EventType t, std::vector<std::string> args, UPCStatus ioStatus) /* GATEWAYS_SNAPSHOT */
+UnionBridge::U168(EventType t, const std::vector<std::string>& args, UPCStatus ioStatus) /* GATEWAYS_SNAPSHOT */
 {
 	if (args.size() < 2)  {
 		log.Error("[UNION BRIDGE] malformed packet, argument mismatch, ignoring");
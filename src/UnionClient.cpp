@@ -40,7 +40,8 @@ The signature is a HMAC digest of the policy with a shared secret key. The share
  * UnionBridge:
  * - Event::READY, "", UPC::Status::SUCCESS ... UPC handshake succeeded and we're ready to go
  * - Event::DISCONNECTED, "", UPC::Status::SUCCESS ... we've successfully and totally disconnected from the server
- * - Event::SELECT_CONNECTION, args, status ... specific underlying connection is changed
+ * - Event::SELECT_CONNECTION, args, status ... specific underlying connection is changed. with UPC::Status::CONNECTION_UPGRADE, a fallback
+ *		transport has been drained and dropped mid session for a better one, and a new session follows on it
  * - Event::CONNECT_FAILURE, msg, status ... generic connection failure. status is negative if from an io error, or if +ve it should be one of
  *		- UPC::Status::CONNECT_REFUSED, reason+description ... connection wasn't allowed
  *		- UPC::Status::PROTOCOL_INCOMPATIBLE, version ... connection wasn't allowed
@@ -50,10 +51,13 @@ The signature is a HMAC digest of the policy with a shared secret key. The share
  *		- UPC::Status::CLIENT_KILL_CONNECT, msg ... server has cut off the current connection
  *		- UPC::Status::NO_VALID_CONNECTION_AVAILABLE, msg ... or we ran out of options for connections
  *		- UPC::Status::CONNECT_TIMEOUT, msg ... or we timed out
+ *		- UPC::Status::CONNECTION_FAILOVER, msg ... the transport died with a warm standby ready, which the monitor reconnects on at once
  *      - UPC::Status::NO_VALID_CONNECTION_AVAILABLE, msg ... this is the one to give up on. other CONNECT_FAILURE messages give state information and we try to autoreconnect
  * - Event::BEGIN_CONNECT, "", connectionState ... used by the timeout subsystem
  * - Event::CONNECTED, "", connectionState ... signalled when we have established communications, and just before we do UPC handshake
  * - Event::IO_ERROR, msg, status ... signalled when we have a recoverable io error on a working connection, status will be an error code from the io subsystem
+ * - Event::SEND_QUEUE_HIGH, bytes, count ... the connection's send queue is over its high watermark, so it's time to hold off on anything bulky
+ * - Event::SEND_QUEUE_DRAINED, bytes, count ... the send queue is back down to its low watermark
  */
 
 UnionClient::UnionClient(AbstractConnector &c)
@@ -71,25 +75,25 @@ UnionClient::UnionClient(AbstractConnector &c)
 
 	DEBUG_OUT("adding default listeners ... ");
 
-	readyListener = std::make_shared<CBUPC>([this](EventType t,  StringArgs a, UPCStatus status) {
+	readyListener = std::make_shared<CBUPC>([this](EventType t, const StringArgs& a, UPCStatus status) {
 		connectionMonitor.EnableHeartbeat();
 		NotifyListeners(t, a.size()>0?a[0]:"", status);
 	});
-	disconnectListener = std::make_shared<CBUPC>([this](EventType t,  StringArgs a, UPCStatus status) {
+	disconnectListener = std::make_shared<CBUPC>([this](EventType t, const StringArgs& a, UPCStatus status) {
 		connectionMonitor.DisableHeartbeat();
 		NotifyListeners(t, a.size()>0?a[0]:"", status);
 	});
-	selectListener = std::make_shared<CBUPC>([this](EventType t,  StringArgs a, UPCStatus status) {
+	selectListener = std::make_shared<CBUPC>([this](EventType t, const StringArgs& a, UPCStatus status) {
 		NotifyListeners(t, a.size()>0?a[0]:"", status);
 	});
-	cnxFailListener = std::make_shared<CBUPC>([this](EventType t,  StringArgs a, UPCStatus status) {
+	cnxFailListener = std::make_shared<CBUPC>([this](EventType t, const StringArgs& a, UPCStatus status) {
 		// this is a bad idea, as it will supress the reasons for the connection failure
 //		if (status == UPC::Status::NO_VALID_CONNECTION_AVAILABLE) {
 			NotifyListeners(t, a.size() > 0 ? a[0] : "", status);
 //		}
 		// if CONNECT_REFUSED there are two params ? either join them or use the second? the first param is the short form, and is the one passed on for now
 	});
-	echoListener = std::make_shared<CBUPC>([this](EventType t,  StringArgs a, UPCStatus status) {
+	echoListener = std::make_shared<CBUPC>([this](EventType t, const StringArgs& a, UPCStatus status) {
 		NotifyListeners(t, a.size()>0?a[0]:"", status);
 	});
 
@@ -100,6 +104,8 @@ UnionClient::UnionClient(AbstractConnector &c)
 	unionBridge.AddUPCListener(Event::CONNECTED, echoListener);
 	unionBridge.AddUPCListener(Event::BEGIN_CONNECT, echoListener);
 	unionBridge.AddUPCListener(Event::IO_ERROR, echoListener);
+	unionBridge.AddUPCListener(Event::SEND_QUEUE_HIGH, echoListener);
+	unionBridge.AddUPCListener(Event::SEND_QUEUE_DRAINED, echoListener);
 	defaultLogger.SetLevel(DefaultLogger::kLogNothing);
 
 	worker.StartUVRunner();
@@ -134,11 +140,13 @@ UnionClient::Connect()
 }
 
 /**
- * passes a disconnect request onto the i/o connector via the UnionBridge
+ * passes a disconnect request onto the i/o connector via the UnionBridge. the session is ended on purpose, so isn't restored on the next
+ * Connect()
  */
 void
 UnionClient::Disconnect()
 {
+	unionBridge.GetSessionRestorer().OnClientDisconnect();
 	unionBridge.Disconnect();
 }
 
@@ -20,6 +20,8 @@
  * - Event::DISCONNECTED .. on successful disconnect
  * - Event::SELECT_CONNECTION .. on successful renegotiation of connection
  * - Event::IO_ERROR .. on any error on successful connection
+ * - Event::SEND_QUEUE_HIGH .. a connection's send queue is over its high watermark. data is the bytes queued, status the count
+ * - Event::SEND_QUEUE_DRAINED .. and back down to its low watermark
  * - Event::CONNECT_FAILURE .. error during connect phase or if connection is lost. status is negative if it is an io error defined elsewhere, else:
  *		- UPC::Status::CONNECT_REFUSED, reason+description ... connection wasn't allowed
  *		- UPC::Status::PROTOCOL_INCOMPATIBLE, version ... connection wasn't allowed
@@ -68,14 +70,23 @@ AbstractConnector::GetHost() const
 void
 AbstractConnector::AddConnection(CnxRef cr, int ind)
 {
-	cr->c = this;
-	if (cr->host == "") cr->host = defaultHost;
+	Adopt(cr);
 	if (ind < 0 || ind >= (int)connections.size())
 		connections.push_back(cr);
 	else
 		connections.insert(connections.begin() + ind, cr);
 }
 
+/**
+ * have cr report to us, as for AddConnection(), without putting it on the list
+ */
+void
+AbstractConnector::Adopt(CnxRef cr)
+{
+	cr->c = this;
+	if (cr->host == "") cr->host = defaultHost;
+}
+
 CnxRef
 AbstractConnector::Connection(int n)
 {
@@ -137,11 +148,13 @@ AbstractConnector::NotifyCheckConnectFailure(const CnxRef cr, const std::string
 AbstractConnection::AbstractConnection(std::string host, std::string service)
 	: host(host)
 	, service(service)
-	, properties(properties)
 	, connectState(ConnectionState::UNKNOWN)
 	, c(nullptr){
 
 	Reset();
+	sendQueue.SetWatermarkCallback([this](const bool high, const size_t bytes, const size_t count) {
+		NxSendQueue(high, bytes, count);
+	});
 }
 
 AbstractConnection::~AbstractConnection() {
@@ -269,6 +282,9 @@ AbstractConnection::NxReceive(const std::string data, const int status)
 		std::clog << "**** null connector in connect NxRecieve";
 		return;
 	}
+	if (!c->OnConnectionEvent(Event::RECEIVE_DATA, this, data, status)) {
+		return;
+	}
 	c->NotifyListeners(Event::RECEIVE_DATA, nullptr, data, status);
 }
 
@@ -296,6 +312,9 @@ AbstractConnection::NxConnected(const CnxRef cr)
 		return;
 	}
 	nCnxSucceed++;
+	if (!c->OnConnectionEvent(Event::CONNECTED, this, "", 0)) {
+		return;
+	}
 	c->NotifyListeners(Event::CONNECTED, cr, "", 0);
 	c->OnConnectSucceed(cr);
 }
@@ -310,6 +329,9 @@ AbstractConnection::NxDisconnected(const CnxRef cr)
 		std::clog << "**** null connector in connect NxDisconnected";
 		return;
 	}
+	if (!c->OnConnectionEvent(Event::DISCONNECTED, this, "", 0)) {
+		return;
+	}
 	c->NotifyListeners(Event::DISCONNECTED, cr, "", 0);
 	c->OnDisconnectSucceed(cr);
 }
@@ -326,6 +348,9 @@ AbstractConnection::NxIOError(const std::string msg, const int status)
 		return;
 	}
 	nIOError++;
+	if (!c->OnConnectionEvent(Event::IO_ERROR, this, msg, status)) {
+		return;
+	}
 	c->NotifyListeners(Event::IO_ERROR, nullptr, msg, 0);
 }
 
@@ -341,6 +366,9 @@ AbstractConnection::NxConnectFailure(const CnxRef cr, const std::string msg, con
 		return;
 	}
 	nCnxFail++;
+	if (!c->OnConnectionEvent(Event::CONNECT_FAILURE, this, msg, status)) {
+		return;
+	}
 	c->NotifyListeners(Event::CONNECT_FAILURE, cr, msg, status);
 	c->OnConnectFailure(cr, status);
 }
@@ -357,10 +385,30 @@ AbstractConnection::NxServerHangup(const CnxRef cr, const std::string msg, const
 		std::clog << "**** null connector in connect NxConnectFailure";
 		return;
 	}
+	if (!c->OnConnectionEvent(Event::CONNECT_FAILURE, this, msg, UPC::Status::SERVER_KILL_CONNECT)) {
+		return;
+	}
 	c->NotifyListeners(Event::CONNECT_FAILURE, cr, msg, UPC::Status::SERVER_KILL_CONNECT);
 	c->OnConnectFailure(cr, status);
 }
 
+/**
+ * wrapper to send Event::SEND_QUEUE_HIGH or Event::SEND_QUEUE_DRAINED via the parent AbstractConnector
+ */
+void
+AbstractConnection::NxSendQueue(const bool high, const size_t bytes, const size_t count)
+{
+	if (c == nullptr) {
+		return;
+	}
+	EventType e = high? Event::SEND_QUEUE_HIGH : Event::SEND_QUEUE_DRAINED;
+	std::string data = std::to_string(bytes);
+	if (!c->OnConnectionEvent(e, this, data, (int)count)) {
+		return;
+	}
+	c->NotifyListeners(e, this, data, (int)count);
+}
+
 /**
  * @param lp an ILogger module to use for messages
  */
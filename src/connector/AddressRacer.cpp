@@ -0,0 +1,172 @@
+/*
+ * AddressRacer.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#include "CommonTypes.h"
+#include "connector/AddressRacer.h"
+
+const int AddressRacer::kDfltAttemptDelayMS;
+const int AddressRacer::kMinAttemptDelayMS;
+const int AddressRacer::kMaxAttemptDelayMS;
+
+/**
+ * @class AddressRacer AddressRacer.h
+ * @brief connects to whichever of a host's addresses answers first, happy eyeballs style (rfc 8305)
+ *
+ * the addresses are put in the order of section 4, the families taking turns, starting with whichever the resolver put first. the first
+ * attempt goes straight away, and each after that once the one before has had attemptDelayMS, or as soon as it fails. the first to succeed
+ * wins, and whatever else is still going is abandoned. so a host whose ipv6 is broken costs us a quarter of a second, rather than a
+ * connect timeout
+ *
+ * the racer doesn't touch sockets itself: it calls start and abandon with the attempt number, and is told how each attempt went with
+ * Succeeded() and Failed(). the section 3 resolution delay has no place here, as getaddrinfo gives us both families at once
+ */
+AddressRacer::AddressRacer(EventLoop* l)
+	: loop(l)
+	, attemptDelayMS(kDfltAttemptDelayMS)
+{
+}
+
+AddressRacer::~AddressRacer()
+{
+	if (delayTimer && loop) loop->CancelTimer(delayTimer);
+}
+
+void
+AddressRacer::SetAttemptDelay(const int ms)
+{
+	attemptDelayMS = ms < kMinAttemptDelayMS? kMinAttemptDelayMS : ms > kMaxAttemptDelayMS? kMaxAttemptDelayMS : ms;
+}
+
+/**
+ * rfc 8305 section 4 ordering: firstFamilyCount of the preferred family, then one of each in turn. each family keeps the order the
+ * resolver gave it
+ */
+UVAddresses
+AddressRacer::Interleave(const UVAddresses& res, const int firstFamilyCount)
+{
+	if (res.size() == 0) return res;
+	int firstFamily = res[0].Family();
+	UVAddresses preferred;
+	UVAddresses other;
+	for (auto& a: res) {
+		if (a.Family() == firstFamily) preferred.push_back(a);
+		else other.push_back(a);
+	}
+	UVAddresses r;
+	size_t p = 0;
+	size_t o = 0;
+	for (int i=0; i<firstFamilyCount && p<preferred.size(); i++) {
+		r.push_back(preferred[p++]);
+	}
+	while (p < preferred.size() || o < other.size()) {
+		if (o < other.size()) r.push_back(other[o++]);
+		if (p < preferred.size()) r.push_back(preferred[p++]);
+	}
+	return r;
+}
+
+/**
+ * start racing for the given addresses. anything still going from a previous race is abandoned first
+ */
+void
+AddressRacer::Race(const UVAddresses& res, StartCB _start, AbandonCB _abandon, FailedCB _failed)
+{
+	Cancel();
+	order = Interleave(res);
+	inFlight.assign(order.size(), false);
+	next = 0;
+	lastStatus = -1;
+	start = _start;
+	abandon = _abandon;
+	failed = _failed;
+	racing = true;
+	StartNext();
+}
+
+void
+AddressRacer::StartNext()
+{
+	if (delayTimer) {
+		loop->CancelTimer(delayTimer);
+		delayTimer = nullptr;
+	}
+	if (!racing) return;
+	if (next >= order.size()) {
+		for (auto it: inFlight) {
+			if (it) return;
+		}
+		racing = false;
+		if (failed) failed(lastStatus);
+		return;
+	}
+	int attempt = (int)next++;
+	inFlight[attempt] = true;
+	if (start) start(order[attempt], attempt);
+	if (racing && next < order.size() && delayTimer == nullptr && loop) {
+		delayTimer = loop->Schedule(attemptDelayMS, 0, [this]() {
+			delayTimer = nullptr;
+			StartNext();
+		});
+	}
+}
+
+/**
+ * @return true if this attempt has won, and everything else has been abandoned. false if it had already been abandoned, in which case
+ * whoever made it should close it
+ */
+bool
+AddressRacer::Succeeded(const int attempt)
+{
+	if (!racing || attempt < 0 || attempt >= (int)inFlight.size() || !inFlight[attempt]) return false;
+	inFlight[attempt] = false;
+	racing = false;
+	if (delayTimer) {
+		loop->CancelTimer(delayTimer);
+		delayTimer = nullptr;
+	}
+	AbandonAll(attempt);
+	return true;
+}
+
+/**
+ * an attempt failed, so the next goes now, rather than waiting out the delay
+ * @return false if it was no longer in the race anyway
+ */
+bool
+AddressRacer::Failed(const int attempt, const int status)
+{
+	if (!racing || attempt < 0 || attempt >= (int)inFlight.size() || !inFlight[attempt]) return false;
+	inFlight[attempt] = false;
+	lastStatus = status;
+	StartNext();
+	return true;
+}
+
+/**
+ * give up on the race, abandoning anything still going. nothing is called back other than abandon
+ */
+void
+AddressRacer::Cancel()
+{
+	if (delayTimer) {
+		loop->CancelTimer(delayTimer);
+		delayTimer = nullptr;
+	}
+	racing = false;
+	AbandonAll(-1);
+}
+
+void
+AddressRacer::AbandonAll(const int except)
+{
+	for (int i=0; i<(int)inFlight.size(); i++) {
+		if (i != except && inFlight[i]) {
+			inFlight[i] = false;
+			if (abandon) abandon(i);
+		}
+	}
+}
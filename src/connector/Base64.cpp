@@ -12,133 +12,442 @@
 
 #include "connector/Base64.h"
 
-Base64 Base64::instance;
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BASE64_X86
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define BASE64_NEON
+#include <arm_neon.h>
+#endif
 
-char Base64::encodingTable[] = {
-		'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H',
-		'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
-		'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X',
-		'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
-		'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n',
-		'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
-		'w', 'x', 'y', 'z', '0', '1', '2', '3',
-		'4', '5', '6', '7', '8', '9', '+', '/'};
-int Base64::modTable[] = {0, 2, 1};
+static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-Base64::Base64() {
-	decodingTable = new char[256];
+/**
+ * each character's sextet, or one of these
+ */
+static const unsigned char kPad = 64;
+static const unsigned char kSpace = 65;
+static const unsigned char kBad = 255;
+static unsigned char decodingTable[256];
 
-	for (int i = 0; i < 256; i++)
-		decodingTable[i] = 0;
-	for (int i = 0; i < 64; i++)
-		decodingTable[(unsigned char) encodingTable[i]] = i;
-}
+/*
+ * the simd kernels. each does as many whole blocks as it can and says how much input it used, a multiple of 3 bytes encoding, or of 4
+ * characters decoding. decoding stops at the first block with anything but the 64 characters in it, padding and whitespace included, and
+ * leaves that to the scalar code. on x86 they're built for their instruction sets whatever the compiler flags, and picked at start up
+ */
+#if defined(BASE64_X86)
 
-Base64::~Base64() {
-	delete [] decodingTable;
+__attribute__((target("ssse3"))) static size_t
+EncodeSSSE3(const unsigned char *data, size_t inputLength, char *out)
+{
+	const __m128i shuffle = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+	const __m128i shiftLUT = _mm_setr_epi8('a'-26, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52, '+'-62, '/'-63, 'A', 0, 0);
+	size_t i = 0;
+	for (; i+16 <= inputLength; i+=12, out+=16) {
+		// 12 bytes, spread to 16 lanes of 6 bits (Mula and Lemire)
+		__m128i in = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data+i)), shuffle);
+		__m128i t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+		__m128i t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+		__m128i sextets = _mm_or_si128(t0, t1);
+		// and to characters, by an offset for each range
+		__m128i range = _mm_subs_epu8(sextets, _mm_set1_epi8(51));
+		range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), sextets), _mm_set1_epi8(13)));
+		_mm_storeu_si128((__m128i*)out, _mm_add_epi8(_mm_shuffle_epi8(shiftLUT, range), sextets));
+	}
+	return i;
 }
 
-char*
-Base64::Encode(const unsigned char *data,
-		size_t inputLength,
-		size_t& outputLength) {
-	return instance._Encode(data, inputLength, outputLength);
+__attribute__((target("ssse3"))) static size_t
+DecodeSSSE3(const char *data, size_t inputLength, unsigned char *out, size_t outCapacity)
+{
+	const __m128i shiftLUT = _mm_setr_epi8(0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i maskLUT = _mm_setr_epi8((char)0xa8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8,
+			(char)0xf8, (char)0xf8, (char)0xf0, 0x54, 0x50, 0x50, 0x50, 0x54);
+	const __m128i bitLUT = _mm_setr_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char)0x80, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	size_t i = 0, j = 0;
+	for (; i+16 <= inputLength && j+16 <= outCapacity; i+=16, j+=12) {
+		__m128i in = _mm_loadu_si128((const __m128i*)(data+i));
+		__m128i hi = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0f));
+		__m128i lo = _mm_and_si128(in, _mm_set1_epi8(0x0f));
+		// a character is good if the bit for its high nibble is set in the mask for its low one
+		__m128i good = _mm_and_si128(_mm_shuffle_epi8(maskLUT, lo), _mm_shuffle_epi8(bitLUT, hi));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(good, _mm_setzero_si128())) != 0) {
+			break;
+		}
+		__m128i shift = _mm_shuffle_epi8(shiftLUT, hi);
+		shift = _mm_add_epi8(shift, _mm_and_si128(_mm_cmpeq_epi8(in, _mm_set1_epi8('/')), _mm_set1_epi8(-3))); // '/' shares its nibble with '+'
+		__m128i sextets = _mm_add_epi8(in, shift);
+		__m128i pairs = _mm_maddubs_epi16(sextets, _mm_set1_epi32(0x01400140));
+		__m128i triples = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+		_mm_storeu_si128((__m128i*)(out+j), _mm_shuffle_epi8(triples, pack));
+	}
+	return i;
 }
 
-unsigned char*
-Base64::Decode(const unsigned char *data,
-		size_t inputLength,
-		size_t& outputLength) {
-	return instance._Decode(data, inputLength, outputLength);
+__attribute__((target("avx2"))) static size_t
+EncodeAVX2(const unsigned char *data, size_t inputLength, char *out)
+{
+	const __m256i shuffle = _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1, 10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+	const __m256i shiftLUT = _mm256_broadcastsi128_si256(_mm_setr_epi8('a'-26, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52,
+			'0'-52, '0'-52, '0'-52, '+'-62, '/'-63, 'A', 0, 0));
+	size_t i = 0;
+	for (; i+28 <= inputLength; i+=24, out+=32) {
+		__m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(data+i))),
+				_mm_loadu_si128((const __m128i*)(data+i+12)), 1);
+		in = _mm256_shuffle_epi8(in, shuffle);
+		__m256i t0 = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+		__m256i t1 = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+		__m256i sextets = _mm256_or_si256(t0, t1);
+		__m256i range = _mm256_subs_epu8(sextets, _mm256_set1_epi8(51));
+		range = _mm256_or_si256(range, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), sextets), _mm256_set1_epi8(13)));
+		_mm256_storeu_si256((__m256i*)out, _mm256_add_epi8(_mm256_shuffle_epi8(shiftLUT, range), sextets));
+	}
+	return i + EncodeSSSE3(data+i, inputLength-i, out);
 }
 
-std::string
-Base64::Encode(
-		const unsigned char *data,
-		size_t inputLength)
+__attribute__((target("avx2"))) static size_t
+DecodeAVX2(const char *data, size_t inputLength, unsigned char *out, size_t outCapacity)
 {
-	size_t l;
-	char *p = instance._Encode(data, inputLength, l);
-	std::string enc(p, l);
-	delete []p;
-	return enc;
+	const __m256i shiftLUT = _mm256_broadcastsi128_si256(_mm_setr_epi8(0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0));
+	const __m256i maskLUT = _mm256_broadcastsi128_si256(_mm_setr_epi8((char)0xa8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8,
+			(char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf0, 0x54, 0x50, 0x50, 0x50, 0x54));
+	const __m256i bitLUT = _mm256_broadcastsi128_si256(_mm_setr_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char)0x80, 0, 0, 0, 0, 0, 0, 0, 0));
+	const __m256i pack = _mm256_broadcastsi128_si256(_mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+	size_t i = 0, j = 0;
+	for (; i+32 <= inputLength && j+32 <= outCapacity; i+=32, j+=24) {
+		__m256i in = _mm256_loadu_si256((const __m256i*)(data+i));
+		__m256i hi = _mm256_and_si256(_mm256_srli_epi32(in, 4), _mm256_set1_epi8(0x0f));
+		__m256i lo = _mm256_and_si256(in, _mm256_set1_epi8(0x0f));
+		__m256i good = _mm256_and_si256(_mm256_shuffle_epi8(maskLUT, lo), _mm256_shuffle_epi8(bitLUT, hi));
+		if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(good, _mm256_setzero_si256())) != 0) {
+			break;
+		}
+		__m256i shift = _mm256_shuffle_epi8(shiftLUT, hi);
+		shift = _mm256_add_epi8(shift, _mm256_and_si256(_mm256_cmpeq_epi8(in, _mm256_set1_epi8('/')), _mm256_set1_epi8(-3)));
+		__m256i sextets = _mm256_add_epi8(in, shift);
+		__m256i pairs = _mm256_maddubs_epi16(sextets, _mm256_set1_epi32(0x01400140));
+		__m256i triples = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+		triples = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(triples, pack), lanes); // 12 from each lane, together at the front
+		_mm256_storeu_si256((__m256i*)(out+j), triples);
+	}
+	return i + DecodeSSSE3(data+i, inputLength-i, out+j, outCapacity-j);
 }
 
-std::vector<unsigned char>
-Base64:: Decode(
-		const unsigned char *data,
-		size_t inputLength)
+#elif defined(BASE64_NEON)
+
+static size_t
+EncodeNEON(const unsigned char *data, size_t inputLength, char *out)
 {
-	size_t l;
-	unsigned char *p = instance._Decode(data, inputLength, l);
-	std::vector<unsigned char> r;
-	r.assign(p, p+l);
-	return r;
+	uint8x16x4_t table;
+	for (int k=0; k<4; k++) {
+		table.val[k] = vld1q_u8((const uint8_t*)kAlphabet + 16*k);
+	}
+	const uint8x16_t low6 = vdupq_n_u8(0x3f);
+	size_t i = 0;
+	for (; i+48 <= inputLength; i+=48, out+=64) {
+		uint8x16x3_t in = vld3q_u8(data+i);
+		uint8x16x4_t sextets;
+		sextets.val[0] = vshrq_n_u8(in.val[0], 2);
+		sextets.val[1] = vandq_u8(vorrq_u8(vshrq_n_u8(in.val[1], 4), vshlq_n_u8(in.val[0], 4)), low6);
+		sextets.val[2] = vandq_u8(vorrq_u8(vshrq_n_u8(in.val[2], 6), vshlq_n_u8(in.val[1], 2)), low6);
+		sextets.val[3] = vandq_u8(in.val[2], low6);
+		for (int k=0; k<4; k++) {
+			sextets.val[k] = vqtbl4q_u8(table, sextets.val[k]);
+		}
+		vst4q_u8((uint8_t*)out, sextets);
+	}
+	return i;
 }
 
+static size_t
+DecodeNEON(const char *data, size_t inputLength, unsigned char *out, size_t outCapacity)
+{
+	uint8x16x4_t low, high; // the decoding table for 0-63 and for 64-127. anything else, or any sextet over 63, is bad
+	for (int k=0; k<4; k++) {
+		low.val[k] = vld1q_u8(decodingTable + 16*k);
+		high.val[k] = vld1q_u8(decodingTable + 64 + 16*k);
+	}
+	size_t i = 0, j = 0;
+	for (; i+64 <= inputLength && j+48 <= outCapacity; i+=64, j+=48) {
+		uint8x16x4_t in = vld4q_u8((const uint8_t*)data+i);
+		uint8x16_t sextets[4];
+		uint8x16_t bad = vdupq_n_u8(0);
+		for (int k=0; k<4; k++) {
+			sextets[k] = vqtbx4q_u8(vqtbl4q_u8(low, in.val[k]), high, vsubq_u8(in.val[k], vdupq_n_u8(64)));
+			bad = vorrq_u8(bad, vorrq_u8(sextets[k], vandq_u8(in.val[k], vdupq_n_u8(0x80))));
+		}
+		if (vmaxvq_u8(bad) > 63) {
+			break;
+		}
+		uint8x16x3_t bytes;
+		bytes.val[0] = vorrq_u8(vshlq_n_u8(sextets[0], 2), vshrq_n_u8(sextets[1], 4));
+		bytes.val[1] = vorrq_u8(vshlq_n_u8(sextets[1], 4), vshrq_n_u8(sextets[2], 2));
+		bytes.val[2] = vorrq_u8(vshlq_n_u8(sextets[2], 6), sextets[3]);
+		vst3q_u8(out+j, bytes);
+	}
+	return i;
+}
 
-char*
-Base64::_Encode(const unsigned char *data,
-		size_t inputLength,
-		size_t& outputLength) {
+#endif
 
-	outputLength = 4 * ((inputLength + 2) / 3);
+Base64 Base64::instance;
 
-	char* encodedData= new char[outputLength];
-	if (encodedData == nullptr) return nullptr;
+const int Base64::kErrInvalid;
+const int Base64::kErrNoRoom;
 
-	for (size_t i = 0, j = 0; i < inputLength;) {
+/**
+ * @class Base64 Base64.h
+ * @brief base64 for the web socket key and for binary payloads that go in attributes and messages
+ *
+ * encoding and decoding go straight into the caller's buffer, sized with EncodedLength() and DecodedLength(). the bulk of the work is done
+ * 12 to 48 bytes at a time with avx2, ssse3 or neon where we have it, and the ends, and anything odd, a quad at a time with tables
+ */
+Base64::Base64() {
+	memset(decodingTable, kBad, sizeof(decodingTable));
+	for (int i = 0; i < 64; i++) {
+		decodingTable[(unsigned char) kAlphabet[i]] = i;
+	}
+	decodingTable[(unsigned char)'='] = kPad;
+	for (const char *p=" \t\r\n"; *p; p++) {
+		decodingTable[(unsigned char)*p] = kSpace;
+	}
+#if defined(BASE64_X86)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		SetEngine("avx2");
+	} else if (__builtin_cpu_supports("ssse3")) {
+		SetEngine("ssse3");
+	}
+#elif defined(BASE64_NEON)
+	SetEngine("neon");
+#endif
+}
 
-		unsigned octet_a = i < inputLength ? (unsigned char)data[i++] : 0;
-		unsigned octet_b = i < inputLength ? (unsigned char)data[i++] : 0;
-		unsigned octet_c = i < inputLength ? (unsigned char)data[i++] : 0;
+Base64::~Base64() {
+}
 
-		unsigned triple = (octet_a << 0x10) + (octet_b << 0x08) + octet_c;
+/**
+ * @return the name of the kernels in use
+ */
+const char*
+Base64::Engine()
+{
+	return instance.engine;
+}
 
-		encodedData[j++] = encodingTable[(triple >> 3 * 6) & 0x3F];
-		encodedData[j++] = encodingTable[(triple >> 2 * 6) & 0x3F];
-		encodedData[j++] = encodingTable[(triple >> 1 * 6) & 0x3F];
-		encodedData[j++] = encodingTable[(triple >> 0 * 6) & 0x3F];
+/**
+ * switch kernels, for testing and benchmarks. "scalar" is always there
+ * @return false if name isn't one this cpu and build can do
+ */
+bool
+Base64::SetEngine(const std::string name)
+{
+	if (name == "scalar") {
+		instance.encodeBlocks = nullptr;
+		instance.decodeBlocks = nullptr;
+		instance.engine = "scalar";
+		return true;
+	}
+#if defined(BASE64_X86)
+	if (name == "avx2" && __builtin_cpu_supports("avx2")) {
+		instance.encodeBlocks = EncodeAVX2;
+		instance.decodeBlocks = DecodeAVX2;
+		instance.engine = "avx2";
+		return true;
+	}
+	if (name == "ssse3" && __builtin_cpu_supports("ssse3")) {
+		instance.encodeBlocks = EncodeSSSE3;
+		instance.decodeBlocks = DecodeSSSE3;
+		instance.engine = "ssse3";
+		return true;
 	}
+#elif defined(BASE64_NEON)
+	if (name == "neon") {
+		instance.encodeBlocks = EncodeNEON;
+		instance.decodeBlocks = DecodeNEON;
+		instance.engine = "neon";
+		return true;
+	}
+#endif
+	return false;
+}
 
-	for (int i = 0; i < modTable[inputLength % 3]; i++)
-		encodedData[outputLength - 1 - i] = '=';
+/**
+ * @return exactly how many bytes data decodes to, if it is good base64 with no whitespace, padded or not
+ */
+size_t
+Base64::DecodedLength(const char *data, size_t inputLength)
+{
+	if (inputLength > 0 && data[inputLength-1] == '=') inputLength--;
+	if (inputLength > 0 && data[inputLength-1] == '=') inputLength--;
+	size_t rest = inputLength % 4;
+	return inputLength / 4 * 3 + (rest > 1? rest - 1 : 0);
+}
 
-	return encodedData;
+/**
+ * encodes data, with padding, into out, which has room for EncodedLength(inputLength)
+ * @return the encoded length
+ */
+size_t
+Base64::Encode(const unsigned char *data, size_t inputLength, char *out)
+{
+	size_t i = 0;
+	char *p = out;
+	if (instance.encodeBlocks) {
+		i = instance.encodeBlocks(data, inputLength, out);
+		p += i / 3 * 4;
+	}
+	for (; i+3 <= inputLength; i+=3) {
+		unsigned triple = (data[i] << 16) | (data[i+1] << 8) | data[i+2];
+		*p++ = kAlphabet[(triple >> 18) & 0x3f];
+		*p++ = kAlphabet[(triple >> 12) & 0x3f];
+		*p++ = kAlphabet[(triple >> 6) & 0x3f];
+		*p++ = kAlphabet[triple & 0x3f];
+	}
+	size_t rest = inputLength - i;
+	if (rest > 0) {
+		unsigned triple = (data[i] << 16) | (rest > 1? data[i+1] << 8 : 0);
+		*p++ = kAlphabet[(triple >> 18) & 0x3f];
+		*p++ = kAlphabet[(triple >> 12) & 0x3f];
+		*p++ = rest > 1? kAlphabet[(triple >> 6) & 0x3f] : '=';
+		*p++ = '=';
+	}
+	return p - out;
 }
 
+/**
+ * decodes data into out, which has room for outCapacity bytes. DecodedLength() is exactly right for anything STRICT will take, and
+ * MaxDecodedLength() is always enough
+ * @return 0 with the decoded length in outputLength, kErrInvalid if data isn't base64 in the given mode, or kErrNoRoom
+ */
+int
+Base64::Decode(const char *data, size_t inputLength, unsigned char *out, size_t outCapacity, size_t& outputLength, DecodeMode mode)
+{
+	const unsigned char *d = (const unsigned char*)data;
+	unsigned char quad[4];
+	int n = 0;
+	bool padded = false;
+	size_t i = 0, j = 0;
+	outputLength = 0;
+	while (i < inputLength) {
+		if (n == 0 && instance.decodeBlocks && inputLength - i >= 16) {
+			size_t used = instance.decodeBlocks(data+i, inputLength-i, out+j, outCapacity-j);
+			i += used;
+			j += used / 4 * 3;
+			if (i >= inputLength) {
+				break;
+			}
+		}
+		if (n == 0) { // a whole quad of nothing but the 64 goes straight through
+			while (i+4 <= inputLength && j+3 <= outCapacity) {
+				unsigned char a = decodingTable[d[i]], b = decodingTable[d[i+1]], c = decodingTable[d[i+2]], e = decodingTable[d[i+3]];
+				if ((a | b | c | e) >= 64) {
+					break;
+				}
+				out[j++] = (a << 2) | (b >> 4);
+				out[j++] = (b << 4) | (c >> 2);
+				out[j++] = (c << 6) | e;
+				i += 4;
+			}
+			if (i >= inputLength) {
+				break;
+			}
+		}
+		unsigned char v = decodingTable[d[i++]];
+		if (v < 64) {
+			quad[n++] = v;
+			if (n == 4) {
+				if (j+3 > outCapacity) return kErrNoRoom;
+				out[j++] = (quad[0] << 2) | (quad[1] >> 4);
+				out[j++] = (quad[1] << 4) | (quad[2] >> 2);
+				out[j++] = (quad[2] << 6) | quad[3];
+				n = 0;
+			}
+		} else if (v == kSpace && mode == LENIENT) {
+			continue;
+		} else if (v == kPad) { // the end. all that can follow is more padding, or whitespace if we're lenient
+			int pads = 1;
+			for (; i < inputLength; i++) {
+				unsigned char w = decodingTable[d[i]];
+				if (w == kPad) {
+					pads++;
+				} else if (!(w == kSpace && mode == LENIENT)) {
+					return kErrInvalid;
+				}
+			}
+			if (n < 2 || n + pads > 4 || (mode == STRICT && n + pads != 4)) return kErrInvalid;
+			padded = true;
+			break;
+		} else {
+			return kErrInvalid;
+		}
+	}
+	if (n == 1) return kErrInvalid;
+	if (n > 0) {
+		if (mode == STRICT) {
+			if (!padded) return kErrInvalid;
+			if ((n == 2 && (quad[1] & 0x0f)) || (n == 3 && (quad[2] & 0x03))) return kErrInvalid;
+		}
+		if (j + n - 1 > outCapacity) return kErrNoRoom;
+		out[j++] = (quad[0] << 2) | (quad[1] >> 4);
+		if (n == 3) out[j++] = (quad[1] << 4) | (quad[2] >> 2);
+	}
+	outputLength = j;
+	return 0;
+}
 
-unsigned char*
-Base64::_Decode(const unsigned char *data,
+char*
+Base64::Encode(const unsigned char *data,
 		size_t inputLength,
 		size_t& outputLength) {
+	char *encoded = new char[EncodedLength(inputLength)];
+	outputLength = Encode(data, inputLength, encoded);
+	return encoded;
+}
 
-	if (inputLength % 4 != 0) return nullptr;
-
-	outputLength = inputLength / 4 * 3;
-	if (data[inputLength - 1] == '=') (outputLength)--;
-	if (data[inputLength - 2] == '=') (outputLength)--;
-
-	unsigned char *decoded_data = new unsigned char[outputLength];
-	if (decoded_data == nullptr) return nullptr;
-
-	for (size_t i = 0, j = 0; i < inputLength;) {
-
-		unsigned sextet_a = data[i] == '=' ? 0 & i++ : decodingTable[data[i++]];
-		unsigned sextet_b = data[i] == '=' ? 0 & i++ : decodingTable[data[i++]];
-		unsigned sextet_c = data[i] == '=' ? 0 & i++ : decodingTable[data[i++]];
-		unsigned sextet_d = data[i] == '=' ? 0 & i++ : decodingTable[data[i++]];
+/**
+ * decodes leniently into a new buffer
+ * @return the buffer, which is ours to delete, or nullptr if data isn't base64
+ */
+unsigned char*
+Base64::Decode(const unsigned char *data,
+		size_t inputLength,
+		size_t& outputLength) {
+	unsigned char *decoded = new unsigned char[MaxDecodedLength(inputLength)];
+	if (Decode((const char*)data, inputLength, decoded, MaxDecodedLength(inputLength), outputLength, LENIENT) < 0) {
+		delete []decoded;
+		outputLength = 0;
+		return nullptr;
+	}
+	return decoded;
+}
 
-		unsigned triple =
-				(sextet_a << 3 * 6)
-				+ (sextet_b << 2 * 6)
-				+ (sextet_c << 1 * 6)
-				+ (sextet_d << 0 * 6);
+std::string
+Base64::Encode(
+		const unsigned char *data,
+		size_t inputLength)
+{
+	std::string enc(EncodedLength(inputLength), '\0');
+	Encode(data, inputLength, &enc[0]);
+	return enc;
+}
 
-		if (j < outputLength) decoded_data[j++] = (triple >> 2 * 8) & 0xFF;
-		if (j < outputLength) decoded_data[j++] = (triple >> 1 * 8) & 0xFF;
-		if (j < outputLength) decoded_data[j++] = (triple >> 0 * 8) & 0xFF;
+/**
+ * decodes leniently
+ * @return the bytes, empty if data isn't base64
+ */
+std::vector<unsigned char>
+Base64:: Decode(
+		const unsigned char *data,
+		size_t inputLength)
+{
+	std::vector<unsigned char> r(MaxDecodedLength(inputLength));
+	size_t l = 0;
+	if (Decode((const char*)data, inputLength, r.data(), r.size(), l, LENIENT) < 0) {
+		l = 0;
 	}
-
-	return decoded_data;
+	r.resize(l);
+	return r;
 }
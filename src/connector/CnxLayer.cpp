@@ -33,6 +33,27 @@ CnxLayer::~CnxLayer()
 {
 }
 
+/**
+ * the default gathers the pieces up and does a Write(). layers that can do better, do
+ */
+int
+CnxLayer::WriteV(const CnxChunk *chunks, const size_t n)
+{
+	if (n == 1) {
+		return Write(chunks[0].data, chunks[0].len);
+	}
+	size_t len = 0;
+	for (size_t i=0; i<n; i++) {
+		len += chunks[i].len;
+	}
+	std::string all;
+	all.reserve(len);
+	for (size_t i=0; i<n; i++) {
+		all.append(chunks[i].data, chunks[i].len);
+	}
+	return Write(all.data(), all.size());
+}
+
 /**
  * format an io error and pass to an upper layer
  */
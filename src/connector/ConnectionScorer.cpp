@@ -0,0 +1,278 @@
+/*
+ * ConnectionScorer.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#include <cmath>
+#include <algorithm>
+
+#include "UCLowerHeaders.h"
+
+const int ConnectionScorer::kDfltFailurePenaltyMS;
+const int ConnectionScorer::kDfltThroughputCreditMS;
+const int ConnectionScorer::kMaxThroughputKBps;
+const int ConnectionScorer::kDfltFailureHalfLifeMS;
+const int ConnectionScorer::kMinSessionMS;
+constexpr double ConnectionScorer::kDfltProbeRate;
+constexpr double ConnectionScorer::kSmoothing;
+
+/**
+ * @class ConnectionScorer ConnectionScorer.h
+ * @brief keeps score of how each connection actually does, so a StandardConnector can try the best one first
+ *
+ * the cost of a connection is roughly what we expect to wait for it, in ms: its smoothed time to the server answering, plus a penalty scaled
+ * by its smoothed failure rate, less a credit for the throughput of its past sessions. failures fade with a half life, so a transport that
+ * was broken an hour ago gets another look. anything we have no history for costs nothing, so everything gets tried once. after that, now
+ * and then (the probe rate) one of the others is moved to the front, so a connection that has got better can be noticed
+ *
+ * records are by ShortName(), so one scorer can be shared between connectors. Shared() is one for the whole process
+ */
+ConnectionScorer::ConnectionScorer(const unsigned seed)
+	: probeRate(kDfltProbeRate)
+	, probes(0)
+	, failurePenaltyMS(kDfltFailurePenaltyMS)
+	, throughputCreditMS(kDfltThroughputCreditMS)
+	, failureHalfLifeMS(kDfltFailureHalfLifeMS)
+	, rng(seed)
+	, clock([]() {
+		return (uint64_t) std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	})
+{
+}
+
+/**
+ * @return a scorer that lasts as long as the process, so what was learned on one connection is there for the next
+ */
+std::shared_ptr<ConnectionScorer>
+ConnectionScorer::Shared()
+{
+	static std::shared_ptr<ConnectionScorer> shared = std::make_shared<ConnectionScorer>();
+	return shared;
+}
+
+uint64_t
+ConnectionScorer::Now() const
+{
+	return clock();
+}
+
+/**
+ * put the candidates in order of cost, keeping their existing order where costs tie, and maybe move one of the others to the front
+ */
+void
+ConnectionScorer::Rank(std::vector<CnxRef>& candidates)
+{
+	std::vector<std::pair<double, CnxRef>> costed;
+	for (auto it: candidates) {
+		costed.push_back(std::make_pair(Cost(it->ShortName()), it));
+	}
+	std::stable_sort(costed.begin(), costed.end(), [](const std::pair<double, CnxRef>& a, const std::pair<double, CnxRef>& b) {
+		return a.first < b.first;
+	});
+	for (size_t i=0; i<costed.size(); i++) {
+		candidates[i] = costed[i].second;
+	}
+	if (candidates.size() > 1 && probeRate > 0 && std::uniform_real_distribution<>(0, 1)(rng) < probeRate) {
+		size_t i = std::uniform_int_distribution<size_t>(1, candidates.size()-1)(rng);
+		std::rotate(candidates.begin(), candidates.begin()+i, candidates.begin()+i+1);
+		probes++;
+	}
+}
+
+/**
+ * @return what we expect the connection to cost us, in ms ... lower is better
+ */
+double
+ConnectionScorer::Cost(const std::string& key) const
+{
+	auto it = records.find(key);
+	if (it == records.end() || it->second.attempts == 0) {
+		return 0;
+	}
+	const Record& r = it->second;
+	double kbps = std::min(r.throughput/1024, (double)kMaxThroughputKBps);
+	return r.latency + DecayedFailure(r)*failurePenaltyMS - kbps*throughputCreditMS;
+}
+
+/**
+ * @return the failure rate, faded for the time since it was last updated
+ */
+double
+ConnectionScorer::DecayedFailure(const Record& r) const
+{
+	uint64_t now = Now();
+	if (failureHalfLifeMS <= 0 || now <= r.failureUpdated) {
+		return r.failure;
+	}
+	return r.failure*std::pow(0.5, (double)(now - r.failureUpdated)/failureHalfLifeMS);
+}
+
+/**
+ * @return the record for a connection, or nullptr if we've never seen it
+ */
+const ConnectionScorer::Record*
+ConnectionScorer::Find(const std::string& key) const
+{
+	auto it = records.find(key);
+	return it != records.end()? &it->second : nullptr;
+}
+
+/**
+ * forget everything
+ */
+void
+ConnectionScorer::Reset()
+{
+	records.clear();
+	probes = 0;
+}
+
+/**
+ * a connect attempt is starting
+ */
+void
+ConnectionScorer::Begin(const std::string& key)
+{
+	Record& r = records[key];
+	r.started = Now();
+	r.answered = 0;
+	r.bytes = 0;
+	r.active = true;
+}
+
+/**
+ * data in. the first since Begin() marks the attempt as a success, and sets the latency
+ */
+void
+ConnectionScorer::Received(const std::string& key, const size_t bytes)
+{
+	auto it = records.find(key);
+	if (it == records.end() || !it->second.active) {
+		return;
+	}
+	Record& r = it->second;
+	if (r.answered == 0) {
+		uint64_t now = Now();
+		r.answered = now > r.started? now : r.started+1;
+		double latency = (double)(r.answered - r.started);
+		r.latency = r.attempts == r.failures? latency : r.latency + kSmoothing*(latency - r.latency);
+		r.failure = r.attempts == 0? 0 : DecayedFailure(r)*(1-kSmoothing);
+		r.failureUpdated = now;
+		r.attempts++;
+	}
+	r.bytes += bytes;
+}
+
+/**
+ * the connection failed, or was lost. before the server answered, that counts against it. after, it's just the end of the session
+ */
+void
+ConnectionScorer::Failed(const std::string& key)
+{
+	auto it = records.find(key);
+	if (it == records.end() || !it->second.active) {
+		return;
+	}
+	Record& r = it->second;
+	if (r.answered != 0) {
+		Ended(key);
+		return;
+	}
+	double failure = DecayedFailure(r);
+	r.failure = r.attempts == 0? 1 : failure + kSmoothing*(1 - failure);
+	r.failureUpdated = Now();
+	r.attempts++;
+	r.failures++;
+	r.active = false;
+}
+
+/**
+ * the session is over. if it lasted long enough to mean anything, note its throughput
+ */
+void
+ConnectionScorer::Ended(const std::string& key)
+{
+	auto it = records.find(key);
+	if (it == records.end() || !it->second.active) {
+		return;
+	}
+	Record& r = it->second;
+	r.active = false;
+	if (r.answered == 0) {
+		return;
+	}
+	uint64_t ms = Now() - r.answered;
+	if (ms < kMinSessionMS) {
+		return;
+	}
+	double throughput = r.bytes*1000.0/ms;
+	r.throughput = r.sessions == 0? throughput : r.throughput + kSmoothing*(throughput - r.throughput);
+	r.sessions++;
+}
+
+/**
+ * we dropped the attempt ourselves (it lost a race), so it doesn't count either way
+ */
+void
+ConnectionScorer::Abandon(const std::string& key)
+{
+	auto it = records.find(key);
+	if (it != records.end() && it->second.answered == 0) {
+		it->second.active = false;
+	}
+}
+
+/**
+ * @param p chance, from 0 to 1, that Rank() puts something other than the best first. 0 to always go with the best
+ */
+void
+ConnectionScorer::SetProbeRate(const double p)
+{
+	probeRate = p < 0? 0 : p > 1? 1 : p;
+}
+
+double
+ConnectionScorer::GetProbeRate() const
+{
+	return probeRate;
+}
+
+/**
+ * @return how many times Rank() has put an alternative first
+ */
+uint64_t
+ConnectionScorer::GetProbeCount() const
+{
+	return probes;
+}
+
+/**
+ * @param failurePenaltyMS the cost of a connection that always fails
+ * @param throughputCreditMS taken off the cost for each KB/s a connection's sessions have averaged, up to kMaxThroughputKBps
+ */
+void
+ConnectionScorer::SetWeights(const int failurePenaltyMS, const int throughputCreditMS)
+{
+	this->failurePenaltyMS = failurePenaltyMS;
+	this->throughputCreditMS = throughputCreditMS;
+}
+
+/**
+ * @param ms how long for a failure rate to count for half as much. 0 and it never fades
+ */
+void
+ConnectionScorer::SetFailureHalfLife(const int ms)
+{
+	failureHalfLifeMS = ms > 0? ms : 0;
+}
+
+/**
+ * replace the millisecond clock, which is std::chrono::steady_clock by default. for tests
+ */
+void
+ConnectionScorer::SetClock(Clock c)
+{
+	clock = c;
+}
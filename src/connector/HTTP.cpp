@@ -26,7 +26,12 @@ inline bool isrvsep(char c) { return (c==':' || c== ' '); }
 
 std::string
 HTTP::PostData::Serialize() {
+	size_t len = 0;
+	for (auto& it: *this) {
+		len += it.first.size() + Url::MaxEncodedLength(it.second.size()) + 2;
+	}
 	std::string s;
+	s.reserve(len);
 	bool first = true;
 	auto it=begin();
 	while (it!=end()) {
@@ -35,7 +40,8 @@ HTTP::PostData::Serialize() {
 		} else {
 			s += "&";
 		}
-		s += it->first + "=" + Url::Encode(it->second);
+		s.append(it->first).append("=");
+		Url::AppendEncoded(s, it->second);
 		++it;
 	}
 	return s;
@@ -193,6 +199,6 @@ HTTP::ErrorResponseMessage(std::string code)
 bool
 HTTP::IsCompleteResponse(const std::string& response)
 {
-	return response.find_last_of("\r\n\r\n") != std::string::npos;
+	return response.find("\r\n\r\n") != std::string::npos || response.find("\n\n") != std::string::npos;
 }
 
@@ -4,27 +4,130 @@
  *  Created on: May 20, 2014
  *      Author: dak
  */
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <zlib.h>
+
 #include "uv.h"
 #include "UCLowerHeaders.h"
 #include "connector/HTTPCnxLayer.h"
 
+const size_t HTTPRequestBuilder::kMaxChunks;
+const size_t HTTPCnxLayer::kInflateChunk;
+const size_t HTTPCnxLayer::kDefaultMaxBodySize;
+const int HTTPCnxLayer::kErrContentEncoding;
+const int HTTPCnxLayer::kErrBodyTooBig;
+const char* HTTPCnxLayer::kAcceptEncoding = "gzip, deflate";
+
+/**
+ * @class HTTPRequestBuilder HTTPCnxLayer.h
+ *
+ * the request line and headers are the same on every request a channel makes, so they are laid out once, with a version ending in the
+ * Content-Length: for requests with a body. a request is then that, the length, the body where it is, and the closing crlf, written
+ * out together. what goes on the wire is byte for byte what HTTP::Message() makes
+ */
+HTTPRequestBuilder::HTTPRequestBuilder()
+	: stale(true)
+	, hasContentLength(false)
+	, headBuilds(0)
+{
+	length[0] = '\0';
+}
+
+void
+HTTPRequestBuilder::MakeHead(const std::string& method, const std::string& host, const std::string& resource, const HTTP::Headers& headers)
+{
+	bool hasContentType = false;
+	hasContentLength = false;
+	head = method+" "+resource+" HTTP/1.1\r\n";
+	head += HTTP_HEADER_HOST ": " + host+"\r\n";
+	for (auto& it: headers) {
+		head += it.first+": "+it.second+"\r\n";
+		if (it.first == HTTP_HEADER_CONTENT_TYPE) {
+			hasContentType = true;
+		} else if (it.first == HTTP_HEADER_CONTENT_LENGTH) {
+			hasContentLength = true;
+		}
+	}
+	bodyHead = head;
+	if (!hasContentType) {
+		bodyHead += HTTP_HEADER_CONTENT_TYPE ": " "text/plain" "\r\n";
+	}
+	if (!hasContentLength) {
+		bodyHead += HTTP_HEADER_CONTENT_LENGTH ": ";
+	}
+	head += "\r\n";
+	stale = false;
+	headBuilds++;
+}
+
+/**
+ * lays out a request for body in chunks, which has room for kMaxChunks. the head is only made again after an Invalidate(). the chunks
+ * point into body and into this, so are good till the next Build()
+ * @return the number of chunks used
+ */
+size_t
+HTTPRequestBuilder::Build(const std::string& method, const std::string& host, const std::string& resource, const HTTP::Headers& headers,
+		const char *body, const size_t len, CnxChunk *chunks)
+{
+	if (stale) {
+		MakeHead(method, host, resource, headers);
+	}
+	if (len == 0) {
+		chunks[0] = { head.data(), head.size() };
+		return 1;
+	}
+	int n = hasContentLength? snprintf(length, sizeof(length), "\r\n") : snprintf(length, sizeof(length), "%u\r\n\r\n", (unsigned)len);
+	chunks[0] = { bodyHead.data(), bodyHead.size() };
+	chunks[1] = { length, (size_t)n };
+	chunks[2] = { body, len };
+	chunks[3] = { "\r\n", 2 };
+	return 4;
+}
+
+/**
+ * @return the chunks all in one string, mostly for checking what went out
+ */
+std::string
+HTTPRequestBuilder::Gather(const CnxChunk *chunks, const size_t n)
+{
+	std::string all;
+	for (size_t i=0; i<n; i++) {
+		all.append(chunks[i].data, chunks[i].len);
+	}
+	return all;
+}
+
 static int _layerid=0;
 /**
  * @class HTTPCnxLayer HTTPCnxLayer.h
  * @brief connection layer providing http connections
+ *
+ * requests say we take gzip and deflate, unless SetCompression() is off. an encoded response body is inflated a piece at a time as it
+ * comes in, so the decoded text is ready when the last of it arrives, and neither end of it is held whole twice
  */
 HTTPCnxLayer::HTTPCnxLayer(CnxLayerUpper* upper, CnxLayer* lower)
 	: CnxLayer(upper, lower)
 	, waitingResponseMessageBody(false)
 	, hasFullResponse(false)
+	, compression(true)
+	, bodyEncoding(kIdentity)
+	, bodyWireBytes(0)
+	, rawDeflate(false)
+	, inflateEnded(false)
+	, inflater(nullptr)
+	, maxBodySize(kDefaultMaxBodySize)
 {
 	id = ++_layerid;
+	SetCompression(true);
 }
 
 HTTPCnxLayer::~HTTPCnxLayer() {
 	DEBUG_OUT("~HTTPCnxLayer() closing lower");
 	if (lower) lower->Close();
 	connectState = ConnectionState::NOT_CONNECTED;
+	EndInflate();
 	DEBUG_OUT("~HTTPCnxLayer() done");
 }
 
@@ -72,25 +175,31 @@ HTTPCnxLayer::Write(const char *data, const size_t len)
 
 
 
+/**
+ * give up on the response we're getting: tell the upper layer, and hang up
+ */
+void
+HTTPCnxLayer::FailResponse(const int status, const std::string msg)
+{
+	DoIOError(status, msg);
+	if (upper) upper->OnOpenFailure(msg, status);
+	connectState = ConnectionState::NOT_CONNECTED;
+	DEBUG_OUT("HTTPCnxLayer closing lower after " << msg);
+	waitingResponseMessageBody = false;
+	if (lower) lower->Close();
+}
+
 int
 HTTPCnxLayer::ProcessHTTPResponseHeaders(const std::string response, HTTP::Response& r)
 {
 	int res = HTTP::SplitResponseHeaders(response, r);
 	if (res < 0) {
-		DoIOError(kErrInvalidHTTPResponse, "Bad HTTP Response "+response);
-		if (upper) upper->OnOpenFailure("Bad HTTP Response "+response, kErrInvalidHTTPResponse);
-		connectState = ConnectionState::NOT_CONNECTED;
-		DEBUG_OUT("HTTPCnxLayer closing lower as error for bad response");
-		if (lower) lower->Close();
+		FailResponse(kErrInvalidHTTPResponse, "Bad HTTP Response "+response);
 		return res;
 	}
 	std::string m = HTTP::ErrorResponseMessage(r.responseCode);
 	if (m != "") {
-		DoIOError(kErrHTTPErrorResponse, "HTTP Error "+r.responseCode+ ", "+m);
-		if (upper) upper->OnOpenFailure("HTTP Error "+r.responseCode+ ", "+m, kErrHTTPErrorResponse);
-		connectState = ConnectionState::NOT_CONNECTED;
-		DEBUG_OUT("HTTPCnxLayer closing lower as error for http error");
-		if (lower) lower->Close();
+		FailResponse(kErrHTTPErrorResponse, "HTTP Error "+r.responseCode+ ", "+m);
 		return kErrHTTPErrorResponse;
 	}
 
@@ -99,64 +208,176 @@ HTTPCnxLayer::ProcessHTTPResponseHeaders(const std::string response, HTTP::Respo
 	return res;
 }
 
-// from CnxLayerUpper
+/**
+ * @return the value of header name, whatever case the server wrote it in, lower cased and trimmed
+ */
+static std::string
+LowerHeaderValue(const HTTP::Headers& headers, const char *name)
+{
+	for (auto& it: headers) {
+		if (strcasecmp(it.first.c_str(), name) == 0) {
+			std::string v;
+			for (char c: it.second) {
+				if (!isspace((unsigned char)c)) v.push_back(tolower((unsigned char)c));
+			}
+			return v;
+		}
+	}
+	return "";
+}
+
+/**
+ * the headers are in. get ready for the body, and an inflater for it if it is encoded
+ */
 int
-HTTPCnxLayer::Receive(const char *msgBytes, const size_t msgLen)
+HTTPCnxLayer::StartBody()
+{
+	bodyWireBytes = 0;
+	response.body.clear();
+	std::string encoding = LowerHeaderValue(response.headers, HTTP_HEADER_CONTENT_ENCODING);
+	if (encoding == "gzip" || encoding == "x-gzip") {
+		bodyEncoding = kGzip;
+	} else if (encoding == "deflate") {
+		bodyEncoding = kDeflate;
+	} else if (encoding == "" || encoding == "identity") {
+		bodyEncoding = kIdentity;
+	} else {
+		FailResponse(kErrContentEncoding, "Unsupported Content-Encoding "+encoding);
+		return kErrContentEncoding;
+	}
+	if (bodyEncoding != kIdentity) {
+		if (inflater == nullptr) {
+			inflater = new z_stream;
+			memset(inflater, 0, sizeof(z_stream));
+			inflateInit2(inflater, 15+32); // zlib or gzip wrapper, whichever turns up
+		} else {
+			inflateReset2(inflater, 15+32);
+		}
+		rawDeflate = false;
+		inflateEnded = false;
+	}
+	waitingResponseMessageBody = response.contentLength > 0;
+	stats.responses++;
+	return 0;
+}
+
+/**
+ * take what's in data of the body, up to the Content-Length, decoding it if need be
+ */
+int
+HTTPCnxLayer::TakeBody(const char *data, const size_t len)
+{
+	size_t n = std::min(len, response.contentLength - bodyWireBytes);
+	bodyWireBytes += n;
+	stats.wireBytesIn += n;
+	if (bodyEncoding == kIdentity) {
+		response.body.append(data, n);
+	} else {
+		int r = Inflate(data, n);
+		if (r < 0) {
+			FailResponse(kErrContentEncoding, r == kErrBodyTooBig? "Encoded HTTP response body inflates past the size limit"
+					: "Bad encoded HTTP response body");
+			EndInflate();
+			std::string().swap(response.body);
+			return kErrContentEncoding;
+		}
+	}
+	if (bodyWireBytes < response.contentLength) {
+		return 0;
+	}
+	if (bodyEncoding != kIdentity && response.contentLength > 0) {
+		if (!inflateEnded) {
+			FailResponse(kErrContentEncoding, "Encoded HTTP response body ends early");
+			return kErrContentEncoding;
+		}
+		stats.responsesInflated++;
+	}
+	stats.rawBytesIn += response.body.size();
+	waitingResponseMessageBody = false;
+	return 0;
+}
+
+/**
+ * run the next piece of an encoded body through zlib, onto the end of the response body
+ * @return 0, or kErrContentEncoding if it isn't what it says it is, or kErrBodyTooBig if it comes to more than maxBodySize
+ */
+int
+HTTPCnxLayer::Inflate(const char *data, const size_t len)
 {
-	std::string data(msgBytes, msgLen);
+	auto start = std::chrono::steady_clock::now();
+	bool fresh = (inflater->total_in == 0);
+	inflater->next_in = (Bytef*)data;
+	inflater->avail_in = (uInt)len;
+	int r = Z_OK;
+	while (!inflateEnded && (inflater->avail_in > 0 || inflater->avail_out == 0)) {
+		size_t out = response.body.size();
+		response.body.resize(out + kInflateChunk);
+		inflater->next_out = (Bytef*)&response.body[out];
+		inflater->avail_out = (uInt)kInflateChunk;
+		r = inflate(inflater, Z_NO_FLUSH);
+		response.body.resize(out + kInflateChunk - inflater->avail_out);
+		if (r == Z_DATA_ERROR && fresh && bodyEncoding == kDeflate && !rawDeflate) { // some servers send deflate without the zlib wrapper
+			rawDeflate = true;
+			inflateReset2(inflater, -15);
+			inflater->next_in = (Bytef*)data;
+			inflater->avail_in = (uInt)len;
+			inflater->avail_out = 1;
+			continue;
+		}
+		if (response.body.size() > maxBodySize) { // a few k of gzip can be gigabytes of zeros
+			stats.inflateNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+			return kErrBodyTooBig;
+		}
+		if (r == Z_STREAM_END) {
+			inflateEnded = true;
+		} else if (r != Z_OK) {
+			break;
+		}
+	}
+	stats.inflateNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	return r == Z_OK || r == Z_STREAM_END || r == Z_BUF_ERROR? 0 : kErrContentEncoding;
+}
 
-	responseMsg = responseMsg + data;
+/**
+ * drop the zlib context, if any
+ */
+void
+HTTPCnxLayer::EndInflate()
+{
+	if (inflater != nullptr) {
+		inflateEnd(inflater);
+		delete inflater;
+		inflater = nullptr;
+	}
+}
 
+// from CnxLayerUpper
+int
+HTTPCnxLayer::Receive(const char *msgBytes, const size_t msgLen)
+{
 	if (waitingResponseMessageBody) {
-		if (responseMsg.size() >= response.contentLength) {
-			response.body.assign(responseMsg.c_str(), response.contentLength);
-//			responseMsg.erase(responseMsg.begin(), responseMsg.begin()+response.contentLength);
-			std::string m(responseMsg.c_str()+response.contentLength, responseMsg.size()-response.contentLength);
-			if (responseMsg.size() > response.contentLength) {
-				std::string m(responseMsg.c_str(), responseMsg.size()-response.contentLength);
-				responseMsg = m;
-			} else {
-				responseMsg = "";
-			}
-			hasFullResponse = true;
-			waitingResponseMessageBody = false;
+		if (TakeBody(msgBytes, msgLen) < 0) {
+			return -1;
 		}
-	} else if (HTTP::IsCompleteResponse(responseMsg)) {
+	} else {
+		responseMsg.append(msgBytes, msgLen);
+		if (!HTTP::IsCompleteResponse(responseMsg)) {
+			return 0;
+		}
+		response.Init();
 		int i = ProcessHTTPResponseHeaders(responseMsg, response);
 		if (i < 0) {
 			return -1;
 		}
-//		responseMsg.erase(responseMsg.begin(), responseMsg.begin()+i);
-		if (responseMsg.size() > (unsigned)i) {
-			std::string m(responseMsg.c_str()+i, responseMsg.size()-i);
-			responseMsg = m;
-		} else {
-			responseMsg = "";
-		}
-		if (response.contentLength > 0) {
-			if (responseMsg.size() >= response.contentLength) {
-				waitingResponseMessageBody = false;
-				response.body.assign(responseMsg.c_str(), response.contentLength);
-//				responseMsg.erase(responseMsg.begin(), responseMsg.begin()+response.contentLength);
-				if (responseMsg.size() > response.contentLength) {
-					std::string m(responseMsg.c_str()+response.contentLength, responseMsg.size()-response.contentLength);
-					responseMsg = m;
-				} else {
-					responseMsg = "";
-				}
-				hasFullResponse = true;
-//				if (upper) upper->Receive(response.body.c_str(), response.contentLength);
-			} else {
-				waitingResponseMessageBody = true;
-			}
-		} else {
-			response.body = "";
-			hasFullResponse = true;
-			waitingResponseMessageBody = false;
+		std::string body = (responseMsg.size() > (unsigned)i)? responseMsg.substr(i) : "";
+		responseMsg = "";
+		if (StartBody() < 0 || TakeBody(body.data(), body.size()) < 0) {
+			return -1;
 		}
 	}
 	if (!waitingResponseMessageBody) {
-		DEBUG_OUT("HTTPCnxLayer " << id << " closing lower in Receive " << response.contentLength << " " << hasFullResponse << " bytes" << response.body);
+		hasFullResponse = true;
+		DEBUG_OUT("HTTPCnxLayer " << id << " closing lower in Receive " << response.body.size() << " bytes" << response.body);
 		if (lower) lower->Close();
 	}
 	return 0;
@@ -173,9 +394,11 @@ HTTPCnxLayer::OnOpen()
 	responseMsg = "";
 	if (!lower) {
 		if (upper) upper->OnOpenFailure("No transport layer", kErrNoTransport);
+		return;
 	}
-	std::string msg = HTTP::Message(method, host, resource, headers, messageBody);
-	lower->Write(msg.c_str(), msg.size());
+	CnxChunk chunks[HTTPRequestBuilder::kMaxChunks];
+	size_t n = builder.Build(method, host, resource, headers, messageBody.data(), messageBody.size(), chunks);
+	lower->WriteV(chunks, n);
 }
 
 /**
@@ -188,7 +411,7 @@ HTTPCnxLayer::OnClose()
 	if (upper) {
 		bool doNotifyReceipt = hasFullResponse;
 		hasFullResponse = false;
-		if (doNotifyReceipt) upper->Receive(response.body.c_str(), response.contentLength);
+		if (doNotifyReceipt) upper->Receive(response.body.c_str(), response.body.size());
 		response.body = "";
 		response.contentLength = 0;
 		responseMsg = "";
@@ -226,23 +449,73 @@ void
 HTTPCnxLayer::SetHost(const std::string h) const
 {
 	host = h;
+	builder.Invalidate();
 }
 
 void
 HTTPCnxLayer::SetResource(const std::string r) const
 {
 	resource = r;
+	builder.Invalidate();
 }
 
 void
 HTTPCnxLayer::SetMethod(const std::string m) const
 {
 	method = m;
+	builder.Invalidate();
 }
 
 void
 HTTPCnxLayer::SetHeaders(const HTTP::Headers h) const
 {
 	headers = h;
+	if (compression && headers.find(HTTP_HEADER_ACCEPT_ENCODING) == headers.end()) {
+		headers[HTTP_HEADER_ACCEPT_ENCODING] = kAcceptEncoding;
+	}
+	builder.Invalidate();
+}
+
+/**
+ * ask for gzip or deflate responses, or not. on by default. whatever we asked for, an encoded response is decoded
+ */
+void
+HTTPCnxLayer::SetCompression(const bool enable) const
+{
+	compression = enable;
+	if (enable) {
+		headers[HTTP_HEADER_ACCEPT_ENCODING] = kAcceptEncoding;
+	} else {
+		headers.erase(HTTP_HEADER_ACCEPT_ENCODING);
+	}
+	builder.Invalidate();
+}
+
+/**
+ * @return the counts of response bytes, as they came and decoded
+ */
+const HTTPCnxLayer::CompressionStats&
+HTTPCnxLayer::GetCompressionStats() const
+{
+	return stats;
+}
+
+/**
+ * @param bytes the most an encoded response body may inflate to. past that, the response fails, as a bad encoding would
+ */
+void
+HTTPCnxLayer::SetMaxBodySize(const size_t bytes) const
+{
+	maxBodySize = bytes;
+}
+
+void
+HTTPCnxLayer::CompressionStats::Add(const CompressionStats& s)
+{
+	responses += s.responses;
+	responsesInflated += s.responsesInflated;
+	rawBytesIn += s.rawBytesIn;
+	wireBytesIn += s.wireBytesIn;
+	inflateNanos += s.inflateNanos;
 }
 
@@ -0,0 +1,386 @@
+/*
+ * SendQueue.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#include <chrono>
+#include <cstring>
+
+#include "UCLowerHeaders.h"
+#include "connector/SendQueue.h"
+
+const int SendQueue::kPriorityControl;
+const int SendQueue::kPriorityNormal;
+const int SendQueue::kPriorityBulk;
+const int SendQueue::kNumPriorities;
+const int SendQueue::kMaxMethod;
+const int SendQueue::kPolicyReject;
+const int SendQueue::kPolicyDropOldest;
+const int SendQueue::kPolicyBlock;
+const size_t SendQueue::kDfltMaxBytes;
+const size_t SendQueue::kDfltMaxCount;
+const size_t SendQueue::kDfltWriteWindow;
+const int SendQueue::kDfltBlockMS;
+const int SendQueue::kErrQueueFull;
+
+/**
+ * @class SendQueue SendQueue.h
+ * @brief the outbound upcs of one connection that its transport hasn't taken yet, bounded in bytes and in count
+ *
+ * a transport Attach()es a Writer, and a measure of what it has been given and not yet sent, and then sends everything through here. while
+ * that's under the write window, messages go straight through. past it, they wait here, in order, and Flush(), which the transport calls as
+ * its writes complete, hands them on. so the socket never has more than about a window's worth in hand, and what's here can still be
+ * dropped, or refused, when it fills.
+ *
+ * a message that would take us over the cap goes by the policy for its priority, which comes from its upc method. kPolicyReject turns it
+ * away. kPolicyDropOldest makes room by dropping the oldest queued messages that are themselves droppable (ie whose priority has that policy).
+ * kPolicyBlock drops the droppable ones too, and then waits for room, but only off the loop thread, which is the one that has to empty us:
+ * there, and if the wait runs out, the message is rejected. by default, control and normal upcs block and room messages are dropped.
+ *
+ * the watermark callback is told when we go over the high watermark, and again once we're back down to the low one. both are fractions of
+ * the caps, and apply to bytes and count alike
+ */
+SendQueue::SendQueue()
+{
+	for (int i=0; i<kNumPriorities; i++) {
+		policy[i] = kPolicyBlock;
+		blockMS[i] = kDfltBlockMS;
+	}
+	policy[kPriorityBulk] = kPolicyDropOldest;
+	for (int i=0; i<kMaxMethod; i++) {
+		priority[i] = kPriorityNormal;
+	}
+	for (UPCMessageID m: {
+			UPC::ID::CLIENT_HELLO, UPC::ID::LOGIN, UPC::ID::LOGOFF, UPC::ID::TERMINATE_SESSION,
+			UPC::ID::JOIN_ROOM, UPC::ID::LEAVE_ROOM, UPC::ID::OBSERVE_ROOM, UPC::ID::STOP_OBSERVING_ROOM,
+			UPC::ID::SET_ROOM_UPDATE_LEVELS }) {
+		priority[UPC::ID::ToCode(m)] = kPriorityControl;
+	}
+	priority[UPC::ID::ToCode(UPC::ID::SEND_MESSAGE_TO_ROOMS)] = kPriorityBulk; // the broadcast that runs away with us
+}
+
+/**
+ * hook up the transport
+ * @param w hands on a message
+ * @param u the bytes given to w that are still to go out
+ */
+void
+SendQueue::Attach(Writer w, Unsent u)
+{
+	std::lock_guard<std::recursive_mutex> g(lock);
+	writer = w;
+	unsent = u;
+}
+
+/**
+ * @param maxBytes most bytes waiting. a message bigger than this on its own is still taken when the queue is empty
+ * @param maxCount most messages waiting
+ */
+void
+SendQueue::SetLimits(const size_t maxBytes, const size_t maxCount)
+{
+	std::lock_guard<std::recursive_mutex> g(lock);
+	this->maxBytes = maxBytes;
+	this->maxCount = maxCount;
+}
+
+/**
+ * @param high fraction of either cap that counts as filling up
+ * @param low fraction of both caps that we have to be back under to count as drained
+ */
+void
+SendQueue::SetWatermarks(const double high, const double low)
+{
+	std::lock_guard<std::recursive_mutex> g(lock);
+	highMark = high;
+	lowMark = low;
+}
+
+/**
+ * @param bytes how much the transport may have in hand before messages wait here
+ */
+void
+SendQueue::SetWriteWindow(const size_t bytes)
+{
+	std::lock_guard<std::recursive_mutex> g(lock);
+	writeWindow = bytes;
+}
+
+/**
+ * @param priority one of the kPriority... classes
+ * @param policy one of the kPolicy... values
+ * @param blockMS for kPolicyBlock, the longest to wait for room
+ */
+void
+SendQueue::SetPolicy(const int priority, const int policy, const int blockMS)
+{
+	if (priority < 0 || priority >= kNumPriorities) {
+		return;
+	}
+	std::lock_guard<std::recursive_mutex> g(lock);
+	this->policy[priority] = policy;
+	this->blockMS[priority] = blockMS;
+}
+
+/**
+ * @param method the upc method number, eg 1 for SEND_MESSAGE_TO_ROOMS
+ * @param priority one of the kPriority... classes
+ */
+void
+SendQueue::SetPriority(const int method, const int priority)
+{
+	if (method < 0 || method >= kMaxMethod || priority < 0 || priority >= kNumPriorities) {
+		return;
+	}
+	std::lock_guard<std::recursive_mutex> g(lock);
+	this->priority[method] = priority;
+}
+
+int
+SendQueue::GetPriority(const int method) const
+{
+	return method >= 0 && method < kMaxMethod? priority[method] : kPriorityNormal;
+}
+
+void
+SendQueue::SetWatermarkCallback(WatermarkCB cb)
+{
+	std::lock_guard<std::recursive_mutex> g(lock);
+	onWatermark = cb;
+}
+
+/**
+ * @param check true if we're on the thread that calls Flush(), so must never wait on it
+ */
+void
+SendQueue::SetLoopThreadCheck(std::function<bool()> check)
+{
+	std::lock_guard<std::recursive_mutex> g(lock);
+	onLoopThread = check;
+}
+
+/**
+ * send a message, now if the transport has room, or once it does
+ * @return less than zero if it was turned away, kErrQueueFull if for want of room, otherwise whatever the transport said, or 0 if queued
+ */
+int
+SendQueue::Send(const std::string& msg)
+{
+	std::unique_lock<std::recursive_mutex> g(lock);
+	if (!writer) {
+		return -1;
+	}
+	if (queue.empty() && (!unsent || unsent() < writeWindow)) {
+		stats.queued++;
+		stats.sent++;
+		flushing++;
+		int r = writer(msg);
+		flushing--;
+		return r;
+	}
+	int p = GetPriority(Method(msg));
+	size_t len = msg.size();
+	if (!Fits(len)) {
+		bool fits = policy[p] != kPolicyReject && DropOldest(len);
+		if (!fits && policy[p] == kPolicyBlock && flushing == 0 && !(onLoopThread && onLoopThread())) {
+			stats.blocked++;
+			uint64_t was = epoch;
+			auto start = std::chrono::steady_clock::now();
+			room.wait_for(g, std::chrono::milliseconds(blockMS[p]), [&]() {
+				return epoch != was || Fits(len);
+			});
+			stats.blockedMS.Add(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+			fits = epoch == was && Fits(len);
+		}
+		if (!fits) {
+			stats.rejected++;
+			return kErrQueueFull;
+		}
+	}
+	queue.push_back({ msg, p });
+	Took(len);
+	stats.queued++;
+	int mark = Watermark();
+	size_t b = bytes, c = queue.size();
+	g.unlock();
+	Notify(mark, b, c);
+	Flush();
+	return 0;
+}
+
+/**
+ * hand on what's waiting, while the transport has room. called by the transport as its writes go
+ */
+void
+SendQueue::Flush()
+{
+	std::unique_lock<std::recursive_mutex> g(lock);
+	if (!writer) {
+		return;
+	}
+	flushing++;
+	bool gave = false;
+	while (!queue.empty() && (!unsent || unsent() < writeWindow)) {
+		std::string msg = std::move(queue.front().msg);
+		queue.pop_front();
+		Gave(msg.size());
+		gave = true;
+		stats.sent++;
+		writer(msg);
+	}
+	flushing--;
+	if (!gave) {
+		return;
+	}
+	room.notify_all();
+	int mark = Watermark();
+	size_t b = bytes, c = queue.size();
+	g.unlock();
+	Notify(mark, b, c);
+}
+
+/**
+ * drop everything waiting, eg when the connection goes. anyone blocked is turned away
+ */
+void
+SendQueue::Clear()
+{
+	std::unique_lock<std::recursive_mutex> g(lock);
+	queue.clear();
+	bytes = 0;
+	epoch++;
+	room.notify_all();
+	int mark = Watermark();
+	g.unlock();
+	Notify(mark, 0, 0);
+}
+
+size_t
+SendQueue::GetBytes() const
+{
+	std::lock_guard<std::recursive_mutex> g(lock);
+	return bytes;
+}
+
+size_t
+SendQueue::GetCount() const
+{
+	std::lock_guard<std::recursive_mutex> g(lock);
+	return queue.size();
+}
+
+/**
+ * @return true between going over the high watermark and getting back to the low one
+ */
+bool
+SendQueue::IsHigh() const
+{
+	std::lock_guard<std::recursive_mutex> g(lock);
+	return high;
+}
+
+SendQueue::Stats
+SendQueue::GetStats() const
+{
+	std::lock_guard<std::recursive_mutex> g(lock);
+	return stats;
+}
+
+void
+SendQueue::ResetStats()
+{
+	std::lock_guard<std::recursive_mutex> g(lock);
+	stats = Stats();
+}
+
+/**
+ * @return the method number of a upc, eg 1 for <U><M>u1</M>..., or -1 if it doesn't look like one
+ */
+int
+SendQueue::Method(const std::string& msg)
+{
+	size_t at = msg.find("<M>");
+	if (at == std::string::npos || at > 16) {
+		return -1;
+	}
+	return UPC::ID::ToCode(msg.c_str() + at + 3);
+}
+
+/**
+ * @return true if a message of len bytes can be queued without going over either cap. called with the lock held
+ */
+bool
+SendQueue::Fits(const size_t len) const
+{
+	return queue.empty() || (bytes + len <= maxBytes && queue.size() < maxCount);
+}
+
+/**
+ * drop the oldest droppable messages until len bytes fits, or there are none left to drop. called with the lock held
+ * @return true if it fits now
+ */
+bool
+SendQueue::DropOldest(const size_t len)
+{
+	for (auto it=queue.begin(); it!=queue.end() && !Fits(len);) {
+		if (policy[it->priority] == kPolicyDropOldest) {
+			Gave(it->msg.size());
+			stats.dropped++;
+			it = queue.erase(it);
+		} else {
+			++it;
+		}
+	}
+	return Fits(len);
+}
+
+void
+SendQueue::Took(const size_t len)
+{
+	bytes += len;
+	if (bytes > stats.peakBytes) stats.peakBytes = bytes;
+	if (queue.size() > stats.peakCount) stats.peakCount = queue.size();
+}
+
+void
+SendQueue::Gave(const size_t len)
+{
+	bytes -= len;
+}
+
+/**
+ * @return 1 if we've just gone over the high watermark, -1 if we've just got back to the low one, otherwise 0. called with the lock held
+ */
+int
+SendQueue::Watermark()
+{
+	if (!high && (bytes >= highMark*maxBytes || queue.size() >= highMark*maxCount)) {
+		high = true;
+		stats.highs++;
+		return 1;
+	}
+	if (high && bytes <= lowMark*maxBytes && queue.size() <= lowMark*maxCount) {
+		high = false;
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * pass on a watermark crossing, without the lock, so the callback is free to send
+ */
+void
+SendQueue::Notify(const int mark, const size_t b, const size_t c)
+{
+	if (mark == 0) {
+		return;
+	}
+	WatermarkCB cb;
+	{
+		std::lock_guard<std::recursive_mutex> g(lock);
+		cb = onWatermark;
+	}
+	if (cb) cb(mark > 0, b, c);
+}
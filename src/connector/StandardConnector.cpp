@@ -4,6 +4,8 @@
  *  Created on: May 2, 2014
  *      Author: dak
  */
+#include <algorithm>
+
 #include "UCLowerHeaders.h"
 #include "connector/UVConnection.h"
 
@@ -16,13 +18,50 @@
  *     - CONNECT_FAILURE if there are no available connections
  *           - status of UPC::Status::NO_VALID_CONNECTION_AVAILABLE if all options are exhausted, else a protocol specific error number
  *     - SELECT_CONNECTION when the current valid connection changes from the previous
+ *
+ * by default, connections are tried one at a time, in priority order, each only after the last has failed or timed out. with SetRacing(),
+ * Connect() starts the first choice and, if the server hasn't answered on it by the stagger time, starts the next as well, and so on down the
+ * list. the bridge sees one CONNECTED, from whichever transport comes up first, and whatever it sends before the race is decided (the
+ * hello) goes out on every runner, including any that come up later. the first runner the server answers on wins, and the rest are
+ * disconnected without their listeners hearing about it. a runner that fails starts the next one straight away. the race needs an EventLoop
+ * for the stagger, which the UnionBridge passes on
+ *
+ * with a ConnectionScorer, the candidates are put in order of how they have actually done, rather than just the order of the connection
+ * priorities, and the scorer is kept up to date with how each attempt goes
+ *
+ * with SetUpgradeProbe(), a session that ends up on a fallback transport (anything without CONNECTION_PERSISTENT, so http) keeps trying a
+ * handshake on the persistent one in the background. once one gets through, the fallback is drained (AbstractConnection::Drain()), so
+ * nothing is half sent and the server has nothing more for us on it, then we end its session with a TERMINATE_SESSION and hang up on it,
+ * connect the probed transport, and report SELECT_CONNECTION with UPC::Status::CONNECTION_UPGRADE. a union session belongs to the transport
+ * it was made on, so the hello that follows starts a new session rather than moving the old one, and the bridge puts back what the old one
+ * was subscribed to
+ *
+ * with SetWarmStandby(), once a session is up on a persistent transport we keep a second copy of it (AbstractConnection::NewStandby())
+ * connected in the background, as far as the CONNECTED that the hello would follow, and hang it up and make it again every so often so no
+ * nat or proxy on the way forgets it. when the session's transport fails, the standby takes its place in the connection list, and we
+ * report CONNECT_FAILURE with UPC::Status::CONNECTION_FAILOVER, which has the monitor straight back, and the reconnect gets CONNECTED on
+ * the standby at once, so the gap is one hello and its answer rather than a resolve, connect and handshake as well. the dead connection
+ * becomes the next standby. GetFailoverGap() has the ms from losing a session to the server answering on the next, with and without one
  */
 
+const int StandardConnector::kDfltRaceStaggerMS;
+const int StandardConnector::kStrategySequential;
+const int StandardConnector::kStrategyRace;
+const int StandardConnector::kNumStrategies;
+const int StandardConnector::kDfltUpgradeProbeMS;
+const int StandardConnector::kMaxUpgradeBackoff;
+const int StandardConnector::kUpgradeRetryMS;
+const int StandardConnector::kMaxRetireTries;
+const int StandardConnector::kDfltStandbyRefreshMS;
+
 /**
  *
  */
 StandardConnector::StandardConnector(std::string dfltHost, std::string dfltPort)
-	: AbstractConnector(dfltHost, dfltPort) {
+	: AbstractConnector(dfltHost, dfltPort)
+	, clock([]() {
+		return (uint64_t) std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}) {
 	SetConnectionFailLimit(-1);
 	activeConnection = nullptr;
 }
@@ -32,9 +71,15 @@ StandardConnector::StandardConnector(std::string dfltHost, std::string dfltPort)
  */
 StandardConnector::~StandardConnector() {
 	DEBUG_OUT("StandardConnector::~StandardConnector()");
+	if (retireTimer != nullptr && loop != nullptr) {
+		loop->CancelTimer(retireTimer);
+	}
 	for (auto it: connections) {
 		delete it;
 	}
+	for (auto it: spares) {
+		delete it;
+	}
 	DEBUG_OUT("StandardConnector::~StandardConnector() done");
 }
 
@@ -60,6 +105,41 @@ StandardConnector::IsReady() const
 }
 
 
+/**
+ * @return connections that could be tried now, best first: those matching each set of connection priorities in turn, then anything else
+ */
+std::vector<CnxRef>
+StandardConnector::Candidates()
+{
+	std::vector<CnxRef> found;
+	auto viable = [this, &found](CnxRef c) {
+		return (connectionFailLimit <= 0 || c->GetConnectFailCount() < connectionFailLimit)
+				&& attempted.find(c) == attempted.end()
+				&& std::find(found.begin(), found.end(), c) == found.end();
+	};
+	for (auto it: connectionPriorities) {
+		for (auto jt : connections) {
+			if (viable(jt) && jt->HasProperties(it)) {
+				found.push_back(jt);
+			}
+		}
+	}
+	for (auto jt : connections) {
+		if (viable(jt)) {
+			found.push_back(jt);
+		}
+	}
+	if (scorer) {
+		scorer->Rank(found);
+	}
+	auto it = std::find(found.begin(), found.end(), preferred);
+	if (it != found.end()) { // the standby just swapped in
+		std::rotate(found.begin(), it, it+1);
+	}
+	preferred = nullptr;
+	return found;
+}
+
 /**
  * connects this connector making appropriate searches for a compatible connection, searching for connections with appropriate properties
  */
@@ -71,43 +151,800 @@ StandardConnector::Connect()
 		Disconnect();
 		return -1;
 	}
-	CnxRef foundConnection = nullptr;
-	for (auto it: connectionPriorities) {
-		for (auto jt : connections) {
-			if ((connectionFailLimit <= 0 || jt->GetConnectFailCount() < connectionFailLimit)
-					&& jt->HasProperties(it)
-					&& (attempted.find(jt) == attempted.end())) {
-				foundConnection = jt;
+	std::vector<CnxRef> candidates = Candidates();
+	if (candidates.empty()) {
+		NotifyListeners(Event::SELECT_CONNECTION, nullptr, "No viable connections available", UPC::Status::NO_VALID_CONNECTION_AVAILABLE);
+		NotifyListeners(Event::CONNECT_FAILURE, nullptr, "No viable connections available", UPC::Status::NO_VALID_CONNECTION_AVAILABLE);
+		NotifyListeners(Event::DISCONNECTED, nullptr, "No viable connections available", UPC::Status::SUCCESS);
+		Disconnect();
+		return -1;
+	}
+	if (attempted.empty()) { // a fresh start, rather than falling back after a failure
+		connectStart = clock();
+	}
+	awaitingReady = true;
+	if (promoted != nullptr && candidates[0] == promoted && promoted->GetConnectState() == ConnectionState::READY && loop != nullptr) {
+		return ConnectPromoted();
+	}
+	promoted = nullptr;
+	if (racing && loop != nullptr && candidates.size() > 1) {
+		connectStrategy = kStrategyRace;
+		return ConnectRace(candidates);
+	}
+	connectStrategy = kStrategySequential;
+	CnxRef foundConnection = candidates[0];
+	if (foundConnection != activeConnection) {
+		NotifyListeners(Event::SELECT_CONNECTION, foundConnection, foundConnection->LongName(), 0);
+	}
+	attempted.insert(foundConnection);
+	losers.erase(foundConnection);
+	activeConnection = foundConnection;
+	if (scorer) {
+		scorer->Begin(foundConnection->ShortName());
+	}
+	return activeConnection->Connect();
+}
+
+/**
+ * start the first of the candidates, and the stagger timer for the next
+ */
+int
+StandardConnector::ConnectRace(const std::vector<CnxRef>& candidates)
+{
+	AbortRace(nullptr);
+	racers = candidates;
+	raceFrom = activeConnection;
+	activeConnection = nullptr;
+	StartNextRacer();
+	return 0;
+}
+
+void
+StandardConnector::StartNextRacer()
+{
+	if (staggerTimer != nullptr) {
+		loop->CancelTimer(staggerTimer);
+		staggerTimer = nullptr;
+	}
+	if (nextRacer >= racers.size()) {
+		return;
+	}
+	CnxRef cr = racers[nextRacer++];
+	attempted.insert(cr);
+	losers.erase(cr);
+	if (nextRacer < racers.size()) {
+		staggerTimer = loop->Schedule(raceStaggerMS, 0, [this]() {
+			staggerTimer = nullptr; // one shot
+			StartNextRacer();
+		});
+	}
+	if (scorer) {
+		scorer->Begin(cr->ShortName());
+	}
+	int r = cr->Connect();
+	if (r < 0 && !racers.empty() && raceFailed.find(cr) == raceFailed.end()) { // refused outright, without telling us
+		if (RacerFailed(cr)) {
+			NotifyListeners(Event::CONNECT_FAILURE, cr, "Connection failed to start", r);
+			OnConnectFailure(cr, r);
+		}
+	}
+}
+
+/**
+ * a runner has failed. start the next straight away, rather than waiting out the stagger
+ * @return true if that was the last one, and the race is lost
+ */
+bool
+StandardConnector::RacerFailed(const CnxRef cr)
+{
+	raceFailed.insert(cr);
+	if (cr == activeConnection) {
+		activeConnection = nullptr;
+		for (size_t i=0; i<nextRacer; i++) {
+			if (raceFailed.find(racers[i]) == raceFailed.end() && racers[i]->GetConnectState() == ConnectionState::READY) {
+				activeConnection = racers[i];
 				break;
 			}
 		}
-		if (foundConnection != nullptr) {
-			break;
+	}
+	if (raceFailed.size() >= racers.size()) {
+		AbortRace(nullptr);
+		activeConnection = cr;
+		return true;
+	}
+	if (nextRacer < racers.size()) {
+		StartNextRacer();
+	}
+	return false;
+}
+
+/**
+ * the server has answered on cr. it carries on as the active connection, and the others are dropped
+ */
+void
+StandardConnector::CommitRacer(const CnxRef cr)
+{
+	CnxRef from = raceFrom;
+	AbortRace(cr);
+	activeConnection = cr;
+	if (cr != from) {
+		NotifyListeners(Event::SELECT_CONNECTION, cr, cr->LongName(), 0);
+	}
+	NoteReady();
+}
+
+/**
+ * finish any race in progress, disconnecting every runner that was started and is still going, apart from keep. anything they say after
+ * this is swallowed
+ */
+void
+StandardConnector::AbortRace(const CnxRef keep)
+{
+	if (staggerTimer != nullptr && loop != nullptr) {
+		loop->CancelTimer(staggerTimer);
+	}
+	staggerTimer = nullptr;
+	std::vector<CnxRef> dropped;
+	for (size_t i=0; i<nextRacer && i<racers.size(); i++) {
+		if (racers[i] != keep && raceFailed.find(racers[i]) == raceFailed.end()) {
+			dropped.push_back(racers[i]);
+			losers.insert(racers[i]);
 		}
 	}
-	if (foundConnection == nullptr) {
-		for (auto jt : connections) {
-			if ((connectionFailLimit <= 0 || jt->GetConnectFailCount() < connectionFailLimit)
-					&& (attempted.find(jt) == attempted.end())) {
-				foundConnection = jt;
-				break;
-			}
+	racers.clear();
+	nextRacer = 0;
+	raceFailed.clear();
+	firstFlight.clear();
+	raceConnected = false;
+	raceFrom = nullptr;
+	for (auto it: dropped) {
+		it->Disconnect();
+	}
+}
+
+/**
+ * the server has answered, so the connection counts as ready, for the time to ready stats
+ */
+void
+StandardConnector::NoteReady()
+{
+	if (!awaitingReady) {
+		return;
+	}
+	awaitingReady = false;
+	uint64_t now = clock();
+	timeToReady[connectStrategy].Add(now > connectStart? now - connectStart : 0);
+	if (failoverAt != 0) {
+		failoverGap[failoverWarm? 1 : 0].Add(now > failoverAt? now - failoverAt : 0);
+		failoverAt = 0;
+	}
+	sessionCnx = activeConnection;
+	sessionStart = now;
+	ScheduleUpgradeProbe();
+	ScheduleStandby(0);
+}
+
+/**
+ * the session on sessionCnx is over, one way or another. add its time up, stop looking for anything better, and drop the standby
+ */
+void
+StandardConnector::EndSession()
+{
+	if (sessionCnx != nullptr) {
+		uint64_t now = clock();
+		connectedTime[sessionCnx->ShortName()] += now > sessionStart? now - sessionStart : 0;
+		sessionCnx = nullptr;
+	}
+	CancelUpgrade();
+	StopStandby();
+}
+
+/**
+ * sees everything our connections report. outside a race, only notes the first data back after a connect. in a race, passes on the first
+ * CONNECTED and replays the first flight to later ones, passes on data from the first runner the server answers on (which wins it), and
+ * keeps failures to itself until there is nothing left to try
+ */
+bool
+StandardConnector::OnConnectionEvent(const EventType e, const CnxRef cr, const std::string& data, const int status)
+{
+	if (cr != nullptr && cr == probing) {
+		return ProbeEvent(e, cr);
+	}
+	if (cr != nullptr && std::find(spares.begin(), spares.end(), cr) != spares.end()) {
+		return StandbyEvent(e, cr);
+	}
+	Score(e, cr, data);
+	if (losers.find(cr) != losers.end()) {
+		if (e == Event::DISCONNECTED || e == Event::CONNECT_FAILURE) {
+			losers.erase(cr);
+		}
+		return false;
+	}
+	if (cr == sessionCnx && e == Event::CONNECT_FAILURE) {
+		if (standbyReady) {
+			return Failover(cr, data);
+		}
+		failoverAt = clock();
+		failoverWarm = false;
+	}
+	if (cr == sessionCnx && (e == Event::DISCONNECTED || e == Event::CONNECT_FAILURE)) {
+		EndSession();
+	}
+	if (racers.empty()) {
+		if (e == Event::RECEIVE_DATA) {
+			NoteReady();
+		}
+		return true;
+	}
+	switch (e) {
+	case Event::CONNECTED:
+		if (activeConnection == nullptr) {
+			activeConnection = cr;
+		}
+		if (!raceConnected) {
+			raceConnected = true;
+			return true;
+		}
+		for (auto& msg: firstFlight) {
+			cr->Send(msg);
+		}
+		return false;
+	case Event::RECEIVE_DATA:
+		CommitRacer(cr);
+		return true;
+	case Event::CONNECT_FAILURE:
+	case Event::DISCONNECTED:
+		return RacerFailed(cr);
+	default:
+		return false;
+	}
+}
+
+/**
+ * tell the scorer how things are going
+ */
+void
+StandardConnector::Score(const EventType e, const CnxRef cr, const std::string& data)
+{
+	if (!scorer) {
+		return;
+	}
+	if (losers.find(cr) != losers.end()) {
+		scorer->Abandon(cr->ShortName());
+		return;
+	}
+	switch (e) {
+	case Event::RECEIVE_DATA:
+		scorer->Received(cr->ShortName(), data.size());
+		break;
+	case Event::CONNECT_FAILURE:
+	case Event::DISCONNECTED:
+		scorer->Failed(cr->ShortName());
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * @param s keeps score of the connections, and puts the best first. ConnectionScorer::Shared() keeps what is learned for the life of the
+ * process. nullptr, the default, goes by the connection priorities alone
+ */
+void
+StandardConnector::SetScorer(std::shared_ptr<ConnectionScorer> s)
+{
+	scorer = s;
+}
+
+std::shared_ptr<ConnectionScorer>
+StandardConnector::GetScorer() const
+{
+	return scorer;
+}
+
+/**
+ * @return the fallback's better alternative, if we are on a fallback and there is one
+ */
+CnxRef
+StandardConnector::UpgradeCandidate()
+{
+	if (sessionCnx == nullptr || sessionCnx->HasProperties({ CONNECTION_PERSISTENT })) {
+		return nullptr;
+	}
+	for (auto it: connections) {
+		if (it != sessionCnx && it->HasProperties({ CONNECTION_PERSISTENT })
+				&& (connectionFailLimit <= 0 || it->GetConnectFailCount() < connectionFailLimit)) {
+			return it;
+		}
+	}
+	return nullptr;
+}
+
+/**
+ * set the probe going after the interval, stretched out by however many probes have failed in a row
+ */
+void
+StandardConnector::ScheduleUpgradeProbe()
+{
+	if (upgradeProbeMS <= 0 || loop == nullptr || probing != nullptr || upgradeTo != nullptr || UpgradeCandidate() == nullptr) {
+		return;
+	}
+	if (upgradeTimer != nullptr) {
+		loop->CancelTimer(upgradeTimer);
+	}
+	upgradeTimer = loop->Schedule(upgradeProbeMS*upgradeBackoff, 0, [this]() {
+		upgradeTimer = nullptr; // one shot
+		StartUpgradeProbe();
+	});
+}
+
+void
+StandardConnector::StartUpgradeProbe()
+{
+	CnxRef cr = UpgradeCandidate();
+	if (cr == nullptr) {
+		return;
+	}
+	probing = cr;
+	probeClosing = false;
+	losers.erase(cr);
+	upgradeStats.probes++;
+	if (cr->Connect() < 0 && probing == cr) {
+		ProbeEvent(Event::CONNECT_FAILURE, cr);
+	}
+}
+
+/**
+ * everything the probe says stops here. it only has to get as far as CONNECTED, then it's hung up again, and once that's done we look for
+ * a moment to upgrade. the hello is left for the real connection, so the server never sees a session on it
+ */
+bool
+StandardConnector::ProbeEvent(const EventType e, const CnxRef cr)
+{
+	if (probeClosing) {
+		if (e == Event::DISCONNECTED || e == Event::CONNECT_FAILURE) {
+			probing = nullptr;
+			probeClosing = false;
+			upgradeTo = cr;
+			TryUpgrade();
+		}
+		return false;
+	}
+	switch (e) {
+	case Event::CONNECTED:
+		probeClosing = true;
+		cr->Disconnect();
+		break;
+	case Event::CONNECT_FAILURE:
+	case Event::DISCONNECTED:
+		probing = nullptr;
+		upgradeStats.probeFailures++;
+		upgradeBackoff = std::min(upgradeBackoff*2, kMaxUpgradeBackoff);
+		ScheduleUpgradeProbe();
+		break;
+	default:
+		break;
+	}
+	return false;
+}
+
+/**
+ * once the fallback is drained, end its session and go over to upgradeTo. till then, look again shortly
+ */
+void
+StandardConnector::TryUpgrade()
+{
+	if (upgradeTo == nullptr || sessionCnx == nullptr || loop == nullptr) {
+		return;
+	}
+	if (!sessionCnx->Drain()) {
+		upgradeTimer = loop->Schedule(kUpgradeRetryMS, 0, [this]() {
+			upgradeTimer = nullptr; // one shot
+			TryUpgrade();
+		});
+		return;
+	}
+	CnxRef from = sessionCnx;
+	CnxRef to = upgradeTo;
+	EndSession();
+	upgradeStats.upgrades++;
+	if (scorer) {
+		scorer->Ended(from->ShortName());
+	}
+	losers.insert(from);
+	Retire(from);
+	attempted.clear();
+	failedSinceConnect.clear();
+	attempted.insert(to);
+	losers.erase(to);
+	activeConnection = to;
+	connectStart = clock();
+	connectStrategy = kStrategySequential;
+	awaitingReady = true;
+	NotifyListeners(Event::SELECT_CONNECTION, to, "Upgrading from " + from->LongName() + " to " + to->LongName(), UPC::Status::CONNECTION_UPGRADE);
+	if (scorer) {
+		scorer->Begin(to->ShortName());
+	}
+	to->Connect();
+}
+
+/**
+ * tell the server we're done with the session on cr, so it doesn't keep a ghost of us in our rooms till it times out, and hang up once the
+ * request has gone, or we've waited long enough. cr is a loser by now, so its SESSION_TERMINATED, and anything else it gets, goes nowhere
+ */
+void
+StandardConnector::Retire(const CnxRef cr, const int tries)
+{
+	if (tries == 0) {
+		StopRetiring();
+		retiring = cr;
+		cr->Send("<U><M>" + std::string(UPC::ID::TERMINATE_SESSION) + "</M></U>");
+	}
+	if (loop == nullptr || cr->IsIdle() || tries >= kMaxRetireTries) {
+		retiring = nullptr;
+		cr->Disconnect();
+		return;
+	}
+	retireTimer = loop->Schedule(kUpgradeRetryMS, 0, [this, cr, tries]() {
+		retireTimer = nullptr; // one shot
+		Retire(cr, tries+1);
+	});
+}
+
+/**
+ * hang up on a connection we're still seeing off, now
+ */
+void
+StandardConnector::StopRetiring()
+{
+	if (retireTimer != nullptr && loop != nullptr) {
+		loop->CancelTimer(retireTimer);
+	}
+	retireTimer = nullptr;
+	if (retiring != nullptr) {
+		CnxRef cr = retiring;
+		retiring = nullptr;
+		cr->Disconnect();
+	}
+}
+
+/**
+ * drop any probe, pending upgrade or timer for either, and let the session's transport go back to normal if we had it draining
+ */
+void
+StandardConnector::CancelUpgrade()
+{
+	if (upgradeTimer != nullptr && loop != nullptr) {
+		loop->CancelTimer(upgradeTimer);
+	}
+	upgradeTimer = nullptr;
+	if (upgradeTo != nullptr && sessionCnx != nullptr) {
+		sessionCnx->Drain(false);
+	}
+	upgradeTo = nullptr;
+	upgradeBackoff = 1;
+	if (probing != nullptr) {
+		CnxRef cr = probing;
+		probing = nullptr;
+		losers.insert(cr);
+		cr->Disconnect();
+	}
+}
+
+/**
+ * a connection to stand by for cr: one we made earlier that is doing nothing, or a new one if cr can make one
+ */
+CnxRef
+StandardConnector::Spare(const CnxRef cr)
+{
+	for (auto it: spares) {
+		int state = it->GetConnectState();
+		if (it->ShortName() == cr->ShortName() && (state == ConnectionState::NOT_CONNECTED || state == ConnectionState::UNKNOWN)) {
+			return it;
 		}
 	}
-	if (foundConnection != nullptr) {
-		if (foundConnection != activeConnection) {
-			NotifyListeners(Event::SELECT_CONNECTION, foundConnection, foundConnection->LongName(), 0);
+	CnxRef s = cr->NewStandby();
+	if (s != nullptr) {
+		Adopt(s);
+		spares.push_back(s);
+	}
+	return s;
+}
+
+/**
+ * connect a standby for the session, if it is on a transport that can have one
+ */
+void
+StandardConnector::StartStandby()
+{
+	if (standbyRefreshMS <= 0 || loop == nullptr || sessionCnx == nullptr || !sessionCnx->HasProperties({ CONNECTION_PERSISTENT })) {
+		return;
+	}
+	if (standby == nullptr) {
+		standby = Spare(sessionCnx);
+		if (standby == nullptr) {
+			return;
 		}
+	}
+	CnxRef cr = standby;
+	standbyReady = false;
+	standbyClosing = false;
+	standbyStats.starts++;
+	if (cr->Connect() < 0 && standby == cr && standbyTimer == nullptr) {
+		StandbyEvent(Event::CONNECT_FAILURE, cr);
+	}
+}
+
+/**
+ * after delayMS, hang up the standby if it is ready, as it has been for long enough, otherwise (re)start it
+ */
+void
+StandardConnector::ScheduleStandby(const int delayMS)
+{
+	if (standbyRefreshMS <= 0 || loop == nullptr) {
+		return;
+	}
+	if (standbyTimer != nullptr) {
+		loop->CancelTimer(standbyTimer);
+	}
+	standbyTimer = loop->Schedule(delayMS, 0, [this]() {
+		standbyTimer = nullptr; // one shot
+		if (standby != nullptr && standbyReady) {
+			standbyStats.refreshes++;
+			standbyReady = false;
+			standbyClosing = true;
+			standby->Disconnect();
+		} else {
+			StartStandby();
+		}
+	});
+}
+
+/**
+ * nothing a standby says gets past here. it is ready at CONNECTED, and the hello waits for it to be promoted. a refresh starts again as
+ * soon as the hang up is done, a failure only after the refresh interval. spares we have finished with are just ignored
+ */
+bool
+StandardConnector::StandbyEvent(const EventType e, const CnxRef cr)
+{
+	if (cr != standby) {
+		return false;
+	}
+	switch (e) {
+	case Event::CONNECTED:
+		standbyReady = true;
+		ScheduleStandby(standbyRefreshMS);
+		break;
+	case Event::IO_ERROR:
+		if (!standbyClosing) {
+			standbyStats.failures++;
+			standbyReady = false;
+			standbyClosing = true;
+			cr->Disconnect();
+		}
+		break;
+	case Event::CONNECT_FAILURE:
+	case Event::DISCONNECTED:
+		standbyReady = false;
+		if (standbyClosing) {
+			standbyClosing = false;
+			ScheduleStandby(0);
+		} else {
+			standbyStats.failures++;
+			ScheduleStandby(standbyRefreshMS);
+		}
+		break;
+	default:
+		break;
+	}
+	return false;
+}
+
+/**
+ * hang up the standby, if there is one, and stop making them
+ */
+void
+StandardConnector::StopStandby()
+{
+	if (standbyTimer != nullptr && loop != nullptr) {
+		loop->CancelTimer(standbyTimer);
+	}
+	standbyTimer = nullptr;
+	standbyReady = false;
+	standbyClosing = false;
+	if (standby != nullptr) {
+		CnxRef cr = standby;
+		standby = nullptr;
+		cr->Disconnect();
+	}
+}
+
+/**
+ * the session's transport has failed with a standby ready. swap the standby in for it, and tell the monitor to come straight back, which
+ * it does through ConnectPromoted()
+ * @return false, as the failure we report replaces the one from the connection
+ */
+bool
+StandardConnector::Failover(const CnxRef from, const std::string& msg)
+{
+	CnxRef to = standby;
+	standby = nullptr;
+	EndSession();
+	auto it = std::find(connections.begin(), connections.end(), from);
+	auto jt = std::find(spares.begin(), spares.end(), to);
+	if (it != connections.end() && jt != spares.end()) {
+		*it = to;
+		*jt = from;
+		OnStandbyPromoted(from, to);
+		standbyStats.promotions++;
+		preferred = to;
+		promoted = to;
+		failoverWarm = true;
+	} else { // from has been taken off the list, so there's nowhere to put the standby, and it's a cold reconnect
+		to->Disconnect();
+		failoverWarm = false;
+	}
+	failoverAt = clock();
+	activeConnection = nullptr;
+	attempted.clear();
+	failedSinceConnect.clear();
+	NotifyListeners(Event::CONNECT_FAILURE, from, msg, UPC::Status::CONNECTION_FAILOVER);
+	return false;
+}
+
+/**
+ * Connect() onto a promoted standby. it's already up, so all there is to do is tell the bridge, which we leave till the next tick as a
+ * transport would
+ */
+int
+StandardConnector::ConnectPromoted()
+{
+	CnxRef cr = promoted;
+	promoted = nullptr;
+	connectStrategy = kStrategySequential;
+	NotifyListeners(Event::SELECT_CONNECTION, cr, cr->LongName(), 0);
+	attempted.insert(cr);
+	losers.erase(cr);
+	activeConnection = cr;
+	if (scorer) {
+		scorer->Begin(cr->ShortName());
+	}
+	if (promoteTimer != nullptr) {
+		loop->CancelTimer(promoteTimer);
+	}
+	promoteTimer = loop->Schedule(0, 0, [this, cr]() {
+		promoteTimer = nullptr; // one shot
+		if (activeConnection == cr && cr->GetConnectState() == ConnectionState::READY) { // if it dropped in between, we've heard about it
+			NotifyListeners(Event::CONNECTED, cr, "", 0);
+			OnConnectSucceed(cr);
+		}
+	});
+	return 0;
+}
+
+/**
+ * @param enable keep a standby connected for sessions on a persistent transport, so a failure can be recovered from without a full
+ * reconnect. it costs the server a second socket per client, so off by default
+ * @param refreshMS how long a ready standby is kept before it's hung up and made again
+ */
+void
+StandardConnector::SetWarmStandby(const bool enable, const int refreshMS)
+{
+	if (!enable) {
+		StopStandby();
+		standbyRefreshMS = 0;
+		return;
+	}
+	standbyRefreshMS = refreshMS > 0? refreshMS : kDfltStandbyRefreshMS;
+	if (sessionCnx != nullptr && standby == nullptr) {
+		ScheduleStandby(0);
+	}
+}
+
+/**
+ * @param warm whether a standby was ready when the session was lost
+ * @return histogram of ms from a session being lost to the server answering on the next
+ */
+const Histogram&
+StandardConnector::GetFailoverGap(const bool warm) const
+{
+	return failoverGap[warm? 1 : 0];
+}
+
+/**
+ * @param intervalMS how long a session sits on a fallback transport before we try the persistent one again. the interval doubles with each
+ * probe that fails, up to kMaxUpgradeBackoff times. 0 to stay put, which is the default
+ */
+void
+StandardConnector::SetUpgradeProbe(const int intervalMS)
+{
+	upgradeProbeMS = intervalMS > 0? intervalMS : 0;
+	if (upgradeProbeMS == 0) {
+		CancelUpgrade();
 	} else {
-		NotifyListeners(Event::SELECT_CONNECTION, nullptr, "No viable connections available", UPC::Status::NO_VALID_CONNECTION_AVAILABLE);
-		NotifyListeners(Event::CONNECT_FAILURE, nullptr, "No viable connections available", UPC::Status::NO_VALID_CONNECTION_AVAILABLE);
-		NotifyListeners(Event::DISCONNECTED, nullptr, "No viable connections available", UPC::Status::SUCCESS);
-		Disconnect();
-		return -1;
+		ScheduleUpgradeProbe();
+	}
+}
+
+/**
+ * @return ms spent connected on the transport with the given short name, from the server first answering to the session ending, including
+ * any session in progress
+ */
+uint64_t
+StandardConnector::GetConnectedTime(const std::string shortName) const
+{
+	auto it = connectedTime.find(shortName);
+	uint64_t t = it != connectedTime.end()? it->second : 0;
+	if (sessionCnx != nullptr && sessionCnx->ShortName() == shortName) {
+		uint64_t now = clock();
+		t += now > sessionStart? now - sessionStart : 0;
+	}
+	return t;
+}
+
+/**
+ * replace the millisecond clock, which is std::chrono::steady_clock by default. for tests
+ */
+void
+StandardConnector::SetClock(Clock c)
+{
+	clock = c;
+}
+
+/**
+ * @param l the loop for the race stagger, upgrade probe and standby timers
+ */
+void
+StandardConnector::SetEventLoop(EventLoop* l)
+{
+	if (l == nullptr) {
+		AbortRace(activeConnection);
+		CancelUpgrade();
+		StopStandby();
+		if (promoteTimer != nullptr && loop != nullptr) {
+			loop->CancelTimer(promoteTimer);
+		}
+		promoteTimer = nullptr;
+		promoted = nullptr;
+	}
+	loop = l;
+}
+
+/**
+ * @param enable race the connections, rather than trying them one at a time
+ * @param staggerMS how long to give each one before starting the next as well
+ */
+void
+StandardConnector::SetRacing(const bool enable, const int staggerMS)
+{
+	racing = enable;
+	raceStaggerMS = staggerMS >= 0? staggerMS : kDfltRaceStaggerMS;
+}
+
+/**
+ * @param strategy kStrategySequential or kStrategyRace
+ * @return histogram of ms from Connect() to the server first answering, across any fallbacks in between
+ */
+const Histogram&
+StandardConnector::GetTimeToReady(const int strategy) const
+{
+	return timeToReady[strategy == kStrategyRace? kStrategyRace : kStrategySequential];
+}
+
+void
+StandardConnector::ResetStats()
+{
+	for (int i=0; i<kNumStrategies; i++) {
+		timeToReady[i].Reset();
+	}
+	upgradeStats = UpgradeStats();
+	standbyStats = StandbyStats();
+	failoverGap[0].Reset();
+	failoverGap[1].Reset();
+	connectedTime.clear();
+	if (sessionCnx != nullptr) {
+		sessionStart = clock();
 	}
-	attempted.insert(foundConnection);
-	activeConnection = foundConnection;
-	return activeConnection->Connect();
 }
 
 /**
@@ -144,10 +981,25 @@ int
 StandardConnector::Disconnect()
 {
 	DEBUG_OUT("StandardConnector::Disconnect()");
+	bool undecided = !racers.empty() && activeConnection == nullptr;
+	AbortRace(activeConnection);
+	EndSession();
+	StopRetiring();
+	failoverAt = 0;
+	promoted = nullptr;
+	if (promoteTimer != nullptr && loop != nullptr) {
+		loop->CancelTimer(promoteTimer);
+	}
+	promoteTimer = nullptr;
+	if (scorer && activeConnection != nullptr) { // our idea, so it doesn't count against it
+		scorer->Abandon(activeConnection->ShortName());
+	}
 	int r = 0;
 	if (activeConnection != nullptr) {
 		r = activeConnection->Disconnect();
 		activeConnection = nullptr;
+	} else if (undecided) { // nothing the bridge knows about to say goodbye for it
+		NotifyListeners(Event::DISCONNECTED, nullptr, "", UPC::Status::SUCCESS);
 	}
 	DEBUG_OUT("StandardConnector::Disconnect() done");
 	return r;
@@ -163,9 +1015,38 @@ StandardConnector::Send(const std::string msg)
 		NotifyListeners(Event::IO_ERROR, nullptr, "Send while no current connection", -1);
 		return -1;
 	}
+	if (!racers.empty()) { // undecided, so everyone who's up gets it, and anyone who comes up later
+		firstFlight.push_back(msg);
+		int r = -1;
+		for (size_t i=0; i<nextRacer; i++) {
+			if (raceFailed.find(racers[i]) == raceFailed.end() && racers[i]->GetConnectState() == ConnectionState::READY
+					&& racers[i]->Send(msg) >= 0) {
+				r = 0;
+			}
+		}
+		return r;
+	}
 	return activeConnection->Send(msg);
 }
 
+/**
+ * transport level ping on the active connection
+ */
+int
+StandardConnector::SendPing()
+{
+	return activeConnection != nullptr? activeConnection->SendPing() : -1;
+}
+
+/**
+ * @return round trip times from the active connection, or nullptr if it doesn't do its own pings
+ */
+const RTTStats*
+StandardConnector::GetRTTStats() const
+{
+	return activeConnection != nullptr? activeConnection->GetRTTStats() : nullptr;
+}
+
 
 /**
  * sets the session id for the http connection which, if it is active, will trigger the polling reader and allow the http upc connection sends which need the session id
@@ -211,6 +1092,42 @@ StandardUVConnector::~StandardUVConnector() {
 	DEBUG_OUT("StandardUVConnector::~StandardUVConnector()");
 }
 
+/**
+ * adds a web socket to a gateway on this host, over the unix domain socket at path, and puts it ahead of the tcp connections. if the gateway
+ * isn't there, the connect fails straight away and we go on to the others
+ * @return the connection, which we own, as for the others
+ */
+UVWSConnection*
+StandardUVConnector::AddLocalConnection(const std::string path)
+{
+	if (localConnection == nullptr) {
+		localConnection = new UVWSConnection("", UVPipeCnxLayer::kUnixScheme + path);
+		ConnectionPropertySet s = localConnection->GetProperties();
+		s.insert(CONNECTION_LOCAL);
+		localConnection->SetProperties(s);
+		AddConnection(localConnection, 0);
+		std::vector<ConnectionPropertySet> pri = connectionPriorities;
+		pri.insert(pri.begin(), ConnectionPropertySet({ CONNECTION_LOCAL }));
+		SetConnectionPriorities(pri);
+	} else {
+		static_cast<AbstractConnection*>(localConnection)->SetHost(UVPipeCnxLayer::kUnixScheme + path);
+	}
+	return localConnection;
+}
+
+/**
+ * a standby has replaced one of ours in the connection list, so keep pointing at whatever is in the list
+ */
+void
+StandardUVConnector::OnStandbyPromoted(const CnxRef from, const CnxRef to)
+{
+	if (from == wsConnection) {
+		wsConnection = static_cast<UVWSConnection*>(to);
+	} else if (from == localConnection) {
+		localConnection = static_cast<UVWSConnection*>(to);
+	}
+}
+
 /**
  * I'm assuming for the moment that this will only be an issue on the http connection, for which there's a clear and simple approach. The web socket would
  * seem to require a full reclose and restart, which may bring in different affinities. For the http connection, it seems that it's simply a question
@@ -0,0 +1,470 @@
+/*
+ * TLSCnxLayer.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#include <cstring>
+
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/x509v3.h>
+
+#include "UCLowerHeaders.h"
+#include "connector/TLSCnxLayer.h"
+
+const int TLSCnxLayer::kErrHandshake;
+const int TLSCnxLayer::kErrTLS;
+const size_t TLSCnxLayer::kReadChunk;
+
+/**
+ * @class TLSContext TLSCnxLayer.h
+ *
+ * a client SSL_CTX, checking the server's certificate against the system's trust store, and anything given to AddTrustedCertificate().
+ * sessions the server hands us (tls 1.2 at the end of the handshake, 1.3 tickets after it) are kept by host:service, and offered on the
+ * next connection there, so a reconnect, or the next http request on its own socket, gets an abbreviated handshake
+ *
+ * the handshake counts and times are kept here rather than per layer, so the resumption rate is over everything sharing the context
+ */
+TLSContext::TLSContext()
+	: verifyPeer(true)
+	, resumption(true)
+	, clock([]() {
+		return (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	})
+{
+	ctx = SSL_CTX_new(TLS_client_method());
+	SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+	SSL_CTX_set_default_verify_paths(ctx);
+	SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+	SSL_CTX_sess_set_new_cb(ctx, OnNewSession);
+}
+
+TLSContext::~TLSContext()
+{
+	FlushSessions();
+	SSL_CTX_free(ctx);
+}
+
+/**
+ * @return a context that lasts as long as the process, so sessions outlive the connections that made them
+ */
+std::shared_ptr<TLSContext>
+TLSContext::Shared()
+{
+	static std::shared_ptr<TLSContext> shared = std::make_shared<TLSContext>();
+	return shared;
+}
+
+/**
+ * trust a certificate, or a ca, besides the system's, eg a self signed one on a test server
+ * @return false if the pem wouldn't parse
+ */
+bool
+TLSContext::AddTrustedCertificate(const std::string pem)
+{
+	BIO* b = BIO_new_mem_buf(pem.data(), (int)pem.size());
+	X509* x = PEM_read_bio_X509(b, nullptr, nullptr, nullptr);
+	BIO_free(b);
+	if (x == nullptr) return false;
+	int r = X509_STORE_add_cert(SSL_CTX_get_cert_store(ctx), x);
+	X509_free(x);
+	return r == 1;
+}
+
+void
+TLSContext::SetSessionResumption(const bool enable)
+{
+	resumption = enable;
+	if (!enable) FlushSessions();
+}
+
+void
+TLSContext::FlushSessions()
+{
+	std::lock_guard<std::mutex> g(lock);
+	for (auto it: sessions) {
+		SSL_SESSION_free(it.second);
+	}
+	sessions.clear();
+}
+
+size_t
+TLSContext::GetSessionCount()
+{
+	std::lock_guard<std::mutex> g(lock);
+	return sessions.size();
+}
+
+void
+TLSContext::ResetStats()
+{
+	stats = Stats();
+}
+
+/**
+ * @return a session for key with a reference for the caller, who should SSL_SESSION_free() it, or nullptr
+ */
+SSL_SESSION*
+TLSContext::FindSession(const std::string key)
+{
+	std::lock_guard<std::mutex> g(lock);
+	if (!resumption) return nullptr;
+	auto it = sessions.find(key);
+	if (it == sessions.end()) return nullptr;
+	if (!SSL_SESSION_is_resumable(it->second)) {
+		SSL_SESSION_free(it->second);
+		sessions.erase(it);
+		return nullptr;
+	}
+	SSL_SESSION_up_ref(it->second);
+	return it->second;
+}
+
+/**
+ * keep s, taking over the caller's reference, in place of whatever we had for key
+ */
+void
+TLSContext::StoreSession(const std::string key, SSL_SESSION* s)
+{
+	std::lock_guard<std::mutex> g(lock);
+	if (!resumption) {
+		SSL_SESSION_free(s);
+		return;
+	}
+	auto it = sessions.find(key);
+	if (it != sessions.end()) {
+		SSL_SESSION_free(it->second);
+		it->second = s;
+	} else {
+		sessions[key] = s;
+	}
+}
+
+void
+TLSContext::NoteHandshake(const bool resumed, const uint64_t micros)
+{
+	stats.handshakes++;
+	if (resumed) {
+		stats.resumed++;
+		stats.resumedMicros.Add(micros);
+	} else {
+		stats.fullMicros.Add(micros);
+	}
+}
+
+/**
+ * OpenSSL's new session callback. returning 1 says we have kept the reference it gave us
+ */
+int
+TLSContext::OnNewSession(SSL* ssl, SSL_SESSION* s)
+{
+	TLSCnxLayer* layer = static_cast<TLSCnxLayer*>(SSL_get_app_data(ssl));
+	if (layer == nullptr || !layer->GetContext()) return 0;
+	layer->GetContext()->StoreSession(layer->SessionKey(), s);
+	return 1;
+}
+
+/**
+ * @class TLSCnxLayer TLSCnxLayer.h
+ *
+ * sits on the socket layer, and under a ws or http layer. once the socket is open, the handshake is run through a pair of memory bios:
+ * what the socket brings in goes in the read bio, and whatever OpenSSL has to send is taken off the write bio and written on the socket. the
+ * layer above only gets its OnOpen() once the handshake is done, and then gets the plaintext
+ *
+ * a failed handshake is an open failure, and the close of the socket that follows it goes no further up
+ */
+TLSCnxLayer::TLSCnxLayer(CnxLayerUpper* upper, CnxLayer* lower, std::shared_ptr<TLSContext> c)
+	: CnxLayer(upper, lower)
+	, CnxLayerUpper()
+	, context(c)
+	, ssl(nullptr)
+	, rbio(nullptr)
+	, wbio(nullptr)
+	, handshaking(false)
+	, resumed(false)
+	, failed(false)
+	, handshakeStart(0)
+{
+	connectState = ConnectionState::NOT_CONNECTED;
+}
+
+TLSCnxLayer::~TLSCnxLayer()
+{
+	Reset();
+}
+
+void
+TLSCnxLayer::SetHost(const std::string h) const
+{
+	host = h;
+}
+
+void
+TLSCnxLayer::SetService(const std::string s) const
+{
+	service = s;
+}
+
+void
+TLSCnxLayer::SetContext(std::shared_ptr<TLSContext> c)
+{
+	context = c;
+}
+
+int
+TLSCnxLayer::Open()
+{
+	DEBUG_OUT("TLSCnxLayer::Open() " << host << ":" << service);
+	Reset();
+	pending.clear();
+	failed = false;
+	connectState = ConnectionState::CONNECTION_IN_PROGRESS;
+	return lower? lower->Open() : kErrNoTransport;
+}
+
+/**
+ * plaintext from above. anything written before the handshake is done waits for it
+ */
+int
+TLSCnxLayer::Write(const char *data, const size_t len)
+{
+	if (ssl == nullptr || handshaking) {
+		pending.append(data, len);
+		return (int)len;
+	}
+	int r = SSL_write(ssl, data, (int)len);
+	Flush();
+	if (r <= 0) {
+		DoIOError(kErrTLS, "TLS write failed %s", LastError().c_str());
+		return kErrTLS;
+	}
+	return r;
+}
+
+/**
+ * the pieces go together into one record, gathered in a buffer that we keep for next time
+ */
+int
+TLSCnxLayer::WriteV(const CnxChunk *chunks, const size_t n)
+{
+	gathered.clear();
+	for (size_t i=0; i<n; i++) {
+		gathered.append(chunks[i].data, chunks[i].len);
+	}
+	return Write(gathered.data(), gathered.size());
+}
+
+/**
+ * sends a close_notify if we got that far, then closes the socket
+ */
+int
+TLSCnxLayer::Close()
+{
+	DEBUG_OUT("TLSCnxLayer::Close()");
+	if (ssl && !handshaking && connectState == ConnectionState::READY) {
+		SSL_shutdown(ssl);
+		Flush();
+	}
+	connectState = ConnectionState::DISCONNECTION_IN_PROGRESS;
+	return lower? lower->Close() : 0;
+}
+
+/**
+ * the socket is up, so start the handshake
+ */
+void
+TLSCnxLayer::OnOpen()
+{
+	if (!Start()) {
+		failed = true;
+		if (context) context->NoteFailure();
+		DoOpenFailure(kErrTLS, "TLS setup failed %s", LastError().c_str());
+		if (lower) lower->Close();
+		return;
+	}
+	Handshake();
+}
+
+/**
+ * ciphertext from the socket
+ */
+int
+TLSCnxLayer::Receive(const char *data, const size_t len)
+{
+	if (ssl == nullptr) return 0;
+	BIO_write(rbio, data, (int)len);
+	if (handshaking) {
+		Handshake();
+	} else {
+		ReadPlain();
+	}
+	return 0;
+}
+
+void
+TLSCnxLayer::OnClose()
+{
+	bool wasFailed = failed;
+	Reset();
+	pending.clear();
+	connectState = ConnectionState::NOT_CONNECTED;
+	if (!wasFailed && upper) upper->OnClose();
+}
+
+void
+TLSCnxLayer::OnOpenFailure(const std::string msg, const int status)
+{
+	Reset();
+	connectState = ConnectionState::NOT_CONNECTED;
+	if (upper) upper->OnOpenFailure(msg, status);
+}
+
+void
+TLSCnxLayer::OnIOError(const std::string msg, const int status)
+{
+	if (upper) upper->OnIOError(msg, status);
+}
+
+void
+TLSCnxLayer::OnServerDisconnect(const std::string msg, const int status)
+{
+	Reset();
+	connectState = ConnectionState::NOT_CONNECTED;
+	if (upper) upper->OnServerDisconnect(msg, status);
+}
+
+/**
+ * a fresh SSL for this connection, with sni and hostname checking for host, and the last session we had there if there is one
+ */
+bool
+TLSCnxLayer::Start()
+{
+	Reset();
+	if (!context) return false;
+	ssl = SSL_new(context->Get());
+	if (ssl == nullptr) return false;
+	SSL_set_app_data(ssl, this);
+	rbio = BIO_new(BIO_s_mem());
+	wbio = BIO_new(BIO_s_mem());
+	SSL_set_bio(ssl, rbio, wbio);
+	SSL_set_connect_state(ssl);
+	if (host.size() > 0) {
+		SSL_set_tlsext_host_name(ssl, host.c_str());
+		SSL_set1_host(ssl, host.c_str());
+	}
+	SSL_set_verify(ssl, context->GetVerifyPeer()? SSL_VERIFY_PEER : SSL_VERIFY_NONE, nullptr);
+	SSL_SESSION* s = context->FindSession(SessionKey());
+	if (s) {
+		SSL_set_session(ssl, s);
+		SSL_SESSION_free(s);
+	}
+	handshaking = true;
+	resumed = false;
+	handshakeStart = context->NowMicros();
+	return true;
+}
+
+/**
+ * push the handshake on as far as what has come in lets us
+ */
+void
+TLSCnxLayer::Handshake()
+{
+	int r = SSL_do_handshake(ssl);
+	Flush();
+	if (r == 1) {
+		handshaking = false;
+		resumed = SSL_session_reused(ssl) == 1;
+		context->NoteHandshake(resumed, context->NowMicros() - handshakeStart);
+		DEBUG_OUT("TLSCnxLayer::Handshake() done " << SSL_get_version(ssl) << (resumed? " resumed" : " full"));
+		connectState = ConnectionState::READY;
+		if (upper) upper->OnOpen();
+		if (ssl && pending.size() > 0) {
+			std::string p;
+			p.swap(pending);
+			Write(p.data(), p.size());
+		}
+		if (ssl) ReadPlain(); // the server may have sent more behind its finished
+		return;
+	}
+	int e = SSL_get_error(ssl, r);
+	if (e == SSL_ERROR_WANT_READ || e == SSL_ERROR_WANT_WRITE) {
+		return;
+	}
+	std::string err = LastError();
+	long v = SSL_get_verify_result(ssl);
+	if (v != X509_V_OK) {
+		err = X509_verify_cert_error_string(v);
+	}
+	failed = true;
+	context->NoteFailure();
+	DoOpenFailure(kErrHandshake, "TLS handshake failed %s", err.c_str());
+	if (lower) lower->Close();
+}
+
+/**
+ * pass up whatever plaintext there is
+ */
+void
+TLSCnxLayer::ReadPlain()
+{
+	char buf[kReadChunk];
+	for (;;) {
+		int n = SSL_read(ssl, buf, sizeof(buf));
+		if (n > 0) {
+			if (upper) upper->Receive(buf, n);
+			if (ssl == nullptr) return; // closed from above
+			continue;
+		}
+		int e = SSL_get_error(ssl, n);
+		if (e == SSL_ERROR_WANT_READ || e == SSL_ERROR_WANT_WRITE) break;
+		if (e == SSL_ERROR_ZERO_RETURN) { // close_notify, and the socket will follow
+			DEBUG_OUT("TLSCnxLayer::ReadPlain() close notify");
+			break;
+		}
+		DoIOError(kErrTLS, "TLS read failed %s", LastError().c_str());
+		break;
+	}
+	Flush(); // post handshake messages may want an answer
+}
+
+/**
+ * write whatever OpenSSL has for the socket
+ */
+void
+TLSCnxLayer::Flush()
+{
+	if (wbio == nullptr) return;
+	char buf[kReadChunk];
+	while (BIO_ctrl_pending(wbio) > 0) {
+		int n = BIO_read(wbio, buf, sizeof(buf));
+		if (n <= 0) break;
+		if (lower) lower->Write(buf, n);
+	}
+}
+
+void
+TLSCnxLayer::Reset()
+{
+	if (ssl) {
+		SSL_set_app_data(ssl, nullptr);
+		SSL_free(ssl); // and the bios with it
+	}
+	ssl = nullptr;
+	rbio = nullptr;
+	wbio = nullptr;
+	handshaking = false;
+}
+
+std::string
+TLSCnxLayer::LastError() const
+{
+	unsigned long e = ERR_get_error();
+	ERR_clear_error();
+	if (e == 0) return "";
+	char buf[256];
+	ERR_error_string_n(e, buf, sizeof(buf));
+	return buf;
+}
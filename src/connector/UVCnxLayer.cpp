@@ -17,6 +17,63 @@
 
 extern UVEventLoop worker;
 
+const size_t UVCnxLayer::kMaxGather;
+
+/**
+ * @class WriteCompletions UVConnection.h
+ * @brief a write completion runs on the loop thread, and may come after its layer has gone: libuv finishes writes still pending when a
+ * handle closes with UV_ECANCELED, and one that fails to start is finished on a later pass. so completions hold on to one of these
+ * rather than the layer, and the layer's destructor cancels it. the lock is recursive, as a layer can be deleted from its own OnWritten()
+ */
+WriteCompletions::WriteCompletions(WrittenCB w)
+	: written(w)
+{
+}
+
+/**
+ * a write of n bytes is finished with. tells the layer, if it's still there
+ */
+void
+WriteCompletions::Done(const size_t n)
+{
+	std::lock_guard<std::recursive_mutex> g(lock);
+	if (written) written(n);
+}
+
+/**
+ * the layer is going. waits out any completion that is telling it now, and after that, nothing more reaches it
+ */
+void
+WriteCompletions::Cancel()
+{
+	std::lock_guard<std::recursive_mutex> g(lock);
+	written = nullptr;
+}
+
+/**
+ * @class ResolveWaiter UVConnection.h
+ * @brief a lookup can outlast the layer that asked, or be given up on by a Close(), so the answer comes through one of these, which the
+ * layer cancels
+ */
+ResolveWaiter::ResolveWaiter(ResolverCB r)
+	: resolved(r)
+{
+}
+
+void
+ResolveWaiter::Done(const UVAddresses& res, int status)
+{
+	std::lock_guard<std::recursive_mutex> g(lock);
+	if (resolved) resolved(res, status);
+}
+
+void
+ResolveWaiter::Cancel()
+{
+	std::lock_guard<std::recursive_mutex> g(lock);
+	resolved = nullptr;
+}
+
 /**
  * @class UVCnxLayer UVConnection.h
  * @brief Class performing raw socket io using libuv. Designed to plug into other layers implementing protocols like http and websocket over the top
@@ -25,72 +82,77 @@ extern UVEventLoop worker;
  * are static C style call back functions.
  *
  * Running this on a separate event loop thread ...  The run thread is static, and shared between UVCnxLayer instances
+ *
+ * addresses come from the loop's DNSCache, so layers going to the same place share lookups. where a host has several, they are raced by an
+ * AddressRacer: the first attempt is on this UVTCPClient, and any others on clients of their own, one of which may become the live one
  */
 
 int _layer_id=0;
 UVCnxLayer::UVCnxLayer(CnxLayerUpper* upper, std::string s, std::string h)
-	: CnxLayer(upper, nullptr) {
+	: CnxLayer(upper, nullptr)
+	, racer(&worker)
+	, live(this)
+	, unsent(0)
+	, completions(std::make_shared<WriteCompletions>([this](const size_t n) { Written(n); })) {
 
 	service = s;
 	host = h;
-	hasResolvedAddress = false;
 	connectState = ConnectionState::NOT_CONNECTED;
 	id = ++_layer_id;
 }
 
 UVCnxLayer::~UVCnxLayer() {
 	DEBUG_OUT("~UVCnxLayer()");
+	completions->Cancel();
+	if (resolving) resolving->Cancel();
+	racer.Cancel();
+	if (live != this) Dispose(live);
 }
 
 
 
 /**
- * setter for the host ... sets a flag so that we make sure we redo the getaddr call
+ * setter for the host
  */
 void
 UVCnxLayer::SetHost(const std::string h) const
 {
-	hasResolvedAddress = false;
 	host = h;
 }
 
 /**
- * setter for the target service ... sets a flag so that we make sure we redo the getaddr call
+ * setter for the target service
  */
 void
 UVCnxLayer::SetService(const std::string s) const
 {
-	hasResolvedAddress = false;
 	service = s;
 }
 
 /**
- * open hook. will call get addr if needed ... otherwise strives for socket connection nirvana
+ * open hook. gets the addresses from the cache, or waits on a lookup, either way on the loop thread, and then strives for socket connection nirvana
  */
 int
 UVCnxLayer::Open()
 {
 	DEBUG_OUT("UVCnxLayer::Opend()" );
-	DEBUG_OUT("connect request ... :" << host << ":" << service << " resolved " << hasResolvedAddress << " layer " << id);
-	if (hasResolvedAddress) {
-		char addr[17] = {'\0'};
-		uv_ip4_name((struct sockaddr_in*) address, addr, 16);
-		DEBUG_OUT("connecting to "<< addr <<" family "<< address->sa_family <<" port "<<(((struct sockaddr_in*) address)->sin_port)<<" connecting ...\n");
-		int r= DoConnection();
-		return r;
+	DEBUG_OUT("connect request ... :" << host << ":" << service << " layer " << id);
+	if (live != this) {
+		Dispose(live);
+		live = this;
 	}
-	worker.Resolve(this, host, service, [this] (sockaddr *adr, int status) {
+	if (resolving) resolving->Cancel();
+	resolving = std::make_shared<ResolveWaiter>([this] (const UVAddresses& res, int status) {
 		DEBUG_OUT("UVCnx resolve" << status);
 		if (status < 0) {
 			DoOpenFailure(status, "uv_getaddrinfo() callback error %s\n", uv_strerror(status));
 			return;
 		}
-		hasResolvedAddress = true;
-		*address = *adr;
-		char addr[17] = {'\0'};
-		uv_ip4_name((struct sockaddr_in*) address, addr, 16);
-		DEBUG_OUT("resolved to "<< addr <<" family "<< address->sa_family <<" port "<<(((struct sockaddr_in*) address)->sin_port)<<" connecting ...\n");
-		DoConnection();
+		DoConnection(res);
+	});
+	std::shared_ptr<ResolveWaiter> r = resolving;
+	worker.GetDNSCache().Resolve(host, service, [r] (const UVAddresses& res, int status) {
+		r->Done(res, status);
 	});
 	return 0;
 }
@@ -101,10 +163,46 @@ UVCnxLayer::Open()
 int
 UVCnxLayer::Write(const char *data, const size_t len) {
 	DEBUG_OUT("UVCnxLayer::Write() " << len << " on " << " layer " << id);
-	worker.Write(this, data, len);
+	unsent += len;
+	std::shared_ptr<WriteCompletions> c = completions;
+	worker.Write(live, data, len, [c, len](int) {
+		c->Done(len);
+	});
 	return 0;
 }
 
+/**
+ * gathered write, copied once into the buffer the loop sends
+ */
+int
+UVCnxLayer::WriteV(const CnxChunk *chunks, const size_t n) {
+	if (n > kMaxGather) {
+		return CnxLayer::WriteV(chunks, n);
+	}
+	uv_buf_t bufs[kMaxGather];
+	size_t len = 0;
+	for (size_t i=0; i<n; i++) {
+		bufs[i] = uv_buf_init((char*)chunks[i].data, (unsigned int)chunks[i].len);
+		len += chunks[i].len;
+	}
+	unsent += len;
+	std::shared_ptr<WriteCompletions> c = completions;
+	worker.Write(live, bufs, n, [c, len](int) {
+		c->Done(len);
+	});
+	return 0;
+}
+
+/**
+ * a write has gone, or failed, on the loop thread. either way it's no longer waiting. only ever called through completions
+ */
+void
+UVCnxLayer::Written(const size_t n)
+{
+	unsent -= n;
+	if (upper) upper->OnWritten();
+}
+
 /**
  * main close hook
  * uncertain about the mutex here ... XXX it is possible for this entry point to be triggered in an error callback ie at a point
@@ -114,6 +212,12 @@ int
 UVCnxLayer::Close() {
 	DEBUG_OUT("UVCnxLayer::Close" << " layer " << id);
 	int r = 0;
+	if (resolving) resolving->Cancel(); // a lookup still out doesn't get to start anything
+	if (racer.IsRacing()) {
+		DEBUG_OUT("UVCnxLayer::Close() abandoning connection attempts" << " layer " << id);
+		racer.Cancel();
+		return 0;
+	}
 	if (connectState == ConnectionState::NOT_CONNECTED) {
 		DEBUG_OUT("UVCnxLayer::Close() already closed" << " layer " << id);
 		return 0;
@@ -123,7 +227,7 @@ UVCnxLayer::Close() {
 		return kCloseOnClosedLayer; // xxx perhaps we shouldn't regard this as an error?
 	}
 	connectState = ConnectionState::DISCONNECTION_IN_PROGRESS;
-	worker.Close(this, [this] (uv_handle_t* h) {
+	worker.Close(live, [this] (uv_handle_t* h) {
 		DEBUG_OUT("UVCnxLayer::Close close callback" << " layer " << id);
 		connectState = ConnectionState::NOT_CONNECTED;
 		if (upper) upper->OnClose();
@@ -135,43 +239,69 @@ UVCnxLayer::Close() {
 }
 
 /**
- * does the actual work of the connection. assumes we have an inet address, and kicks in a read callback if we succeed
+ * does the actual work of the connection. races the addresses we have, and kicks in a read callback on whichever wins
  */
 int
-UVCnxLayer::DoConnection()
+UVCnxLayer::DoConnection(const UVAddresses& res)
 {
-	DEBUG_OUT("DoConnection() ... " << hasResolvedAddress << id);
-	if (!hasResolvedAddress) {
-		DoIOError(-1, "MakeConnection:: address unresolved\n");
-		return -1;
-	}
-	DEBUG_OUT("DoConnection() ... " << host << ":" << service << " layer " << id);
-	worker.Connect(this,
-			[this] (uv_connect_t *req, int status) {
+	DEBUG_OUT("DoConnection() ... " << host << ":" << service << " " << res.size() << " addresses, layer " << id);
+	attempts.assign(res.size(), nullptr);
+	racer.Race(res,
+		[this] (const UVAddress& a, const int attempt) {
+			StartAttempt(a, attempt);
+		},
+		[this] (const int attempt) {
+			Abandon(attempts[attempt]);
+			attempts[attempt] = nullptr;
+		},
+		[this] (const int status) {
+			worker.GetDNSCache().Forget(host, service); // nothing there answered, so perhaps it has moved
+			DoOpenFailure(status, "connect failed error %s\n", uv_strerror(status));
+		});
+	return 0;
+}
+
+/**
+ * one go at one address. the first is on our own UVTCPClient, the rest get one of their own
+ */
+void
+UVCnxLayer::StartAttempt(const UVAddress& a, const int attempt)
+{
+	UVTCPClient* c = attempt == 0? this : new UVTCPClient();
+	attempts[attempt] = c;
+	c->SetAddress(a);
+	DEBUG_OUT("UVCnxLayer::StartAttempt() " << attempt << " to " << a.Name() << " layer " << id);
+	worker.Connect(c,
+			[this, c, attempt] (uv_connect_t *req, int status) {
 				if (status < 0) {
-					DoOpenFailure(status, "connect failed error %s\n", uv_strerror(status));
 					DEBUG_OUT("UVCnxLayer::DoConnection() error ..." << uv_strerror(status) << " layer " << id);
+					if (racer.Failed(attempt, status)) {
+						attempts[attempt] = nullptr;
+						Abandon(c);
+					}
+					return;
+				}
+				if (!racer.Succeeded(attempt)) { // something beat it to it
+					Abandon(c);
 					return;
 				}
 				DEBUG_OUT("UVCnxLayer::DoConnection() ready  ..." << " layer " << id );
+				attempts[attempt] = nullptr;
+				live = c;
 				connectState = ConnectionState::READY;
 				if (upper) upper->OnOpen();
 			},
-			[this](uv_stream_t *client, ssize_t nread, const uv_buf_t *buf) {
+			[this, c](uv_stream_t *client, ssize_t nread, const uv_buf_t *buf) {
 				if (nread < 0) {
 					if (nread != UV_EOF) {
 						DEBUG_OUT("UVCnxLayer::Read() io error  ..." << uv_strerror((int)nread) << " layer " << id );
 						DoIOError(-1, "Read error %s\n", uv_strerror((int)nread));
 					} else {
 						DEBUG_OUT("UVCnxLayer::Read() eof error  ..."<< " layer " << id);
-						worker.Close(this, [this] (uv_handle_t* h) {
+						worker.Close(c, [this] (uv_handle_t* h) {
 							connectState = ConnectionState::NOT_CONNECTED;
 							DoServerDisconnect(-1, "Unexpected end of file on uv read");
 						});
-//						DoServerDisconnect(-1, "Unexpected end of file on uv read");
-//						worker.Close(this, [this] (uv_handle_t* h) {
-//							connectState = ConnectionState::NOT_CONNECTED;
-//						});
 					}
 					return;
 				} else if (nread > 0) {
@@ -179,5 +309,28 @@ UVCnxLayer::DoConnection()
 				}
 			}
 		);
-	return 0;
+}
+
+/**
+ * close an attempt that lost, or was given up on
+ */
+void
+UVCnxLayer::Abandon(UVTCPClient* c)
+{
+	if (c == nullptr) return;
+	worker.Close(c, [this, c] (uv_handle_t* h) {
+		if (c != this) Dispose(c);
+	});
+}
+
+/**
+ * delete a client of our own once uv is done with it. uv still has a hand on the handle in the close callback, so not there
+ */
+void
+UVCnxLayer::Dispose(UVTCPClient* c)
+{
+	if (c == nullptr || c == this) return;
+	worker.Schedule(0, 0, [c]() {
+		delete c;
+	});
 }
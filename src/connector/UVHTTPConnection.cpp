@@ -6,6 +6,7 @@
  */
 
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <random>
@@ -19,28 +20,45 @@
 
 extern UVEventLoop worker;
 
+const size_t UVHTTPCnxUpper::kDfltMaxBatchBytes;
+const int UVHTTPCnxUpper::kRetryMS;
+const int UVHTTPCnxUpper::kMaxRetryMS;
+const int UVHTTPCnxUpper::kMaxRetries;
+const int UPCHTTPConnection::kMaxPollDepth;
+const int UPCHTTPConnection::kMaxPollRetries;
+
 /**
  * @class UVHTTPCnxUpper UVConnection.h
- * @brief implements an unsecured http connection over a libuv raw tcp socket.
+ * @brief implements an http connection over a libuv raw tcp socket, or over tls on one with SetSecure().
  *
  * this is the base http connector ... in the current case, we need a couple of these to talk http with the server the HTTPCnxLayer handles the
  * core HTTP implementation, this layer gives it the UV transport and provides error tracking, timeouts, and queueing of requests
+ *
+ * one request is out at a time. Write() queues a whole request body. WriteBatched() queues a piece of one: everything batched while a
+ * request is out goes together in the next, up to the batch size, wrapped up by the Framer given to SetBatching(). a request that can't
+ * be got out is retried after kRetryMS, doubling each time up to kMaxRetryMS, and after kMaxRetries we give up and report an open failure
  */
 UVHTTPCnxUpper::UVHTTPCnxUpper(CnxLayerUpper* upper, const std::string host,  const std::string resource, const std::string service)
 	: CnxLayer(upper, &http)
 	, CnxLayerUpper()
 	, uv(&http, service, host)
 	, http(this, &uv)
-	, retryDelay(10)
+	, tls(&http, &uv)
+	, pipe(&http)
+	, loop(&worker)
 	, notifyReceipt(true)
 {
 	queueLock = new UVLock();
+	SetHost(host);
 }
 
 
 UVHTTPCnxUpper::~UVHTTPCnxUpper()
 {
 	DEBUG_OUT( "~UVHTTPCnxUpper()");
+	if (retryTimer != nullptr) {
+		loop->CancelTimer(retryTimer);
+	}
 	delete queueLock;
 }
 
@@ -62,21 +80,27 @@ void UVHTTPCnxUpper::OnOpen()
 	if (upper) upper->OnOpen(); // probably shouldn't get this ... the http layer does it's write on opens automatically though it's closed, and gives an an open response
 }
 
+/**
+ * the request is done with, and the socket closed. the upper layer is told there's room while we're still busy, so that what it has
+ * waiting goes into the next request together, and then it's on to that
+ */
 void UVHTTPCnxUpper::OnClose()
 {
+	request.clear();
+	retries = 0;
+	retryMS = kRetryMS;
+	if (upper) upper->OnWritten();
+	busy = false;
 	CheckQAndWrite();
 }
 
 void UVHTTPCnxUpper::OnOpenFailure(const std::string msg, const int status)
 {
-	if (status == UV_EALREADY) {
-		queueLock->Lock();
-		messageQueue.push_front(msg);
-		queueLock->Unlock();
-		worker.Schedule(retryDelay*1000, 0, [this](){
-			CheckQAndWrite();
-		});
+	if (status == UV_EALREADY && busy) {
+		RetryRequest(msg, status);
 	} else {
+		busy = false;
+		request.clear();
 		if (upper) upper->OnOpenFailure(msg, status);
 	}
 }
@@ -95,6 +119,8 @@ void UVHTTPCnxUpper::OnIOError(const std::string msg, const int status)
  */
 void UVHTTPCnxUpper::OnServerDisconnect(const std::string msg, const int status)
 {
+	busy = false;
+	request.clear();
 	if (upper) upper->OnServerDisconnect(msg, status);
 }
 
@@ -109,60 +135,192 @@ int UVHTTPCnxUpper::Open()
 
 
 /**
- * output hook
+ * output hook. queues a whole request
  */
 int UVHTTPCnxUpper::Write(const char *data, const size_t len)
 {
-	std::string msg(data, len);
-//	DEBUG_OUT("UVHTTPCnxUpper::Write " << msg );
 	queueLock->Lock();
-	messageQueue.push_back(msg);
+	messageQueue.emplace_back(data, len);
 	queueLock->Unlock();
 	return CheckQAndWrite();
 }
 
 /**
- * http messages create a mess when several are sent at once. if the outgoing line is busy, they are queued. here we check any http messages that may be queued.
+ * queues a piece of a request, to go with whatever else is batched by then. without SetBatching(), it goes as it is
+ */
+int
+UVHTTPCnxUpper::WriteBatched(const char *data, const size_t len)
+{
+	queueLock->Lock();
+	batchQueue.emplace_back(data, len);
+	queueLock->Unlock();
+	return CheckQAndWrite();
+}
+
+/**
+ * as above, for a piece made just for us
+ */
+int
+UVHTTPCnxUpper::WriteBatched(std::string&& piece)
+{
+	queueLock->Lock();
+	batchQueue.push_back(std::move(piece));
+	queueLock->Unlock();
+	return CheckQAndWrite();
+}
+
+/**
+ * http messages create a mess when several are sent at once. if a request is out, they wait for it to finish. whole requests go first,
+ * then as much of the batch as fits
  */
 int
 UVHTTPCnxUpper::CheckQAndWrite()
 {
-	int r=0;
-	std::string msg;
-	bool hasFromQ = false;
 	queueLock->Lock();
+	if (busy || (messageQueue.empty() && batchQueue.empty())) {
+		queueLock->Unlock();
+		return 0;
+	}
 	if (!messageQueue.empty()) {
-		msg = messageQueue.front();
+		request = std::move(messageQueue.front());
 		messageQueue.pop_front();
-		hasFromQ = true;
+	} else {
+		batch.assign(batchQueue.front());
+		batchQueue.pop_front();
+		while (!batchQueue.empty() && batch.size() + batchQueue.front().size() <= maxBatch) {
+			batch += batchQueue.front();
+			batchQueue.pop_front();
+		}
+		request.clear();
+		if (framer) {
+			framer(request, batch);
+		} else {
+			request.append(batch);
+		}
 	}
+	busy = true;
 	queueLock->Unlock();
-	if (hasFromQ) {
-		DEBUG_OUT("UVHTTPCnxUpper::CheckQAndWrite() finds message" );
-		if (lower) r = lower->Write(msg.c_str(), msg.size());
-		if (r < 0) {
-			queueLock->Lock();
-			messageQueue.push_front(msg);
-			queueLock->Unlock();
-			worker.Schedule(retryDelay*1000, 0, [this](){
-				CheckQAndWrite();
-			});
-
-			if (r == kErrTransportLayerBusy) {
-			} else {
-			}
-		}
+	DEBUG_OUT("UVHTTPCnxUpper::CheckQAndWrite() sending " << request.size() << " bytes");
+	return SendRequest();
+}
+
+/**
+ * send, or resend, the request we're on
+ */
+int
+UVHTTPCnxUpper::SendRequest()
+{
+	requestCount++;
+	Relink();
+	int r = lower? lower->Write(request.c_str(), request.size()) : 0;
+	if (r < 0) {
+		RetryRequest("Request failed to start", r);
 	}
 	return r;
 }
 
 /**
- * close hook
+ * have another go at the current request after a while, unless we've been at it long enough
+ */
+void
+UVHTTPCnxUpper::RetryRequest(const std::string msg, const int status)
+{
+	if (++retries > kMaxRetries) {
+		busy = false;
+		request.clear();
+		retries = 0;
+		retryMS = kRetryMS;
+		if (upper) upper->OnOpenFailure(msg + ", after retrying", status);
+		return;
+	}
+	int delay = retryMS;
+	retryMS = std::min(retryMS*2, kMaxRetryMS);
+	retryTimer = loop->Schedule(delay, 0, [this]() {
+		retryTimer = nullptr; // one shot
+		if (busy) SendRequest();
+	});
+}
+
+/**
+ * close hook. anything still waiting is dropped
  */
 int UVHTTPCnxUpper::Close()
 {
-	if (lower) return lower->Close();
-	return 0;
+	queueLock->Lock();
+	messageQueue.clear();
+	batchQueue.clear();
+	queueLock->Unlock();
+	if (retryTimer != nullptr) {
+		loop->CancelTimer(retryTimer);
+		retryTimer = nullptr;
+	}
+	retries = 0;
+	retryMS = kRetryMS;
+	int r = lower? lower->Close() : 0;
+	busy = false;
+	request.clear();
+	return r;
+}
+
+/**
+ * @param f wraps a batch up as a request body
+ * @param maxBody most bytes of batched pieces to put in one request. a single piece bigger than that still goes, on its own. 0 for one
+ * piece per request
+ */
+void
+UVHTTPCnxUpper::SetBatching(Framer f, const size_t maxBody)
+{
+	framer = f;
+	maxBatch = maxBody;
+}
+
+/**
+ * @param l loop for the retry timer. the shared worker by default
+ */
+void
+UVHTTPCnxUpper::SetEventLoop(EventLoop* l)
+{
+	loop = l;
+}
+
+/**
+ * replace the socket under the http layer. for tests
+ */
+void
+UVHTTPCnxUpper::SetTransport(CnxLayer* t)
+{
+	transport = t;
+	Relink();
+}
+
+/**
+ * put tls between the http and the socket (https), or take it out. each request is on a socket of its own, so this is where session
+ * resumption earns its keep
+ */
+void
+UVHTTPCnxUpper::SetSecure(const bool enable, std::shared_ptr<TLSContext> c)
+{
+	secure = enable;
+	tls.SetContext(c);
+	Relink();
+}
+
+/**
+ * stack the layers for how we are set up: http, then tls if secure, on a pipe for a unix: host, otherwise on tcp
+ */
+void
+UVHTTPCnxUpper::Relink()
+{
+	CnxLayer* bottom = transport? transport : UVPipeCnxLayer::IsPipeEndpoint(host)? (CnxLayer*)&pipe : (CnxLayer*)&uv;
+	if (secure) {
+		http.lower = &tls;
+		tls.upper = &http;
+		tls.lower = bottom;
+		bottom->upper = &tls;
+	} else {
+		http.lower = bottom;
+		bottom->upper = &http;
+	}
 }
 
 /**
@@ -172,8 +330,16 @@ int UVHTTPCnxUpper::Close()
 void
 UVHTTPCnxUpper::SetHost(const std::string h) const
 {
+	host = h;
+	if (UVPipeCnxLayer::IsPipeEndpoint(h)) {
+		pipe.SetPath(UVPipeCnxLayer::PipePath(h));
+		http.SetHost(UVPipeCnxLayer::kPipeHostHeader);
+		tls.SetHost(UVPipeCnxLayer::kPipeHostHeader);
+		return;
+	}
 	http.SetHost(h);
 	uv.SetHost(h);
+	tls.SetHost(h);
 }
 
 /**
@@ -194,6 +360,7 @@ void
 UVHTTPCnxUpper::SetService(const std::string s) const
 {
 	uv.SetService(s);
+	tls.SetService(s);
 }
 
 
@@ -216,16 +383,85 @@ UVHTTPCnxUpper::SetNotifyReceipt(bool n)
 	notifyReceipt = n;
 }
 
+/**
+ * @return true if nothing is queued and no request is out
+ */
+bool
+UVHTTPCnxUpper::IsIdle() const
+{
+	queueLock->Lock();
+	bool empty = messageQueue.empty() && batchQueue.empty();
+	queueLock->Unlock();
+	return empty && !busy;
+}
+
+/**
+ * @return bytes queued for requests, and in the request that's out
+ */
+size_t
+UVHTTPCnxUpper::GetUnsentBytes() const
+{
+	size_t n = 0;
+	queueLock->Lock();
+	for (auto& m: messageQueue) n += m.size();
+	for (auto& b: batchQueue) n += b.size();
+	queueLock->Unlock();
+	return busy? n + request.size() : n;
+}
+
+/**
+ * @class UPCHTTPPoll UVConnection.h
+ * @brief one of the long polls of a UPCHTTPConnection, on its own socket, and knowing which request it has out
+ */
+UPCHTTPPoll::UPCHTTPPoll(UPCHTTPConnection* cnx)
+	: CnxLayerUpper()
+	, cnx(cnx)
+{
+	http = cnx->NewPollLayer(this);
+}
+
+UPCHTTPPoll::~UPCHTTPPoll()
+{
+	delete http;
+}
+
+int
+UPCHTTPPoll::Receive(const char *data, const size_t len)
+{
+	return cnx->PollReceive(this, data, len);
+}
+
+void
+UPCHTTPPoll::OnOpenFailure(const std::string msg, const int status)
+{
+	cnx->OnOpenFailure(msg, status);
+}
+
+void
+UPCHTTPPoll::OnIOError(const std::string msg, const int status)
+{
+	cnx->PollIOError(this, msg, status);
+}
+
+void
+UPCHTTPPoll::OnServerDisconnect(const std::string msg, const int status)
+{
+	cnx->OnServerDisconnect(msg, status);
+}
+
 /**
  * @class UPCHTTPConnection UVConnection.h
- * @brief implements a pair of unsecured http connections over a libuv raw tcp socket with a bit of upc wierdness added
+ * @brief implements a set of http (or, with SetSecure(), https) connections over libuv raw tcp sockets with a bit of upc wierdness added
  *
- * actually implements a couple of http connections, and does its best to cope with UPC's peculiarities
+ * actually implements a couple of http connections, and does its best to cope with UPC's peculiarities. sends go on httpTx. the server's
+ * side comes back on mode c long polls, by default one at a time, so anything pushed while the next poll is on its way waits for it.
+ * SetPollDepth() keeps more out at once, each on a socket of its own, so there is nearly always one waiting at the server. responses are
+ * passed on in request order, whatever order they arrive in. an empty response is the server saying it had nothing for the whole poll,
+ * and then we drop back to one poll until something turns up
  */
 UPCHTTPConnection::UPCHTTPConnection(std::string host, std::string resource, const std::string service)
 	: AbstractConnection(host, service)
 	, CnxLayerUpper()
-	, httpRx(this)
 	, httpTx(this)
 {
 	sRequestIndex = 1;
@@ -234,30 +470,46 @@ UPCHTTPConnection::UPCHTTPConnection(std::string host, std::string resource, con
 	SetHost(host);
 	SetService(service);
 	SetResource(resource);
-	httpRx.SetMethod( HTTP_METHOD_POST);
 	httpTx.SetMethod( HTTP_METHOD_POST);
+	SetMaxSendBatch(maxSendBatch);
+	sendQueue.Attach([this](const std::string& msg) {
+		return Transmit(msg);
+	}, [this]() {
+		return httpTx.GetUnsentBytes();
+	});
+	sendQueue.SetLoopThreadCheck([]() {
+		return worker.IsLoopThread();
+	});
 }
 
 UPCHTTPConnection:: ~UPCHTTPConnection()
 {
 	DEBUG_OUT("~UVHTTPConnection() closing connection");
 	if (connectState != ConnectionState::DISCONNECTION_IN_PROGRESS && connectState != ConnectionState::NOT_CONNECTED) {
-		httpRx.Close();
+		for (auto it: polls) {
+			it->http->Close();
+		}
 		httpTx.Close();
 	}
+	for (auto it: polls) {
+		delete it;
+	}
 	DEBUG_OUT("~UVHTTPConnection() done");
 }
 
 std::string
 UPCHTTPConnection::LongName()
 {
-	return std::string("http connection at " + host + ":" + service);
+	return std::string((secure? "https connection at " : "http connection at ") + host + ":" + service);
 }
 
 std::string
 UPCHTTPConnection::ShortName()
 {
-	return std::string("http://" + host + ":" + service);
+	if (UVPipeCnxLayer::IsPipeEndpoint(host)) {
+		return std::string((secure? "https+" : "http+") + host);
+	}
+	return std::string((secure? "https://" : "http://") + host + ":" + service);
 }
 
 /**
@@ -267,6 +519,7 @@ int
 UPCHTTPConnection::Connect()
 {
 	initialRequest = true;
+	sendQueue.Clear();
 	httpTx.SetNotifyReceipt(true);
 	connectState = ConnectionState::READY; // we won't get errors till we try to do something
 	NxConnected(this);
@@ -282,7 +535,8 @@ UPCHTTPConnection::Disconnect()
 	DEBUG_OUT("UPCHTTPConnection disconnecting ..." );
 	if (connectState != ConnectionState::DISCONNECTION_IN_PROGRESS && connectState != ConnectionState::NOT_CONNECTED) {
 		connectState = ConnectionState::DISCONNECTION_IN_PROGRESS;
-		httpRx.Close();
+		ClosePolls();
+		sendQueue.Clear();
 		httpTx.Close();
 		connectState = ConnectionState::NOT_CONNECTED;
 		NxDisconnected(this);
@@ -291,46 +545,241 @@ UPCHTTPConnection::Disconnect()
 }
 
 /**
- * main hook to send data ... uses the httpTx connector with different setting depending on whether it is the first transmission or subsequent.
- * in upc, subsequent requests return no data of interest as all the interesting bits come from the long poll on httpRx
+ * main hook to send data ... goes through the send queue, which holds on to it while httpTx has a batch out and the next one full
  */
 int
 UPCHTTPConnection::Send(const std::string msg)
 {
-	HTTP::PostData pd;
+	if (draining) { // whatever comes of this has to be collected too
+		drained = false;
+		FillPolls();
+	}
+	return sendQueue.Send(msg);
+}
+
+/**
+ * a request has gone, so there may be room for what's queued
+ */
+void
+UPCHTTPConnection::OnWritten()
+{
+	sendQueue.Flush();
+}
+
+/**
+ * hands a message to the httpTx connector, with different setting depending on whether it is the first transmission or subsequent.
+ * in upc, subsequent requests return no data of interest as all the interesting bits come from the long polls. after the first, sends
+ * are encoded as they come, and everything sent while a request is out goes in one mode s request after it
+ */
+int
+UPCHTTPConnection::Transmit(const std::string& msg)
+{
 	if (initialRequest) {
+		HTTP::PostData pd;
 		pd["mode"] = "d";
-	} else {
-		pd["mode"] = "s";
-		pd["rid"] = std_to_string(sRequestIndex++);
-		pd["sid"] = sessionID;
+		pd["data"] = msg;
+		std::string ucpMsg = pd.Serialize();
+		return httpTx.Write(ucpMsg.c_str(), (size_t) ucpMsg.size());
 	}
-	pd["data"] = msg;
-	std::string ucpMsg = pd.Serialize();
-	return httpTx.Write(ucpMsg.c_str(), (size_t) ucpMsg.size());
+	std::string encoded;
+	Url::AppendEncoded(encoded, msg);
+	return httpTx.WriteBatched(std::move(encoded));
+}
+
+/**
+ * @param bytes most encoded upc to put in one mode s request. 0 for a request per upc
+ */
+void
+UPCHTTPConnection::SetMaxSendBatch(const size_t bytes)
+{
+	maxSendBatch = bytes;
+	sendQueue.SetWriteWindow(bytes > 0? 2*bytes : SendQueue::kDfltWriteWindow); // a batch out, and the next one filling
+	httpTx.SetBatching([this](std::string& request, const std::string& batch) {
+		request.append("mode=s&rid=").append(std_to_string(sRequestIndex++)).append("&sid=");
+		Url::AppendEncoded(request, sessionID);
+		request.append("&data=").append(batch);
+	}, maxSendBatch);
 }
 
 /**
- * data receipt from lower layers
+ * data receipt from httpTx, which only passes on the answer to the first request. after that, everything comes on the polls
  */
 int
 UPCHTTPConnection::Receive(const char *data, const size_t len) {
-	std::string strData(data, len);
 	DEBUG_OUT("UPCHTTPConnection::Receive" << len << " " << initialRequest);
 	if (initialRequest) {
-		NxReceive(strData, UPC::Status::SUCCESS);
-	} else {
-		if (strData.size() > 0) {
-			NxReceive(strData, UPC::Status::SUCCESS);
+		NxReceive(std::string(data, len), UPC::Status::SUCCESS);
+	}
+	return 0;
+}
+
+/**
+ * the response to a poll. it's held until everything before it has been passed on, then the polls are topped up again
+ */
+int
+UPCHTTPConnection::PollReceive(UPCHTTPPoll* poll, const char *data, const size_t len)
+{
+	int rid = poll->rid;
+	poll->rid = 0;
+	if (rid == 0 || connectState != ConnectionState::READY) {
+		return 0;
+	}
+	poll->errors = 0;
+	DEBUG_OUT("UPCHTTPConnection::PollReceive() " << rid << ", " << len << " bytes");
+	pollEarly[rid] = std::string(data, len);
+	pollIdle = (len == 0);
+	bool empty = false;
+	while (!pollEarly.empty() && pollEarly.begin()->first == nextPollRid) {
+		std::string d = pollEarly.begin()->second;
+		pollEarly.erase(pollEarly.begin());
+		nextPollRid++;
+		empty = d.empty();
+		if (d.size() > 0) {
+			NxReceive(d, UPC::Status::SUCCESS);
 		}
-		if (connectState == ConnectionState::READY) {
-			DEBUG_OUT("UPCHTTPConnection::Receive() initiate mode c request on receipt of " << strData.size() << " bytes ");
-			ModeCRequest();
+		if (connectState != ConnectionState::READY) { // hung up by whoever got that
+			return 0;
 		}
 	}
+	if (draining) {
+		drained = empty && pollEarly.empty() && std::none_of(polls.begin(), polls.end(), [](UPCHTTPPoll* p) { return p->rid != 0; });
+	}
+	FillPolls();
 	return 0;
 }
 
+/**
+ * a poll has gone wrong, so its response isn't coming. the same rid is asked for again, as everything after it is held till it turns up,
+ * and if that keeps failing, we give up on the connection
+ */
+void
+UPCHTTPConnection::PollIOError(UPCHTTPPoll* poll, const std::string msg, const int status)
+{
+	int rid = poll->rid;
+	poll->rid = 0;
+	NxIOError(msg, status);
+	if (rid == 0 || connectState != ConnectionState::READY) {
+		return;
+	}
+	if (++poll->errors > kMaxPollRetries) {
+		poll->errors = 0;
+		ClosePolls();
+		OnServerDisconnect(msg + ", polling", status);
+		return;
+	}
+	DEBUG_OUT("UPCHTTPConnection::PollIOError() reissuing " << rid);
+	ModeCRequest(poll, rid);
+}
+
+/**
+ * hang up every poll, and forget what they had out
+ */
+void
+UPCHTTPConnection::ClosePolls()
+{
+	for (auto it: polls) {
+		it->http->Close();
+		it->rid = 0;
+		it->errors = 0;
+	}
+	pollEarly.clear();
+	draining = drained = false;
+}
+
+/**
+ * get as many polls out as we want: the poll depth, or just the one while the server is idle or we're draining, and none once drained.
+ * nothing is held open between polls, so the spares cost nothing while they're not in use
+ */
+void
+UPCHTTPConnection::FillPolls()
+{
+	if (initialRequest || connectState != ConnectionState::READY) {
+		return;
+	}
+	int want = draining? (drained? 0 : 1) : pollIdle? 1 : pollDepth;
+	int out = 0;
+	for (auto it: polls) {
+		if (it->rid != 0) out++;
+	}
+	for (size_t i=0; out < want; i++) {
+		if (i == polls.size()) {
+			polls.push_back(new UPCHTTPPoll(this));
+		}
+		if (polls[i]->rid == 0) {
+			out++;
+			ModeCRequest(polls[i]);
+		}
+	}
+}
+
+/**
+ * @return a new transport for a poll. overridden for tests
+ */
+UVHTTPCnxUpper*
+UPCHTTPConnection::NewPollLayer(CnxLayerUpper* poll)
+{
+	UVHTTPCnxUpper* l = new UVHTTPCnxUpper(poll, host, resource, service);
+	l->SetMethod(HTTP_METHOD_POST);
+	if (secure) l->SetSecure(true, tlsContext);
+	l->SetCompression(compression);
+	return l;
+}
+
+/**
+ * https, or not, for the sends and every poll. takes effect on the next request
+ */
+void
+UPCHTTPConnection::SetSecure(const bool enable, std::shared_ptr<TLSContext> c)
+{
+	secure = enable;
+	tlsContext = c;
+	httpTx.SetSecure(enable, c);
+	for (auto it: polls) {
+		it->http->SetSecure(enable, c);
+	}
+	if (secure) {
+		properties.insert(CONNECTION_SECURE);
+	} else {
+		properties.erase(CONNECTION_SECURE);
+	}
+}
+
+/**
+ * ask for gzip or deflate on the polls and sends, or not. on by default. snapshots and busy rooms shrink to a fraction on the wire
+ */
+void
+UPCHTTPConnection::SetCompression(const bool enable)
+{
+	compression = enable;
+	httpTx.SetCompression(enable);
+	for (auto it: polls) {
+		it->http->SetCompression(enable);
+	}
+}
+
+/**
+ * @return the response byte counts of the sends and every poll together
+ */
+HTTPCnxLayer::CompressionStats
+UPCHTTPConnection::GetCompressionStats() const
+{
+	HTTPCnxLayer::CompressionStats s = httpTx.GetCompressionStats();
+	for (auto it: polls) {
+		s.Add(it->http->GetCompressionStats());
+	}
+	return s;
+}
+
+/**
+ * @param n how many mode c polls to keep out at once, from 1 (the default, one after another) to kMaxPollDepth. 2 is usually plenty
+ */
+void
+UPCHTTPConnection::SetPollDepth(const int n)
+{
+	pollDepth = n < 1? 1 : n > kMaxPollDepth? kMaxPollDepth : n;
+	FillPolls();
+}
+
 /**
  * open notification from lower layer(s)
  */
@@ -349,6 +798,7 @@ void
 UPCHTTPConnection::OnOpenFailure(std::string msg, int status) {
 	DEBUG_OUT("UVHTTPConnection::OnOpenFailure");
 	connectState = ConnectionState::NOT_CONNECTED;
+	sendQueue.Clear();
 	NxConnectFailure(this, msg, status);
 }
 /**
@@ -364,6 +814,7 @@ UPCHTTPConnection::OnIOError(std::string msg, int status) {
 void
 UPCHTTPConnection::OnServerDisconnect(std::string msg, int status) {
 	connectState = ConnectionState::NOT_CONNECTED;
+	sendQueue.Clear();
 	NxServerHangup(this, msg, status);
 }
 
@@ -375,7 +826,9 @@ void
 UPCHTTPConnection::SetHost(const std::string h) const
 {
 	host = h;
-	httpRx.SetHost(h);
+	for (auto it: polls) {
+		it->http->SetHost(h);
+	}
 	httpTx.SetHost(h);
 }
 
@@ -387,10 +840,40 @@ void
 UPCHTTPConnection::SetService(const std::string s) const
 {
 	service = s;
-	httpRx.SetService(s);
+	for (auto it: polls) {
+		it->http->SetService(s);
+	}
 	httpTx.SetService(s);
 }
 
+/**
+ * @return true if every send has gone out and been answered. the long polls don't count. one is always out, so hanging up can still
+ * lose whatever the server has for us, unless we Drain() first
+ */
+bool
+UPCHTTPConnection::IsIdle()
+{
+	return httpTx.IsIdle();
+}
+
+/**
+ * stop topping up the polls, and keep just the one going till it comes back empty. the server only lets a poll go empty when it has had
+ * nothing for us the whole time, so after that, and with no send out, there's nothing of the session's left to lose
+ * @param enable false to go back to polling as usual
+ * @return true once drained
+ */
+bool
+UPCHTTPConnection::Drain(const bool enable)
+{
+	if (!enable) {
+		draining = drained = false;
+		FillPolls();
+		return false;
+	}
+	draining = true;
+	return drained && httpTx.IsIdle();
+}
+
 /**
  * sets the resource to access
  * @param r the resource
@@ -398,7 +881,10 @@ UPCHTTPConnection::SetService(const std::string s) const
 void
 UPCHTTPConnection::SetResource(const std::string r) const
 {
-	httpRx.SetResource(r);
+	resource = r;
+	for (auto it: polls) {
+		it->http->SetResource(r);
+	}
 	httpTx.SetResource(r);
 }
 
@@ -413,22 +899,27 @@ UPCHTTPConnection::SetSessionID(const std::string id)
 	sessionID = id;
 	initialRequest = false;
 	httpTx.SetNotifyReceipt(false);
-	ModeCRequest();
+	nextPollRid = cRequestIndex;
+	pollEarly.clear();
+	pollIdle = false;
+	draining = drained = false;
+	FillPolls();
 }
 
 /**
- * initiate the long polling request
+ * initiate a long polling request
+ * @param rid to ask again for one that failed. 0, the default, for the next
  */
 int
-UPCHTTPConnection::ModeCRequest()
+UPCHTTPConnection::ModeCRequest(UPCHTTPPoll* poll, const int rid)
 {
 	HTTP::PostData pd;
+	poll->rid = rid != 0? rid : cRequestIndex++;
 	pd["mode"] = "c";
-	pd["rid"] = std_to_string(cRequestIndex++);
+	pd["rid"] = std_to_string(poll->rid);
 	pd["sid"] = sessionID;
 	std::string ucpMsg = pd.Serialize();
-	DEBUG_OUT("mode c request " );
-	return httpRx.Write(ucpMsg.c_str(), (size_t) ucpMsg.size());
-
+	DEBUG_OUT("mode c request " << poll->rid);
+	return poll->http->Write(ucpMsg.c_str(), (size_t) ucpMsg.size());
 }
 
@@ -0,0 +1,164 @@
+/*
+ * UVPipeCnxLayer.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+#include <cstring>
+
+#include "uv.h"
+#include "UCLowerHeaders.h"
+#include "connector/UVConnection.h"
+#include "UVEventLoop.h"
+
+extern UVEventLoop worker;
+
+const char* UVPipeCnxLayer::kUnixScheme = "unix:";
+const char* UVPipeCnxLayer::kPipeHostHeader = "localhost";
+
+/**
+ * @class UVPipeCnxLayer UVConnection.h
+ * @brief raw io over a unix domain socket (a named pipe on windows) with libuv, for a gateway on the same host
+ *
+ * a drop in for UVCnxLayer under the ws, tls or http layers: there's no lookup and nothing to race, and the kernel doesn't run the
+ * bytes through its tcp stack. UVWSConnection and UVHTTPCnxUpper switch to one of these when their host is a kUnixScheme endpoint
+ */
+int _pipe_layer_id=0;
+UVPipeCnxLayer::UVPipeCnxLayer(CnxLayerUpper* upper, std::string p)
+	: CnxLayer(upper, nullptr)
+	, unsent(0)
+	, completions(std::make_shared<WriteCompletions>([this](const size_t n) { Written(n); }))
+{
+	connectState = ConnectionState::NOT_CONNECTED;
+	id = ++_pipe_layer_id;
+	path = p;
+}
+
+UVPipeCnxLayer::~UVPipeCnxLayer()
+{
+	DEBUG_OUT("~UVPipeCnxLayer()");
+	completions->Cancel();
+}
+
+/**
+ * @return true if host is a unix domain socket endpoint, eg unix:/var/run/union.sock
+ */
+bool
+UVPipeCnxLayer::IsPipeEndpoint(const std::string host)
+{
+	return host.compare(0, strlen(kUnixScheme), kUnixScheme) == 0;
+}
+
+/**
+ * @return the path part of a unix: endpoint
+ */
+std::string
+UVPipeCnxLayer::PipePath(const std::string host)
+{
+	return IsPipeEndpoint(host)? host.substr(strlen(kUnixScheme)) : host;
+}
+
+void
+UVPipeCnxLayer::SetPath(const std::string p) const
+{
+	path = p;
+}
+
+int
+UVPipeCnxLayer::Open()
+{
+	DEBUG_OUT("UVPipeCnxLayer::Open() " << path << " layer " << id);
+	if (path.empty()) {
+		DoOpenFailure(kErrNoTransport, "no path for unix domain socket");
+		return kErrNoTransport;
+	}
+	connectState = ConnectionState::CONNECTION_IN_PROGRESS;
+	UsePipe(path);
+	worker.Connect(this,
+			[this] (uv_connect_t *req, int status) {
+				if (status < 0) {
+					DEBUG_OUT("UVPipeCnxLayer::Open() error ..." << uv_strerror(status) << " layer " << id);
+					connectState = ConnectionState::NOT_CONNECTED;
+					DoOpenFailure(status, "pipe connect failed error %s\n", uv_strerror(status));
+					return;
+				}
+				connectState = ConnectionState::READY;
+				if (upper) upper->OnOpen();
+			},
+			[this](uv_stream_t *client, ssize_t nread, const uv_buf_t *buf) {
+				if (nread < 0) {
+					if (nread != UV_EOF) {
+						DoIOError(-1, "Read error %s\n", uv_strerror((int)nread));
+					} else {
+						worker.Close(this, [this] (uv_handle_t* h) {
+							connectState = ConnectionState::NOT_CONNECTED;
+							DoServerDisconnect(-1, "Unexpected end of file on uv read");
+						});
+					}
+					return;
+				} else if (nread > 0) {
+					if (upper) upper->Receive(buf->base, nread);
+				}
+			}
+		);
+	return 0;
+}
+
+int
+UVPipeCnxLayer::Write(const char *data, const size_t len)
+{
+	unsent += len;
+	std::shared_ptr<WriteCompletions> c = completions;
+	worker.Write(this, data, len, [c, len](int) {
+		c->Done(len);
+	});
+	return 0;
+}
+
+int
+UVPipeCnxLayer::WriteV(const CnxChunk *chunks, const size_t n)
+{
+	if (n > UVCnxLayer::kMaxGather) {
+		return CnxLayer::WriteV(chunks, n);
+	}
+	uv_buf_t bufs[UVCnxLayer::kMaxGather];
+	size_t len = 0;
+	for (size_t i=0; i<n; i++) {
+		bufs[i] = uv_buf_init((char*)chunks[i].data, (unsigned int)chunks[i].len);
+		len += chunks[i].len;
+	}
+	unsent += len;
+	std::shared_ptr<WriteCompletions> c = completions;
+	worker.Write(this, bufs, n, [c, len](int) {
+		c->Done(len);
+	});
+	return 0;
+}
+
+/**
+ * as for UVCnxLayer::Written()
+ */
+void
+UVPipeCnxLayer::Written(const size_t n)
+{
+	unsent -= n;
+	if (upper) upper->OnWritten();
+}
+
+int
+UVPipeCnxLayer::Close()
+{
+	DEBUG_OUT("UVPipeCnxLayer::Close" << " layer " << id);
+	if (connectState == ConnectionState::NOT_CONNECTED) {
+		return 0;
+	}
+	if (connectState == ConnectionState::DISCONNECTION_IN_PROGRESS) {
+		return kCloseOnClosedLayer;
+	}
+	connectState = ConnectionState::DISCONNECTION_IN_PROGRESS;
+	worker.Close(this, [this] (uv_handle_t* h) {
+		connectState = ConnectionState::NOT_CONNECTED;
+		if (upper) upper->OnClose();
+	});
+	return 0;
+}
@@ -11,29 +11,44 @@
 #include "uv.h"
 #include "UCLowerHeaders.h"
 #include "connector/UVConnection.h"
+#include "UVEventLoop.h"
 
 #include <ctype.h>
 
+extern UVEventLoop worker;
+
 
 /**
  * @class UVWSConnection UVConnection.h
- * @brief implements an unsecured WebSocket connection over a libuv raw tcp socket.
+ * @brief implements a WebSocket connection over a libuv raw tcp socket.
  * sets up two connected CnxLayers ... a websocket layer, which will talk to a uv layer ... the object using us will request stuff which we push to the ws layer which then
- * talks over uv.
+ * talks over uv. with SetSecure(), a TLSCnxLayer goes between the two
+ *
+ * connectState will be READY only once we have a correctly negotiated web socket, or, with SetFastOpen(), once the upgrade request is out
  *
- * connectState will be READY only once we have a correctly negotiated web socket
+ * sends go through the connection's SendQueue, which keeps no more than its write window unsent on the socket, and holds the rest
  */
 UVWSConnection::UVWSConnection(std::string service, std::string host)
 	: AbstractConnection(host, service)
 	, CnxLayerUpper()
 	, ws(this, &uv)
 	, uv(&ws, service, host)
+	, tls(&ws, &uv)
+	, pipe(&ws)
 {
 	SetHost(host);
 	SetService(service);
 	ConnectionPropertySet s;
 	s.insert(CONNECTION_PERSISTENT);
 	SetProperties(s);
+	sendQueue.Attach([this](const std::string& msg) {
+		return ws.Write(msg.c_str(), (size_t) msg.size());
+	}, [this]() {
+		return ws.GetUnsentBytes();
+	});
+	sendQueue.SetLoopThreadCheck([]() {
+		return worker.IsLoopThread();
+	});
 }
 
 UVWSConnection:: ~UVWSConnection()
@@ -48,13 +63,16 @@ UVWSConnection:: ~UVWSConnection()
 std::string
 UVWSConnection::LongName()
 {
-	return std::string("web socket at " + host + ":" + service);
+	return std::string((secure? "secure web socket at " : "web socket at ") + host + ":" + service);
 }
 
 std::string
 UVWSConnection::ShortName()
 {
-	return std::string("ws://" + host + ":" + service);
+	if (UVPipeCnxLayer::IsPipeEndpoint(host)) {
+		return std::string((secure? "wss+" : "ws+") + host);
+	}
+	return std::string((secure? "wss://" : "ws://") + host + ":" + service);
 }
 
 
@@ -65,7 +83,14 @@ UVWSConnection::ShortName()
 int
 UVWSConnection::Connect()
 {
-	return ws.Open();
+	connectState = ConnectionState::CONNECTION_IN_PROGRESS;
+	sendQueue.Clear();
+	Relink();
+	int r = ws.Open();
+	if (r < 0) {
+		connectState = ConnectionState::NOT_CONNECTED;
+	}
+	return r;
 }
 
 /**
@@ -77,6 +102,7 @@ UVWSConnection::Disconnect()
 	int r=0;
 	if (connectState != ConnectionState::DISCONNECTION_IN_PROGRESS && connectState != ConnectionState::NOT_CONNECTED) {
 		connectState = ConnectionState::DISCONNECTION_IN_PROGRESS;
+		sendQueue.Clear();
 		r = ws.Close();
 	}
 	return r;
@@ -88,8 +114,16 @@ UVWSConnection::Disconnect()
 int
 UVWSConnection::Send(const std::string msg)
 {
-	int r = ws.Write(msg.c_str(), (size_t) msg.size());
-	return r;
+	return sendQueue.Send(msg);
+}
+
+/**
+ * the socket has sent something, so there may be room for what's queued
+ */
+void
+UVWSConnection::OnWritten()
+{
+	sendQueue.Flush();
 }
 
 /**
@@ -117,6 +151,7 @@ UVWSConnection::OnOpen() {
 void
 UVWSConnection::OnClose() {
 	connectState = ConnectionState::NOT_CONNECTED;
+	sendQueue.Clear();
 	NxDisconnected(this);
 }
 
@@ -127,6 +162,7 @@ void
 UVWSConnection::OnOpenFailure(std::string msg, int status) {
 	DEBUG_OUT("UVWSConnection::OnOpenFailure" );
 	connectState = ConnectionState::NOT_CONNECTED;
+	sendQueue.Clear();
 	NxConnectFailure(this, msg, status);
 }
 
@@ -148,6 +184,7 @@ UVWSConnection::OnIOError(std::string msg, int status) {
  */
 void
 UVWSConnection::OnServerDisconnect(std::string msg, int status) {
+	sendQueue.Clear();
 	if (connectState == ConnectionState::DISCONNECTION_IN_PROGRESS) {
 		connectState = ConnectionState::NOT_CONNECTED;
 		NxDisconnected(this);
@@ -164,8 +201,15 @@ void
 UVWSConnection::SetHost(const std::string newHost) const
 {
 	host = newHost;
+	if (UVPipeCnxLayer::IsPipeEndpoint(host)) {
+		pipe.SetPath(UVPipeCnxLayer::PipePath(host));
+		ws.SetHost(UVPipeCnxLayer::kPipeHostHeader);
+		tls.SetHost(UVPipeCnxLayer::kPipeHostHeader);
+		return;
+	}
 	uv.SetHost(host);
 	ws.SetHost(host);
+	tls.SetHost(host);
 }
 
 /**
@@ -176,4 +220,92 @@ UVWSConnection::SetService(const std::string newService) const
 {
 	service = newService;
 	uv.SetService(service);
+	tls.SetService(service);
+}
+
+/**
+ * run the websocket over tls (wss), or not. takes effect on the next connect
+ * @param c where the tls sessions and settings come from, shared between connections by default so a reconnect resumes
+ */
+void
+UVWSConnection::SetSecure(const bool enable, std::shared_ptr<TLSContext> c)
+{
+	secure = enable;
+	tls.SetContext(c);
+	if (secure) {
+		properties.insert(CONNECTION_SECURE);
+	} else {
+		properties.erase(CONNECTION_SECURE);
+	}
+	Relink();
+}
+
+/**
+ * stack the layers for how we are set up: ws, then tls if secure, on a pipe for a unix: host, otherwise on tcp
+ */
+void
+UVWSConnection::Relink()
+{
+	CnxLayer* bottom = UVPipeCnxLayer::IsPipeEndpoint(host)? (CnxLayer*)&pipe : (CnxLayer*)&uv;
+	if (secure) {
+		ws.lower = &tls;
+		tls.upper = &ws;
+		tls.lower = bottom;
+		bottom->upper = &tls;
+	} else {
+		ws.lower = bottom;
+		bottom->upper = &ws;
+	}
+}
+
+/**
+ * offer permessage-deflate on the next connect
+ * @param enable whether to offer it
+ * @param threshold messages shorter than this go uncompressed
+ */
+void
+UVWSConnection::SetCompression(const bool enable, const size_t threshold)
+{
+	ws.SetCompression(enable, threshold);
+}
+
+/**
+ * @return compression ratio and time spent compressing on this connection
+ */
+const WSCnxLayer::CompressionStats&
+UVWSConnection::GetCompressionStats() const
+{
+	return ws.GetCompressionStats();
+}
+
+/**
+ * websocket ping, which is cheaper than a upc heartbeat and answered by the server's socket layer rather than its message loop
+ */
+int
+UVWSConnection::SendPing()
+{
+	return ws.SendPing();
+}
+
+/**
+ * @return round trip times from our websocket pings
+ */
+const RTTStats*
+UVWSConnection::GetRTTStats() const
+{
+	return &ws.GetRTTStats();
+}
+
+/**
+ * a second web socket to the same place, over the same kind of socket, with the same tls context and compression offer, for the connector
+ * to keep in reserve
+ */
+CnxRef
+UVWSConnection::NewStandby()
+{
+	UVWSConnection* s = new UVWSConnection(service, host);
+	s->ws.CopySettings(ws);
+	s->SetSecure(secure, tls.GetContext());
+	s->SetProperties(properties);
+	return s;
 }
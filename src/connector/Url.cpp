@@ -10,9 +10,72 @@
 #include <vector>
 #include <ctype.h>
 #include <connector/Url.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 Url Url::instance;
 
+/**
+ * what to do with each byte when encoding: 1 copies it as is, 2 is the space that becomes a '+', and 0 gets %xx escaped
+ */
+const char Url::kSafe[256] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0,
+	0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 1,
+	0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 1, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+/**
+ * and what each byte becomes
+ */
+static const char kEscaped[256][4] = {
+	"%00", "%01", "%02", "%03", "%04", "%05", "%06", "%07",
+	"%08", "%09", "%0a", "%0b", "%0c", "%0d", "%0e", "%0f",
+	"%10", "%11", "%12", "%13", "%14", "%15", "%16", "%17",
+	"%18", "%19", "%1a", "%1b", "%1c", "%1d", "%1e", "%1f",
+	"+", "%21", "%22", "%23", "%24", "%25", "%26", "%27",
+	"%28", "%29", "%2a", "%2b", "%2c", "-", ".", "%2f",
+	"0", "1", "2", "3", "4", "5", "6", "7",
+	"8", "9", "%3a", "%3b", "%3c", "%3d", "%3e", "%3f",
+	"%40", "A", "B", "C", "D", "E", "F", "G",
+	"H", "I", "J", "K", "L", "M", "N", "O",
+	"P", "Q", "R", "S", "T", "U", "V", "W",
+	"X", "Y", "Z", "%5b", "%5c", "%5d", "%5e", "_",
+	"%60", "a", "b", "c", "d", "e", "f", "g",
+	"h", "i", "j", "k", "l", "m", "n", "o",
+	"p", "q", "r", "s", "t", "u", "v", "w",
+	"x", "y", "z", "%7b", "%7c", "%7d", "~", "%7f",
+	"%80", "%81", "%82", "%83", "%84", "%85", "%86", "%87",
+	"%88", "%89", "%8a", "%8b", "%8c", "%8d", "%8e", "%8f",
+	"%90", "%91", "%92", "%93", "%94", "%95", "%96", "%97",
+	"%98", "%99", "%9a", "%9b", "%9c", "%9d", "%9e", "%9f",
+	"%a0", "%a1", "%a2", "%a3", "%a4", "%a5", "%a6", "%a7",
+	"%a8", "%a9", "%aa", "%ab", "%ac", "%ad", "%ae", "%af",
+	"%b0", "%b1", "%b2", "%b3", "%b4", "%b5", "%b6", "%b7",
+	"%b8", "%b9", "%ba", "%bb", "%bc", "%bd", "%be", "%bf",
+	"%c0", "%c1", "%c2", "%c3", "%c4", "%c5", "%c6", "%c7",
+	"%c8", "%c9", "%ca", "%cb", "%cc", "%cd", "%ce", "%cf",
+	"%d0", "%d1", "%d2", "%d3", "%d4", "%d5", "%d6", "%d7",
+	"%d8", "%d9", "%da", "%db", "%dc", "%dd", "%de", "%df",
+	"%e0", "%e1", "%e2", "%e3", "%e4", "%e5", "%e6", "%e7",
+	"%e8", "%e9", "%ea", "%eb", "%ec", "%ed", "%ee", "%ef",
+	"%f0", "%f1", "%f2", "%f3", "%f4", "%f5", "%f6", "%f7",
+	"%f8", "%f9", "%fa", "%fb", "%fc", "%fd", "%fe", "%ff",
+};
+
 Url::Url() {
 }
 
@@ -24,12 +87,6 @@ Hex2Char(char ch) {
   return isdigit(ch) ? ch - '0' : tolower(ch) - 'a' + 10;
 }
 
-char
-Char2Hex(char code) {
-	static char hex[] = "0123456789abcdef";
-	return hex[code & 15];
-}
-
 
 char*
 Url::Encode(const char *data,
@@ -47,10 +104,8 @@ Url::Decode(const char *data,
 
 std::string
 Url::Encode(std::string s){
-	size_t o;
-	char *p = instance._Encode(s.c_str(), s.size(), o);
-	std::string res(p, o);
-	delete []p;
+	std::string res;
+	AppendEncoded(res, s.data(), s.size());
 	return res;
 }
 std::string
@@ -67,23 +122,78 @@ Url::_Encode(
 		const char *data,
 		size_t inputLength,
 		size_t& outputLength) {
-	char *buf = new char[inputLength * 3 + 1];
-	char *pbuf = buf;
-	outputLength = inputLength;
-	for (size_t i=0; i<inputLength; i++) {
-		if (isalnum(data[i]) || data[i] == '-' || data[i] == '_' || data[i] == '.' || data[i] == '~') {
-			*pbuf++ = data[i];
-		} else if (data[i] == ' ') {
-			*pbuf++ = '+';
+	char *buf = new char[MaxEncodedLength(inputLength) + 1];
+	outputLength = Encode(data, inputLength, buf);
+	buf[outputLength]='\0';
+	return buf;
+}
+
+#if defined(__SSE2__)
+/**
+ * @return a bit for each of the 16 bytes at data that can go through unescaped
+ */
+static inline int
+SafeMask(const char *data)
+{
+	const __m128i v = _mm_loadu_si128((const __m128i*)data);
+	const __m128i l = _mm_or_si128(v, _mm_set1_epi8(0x20)); // folds A-Z onto a-z, and nothing else onto them. bytes over 0x7f stay negative and fail every test
+	__m128i ok = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0'-1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9'+1)));
+	ok = _mm_or_si128(ok, _mm_and_si128(_mm_cmpgt_epi8(l, _mm_set1_epi8('a'-1)), _mm_cmplt_epi8(l, _mm_set1_epi8('z'+1))));
+	ok = _mm_or_si128(ok, _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('-')), _mm_cmpeq_epi8(v, _mm_set1_epi8('_'))));
+	ok = _mm_or_si128(ok, _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('.')), _mm_cmpeq_epi8(v, _mm_set1_epi8('~'))));
+	return _mm_movemask_epi8(ok);
+}
+#endif
+
+/**
+ * puts c at p, escaped if need be. always writes 3 bytes, which is fine in a buffer of MaxEncodedLength(), as what comes next writes over the spare
+ */
+static inline char*
+Put(char *p, unsigned char c, const char *safe)
+{
+	memcpy(p, kEscaped[c], 3);
+	return p + (safe[c]? 1 : 3);
+}
+
+/**
+ * form encodes data straight into out, which must have room for MaxEncodedLength(inputLength). nothing is allocated. with sse2, a block of
+ * 16 that needs no escaping is copied as it is, and anything else goes a byte at a time through the tables, without branching
+ * @return the encoded length
+ */
+size_t
+Url::Encode(const char *data, size_t inputLength, char *out)
+{
+	const unsigned char *d = (const unsigned char*)data;
+	char *p = out;
+	size_t i = 0;
+#if defined(__SSE2__)
+	for (; i+16 <= inputLength; i+=16) {
+		if (SafeMask(data+i) == 0xffff) {
+			memcpy(p, data+i, 16);
+			p += 16;
 		} else {
-			*pbuf++ = '%';
-			*pbuf++ = Char2Hex(data[i] >> 4);
-			*pbuf++ = Char2Hex(data[i] & 0x0f);
-			outputLength += 2;
+			for (size_t j=i; j<i+16; j++) {
+				p = Put(p, d[j], kSafe);
+			}
 		}
 	}
-	*pbuf='\0';
-	return buf;
+#endif
+	for (; i<inputLength; i++) {
+		p = Put(p, d[i], kSafe);
+	}
+	return p - out;
+}
+
+/**
+ * form encodes data onto the end of out. with an out that is reused, and has grown to fit, this doesn't allocate either
+ */
+void
+Url::AppendEncoded(std::string& out, const char *data, size_t inputLength)
+{
+	size_t at = out.size();
+	out.resize(at + MaxEncodedLength(inputLength));
+	size_t n = Encode(data, inputLength, &out[at]);
+	out.resize(at + n);
 }
 
 char *
@@ -93,12 +203,11 @@ Url::_Decode(
 		size_t& outputLength) {
 	char* buf = new char[inputLength + 1];
 	char* pbuf = buf;
-	outputLength = inputLength;
 	for (size_t i=0; i<inputLength; i++) {
 		if (data[i] == '%') {
-			if (i<inputLength-2) {
+			if (i+2 < inputLength) {
 				*pbuf++ = Hex2Char(data[i+1]) << 4 | Hex2Char(data[i+2]);
-				outputLength -= 2;
+				i += 2;
 			}
 		} else if (data[i] == '+') {
 			*pbuf++ = ' ';
@@ -107,5 +216,6 @@ Url::_Decode(
 		}
 	}
 	*pbuf = '\0';
+	outputLength = pbuf - buf;
 	return buf;
 }
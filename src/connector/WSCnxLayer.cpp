@@ -5,10 +5,14 @@
  *      Author: dak
  */
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <random>
 
+#include <zlib.h>
+#include <uv.h>
+
 #include "UCLowerHeaders.h"
 #include "connector/WSCnxLayer.h"
 #include "connector/Base64.h"
@@ -22,19 +26,50 @@
  *
  * TODO if the frame is too short we should probably stash the bytes and see if there is an issue on the next
  * chunk of data from the lower layer ... I think it possible that ssl will split ws packets
+ *
+ * permessage-deflate (rfc 7692) is offered in the upgrade if SetCompression() is on, and used if the server accepts it. each connection
+ * keeps a streaming deflate and inflate context, reset per message if either side asks for no_context_takeover. messages shorter than the
+ * threshold go out uncompressed, as deflate only costs us there
+ *
+ * pings from the server are ponged straight back. SendPing() sends our own, carrying a uv_hrtime() stamp that the server has to echo in
+ * its pong, so the round trip comes back without us having to remember anything about pings in flight
+ *
+ * with SetFastOpen(), the layer above is told we're open as soon as the upgrade request is written, and whatever it sends then (the hello,
+ * and anything queued behind it) goes out as frames straight after the request, in the same flight, instead of a round trip later. what
+ * the server sends back ahead of the 101 is held in 'response' as usual, and frames that come in behind the 101 go to the frame parser. a
+ * server, or something in the way, that won't take frames before it has answered the upgrade gets an open failure, and fast open is turned
+ * off so that the reconnect goes the slow, safe way
  */
 const char *WSCnxLayer::WSGUID ="258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
 
+static const char kDeflateTail[] = { 0x00, 0x00, (char)0xff, (char)0xff };
+
 WSCnxLayer::WSCnxLayer(CnxLayerUpper* upper, CnxLayer* lower)
 	: CnxLayer(upper, lower)
 	, rxType(0)
+	, rxCompressed(false)
+	, deflateRequested(false)
+	, deflateThreshold(kDefaultDeflateThreshold)
+	, deflateWindowBits(15)
+	, maxMessageSize(kDefaultMaxMessageSize)
+	, requestClientNoContextTakeover(false)
+	, requestServerNoContextTakeover(false)
+	, deflateActive(false)
+	, deflateOutbound(false)
+	, clientNoContextTakeover(false)
+	, serverNoContextTakeover(false)
+	, deflater(nullptr)
+	, inflater(nullptr)
+	, firstPingSent(0)
+	, fastOpen(false)
+	, speculative(false)
 {
 
 }
 
 WSCnxLayer::~WSCnxLayer()
 {
-
+	EndDeflate();
 }
 
 int
@@ -50,10 +85,19 @@ WSCnxLayer::Open()
  */
 int
 WSCnxLayer::Write(const char *data, const size_t len) {
-	if (connectState != ConnectionState::READY) {
+	if (connectState != ConnectionState::READY && !speculative) {
 		if (upper) upper->OnIOError("send before web socket negotiated", -1);
 		return -1;
 	}
+	if (deflateOutbound) {
+		if (len >= deflateThreshold) {
+			if (Deflate(data, len)) {
+				return DoWSWrite(kWSTextData, deflated.data(), deflated.size(), true, true);
+			}
+		} else {
+			stats.messagesUnderThreshold++;
+		}
+	}
 	return DoWSWrite(kWSTextData, data, len, true);
 }
 
@@ -62,8 +106,10 @@ WSCnxLayer::Close() {
 	DEBUG_OUT("WSCnxLayer::Close()" );
 	if (connectState == ConnectionState::READY) {
 		connectState = ConnectionState::DISCONNECTION_IN_PROGRESS;
-		uint16_t s=1; // not especially worried about network byte order atm TODO
-		DoWSWrite(kWSCnxClose, (const char*)&s, 2, true);
+		DoWSClose(kWSCloseNormal);
+	} else if (speculative) {
+		connectState = ConnectionState::DISCONNECTION_IN_PROGRESS;
+		speculative = false;
 	}
 	int r = lower? lower->Close():0;
 	DEBUG_OUT("WSCnxLayer::Close() ok");
@@ -94,7 +140,12 @@ WSCnxLayer::Receive(const char *msgBytesThisFrame, const size_t nBytesThisFrame)
 //		DEBUG_OUT( "incoming response " << data );
 		response = response + data;
 		if (HTTP::IsCompleteResponse(response)) {
-			ProcessHTTPResponse(response);
+			std::string r = response;
+			response = "";
+			int n = ProcessHTTPResponse(r);
+			if (n > 0 && (size_t)n < r.size() && connectState == ConnectionState::READY) { // frames that came in right behind the 101
+				Receive(&r[n], r.size() - n);
+			}
 		}
 	} else {
 		int n=0;
@@ -117,8 +168,7 @@ WSCnxLayer::Receive(const char *msgBytesThisFrame, const size_t nBytesThisFrame)
 				// chunk of data from the lower layer ... I think it possible that ssl will split ws packets
 			} else {
 				DoIOError(-1, "websocket error processing frames, unexpected error");
-				uint16_t s=1; // not especially worried about network byte order atm TODO
-				DoWSWrite(kWSCnxClose, (const char*)&s, 2, true);
+				DoWSClose(n == kErrMessageTooBig? kWSCloseMessageTooBig : kWSCloseProtocolError);
 				if (lower) lower->Close();
 			}
 		}
@@ -138,18 +188,40 @@ WSCnxLayer::OnOpen()  {
 	connectState = ConnectionState::CONNECTION_IN_PROGRESS;
 	key = MakeWSKey();
 	response = "";
-	std::string msg = HTTP::Message( HTTP_METHOD_GET, host, resource, {
+	EndDeflate();
+	HTTP::Headers headers = {
 			{"Upgrade", "websocket"},
 			{"Connection","Upgrade"},
 			{"Sec-WebSocket-Key",key},
 			{"Sec-WebSocket-Version","13"}
-	});
+	};
+	if (deflateRequested) {
+		headers["Sec-WebSocket-Extensions"] = DeflateOffer();
+	}
+	std::string msg = HTTP::Message( HTTP_METHOD_GET, host, resource, headers);
 	lower->Write(msg.c_str(), msg.size());
+	if (fastOpen) {
+		speculative = true;
+		if (upper) upper->OnOpen();
+	}
 }
 
+/**
+ * a server that hangs up on a fast open before answering the upgrade has most likely choked on the frames behind the request, so that's a
+ * failed open, not a disconnect, and the next try is without
+ */
 void
 WSCnxLayer::OnClose()
 {
+	EndDeflate();
+	if (speculative && connectState == ConnectionState::CONNECTION_IN_PROGRESS) {
+		speculative = false;
+		fastOpen = false;
+		connectState = ConnectionState::NOT_CONNECTED;
+		if (upper) upper->OnOpenFailure("Server closed before websocket upgrade, fast open turned off", kErrWebsocketNotAccepted);
+		return;
+	}
+	speculative = false;
 	if (upper) upper->OnClose();
 }
 
@@ -182,32 +254,40 @@ WSCnxLayer::OnServerDisconnect(std::string msg, int status) {
 
 
 
-void
+/**
+ * check the answer to our upgrade request
+ * @return the length of the response headers, less than zero if the upgrade didn't happen
+ */
+int
 WSCnxLayer::ProcessHTTPResponse(const std::string& response)
 {
 	HTTP::Response r;
 	int res = HTTP::SplitResponseHeaders(response, r);
-	if (res < 0) {
-		DoIOError(-1, "Bad HTTP Response "+response);
-		if (upper) upper->OnOpenFailure("Bad HTTP Response, no message "+response, kErrInvalidHTTPResponse);
-		connectState = ConnectionState::NOT_CONNECTED;
-		if (lower) lower->Close();
-		return;
+	if (res >= 0 && r.responseCode !=  HTTP_RESPONSE_SWITCHING_PROTOCOLS) {
+		res = kErrWebsocketNotAccepted;
 	}
-	if (r.responseCode !=  HTTP_RESPONSE_SWITCHING_PROTOCOLS) {
-		DoIOError(-1, "Unfavourable HTTP Response "+r.statusMessage);
-		if (upper) upper->OnOpenFailure("Unfavourable HTTP Response "+r.statusMessage, kErrWebsocketNotAccepted);
+	if (res < 0) {
+		std::string msg = res == kErrWebsocketNotAccepted? "Unfavourable HTTP Response "+r.statusMessage : "Bad HTTP Response "+response;
+		DoIOError(-1, msg);
+		if (speculative) {
+			DEBUG_OUT("WSCnxLayer fast open refused, turning it off");
+			fastOpen = false;
+			msg += ", fast open turned off";
+		}
+		speculative = false;
 		connectState = ConnectionState::NOT_CONNECTED;
+		if (upper) upper->OnOpenFailure(msg, res == kErrWebsocketNotAccepted? kErrWebsocketNotAccepted : kErrInvalidHTTPResponse);
 		if (lower) lower->Close();
-		return;
-	}
-	auto it = r.headers.begin();
-	++it;
-	while (it != r.headers.end()) {
-		++it;
+		return res;
 	}
+	NegotiateDeflate(r);
 	connectState = ConnectionState::READY;
-	if (upper) upper->OnOpen();
+	if (speculative) { // the layer above has been open since the request went
+		speculative = false;
+	} else {
+		if (upper) upper->OnOpen();
+	}
+	return res;
 }
 
 
@@ -226,6 +306,7 @@ WSCnxLayer::ProcessWSRxFrame(char *msgBytes, const uint64_t msgLen)
 	if (msgLen < 2) {
 		return kErrFrameTooShort;
 	}
+	const unsigned char *header = (const unsigned char *)msgBytes;
 	bool isFinal = ((msgBytes[0]&0x80) != 0);
 	bool doMask = ((msgBytes[1]&0x80) != 0);
 	uint64_t dataLen=0;
@@ -236,21 +317,15 @@ WSCnxLayer::ProcessWSRxFrame(char *msgBytes, const uint64_t msgLen)
 			return kErrFrameTooShort;
 		}
 
-		dataLen |= (((uint64_t)msgBytes[2]) << 56);
-		dataLen |= (((uint64_t)msgBytes[3]) << 48);
-		dataLen |= (((uint64_t)msgBytes[4]) << 40);
-		dataLen |= (((uint64_t)msgBytes[5]) << 32);
-		dataLen |= (((uint64_t)msgBytes[6]) << 24);
-		dataLen |= (((uint64_t)msgBytes[7]) << 16);
-		dataLen |= (((uint64_t)msgBytes[8]) << 8);
-		dataLen |= (((uint64_t)msgBytes[9]));
+		for (int i=2; i<10; i++) {
+			dataLen = (dataLen << 8) | header[i];
+		}
 	} else if ((msgBytes[1] & 0x7f) == 126) {
 		headerLen += 4;
 		if (msgLen < headerLen) {
 			return kErrFrameTooShort;
 		}
-		dataLen |= (((unsigned char)msgBytes[2]) << 8);
-		dataLen |= (((unsigned char)msgBytes[3]));
+		dataLen = (header[2] << 8) | header[3];
 	} else {
 		headerLen += 2;
 		if (msgLen < headerLen) {
@@ -263,58 +338,70 @@ WSCnxLayer::ProcessWSRxFrame(char *msgBytes, const uint64_t msgLen)
 	}
 	char *msgData = msgBytes+headerLen;
 	if (doMask) {
-		char *masks = msgBytes + headerLen;
+		char *masks = msgData - 4;
 		for (unsigned i=0; i<dataLen; i++) {
 			msgData[i] ^= masks[i%4];
 		}
 	}
 	int msgType = msgBytes[0]&0x0f;
+	if ((msgType & 0x8) != 0 && (!isFinal || dataLen > kWSMaxControlPayload)) { // rfc 6455 5.5, control frames are short and never fragmented
+		DoIOError(kErrBadControlFrame, "websocket control frame is fragmented or too long");
+		return kErrBadControlFrame;
+	}
 	switch (msgType) {
 	case kWSContinue:
 	case kWSTextData:
 	case kWSBinaryData: {
 //		DEBUG_OUt("data frame " << msgLen);
+		if (msgType != kWSContinue) {
+			rxType = msgType;
+			rxCompressed = ((msgBytes[0]&kWSRsv1) != 0);
+			if (rxCompressed && !deflateActive) {
+				DoIOError(kErrInflate, "compressed websocket frame, but deflate was not negotiated");
+				return kErrInflate;
+			}
+		}
 		if (isFinal) {
+			const char *payload = msgData;
+			size_t payloadLen = (size_t)dataLen;
 			if (rxData.size() > 0) {
-				for (size_t i=0; i<dataLen; i++) {
-					rxData.push_back(msgData[i]);
-				}
-				if (rxType == kWSTextData) {
-					if (upper) {
-						upper->Receive(rxData.data(), (size_t)rxData.size());
-					}
+				rxData.insert(rxData.end(), msgData, msgData+dataLen);
+				payload = rxData.data();
+				payloadLen = rxData.size();
+			}
+			if (rxCompressed) {
+				int r = Inflate(payload, payloadLen);
+				if (r < 0) {
 					rxData.clear();
+					DoIOError(r, r == kErrMessageTooBig? "websocket message inflates past the size limit" : "websocket inflate failed");
+					return r;
 				}
-			} else {
-				if (msgType == kWSTextData) {
-					if (upper) {
-						upper->Receive(msgData,  (size_t)dataLen);
-					}
-					rxData.clear(); // just to be sure ...
+				payload = inflated.data();
+				payloadLen = inflated.size();
+			}
+			if (rxType == kWSTextData) {
+				if (upper) {
+					upper->Receive(payload, payloadLen);
 				}
 			}
+			rxData.clear();
 		} else {
 			if (msgType != kWSContinue) {
-				rxType = msgType;
 				rxData.assign(msgData, msgData+dataLen);
 			} else {
-				for (size_t i=0; i<dataLen; i++) {
-					rxData.push_back(msgData[i]);
-				}
+				rxData.insert(rxData.end(), msgData, msgData+dataLen);
 			}
 		}
 		break;
 	}
 	case kWSCnxClose: {
 //		DEBUG_OUT("close frame");
-		if (dataLen > 125) { // either someone hasn't read rfc6455, or we have screwed up royally
-		}
 		unsigned status = 0;
 		std::string reason;
 		if (dataLen >= 2) {
-			status = (msgData[0]<<8) | msgData[1];
+			status = (((unsigned char)msgData[0])<<8) | ((unsigned char)msgData[1]);
 			if (dataLen > 2) {
-				reason.assign(msgData, dataLen);
+				reason.assign(msgData+2, (size_t)dataLen-2);
 			}
 		}
 		if (connectState != ConnectionState::DISCONNECTION_IN_PROGRESS) { // we didn't generate this so we should do it politely
@@ -324,20 +411,15 @@ WSCnxLayer::ProcessWSRxFrame(char *msgBytes, const uint64_t msgLen)
 		}
 		break;
 	}
-	case kWSPing:  { // we are now morally and technically required to pong
+	case kWSPing:  { // we are now morally and technically required to pong, with the same application data
 //		DEBUG_OUT("ping frame");
-		if (dataLen > 125) { // either someone hasn't read rfc6455, or we have screwed up royally
-// TODO double check whether it would be better to pong straight away, or wait until a more relaxed opportunity, like when we get out of this callback
-			DoWSWrite(kWSPong, msgData, dataLen, true);
-		}
+		DoWSWrite(kWSPong, msgData, dataLen, true);
 		break;
 	}
 
 	case kWSPong: { // we have pinged, and all is ok
 //		DEBUG_OUT("pong frame");
-		if (dataLen > 125) { // either someone hasn't read rfc6455, or we have screwed up royally
-
-		}
+		OnPong(msgData, dataLen);
 		break;
 	}
 	default: {
@@ -356,9 +438,10 @@ WSCnxLayer::ProcessWSRxFrame(char *msgBytes, const uint64_t msgLen)
  * @param msg the message
  * @param length it's length
  * @param doMask if we need to mask the data ... which we must on client side
+ * @param compressed sets rsv1, marking msg as a permessage-deflate payload
  */
 int
-WSCnxLayer::DoWSWrite(const int msgType, const char *msg, const uint64_t len, const bool doMask)
+WSCnxLayer::DoWSWrite(const int msgType, const char *msg, const uint64_t len, const bool doMask, const bool compressed)
 {
 	char *msgBytes;
 	size_t msgLen = len;
@@ -388,7 +471,7 @@ WSCnxLayer::DoWSWrite(const int msgType, const char *msg, const uint64_t len, co
 			msgData[i] ^= masks[i%4];
 		}
 	}
-	msgBytes[0] = msgType|0x80; // final fragment of text
+	msgBytes[0] = msgType|0x80|(compressed?kWSRsv1:0); // final fragment of text
 	if (headerLen == 2) {
 		msgBytes[1] = (char)(len|(doMask?0x80:0));
 	} else if (headerLen == 4) {
@@ -412,6 +495,68 @@ WSCnxLayer::DoWSWrite(const int msgType, const char *msg, const uint64_t len, co
 	return (int)n;
 }
 
+/**
+ * send a close frame
+ * @param status the close status code, which goes in network byte order
+ */
+int
+WSCnxLayer::DoWSClose(const uint16_t status)
+{
+	char s[2] = { (char)(status >> 8), (char)(status & 0xff) };
+	return DoWSWrite(kWSCnxClose, s, 2, true);
+}
+
+/**
+ * send a ping, with the current uv_hrtime() as its 8 byte payload, for OnPong() to take the round trip from
+ * @return the number of bytes written, less than zero if the socket isn't open
+ */
+int
+WSCnxLayer::SendPing()
+{
+	if (connectState != ConnectionState::READY) {
+		return -1;
+	}
+	uint64_t now = uv_hrtime();
+	char stamp[8];
+	for (int i=0; i<8; i++) {
+		stamp[i] = (char)((now >> (56 - 8*i)) & 0xff);
+	}
+	if (firstPingSent == 0) {
+		firstPingSent = now;
+	}
+	return DoWSWrite(kWSPing, stamp, 8, true);
+}
+
+/**
+ * a pong to one of our pings carries back the stamp we sent. anything else (an unsolicited pong, or one from a server that doesn't echo
+ * the payload) has no business looking like a time we could have sent, and is ignored
+ */
+void
+WSCnxLayer::OnPong(const char *data, const uint64_t len)
+{
+	if (len != 8 || firstPingSent == 0) {
+		return;
+	}
+	uint64_t sent = 0;
+	for (int i=0; i<8; i++) {
+		sent = (sent << 8) | (unsigned char)data[i];
+	}
+	uint64_t now = uv_hrtime();
+	if (sent < firstPingSent || sent > now) {
+		return;
+	}
+	rtt.Add((now - sent) / 1000);
+}
+
+/**
+ * @return round trip times, in microseconds, from our pings
+ */
+const RTTStats&
+WSCnxLayer::GetRTTStats() const
+{
+	return rtt;
+}
+
 std::string
 WSCnxLayer::MakeWSKey() const
 {
@@ -436,3 +581,307 @@ WSCnxLayer::SetResource(const std::string r) const
 {
 	resource = r;
 }
+
+/**
+ * offer permessage-deflate in the upgrade request. needs to be set before the connection opens
+ * @param enable whether to offer it
+ * @param threshold messages shorter than this are sent uncompressed
+ */
+void
+WSCnxLayer::SetCompression(const bool enable, const size_t threshold)
+{
+	deflateRequested = enable;
+	deflateThreshold = threshold;
+}
+
+/**
+ * @param bits the largest deflate window we will use, 9 to 15. smaller saves memory on both ends, at some cost in compression
+ */
+void
+WSCnxLayer::SetCompressionWindowBits(const int bits)
+{
+	deflateWindowBits = bits < 9? 9 : bits > 15? 15 : bits;
+}
+
+/**
+ * @param bytes the most a compressed message may inflate to. past that, the connection is closed with 1009, message too big
+ */
+void
+WSCnxLayer::SetMaxMessageSize(const size_t bytes)
+{
+	maxMessageSize = bytes;
+}
+
+/**
+ * take the resource and the compression we offer from another layer, for a second connection to the same place
+ */
+void
+WSCnxLayer::CopySettings(const WSCnxLayer& from)
+{
+	resource = from.resource;
+	deflateRequested = from.deflateRequested;
+	deflateThreshold = from.deflateThreshold;
+	deflateWindowBits = from.deflateWindowBits;
+	maxMessageSize = from.maxMessageSize;
+	requestClientNoContextTakeover = from.requestClientNoContextTakeover;
+	requestServerNoContextTakeover = from.requestServerNoContextTakeover;
+	fastOpen = from.fastOpen;
+}
+
+/**
+ * send frames right behind the upgrade request, without waiting on the 101. this saves a round trip on every connect, but needs a server
+ * (and whatever proxies are in the way) that will take frames that were sent ahead of its answer. off by default. a refused fast open turns
+ * it off again
+ */
+void
+WSCnxLayer::SetFastOpen(const bool enable)
+{
+	fastOpen = enable;
+}
+
+/**
+ * @return true if the next connect will be a fast open
+ */
+bool
+WSCnxLayer::IsFastOpen() const
+{
+	return fastOpen;
+}
+
+/**
+ * ask for the compression context to be dropped after every message
+ * @param client on our side, which saves the deflate window between messages
+ * @param server on the server side, ditto for our inflate window
+ */
+void
+WSCnxLayer::SetNoContextTakeover(const bool client, const bool server)
+{
+	requestClientNoContextTakeover = client;
+	requestServerNoContextTakeover = server;
+}
+
+/**
+ * @return true if permessage-deflate was negotiated on the current connection
+ */
+bool
+WSCnxLayer::IsCompressing() const
+{
+	return deflateActive;
+}
+
+/**
+ * @return the permessage-deflate counters
+ */
+const WSCnxLayer::CompressionStats&
+WSCnxLayer::GetCompressionStats() const
+{
+	return stats;
+}
+
+/**
+ * @return our permessage-deflate offer for the Sec-WebSocket-Extensions header
+ */
+std::string
+WSCnxLayer::DeflateOffer() const
+{
+	std::string offer = "permessage-deflate; client_max_window_bits";
+	if (deflateWindowBits < 15) {
+		offer += "=" + std_to_string(deflateWindowBits);
+	}
+	if (requestClientNoContextTakeover) {
+		offer += "; client_no_context_takeover";
+	}
+	if (requestServerNoContextTakeover) {
+		offer += "; server_no_context_takeover";
+	}
+	return offer;
+}
+
+/**
+ * look for the server's acceptance of permessage-deflate in the upgrade response, and set up zlib to suit if it's there
+ */
+void
+WSCnxLayer::NegotiateDeflate(const HTTP::Response& r)
+{
+	EndDeflate();
+	if (!deflateRequested) {
+		return;
+	}
+	std::string extensions;
+	for (auto it: r.headers) {
+		std::string k = it.first;
+		for (auto &c: k) c = tolower(c);
+		if (k == "sec-websocket-extensions") {
+			extensions = it.second;
+			break;
+		}
+	}
+	std::string accepted;
+	std::stringstream ext(extensions);
+	while (std::getline(ext, accepted, ',')) {
+		accepted.erase(0, accepted.find_first_not_of(" \t"));
+		if (accepted.compare(0, 18, "permessage-deflate") == 0) {
+			break;
+		}
+		accepted.clear();
+	}
+	if (accepted.empty()) {
+		return;
+	}
+	int windowBits = deflateWindowBits;
+	clientNoContextTakeover = requestClientNoContextTakeover;
+	serverNoContextTakeover = false;
+	deflateOutbound = true;
+	std::string param;
+	std::stringstream params(accepted);
+	std::getline(params, param, ';');
+	while (std::getline(params, param, ';')) {
+		param.erase(0, param.find_first_not_of(" \t"));
+		param.erase(param.find_last_not_of(" \t")+1);
+		std::string value;
+		size_t eq = param.find('=');
+		if (eq != std::string::npos) {
+			value = param.substr(eq+1);
+			param.erase(eq);
+			if (value.size() > 1 && value.front() == '"') value = value.substr(1, value.size()-2);
+		}
+		if (param == "client_no_context_takeover") {
+			clientNoContextTakeover = true;
+		} else if (param == "server_no_context_takeover") {
+			serverNoContextTakeover = true;
+		} else if (param == "client_max_window_bits") {
+			int bits = value.empty()? 15 : atoi(value.c_str()); // rfc 7692 7.1.2.2, with no value it's only saying it could take one
+			if (bits < 9) { // zlib can't do an 8 bit raw deflate window ... we can still inflate, but send plain
+				deflateOutbound = false;
+			} else if (bits < windowBits) {
+				windowBits = bits;
+			}
+		}
+	}
+
+	deflater = new z_stream;
+	memset(deflater, 0, sizeof(z_stream));
+	inflater = new z_stream;
+	memset(inflater, 0, sizeof(z_stream));
+	if (deflateInit2(deflater, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK
+			|| inflateInit2(inflater, -15) != Z_OK) {
+		DoIOError(kErrInflate, "zlib failed to initialise, websocket compression disabled");
+		EndDeflate();
+		return;
+	}
+	deflateActive = true;
+	DEBUG_OUT("permessage-deflate negotiated: " << accepted);
+}
+
+/**
+ * compress a message into 'deflated', stripping the sync flush tail as rfc 7692 requires
+ */
+bool
+WSCnxLayer::Deflate(const char *data, const size_t len)
+{
+	auto start = std::chrono::steady_clock::now();
+	deflated.resize(deflateBound(deflater, (uLong)len) + 16);
+	deflater->next_in = (Bytef*)data;
+	deflater->avail_in = (uInt)len;
+	size_t out = 0;
+	int r;
+	do {
+		if (out == deflated.size()) {
+			deflated.resize(deflated.size()*2);
+		}
+		deflater->next_out = (Bytef*)deflated.data() + out;
+		deflater->avail_out = (uInt)(deflated.size() - out);
+		r = deflate(deflater, Z_SYNC_FLUSH);
+		out = deflated.size() - deflater->avail_out;
+	} while (r == Z_OK && deflater->avail_out == 0);
+	if (r != Z_OK && r != Z_BUF_ERROR) {
+		deflateReset(deflater);
+		return false;
+	}
+	if (out >= 4 && memcmp(deflated.data()+out-4, kDeflateTail, 4) == 0) {
+		out -= 4;
+	}
+	deflated.resize(out);
+	if (clientNoContextTakeover) {
+		deflateReset(deflater);
+	}
+	stats.messagesDeflated++;
+	stats.rawBytesOut += len;
+	stats.wireBytesOut += out;
+	stats.deflateNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	return true;
+}
+
+/**
+ * decompress a message into inflated, feeding in the sync flush tail that the sender stripped
+ * @return 0, or kErrInflate if it won't, or kErrMessageTooBig if it comes to more than maxMessageSize
+ */
+int
+WSCnxLayer::Inflate(const char *data, const size_t len)
+{
+	auto start = std::chrono::steady_clock::now();
+	if (inflated.size() < len*4 + 64) {
+		inflated.resize(len*4 + 64);
+	} else {
+		inflated.resize(inflated.capacity());
+	}
+	size_t out = 0;
+	const char *in[] = { data, kDeflateTail };
+	size_t inLen[] = { len, 4 };
+	for (int i=0; i<2; i++) {
+		inflater->next_in = (Bytef*)in[i];
+		inflater->avail_in = (uInt)inLen[i];
+		int r;
+		do {
+			if (out > maxMessageSize) {
+				inflateReset(inflater);
+				return kErrMessageTooBig;
+			}
+			if (out == inflated.size()) {
+				inflated.resize(std::min(inflated.size()*2, maxMessageSize+1));
+			}
+			inflater->next_out = (Bytef*)inflated.data() + out;
+			inflater->avail_out = (uInt)(inflated.size() - out);
+			r = inflate(inflater, Z_SYNC_FLUSH);
+			out = inflated.size() - inflater->avail_out;
+		} while (r == Z_OK && (inflater->avail_in > 0 || inflater->avail_out == 0));
+		if (r != Z_OK && r != Z_BUF_ERROR && r != Z_STREAM_END) {
+			inflateReset(inflater);
+			return kErrInflate;
+		}
+	}
+	if (out > maxMessageSize) {
+		inflateReset(inflater);
+		return kErrMessageTooBig;
+	}
+	inflated.resize(out);
+	if (serverNoContextTakeover) {
+		inflateReset(inflater);
+	}
+	stats.messagesInflated++;
+	stats.rawBytesIn += out;
+	stats.wireBytesIn += len;
+	stats.inflateNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	return 0;
+}
+
+/**
+ * drop the zlib contexts, if any
+ */
+void
+WSCnxLayer::EndDeflate()
+{
+	if (deflater != nullptr) {
+		deflateEnd(deflater);
+		delete deflater;
+		deflater = nullptr;
+	}
+	if (inflater != nullptr) {
+		inflateEnd(inflater);
+		delete inflater;
+		inflater = nullptr;
+	}
+	deflateActive = false;
+	deflateOutbound = false;
+	rxCompressed = false;
+}
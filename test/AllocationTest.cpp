@@ -0,0 +1,178 @@
+#include <cstdlib>
+#include <atomic>
+#include <new>
+#include <gtest/gtest.h>
+#ifndef _MSC_VER
+#include <unistd.h>
+#endif
+
+#include "uv.h"
+#include "CommonTypes.h"
+#include "Notifier.h"
+#include "UVEventLoop.h"
+
+/*
+ * global operator new is swapped out for one that counts while 'counting' is set, so we can check that the steady state paths stay off the heap
+ */
+static std::atomic<long> allocations(0);
+static std::atomic<bool> counting(false);
+
+void* operator new(std::size_t n) {
+	if (counting) allocations++;
+	void *p = std::malloc(n > 0 ? n : 1);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+/*
+ * gcc inlines these into new/delete expressions and then sees free() on what came from operator new, not knowing it's our malloc() underneath
+ */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpragmas"
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+	std::free(p);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+static void StartCounting() {
+	allocations = 0;
+	counting = true;
+}
+
+static long StopCounting() {
+	counting = false;
+	return allocations;
+}
+
+static void Nap(int ms) {
+#ifdef _MSC_VER
+	Sleep(ms);
+#else
+	usleep(ms*1000);
+#endif
+}
+
+TEST(Allocation, InlineFunctionKeepsCapturesInline) {
+	int a=1, b=2, c=3;
+	int sum=0;
+	StartCounting();
+	InlineFunction<void(int)> f([&a, &b, &c, &sum](int d) {
+		sum = a + b + c + d;
+	});
+	InlineFunction<void(int)> g(std::move(f));
+	g(4);
+	long n = StopCounting();
+	EXPECT_FALSE(f);
+	EXPECT_TRUE((bool)g);
+	EXPECT_EQ(10, sum);
+	EXPECT_EQ(0, n);
+}
+
+TEST(Allocation, InlineFunctionFromEmptyFunctionIsEmpty) {
+	std::function<void()> empty;
+	TimerCB cb(empty);
+	EXPECT_FALSE(cb);
+}
+
+TEST(Allocation, NotifyInSteadyState) {
+	Notifier<int, UPCStatus> notifier;
+	int total = 0;
+	std::vector<std::shared_ptr<NXR<int, UPCStatus>::CB>> handles;
+	for (int i=0; i<8; i++) {
+		handles.push_back(notifier.AddEventListener(1, [&total](EventType, int v, UPCStatus) {
+			total += v;
+		}));
+	}
+	notifier.NotifyListeners(1, 1, 0);
+
+	StartCounting();
+	for (int i=0; i<1000; i++) {
+		notifier.NotifyListeners(1, 1, 0);
+	}
+	long n = StopCounting();
+
+	EXPECT_EQ(8*1001, total);
+	EXPECT_EQ(0, n);
+}
+
+TEST(Allocation, DispatchInSteadyState) {
+	Dispatcher<int> dispatcher;
+	int total = 0;
+	auto handle = dispatcher.AddEventListener(1, [&total](EventType, int v) {
+		total += v;
+	});
+	for (int i=0; i<2; i++) { // the pending and processing queues swap, so both need sizing
+		dispatcher.DispatchEvent(1, 1);
+		dispatcher.ProcessDispatches();
+	}
+
+	StartCounting();
+	for (int i=0; i<1000; i++) {
+		dispatcher.DispatchEvent(1, 1);
+		dispatcher.ProcessDispatches();
+	}
+	long n = StopCounting();
+
+	EXPECT_EQ(1002, total);
+	EXPECT_EQ(0, n);
+}
+
+TEST(Allocation, ScheduleInSteadyState) {
+	static const int kTimersPerRound = 16;
+	UVEventLoop loop;
+	std::atomic<int> fired(0);
+
+	auto round = [&loop, &fired]() {
+		fired = 0;
+		for (int i=0; i<kTimersPerRound; i++) {
+			loop.Schedule(0, 0, [&fired]() {
+				fired++;
+			});
+		}
+		for (int wait=0; wait<1000 && fired < kTimersPerRound; wait++) {
+			Nap(1);
+		}
+		Nap(10); // let the loop recycle the one shot records
+	};
+	round(); // fills the free list and sizes the queues
+
+	StartCounting();
+	for (int i=0; i<10; i++) {
+		round();
+	}
+	long n = StopCounting();
+
+	EXPECT_EQ(kTimersPerRound, fired);
+	EXPECT_EQ(0, n);
+}
+
+TEST(Allocation, StaleTimerRefCancelsNothing) {
+	UVEventLoop loop;
+	std::atomic<int> first(0), second(0);
+	TimerRef stale = loop.Schedule(0, 0, [&first]() {
+		first++;
+	});
+	for (int wait=0; wait<1000 && first == 0; wait++) {
+		Nap(1);
+	}
+	Nap(10); // let the loop recycle the record
+	TimerRef current = loop.Schedule(20, 0, [&second]() {
+		second++;
+	});
+	EXPECT_EQ(stale.timer, current.timer); // the same record, on its next use
+	loop.CancelTimer(stale);
+	for (int wait=0; wait<1000 && second == 0; wait++) {
+		Nap(1);
+	}
+	EXPECT_EQ(1, first);
+	EXPECT_EQ(1, second);
+}
@@ -0,0 +1,208 @@
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "connector/Base64.h"
+
+/*
+ * the codec as it was, a byte at a time into new[] buffers, to check against and to race
+ */
+static std::string
+ByteAtATimeEncode(const unsigned char *data, size_t len)
+{
+	static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	static const int mods[] = { 0, 2, 1 };
+	size_t outLen = 4 * ((len + 2) / 3);
+	char *buf = new char[outLen];
+	for (size_t i = 0, j = 0; i < len;) {
+		uint32_t a = i < len ? data[i++] : 0;
+		uint32_t b = i < len ? data[i++] : 0;
+		uint32_t c = i < len ? data[i++] : 0;
+		uint32_t triple = (a << 0x10) + (b << 0x08) + c;
+		buf[j++] = table[(triple >> 3 * 6) & 0x3F];
+		buf[j++] = table[(triple >> 2 * 6) & 0x3F];
+		buf[j++] = table[(triple >> 1 * 6) & 0x3F];
+		buf[j++] = table[(triple >> 0 * 6) & 0x3F];
+	}
+	for (int i = 0; i < mods[len % 3]; i++) buf[outLen - 1 - i] = '=';
+	std::string r(buf, outLen);
+	delete []buf;
+	return r;
+}
+
+static std::vector<unsigned char>
+ByteAtATimeDecode(const std::string& s)
+{
+	static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	char decoding[256] = { 0 };
+	for (int i = 0; i < 64; i++) decoding[(unsigned char)table[i]] = i;
+	size_t len = s.size();
+	size_t outLen = len / 4 * 3;
+	if (s[len - 1] == '=') outLen--;
+	if (s[len - 2] == '=') outLen--;
+	unsigned char *buf = new unsigned char[outLen];
+	for (size_t i = 0, j = 0; i < len;) {
+		uint32_t a = s[i] == '=' ? 0 & i++ : decoding[(unsigned char)s[i++]];
+		uint32_t b = s[i] == '=' ? 0 & i++ : decoding[(unsigned char)s[i++]];
+		uint32_t c = s[i] == '=' ? 0 & i++ : decoding[(unsigned char)s[i++]];
+		uint32_t d = s[i] == '=' ? 0 & i++ : decoding[(unsigned char)s[i++]];
+		uint32_t triple = (a << 3 * 6) + (b << 2 * 6) + (c << 1 * 6) + (d << 0 * 6);
+		if (j < outLen) buf[j++] = (triple >> 2 * 8) & 0xFF;
+		if (j < outLen) buf[j++] = (triple >> 1 * 8) & 0xFF;
+		if (j < outLen) buf[j++] = (triple >> 0 * 8) & 0xFF;
+	}
+	std::vector<unsigned char> r(buf, buf + outLen);
+	delete []buf;
+	return r;
+}
+
+static std::vector<std::string>
+Engines()
+{
+	std::vector<std::string> engines;
+	std::string was = Base64::Engine();
+	for (auto e: { "scalar", "ssse3", "avx2", "neon" }) {
+		if (Base64::SetEngine(e)) engines.push_back(e);
+	}
+	Base64::SetEngine(was);
+	return engines;
+}
+
+static int
+StrictDecode(const std::string& s, std::vector<unsigned char>& out, Base64::DecodeMode mode=Base64::STRICT)
+{
+	out.resize(Base64::MaxDecodedLength(s.size()));
+	size_t n = 0;
+	int err = Base64::Decode(s.data(), s.size(), out.data(), out.size(), n, mode);
+	out.resize(n);
+	return err;
+}
+
+TEST(Base64, RoundTripsOnEveryEngine) {
+	std::string was = Base64::Engine();
+	for (auto engine: Engines()) {
+		ASSERT_TRUE(Base64::SetEngine(engine));
+		std::mt19937 rng(45);
+		for (int i=0; i<3000; i++) {
+			size_t len = (i < 200)? i : rng()%2000;
+			std::vector<unsigned char> data(len);
+			for (auto& b: data) b = rng();
+			std::string expect = ByteAtATimeEncode(data.data(), len);
+
+			std::string enc(Base64::EncodedLength(len), '\0');
+			ASSERT_EQ(enc.size(), Base64::Encode(data.data(), len, &enc[0]));
+			ASSERT_EQ(expect, enc) << engine << " length " << len;
+			ASSERT_EQ(Base64::DecodedLength(enc.data(), enc.size()), len);
+
+			std::vector<unsigned char> dec(len);
+			size_t n = 0;
+			ASSERT_EQ(0, Base64::Decode(enc.data(), enc.size(), dec.data(), dec.size(), n)) << engine << " length " << len;
+			ASSERT_EQ(len, n);
+			ASSERT_EQ(data, dec) << engine << " length " << len;
+			if (len > 0) {
+				ASSERT_EQ(data, ByteAtATimeDecode(enc));
+				ASSERT_EQ(Base64::kErrNoRoom, Base64::Decode(enc.data(), enc.size(), dec.data(), len-1, n)) << engine << " length " << len;
+			}
+
+			// a bad character anywhere, so it turns up in a simd block as well as in the tail
+			if (len > 0) {
+				std::string bad = enc;
+				bad[rng()%bad.size()] = "!*-_\x80 \n."[rng()%8];
+				ASSERT_EQ(Base64::kErrInvalid, StrictDecode(bad, dec)) << engine << " " << bad;
+			}
+		}
+	}
+	Base64::SetEngine(was);
+}
+
+TEST(Base64, StrictAndLenient) {
+	std::string was = Base64::Engine();
+	std::vector<unsigned char> out;
+	const std::string hello = "hello, world";
+	for (auto engine: Engines()) {
+		ASSERT_TRUE(Base64::SetEngine(engine));
+		EXPECT_EQ(0, StrictDecode("aGVsbG8sIHdvcmxk", out));
+		EXPECT_EQ(hello, std::string(out.begin(), out.end()));
+		EXPECT_EQ(0, StrictDecode("", out));
+		EXPECT_TRUE(out.empty());
+
+		for (std::string s: { "Zg", "Zm8", "Zg=", "Zg===", "Z===", "Zh==", "Zm9=", "Zg==Zg==", "=Zg=", "Zm9v\nYmFy", " Zm9v", "Z", "Zm9vY" }) {
+			EXPECT_EQ(Base64::kErrInvalid, StrictDecode(s, out)) << engine << " " << s;
+		}
+		EXPECT_EQ(0, StrictDecode("Zg", out, Base64::LENIENT));
+		EXPECT_EQ("f", std::string(out.begin(), out.end()));
+		EXPECT_EQ(0, StrictDecode("Zm8", out, Base64::LENIENT));
+		EXPECT_EQ("fo", std::string(out.begin(), out.end()));
+		EXPECT_EQ(0, StrictDecode("Zh==", out, Base64::LENIENT));
+		EXPECT_EQ("f", std::string(out.begin(), out.end()));
+		EXPECT_EQ(0, StrictDecode(" Zm9v\r\nYmFy\tYmF6 ", out, Base64::LENIENT));
+		EXPECT_EQ("foobarbaz", std::string(out.begin(), out.end()));
+		for (std::string s: { "Zg===", "Z===", "Zg==Zg==", "Z", "Zm9vY", "Zm9v!" }) {
+			EXPECT_EQ(Base64::kErrInvalid, StrictDecode(s, out, Base64::LENIENT)) << engine << " " << s;
+		}
+
+		// mime style line breaks every 76 characters through a long payload
+		std::vector<unsigned char> data(5000);
+		for (size_t i=0; i<data.size(); i++) data[i] = i * 7;
+		std::string enc = Base64::Encode(data.data(), data.size());
+		std::string wrapped;
+		for (size_t i=0; i<enc.size(); i+=76) wrapped += enc.substr(i, 76) + "\r\n";
+		EXPECT_EQ(Base64::kErrInvalid, StrictDecode(wrapped, out));
+		EXPECT_EQ(0, StrictDecode(wrapped, out, Base64::LENIENT));
+		EXPECT_EQ(data, out);
+	}
+	Base64::SetEngine(was);
+
+	// and the old allocating calls, which are lenient, and no longer leak
+	size_t n = 0;
+	unsigned char* p = Base64::Decode((const unsigned char*)"aGVsbG8sIHdvcmxk", 16, n);
+	ASSERT_NE(nullptr, p);
+	EXPECT_EQ(hello, std::string((char*)p, n));
+	delete []p;
+	EXPECT_EQ(nullptr, Base64::Decode((const unsigned char*)"a!==", 4, n));
+	EXPECT_TRUE(Base64::Decode((const unsigned char*)"a!==", 4).empty());
+}
+
+TEST(Base64, Benchmark) {
+	std::string was = Base64::Engine();
+	std::mt19937 rng(3);
+	std::vector<unsigned char> data(256*1024);
+	for (auto& b: data) b = rng();
+	std::string enc(Base64::EncodedLength(data.size()), '\0');
+	std::vector<unsigned char> dec(data.size());
+	const int rounds = 40;
+	size_t sink = 0;
+	typedef std::chrono::steady_clock clock;
+	auto mbs = [&](clock::time_point start, size_t bytes) {
+		return rounds*bytes/(1024.0*1024.0)/std::chrono::duration<double>(clock::now() - start).count();
+	};
+
+	auto start = clock::now();
+	for (int r=0; r<rounds; r++) sink += ByteAtATimeEncode(data.data(), data.size()).size();
+	double oldEncode = mbs(start, data.size());
+	std::string oldEnc = ByteAtATimeEncode(data.data(), data.size());
+	start = clock::now();
+	for (int r=0; r<rounds; r++) sink += ByteAtATimeDecode(oldEnc).size();
+	double oldDecode = mbs(start, data.size());
+	std::cout << "before: encode " << oldEncode << "MB/s, decode " << oldDecode << "MB/s" << std::endl;
+
+	for (auto engine: Engines()) {
+		Base64::SetEngine(engine);
+		start = clock::now();
+		for (int r=0; r<rounds; r++) sink += Base64::Encode(data.data(), data.size(), &enc[0]);
+		double encode = mbs(start, data.size());
+		size_t n = 0;
+		start = clock::now();
+		for (int r=0; r<rounds; r++) {
+			Base64::Decode(enc.data(), enc.size(), dec.data(), dec.size(), n);
+			sink += n;
+		}
+		double decode = mbs(start, data.size());
+		EXPECT_EQ(data, dec);
+		std::cout << engine << ": encode " << encode << "MB/s, decode " << decode << "MB/s" << std::endl;
+	}
+	Base64::SetEngine(was);
+	EXPECT_GT(sink, 0u);
+}
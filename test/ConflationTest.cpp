@@ -0,0 +1,148 @@
+#include <map>
+#include <random>
+#include <gtest/gtest.h>
+
+#include "CommonTypes.h"
+#include "UCUpperHeaders.h"
+#include "UCLowerHeaders.h"
+
+/*
+ * a DispatchUPC with the same conflation stage as the UnionBridge, and listeners that keep a model of the client and room state
+ */
+class ConflatingDispatcher: public DispatchUPC {
+public:
+	UPCConflator conflator;
+protected:
+	virtual void PrepareDispatches(std::vector<ER>& batch) override {
+		conflator.Conflate(batch);
+	}
+};
+
+struct StateModel {
+	std::map<std::string, std::string> state;
+	std::vector<std::string> others; // everything that can't be conflated, in the order it was seen
+
+	void Listen(ConflatingDispatcher& d, std::vector<CBUPCRef>& handles) {
+		auto attr = [this](EventType t, const StringArgs& a, UPCStatus) {
+			state[UPCConflator::Key(t, a)] = t == 8? a[4]: a[3];
+		};
+		auto count = [this](EventType t, const StringArgs& a, UPCStatus) {
+			state[UPCConflator::Key(t, a)] = a[1];
+		};
+		auto removed = [this](EventType t, const StringArgs& a, UPCStatus) { // CLIENT_ATTR_REMOVED: scope, client, user, name
+			state.erase(UPCConflator::Key(8, {a[0], a[1], a[2], a[3], "", "0"}));
+			others.push_back(a[0]+a[1]+a[3]);
+		};
+		auto other = [this](EventType t, const StringArgs& a, UPCStatus) {
+			others.push_back(a[0]);
+		};
+		handles.push_back(d.AddEventListener(8, attr));
+		handles.push_back(d.AddEventListener(9, attr));
+		handles.push_back(d.AddEventListener(131, count));
+		handles.push_back(d.AddEventListener(132, count));
+		handles.push_back(d.AddEventListener(81, removed));
+		handles.push_back(d.AddEventListener(7, other));
+	}
+};
+
+/*
+ * a random stream heavy with updates to a small set of keys, and some removes and plain messages mixed in
+ */
+static void
+Feed(ConflatingDispatcher& d, std::mt19937& rng, int n)
+{
+	static const char* rooms[] = { "r1", "r2", "r3" };
+	static const char* clients[] = { "c1", "c2", "c3", "c4" };
+	static const char* attrs[] = { "a", "b" };
+	for (int i=0; i<n; i++) {
+		std::string v = std::to_string(i);
+		std::string room = rooms[rng()%3];
+		std::string client = clients[rng()%4];
+		std::string attr = attrs[rng()%2];
+		switch (rng()%8) {
+		case 0: case 1:
+			d.DispatchEvent(8, {"", client, "", attr, v, "0"}, 0);
+			break;
+		case 2:
+			d.DispatchEvent(8, {room, client, "u"+client, attr, v, std::to_string(Attribute::FLAG_PERSISTENT)}, 0);
+			break;
+		case 3:
+			d.DispatchEvent(9, {room, client, attr, v}, 0);
+			break;
+		case 4:
+			d.DispatchEvent(131, {room, v}, 0);
+			break;
+		case 5:
+			d.DispatchEvent(132, {room, v}, 0);
+			break;
+		case 6:
+			d.DispatchEvent(81, {"", client, "", attr}, 0);
+			break;
+		default:
+			d.DispatchEvent(7, {"msg"+v}, 0);
+			break;
+		}
+	}
+}
+
+static void
+RunStream(StateModel& model, size_t threshold, int& conflated)
+{
+	ConflatingDispatcher d;
+	std::vector<CBUPCRef> handles;
+	model.Listen(d, handles);
+	d.conflator.SetThreshold(threshold);
+	std::mt19937 rng(1234);
+	std::mt19937 sizes(42);
+	for (int round=0; round<200; round++) {
+		Feed(d, rng, sizes()%100); // sometimes under the threshold, mostly over it
+		d.ProcessDispatches();
+	}
+	conflated = d.conflator.GetNumConflated();
+}
+
+TEST(Conflation, StressMatchesUnconflated) {
+	StateModel plain, conflated;
+	int nPlain = 0, nConflated = 0;
+	RunStream(plain, 0, nPlain);
+	RunStream(conflated, 20, nConflated);
+
+	EXPECT_EQ(0, nPlain);
+	EXPECT_GT(nConflated, 0);
+	EXPECT_EQ(plain.state, conflated.state);
+	EXPECT_EQ(plain.others, conflated.others);
+}
+
+TEST(Conflation, KeepsLastAndOrder) {
+	ConflatingDispatcher d;
+	std::vector<std::string> seen;
+	auto h = d.AddEventListener(131, [&seen](EventType, const StringArgs& a, UPCStatus) { seen.push_back(a[0]+"="+a[1]); });
+	auto g = d.AddEventListener(7, [&seen](EventType, const StringArgs& a, UPCStatus) { seen.push_back(a[0]); });
+	d.conflator.SetThreshold(2);
+	d.DispatchEvent(131, {"r1", "1"}, 0);
+	d.DispatchEvent(7, {"m1"}, 0);
+	d.DispatchEvent(131, {"r2", "5"}, 0);
+	d.DispatchEvent(131, {"r1", "2"}, 0);
+	d.DispatchEvent(7, {"m2"}, 0);
+	d.DispatchEvent(131, {"r1", "3"}, 0);
+	d.ProcessDispatches();
+
+	std::vector<std::string> expect = { "m1", "r2=5", "m2", "r1=3" };
+	EXPECT_EQ(expect, seen);
+	EXPECT_EQ(2, d.conflator.GetNumConflated());
+	EXPECT_EQ(2, d.conflator.GetNumConflated(131));
+	EXPECT_EQ(0, d.conflator.GetNumConflated(8));
+}
+
+TEST(Conflation, UnderThresholdUntouched) {
+	ConflatingDispatcher d;
+	int n = 0;
+	auto h = d.AddEventListener(9, [&n](EventType, const StringArgs&, UPCStatus) { n++; });
+	d.conflator.SetThreshold(10);
+	for (int i=0; i<10; i++) {
+		d.DispatchEvent(9, {"r1", "", "a", std::to_string(i)}, 0);
+	}
+	d.ProcessDispatches();
+	EXPECT_EQ(10, n);
+	EXPECT_EQ(0, d.conflator.GetNumConflated());
+}
@@ -0,0 +1,421 @@
+#include <gtest/gtest.h>
+
+#include "UnionClient.h"
+#include "connector/ConnectionScorer.h"
+#include "connector/StandardConnector.h"
+#include "SimLoop.h"
+
+/*
+ * a connection with a scripted outcome. it comes up, or fails, connectMS after Connect(), and the server answers a hello answerMS after
+ * it goes out. -1 for either means never
+ */
+class FakeConnection: public AbstractConnection {
+public:
+	FakeConnection(SimLoop& loop, const std::string name, int connectMS, int answerMS, bool fails=false)
+		: loop(loop), name(name), connectMS(connectMS), answerMS(answerMS), fails(fails) {}
+
+	virtual int Connect() override {
+		connects++;
+		connectState = ConnectionState::CONNECTION_IN_PROGRESS;
+		if (connectMS >= 0) {
+			pending = loop.Schedule(connectMS, 0, [this]() {
+				pending = nullptr;
+				if (fails) {
+					connectState = ConnectionState::NOT_CONNECTED;
+					NxConnectFailure(this, "refused", -1);
+				} else {
+					connectState = ConnectionState::READY;
+					NxConnected(this);
+				}
+			});
+		}
+		return 0;
+	}
+	virtual int Disconnect() override {
+		if (pending != nullptr) {
+			loop.CancelTimer(pending);
+			pending = nullptr;
+		}
+		if (connectState != ConnectionState::NOT_CONNECTED) {
+			connectState = ConnectionState::NOT_CONNECTED;
+			disconnects++;
+			NxDisconnected(this);
+		}
+		return 0;
+	}
+	virtual int Send(const std::string msg) override {
+		sent.push_back(msg);
+		if (answerMS >= 0 && msg.find("<M>u65</M>") != std::string::npos) {
+			loop.Schedule(answerMS, 0, [this]() {
+				if (connectState == ConnectionState::READY) {
+					NxReceive("<U><M>u66</M><L><A>" + name + "</A></L></U>", 0);
+				}
+			});
+		}
+		return 0;
+	}
+	virtual std::string LongName() override { return name; }
+	virtual std::string ShortName() override { return name; }
+	virtual bool IsIdle() override { return idle; }
+	virtual bool Drain(const bool enable) override {
+		draining = enable;
+		return idle;
+	}
+	virtual CnxRef NewStandby() override {
+		if (!standbys) return nullptr;
+		FakeConnection* s = new FakeConnection(loop, name, connectMS, answerMS, fails);
+		s->SetProperties(properties);
+		s->standbys = true;
+		return s;
+	}
+	/** the server goes away */
+	void Drop() {
+		connectState = ConnectionState::NOT_CONNECTED;
+		NxServerHangup(this, "dropped", 0);
+	}
+
+	SimLoop& loop;
+	std::string name;
+	int connectMS;
+	int answerMS;
+	bool fails;
+	bool idle = true;
+	bool draining = false;
+	bool standbys = false;
+	TimerRef pending = nullptr;
+	int connects = 0;
+	int disconnects = 0;
+	std::vector<std::string> sent;
+};
+
+/*
+ * plays the bridge: says hello on CONNECTED, and, like the monitor, tries again after a failure
+ */
+struct ConnectorFixture {
+	ConnectorFixture(int wsConnectMS, int wsAnswerMS, bool wsFails, int httpConnectMS, int httpAnswerMS, bool httpFails=false)
+		: ws(new FakeConnection(loop, "ws", wsConnectMS, wsAnswerMS, wsFails))
+		, http(new FakeConnection(loop, "http", httpConnectMS, httpAnswerMS, httpFails))
+	{
+		connector.AddConnection(ws);
+		connector.AddConnection(http);
+		connector.SetEventLoop(&loop);
+		listener = std::make_shared<CBConnection>([this](EventType e, const CnxRef& cr, const std::string& data, const ConnectionStatus& s) {
+			switch (e) {
+			case Event::CONNECTED:
+				connected++;
+				connector.Send("<U><M>u65</M></U>");
+				break;
+			case Event::RECEIVE_DATA:
+				received.push_back(data);
+				if (readyAt == 0) readyAt = loop.nowMS;
+				break;
+			case Event::SELECT_CONNECTION:
+				if (s == UPC::Status::CONNECTION_UPGRADE) upgrades++;
+				break;
+			case Event::CONNECT_FAILURE:
+				failures++;
+				if (s == UPC::Status::CONNECTION_FAILOVER) failovers++;
+				if (s != UPC::Status::NO_VALID_CONNECTION_AVAILABLE) connector.Connect();
+				break;
+			case Event::DISCONNECTED:
+				disconnected++;
+				break;
+			}
+		});
+		for (EventType e: { Event::CONNECTED, Event::RECEIVE_DATA, Event::SELECT_CONNECTION, Event::CONNECT_FAILURE, Event::DISCONNECTED }) {
+			connector.AddListener(e, listener);
+		}
+	}
+	~ConnectorFixture() {
+		connector.SetEventLoop(nullptr);
+	}
+	/** connect, and return the simulated ms until the server first answered */
+	uint64_t Connect(uint64_t runMS=20000) {
+		uint64_t start = loop.nowMS;
+		connector.Connect();
+		loop.Advance(runMS);
+		return readyAt - start;
+	}
+	/** connect, hang up after a while, and say who the server answered on */
+	std::string Cycle() {
+		readyAt = 0;
+		received.clear();
+		connector.Connect();
+		loop.Advance(20000);
+		connector.Disconnect();
+		loop.Advance(10);
+		return received.empty()? "" : received[0].substr(19, received[0].find("</A>") - 19);
+	}
+	std::shared_ptr<ConnectionScorer> Score(std::shared_ptr<ConnectionScorer> s=std::make_shared<ConnectionScorer>(1)) {
+		s->SetClock([this]() { return loop.nowMS; });
+		s->SetProbeRate(0);
+		connector.SetScorer(s);
+		return s;
+	}
+	/** ws marked as the persistent one, failing at first so we end up on http, and probing for it every probeMS */
+	void Fallback(int probeMS) {
+		ws->SetProperties({ CONNECTION_PERSISTENT });
+		connector.SetClock([this]() { return loop.nowMS; });
+		connector.SetUpgradeProbe(probeMS);
+		connector.Connect();
+	}
+	std::string LastFrom() {
+		return received.empty()? "" : received.back().substr(19, received.back().find("</A>") - 19);
+	}
+
+	SimLoop loop;
+	StandardConnector connector;
+	FakeConnection* ws;
+	FakeConnection* http;
+	CBConnectionRef listener;
+	int connected = 0;
+	int failures = 0;
+	int disconnected = 0;
+	int upgrades = 0;
+	int failovers = 0;
+	uint64_t readyAt = 0;
+	std::vector<std::string> received;
+};
+
+TEST(Connector, RaceWonByFirstChoice) {
+	ConnectorFixture f(50, 20, false, 0, 10);
+	f.connector.SetRacing(true, 250);
+	EXPECT_EQ(70u, f.Connect());
+	EXPECT_EQ(0, f.http->connects); // never needed
+	EXPECT_EQ(1, f.connected);
+	EXPECT_TRUE(f.connector.IsReady());
+	EXPECT_EQ(1u, f.connector.GetTimeToReady(StandardConnector::kStrategyRace).GetCount());
+}
+
+TEST(Connector, RaceFallsBackWhenWSHangs) {
+	ConnectorFixture f(-1, 20, false, 0, 30);
+	f.connector.SetRacing(true, 250);
+	EXPECT_EQ(280u, f.Connect());
+	EXPECT_EQ(1, f.ws->disconnects); // aborted quietly
+	EXPECT_EQ(0, f.disconnected);
+	EXPECT_EQ(0, f.failures);
+	EXPECT_EQ(1, f.connected);
+	f.connector.Send("<U><M>u2</M></U>");
+	EXPECT_EQ(2u, f.http->sent.size());
+	EXPECT_TRUE(f.ws->sent.empty());
+}
+
+TEST(Connector, RaceReplaysFirstFlight) {
+	ConnectorFixture f(10, 1000, false, 0, 30); // ws gets through a proxy that sits on the data
+	f.connector.SetRacing(true, 250);
+	EXPECT_EQ(280u, f.Connect());
+	EXPECT_EQ(1, f.connected); // the bridge only said hello once ...
+	ASSERT_EQ(1u, f.http->sent.size()); // ... but it went out on both
+	EXPECT_EQ(1u, f.ws->sent.size());
+	ASSERT_EQ(1u, f.received.size()); // and only the winner's answer came back
+	EXPECT_NE(std::string::npos, f.received[0].find("http"));
+	EXPECT_EQ(1, f.ws->disconnects);
+	EXPECT_EQ(0, f.disconnected);
+}
+
+TEST(Connector, RaceFailureStartsNextAtOnce) {
+	ConnectorFixture f(30, 20, true, 0, 10);
+	f.connector.SetRacing(true, 250);
+	EXPECT_EQ(40u, f.Connect());
+	EXPECT_EQ(0, f.failures);
+	EXPECT_EQ(1, f.connected);
+}
+
+TEST(Connector, RaceLostReportsOnce) {
+	ConnectorFixture f(30, 20, true, 10, 10, true);
+	f.connector.SetRacing(true, 250);
+	f.Connect();
+	EXPECT_EQ(2, f.failures); // the last runner's failure, then no viable connections on the retry
+	EXPECT_EQ(0, f.connected);
+	EXPECT_TRUE(f.received.empty());
+}
+
+TEST(Connector, TimeToReadyByStrategy) {
+	// ws blocked by a proxy that drops it after 5s. sequentially, http only gets its turn after that
+	ConnectorFixture sequential(5000, 20, true, 0, 30);
+	uint64_t s = sequential.Connect();
+	ConnectorFixture raced(5000, 20, true, 0, 30);
+	raced.connector.SetRacing(true, 250);
+	uint64_t r = raced.Connect();
+	std::cout << "time to ready with ws blocked: sequential " << s << "ms, race " << r << "ms" << std::endl;
+	EXPECT_EQ(5030u, s);
+	EXPECT_EQ(280u, r);
+	EXPECT_EQ(1u, sequential.connector.GetTimeToReady(StandardConnector::kStrategySequential).GetCount());
+	EXPECT_EQ(0u, sequential.connector.GetTimeToReady(StandardConnector::kStrategyRace).GetCount());
+	EXPECT_EQ(1u, raced.connector.GetTimeToReady(StandardConnector::kStrategyRace).GetCount());
+}
+
+TEST(Connector, ScoreFindsFasterTransport) {
+	ConnectorFixture f(0, 400, false, 0, 50);
+	auto s = f.Score();
+	EXPECT_EQ("ws", f.Cycle()); // nothing known, so priority order
+	EXPECT_EQ("http", f.Cycle()); // untried, so worth a go
+	for (int i=0; i<10; i++) {
+		EXPECT_EQ("http", f.Cycle());
+	}
+	EXPECT_EQ(1, f.ws->connects);
+	EXPECT_NEAR(50, s->Find("http")->latency, 1);
+	EXPECT_EQ(11u, s->Find("http")->sessions);
+}
+
+TEST(Connector, ScoreAvoidsFailingTransport) {
+	ConnectorFixture f(100, 20, true, 0, 30);
+	auto s = f.Score();
+	EXPECT_EQ("http", f.Cycle()); // after falling back
+	for (int i=0; i<10; i++) {
+		EXPECT_EQ("http", f.Cycle());
+	}
+	EXPECT_EQ(1, f.ws->connects);
+	EXPECT_EQ(1u, s->Find("ws")->failures);
+
+	f.ws->fails = false; // fixed, and quicker, but we don't know that until the failure has faded
+	f.ws->connectMS = 0;
+	f.loop.Advance(60*60*1000);
+	EXPECT_EQ("ws", f.Cycle());
+	EXPECT_EQ("ws", f.Cycle());
+	EXPECT_EQ(3, f.ws->connects);
+}
+
+TEST(Connector, ScoreProbesAlternatives) {
+	ConnectorFixture f(0, 400, false, 0, 50);
+	auto s = f.Score();
+	s->SetProbeRate(0.2);
+	int ws = 0;
+	for (int i=0; i<100; i++) {
+		if (f.Cycle() == "ws") ws++;
+	}
+	EXPECT_GT(s->GetProbeCount(), 5u);
+	EXPECT_GT(ws, 5);
+	EXPECT_LT(ws, 40);
+	s->SetProbeRate(0);
+	EXPECT_EQ("http", f.Cycle());
+}
+
+TEST(Connector, ScoreOutlivesConnector) {
+	auto s = std::make_shared<ConnectionScorer>(1);
+	{
+		ConnectorFixture f(100, 20, true, 0, 30);
+		f.Score(s);
+		EXPECT_EQ("http", f.Cycle());
+	}
+	ConnectorFixture f(100, 20, true, 0, 30);
+	f.Score(s);
+	f.connector.SetRacing(true, 250);
+	EXPECT_EQ("http", f.Cycle());
+	EXPECT_EQ(0, f.ws->connects); // raced, but http was first and won before the stagger
+}
+
+TEST(Connector, UpgradeToWebSocket) {
+	ConnectorFixture f(100, 20, true, 0, 30);
+	f.Fallback(10000);
+	f.loop.Advance(5000);
+	EXPECT_EQ("http", f.LastFrom()); // ready at 130
+	EXPECT_EQ(1, f.failures);
+
+	f.ws->fails = false; // the proxy has gone away. the probe goes out at 10130, and is through at 10230
+	f.loop.Advance(6000);
+	EXPECT_EQ(3, f.ws->connects); // the probe, then the real thing
+	EXPECT_EQ(1, f.upgrades);
+	EXPECT_EQ("ws", f.LastFrom()); // went straight over to ws, and is ready at 10350
+	EXPECT_EQ(1, f.http->disconnects);
+	EXPECT_EQ(0, f.disconnected); // the hang up on http is ours, and not passed on
+	EXPECT_EQ(1, f.failures); // just the first ws attempt
+
+	f.loop.Advance(100000); // and stays there
+	EXPECT_EQ(3, f.ws->connects);
+	EXPECT_EQ(1u, f.connector.GetUpgradeStats().probes);
+	EXPECT_EQ(1u, f.connector.GetUpgradeStats().upgrades);
+	EXPECT_EQ(10100u, f.connector.GetConnectedTime("http"));
+	EXPECT_EQ(f.loop.nowMS - 1000 - 10350, f.connector.GetConnectedTime("ws"));
+	std::cout << "connected on http " << f.connector.GetConnectedTime("http") << "ms, ws " << f.connector.GetConnectedTime("ws") << "ms" << std::endl;
+}
+
+TEST(Connector, UpgradeProbeBacksOff) {
+	ConnectorFixture f(100, 20, true, 0, 30);
+	f.Fallback(1000);
+	f.loop.Advance(30000); // probes at 1130, 3230, 7330, 15430, 23530, then every 8000
+	EXPECT_EQ(6, f.ws->connects);
+	EXPECT_EQ(5u, f.connector.GetUpgradeStats().probeFailures);
+	EXPECT_EQ(0, f.upgrades);
+	EXPECT_EQ(1, f.failures); // the probes keep their failures to themselves
+	EXPECT_TRUE(f.connector.IsReady());
+	f.connector.SetUpgradeProbe(0);
+	f.loop.Advance(30000);
+	EXPECT_EQ(6, f.ws->connects);
+}
+
+TEST(Connector, UpgradeWaitsForDrain) {
+	ConnectorFixture f(100, 20, true, 0, 30);
+	f.Fallback(1000);
+	f.loop.Advance(500);
+	f.ws->fails = false;
+	f.http->idle = false; // still collecting from the server
+	f.loop.Advance(5000);
+	EXPECT_EQ(2, f.ws->connects); // probed, and good to go, but waiting
+	EXPECT_EQ(0, f.upgrades);
+	EXPECT_TRUE(f.http->draining);
+	EXPECT_EQ("http", f.LastFrom());
+	f.http->idle = true;
+	size_t sent = f.http->sent.size();
+	f.loop.Advance(100);
+	EXPECT_EQ(1, f.upgrades);
+	ASSERT_EQ(sent+1, f.http->sent.size()); // the old session is ended, not just hung up on
+	EXPECT_EQ("<U><M>u83</M></U>", f.http->sent.back());
+	EXPECT_TRUE(f.http->GetConnectState() == ConnectionState::NOT_CONNECTED);
+	f.loop.Advance(200);
+	EXPECT_EQ("ws", f.LastFrom());
+}
+
+TEST(Connector, NoProbeWhenPersistent) {
+	ConnectorFixture f(0, 20, false, 0, 30);
+	f.Fallback(1000);
+	f.loop.Advance(10000);
+	EXPECT_EQ("ws", f.LastFrom());
+	EXPECT_EQ(1, f.ws->connects);
+	EXPECT_EQ(0, f.http->connects);
+	EXPECT_EQ(0u, f.connector.GetUpgradeStats().probes);
+}
+
+TEST(Connector, WarmStandby) {
+	ConnectorFixture f(300, 50, false, 0, 30);
+	f.ws->SetProperties({ CONNECTION_PERSISTENT });
+	f.ws->standbys = true;
+	f.connector.SetClock([&f]() { return f.loop.nowMS; });
+	f.connector.SetWarmStandby(true, 10000);
+	f.Connect(1000); // ready at 1350, and the standby is up at 1650
+	EXPECT_TRUE(f.connector.IsStandbyReady());
+	f.loop.Advance(24000); // hung up and made again at 11650 and 21950
+	const StandardConnector::StandbyStats& s = f.connector.GetStandbyStats();
+	EXPECT_EQ(3u, s.starts);
+	EXPECT_EQ(2u, s.refreshes);
+	EXPECT_EQ(0u, s.failures);
+	EXPECT_EQ(1, f.ws->connects);
+	EXPECT_EQ(1, f.connected); // the standby never gets as far as the bridge
+
+	FakeConnection* primary = f.ws;
+	primary->Drop();
+	f.loop.Advance(1000);
+	EXPECT_EQ(1u, s.promotions);
+	EXPECT_EQ(1, f.failovers);
+	EXPECT_EQ(2, f.connected);
+	ASSERT_NE(primary, f.connector.Connection(0)); // swapped in, with the dead one to be the next standby
+	FakeConnection* promoted = static_cast<FakeConnection*>(f.connector.Connection(0));
+	EXPECT_EQ(3, promoted->connects); // the standby made three times over
+	EXPECT_EQ(1u, promoted->sent.size()); // the hello, which waited for it to be promoted
+	EXPECT_EQ(0, f.http->connects);
+	EXPECT_EQ(2, primary->connects);
+	EXPECT_TRUE(f.connector.IsStandbyReady());
+	EXPECT_EQ(1u, f.connector.GetFailoverGap(true).GetCount());
+	EXPECT_EQ(50u, f.connector.GetFailoverGap(true).GetMax()); // just the hello and its answer
+
+	f.connector.SetWarmStandby(false);
+	promoted->Drop();
+	f.loop.Advance(1000);
+	EXPECT_EQ(1u, f.connector.GetFailoverGap(false).GetCount());
+	EXPECT_EQ(350u, f.connector.GetFailoverGap(false).GetMax()); // the whole connect as well
+	EXPECT_EQ(promoted, f.connector.Connection(0));
+	EXPECT_EQ(4, promoted->connects);
+	EXPECT_EQ(1, f.failovers);
+	std::cout << "failover gap, warm " << f.connector.GetFailoverGap(true).GetMax() << "ms, cold "
+			<< f.connector.GetFailoverGap(false).GetMax() << "ms" << std::endl;
+}
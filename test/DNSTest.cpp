@@ -0,0 +1,239 @@
+#include <map>
+#include <gtest/gtest.h>
+
+#include "uv.h"
+#include "CommonTypes.h"
+#include "EventLoop.h"
+#include "DNSCache.h"
+#include "connector/AddressRacer.h"
+#include "SimLoop.h"
+
+static UVAddress
+IP4(const char* ip, int port=80)
+{
+	sockaddr_in a;
+	uv_ip4_addr(ip, port, &a);
+	return UVAddress((sockaddr*)&a);
+}
+
+static UVAddress
+IP6(const char* ip, int port=80)
+{
+	sockaddr_in6 a;
+	uv_ip6_addr(ip, port, &a);
+	return UVAddress((sockaddr*)&a);
+}
+
+/*
+ * stands in for getaddrinfo. answers straight away, unless held, in which case Answer() does it
+ */
+struct StubResolver {
+	DNSCache::Lookup Lookup() {
+		return [this](const std::string host, const std::string service, ResolverCB cb) {
+			lookups++;
+			if (hold) pending.push_back(cb);
+			else cb(answer, status);
+		};
+	}
+	void Answer() {
+		auto p = pending;
+		pending.clear();
+		for (auto& cb: p) cb(answer, status);
+	}
+	UVAddresses answer = { IP6("2001:db8::1"), IP4("192.0.2.1") };
+	int status = 0;
+	bool hold = false;
+	int lookups = 0;
+	std::vector<ResolverCB> pending;
+};
+
+struct CacheFixture {
+	CacheFixture()
+		: cache(stub.Lookup()) {
+		cache.SetClock([this]() { return loop.nowMS; });
+	}
+	void Resolve() {
+		cache.Resolve("union.example.com", "80", [this](const UVAddresses& res, int status) {
+			answers.push_back(res);
+			statuses.push_back(status);
+		});
+	}
+	SimLoop loop;
+	StubResolver stub;
+	DNSCache cache;
+	std::vector<UVAddresses> answers;
+	std::vector<int> statuses;
+};
+
+TEST(DNS, CacheHonoursTTL) {
+	CacheFixture f;
+	f.cache.SetTTL(30000);
+	f.Resolve();
+	f.loop.Advance(29999);
+	f.Resolve();
+	EXPECT_EQ(1, f.stub.lookups);
+	EXPECT_EQ(1u, f.cache.GetStats().hits);
+	ASSERT_EQ(2u, f.answers.size());
+	EXPECT_EQ(2u, f.answers[1].size());
+	EXPECT_TRUE(f.answers[1][0].IsIP6());
+	f.loop.Advance(1);
+	f.Resolve();
+	EXPECT_EQ(2, f.stub.lookups);
+	f.cache.Forget("union.example.com", "80");
+	f.Resolve();
+	EXPECT_EQ(3, f.stub.lookups);
+}
+
+TEST(DNS, HitsGoThroughDeliver) {
+	CacheFixture f;
+	f.cache.SetDeliver([&f](std::function<void()> d) {
+		f.loop.Schedule(0, 0, [d]() { d(); });
+	});
+	f.Resolve();
+	ASSERT_EQ(1u, f.answers.size()); // the stub answered, as a lookup would, on its own thread
+	f.Resolve();
+	EXPECT_EQ(1u, f.cache.GetStats().hits);
+	EXPECT_EQ(1u, f.answers.size()); // not on ours
+	f.loop.Advance(0);
+	ASSERT_EQ(2u, f.answers.size());
+	EXPECT_EQ(0, f.statuses[1]);
+}
+
+TEST(DNS, LookupsInFlightShared) {
+	CacheFixture f;
+	f.stub.hold = true;
+	for (int i=0; i<3; i++) {
+		f.Resolve();
+	}
+	EXPECT_EQ(1, f.stub.lookups);
+	EXPECT_EQ(2u, f.cache.GetStats().joined);
+	EXPECT_TRUE(f.answers.empty());
+	f.stub.Answer();
+	ASSERT_EQ(3u, f.answers.size());
+	for (auto& it: f.answers) {
+		EXPECT_EQ("2001:db8::1", it[0].Name());
+		EXPECT_EQ("192.0.2.1", it[1].Name());
+	}
+}
+
+TEST(DNS, FailuresNotKept) {
+	CacheFixture f;
+	f.stub.status = -3008;
+	f.stub.answer.clear();
+	f.Resolve();
+	ASSERT_EQ(1u, f.statuses.size());
+	EXPECT_EQ(-3008, f.statuses[0]);
+	f.stub.status = 0;
+	f.stub.answer = { IP4("192.0.2.7") };
+	f.Resolve();
+	EXPECT_EQ(2, f.stub.lookups);
+	EXPECT_EQ(0, f.statuses[1]);
+	EXPECT_EQ(1u, f.cache.GetStats().failures);
+}
+
+TEST(DNS, FamiliesInterleaved) {
+	UVAddresses res = { IP6("2001:db8::1"), IP6("2001:db8::2"), IP6("2001:db8::3"), IP4("192.0.2.1"), IP4("192.0.2.2") };
+	UVAddresses r = AddressRacer::Interleave(res);
+	std::vector<std::string> names;
+	for (auto& it: r) names.push_back(it.Name());
+	std::vector<std::string> expect = { "2001:db8::1", "192.0.2.1", "2001:db8::2", "192.0.2.2", "2001:db8::3" };
+	EXPECT_EQ(expect, names);
+
+	res = { IP4("192.0.2.1"), IP4("192.0.2.2"), IP6("2001:db8::1") }; // the resolver's preference is kept
+	r = AddressRacer::Interleave(res, 2);
+	EXPECT_EQ("192.0.2.1", r[0].Name());
+	EXPECT_EQ("192.0.2.2", r[1].Name());
+	EXPECT_EQ("2001:db8::1", r[2].Name());
+}
+
+/*
+ * attempts that answer, or don't, after a given time
+ */
+struct RaceFixture {
+	RaceFixture()
+		: racer(&loop) {}
+	void Race(UVAddresses res) {
+		racer.Race(res,
+			[this](const UVAddress& a, const int attempt) {
+				started.push_back(std::make_pair(attempt, loop.nowMS));
+				names.push_back(a.Name());
+				auto it = outcome.find(a.Name());
+				if (it == outcome.end()) return; // a black hole
+				int ms = it->second.first;
+				bool ok = it->second.second;
+				loop.Schedule(ms, 0, [this, attempt, ok]() {
+					if (ok) {
+						if (racer.Succeeded(attempt)) won = attempt;
+					} else {
+						racer.Failed(attempt, -111);
+					}
+				});
+			},
+			[this](const int attempt) {
+				abandoned.push_back(attempt);
+			},
+			[this](const int status) {
+				failures.push_back(status);
+			});
+	}
+	SimLoop loop;
+	AddressRacer racer;
+	std::map<std::string, std::pair<int, bool>> outcome;
+	std::vector<std::pair<int, uint64_t>> started;
+	std::vector<std::string> names;
+	std::vector<int> abandoned;
+	std::vector<int> failures;
+	int won = -1;
+};
+
+TEST(DNS, BrokenIP6CostsOneDelay) {
+	RaceFixture f;
+	f.outcome["192.0.2.1"] = std::make_pair(30, true); // and the ipv6 one never answers
+	uint64_t t0 = f.loop.nowMS;
+	f.Race({ IP6("2001:db8::1"), IP4("192.0.2.1") });
+	f.loop.Advance(1000);
+	ASSERT_EQ(2u, f.started.size());
+	EXPECT_EQ(t0, f.started[0].second);
+	EXPECT_EQ(t0 + AddressRacer::kDfltAttemptDelayMS, f.started[1].second);
+	EXPECT_EQ("192.0.2.1", f.names[1]);
+	EXPECT_EQ(1, f.won);
+	EXPECT_EQ(std::vector<int>({ 0 }), f.abandoned);
+	EXPECT_FALSE(f.racer.IsRacing());
+	EXPECT_TRUE(f.failures.empty());
+}
+
+TEST(DNS, FailureStartsNextAtOnce) {
+	RaceFixture f;
+	f.outcome["2001:db8::1"] = std::make_pair(10, false); // refused
+	f.outcome["192.0.2.1"] = std::make_pair(100, false);
+	f.outcome["2001:db8::2"] = std::make_pair(20, true);
+	uint64_t t0 = f.loop.nowMS;
+	f.Race({ IP6("2001:db8::1"), IP6("2001:db8::2"), IP4("192.0.2.1"), IP4("192.0.2.2") });
+	f.loop.Advance(1000);
+	ASSERT_EQ(3u, f.started.size()); // the win came before the fourth was due
+	EXPECT_EQ(t0 + 10, f.started[1].second);
+	EXPECT_EQ(t0 + 110, f.started[2].second);
+	EXPECT_EQ("2001:db8::2", f.names[2]);
+	EXPECT_EQ(2, f.won);
+	EXPECT_TRUE(f.abandoned.empty());
+}
+
+TEST(DNS, AllFailReportedOnce) {
+	RaceFixture f;
+	f.outcome["2001:db8::1"] = std::make_pair(10, false);
+	f.outcome["192.0.2.1"] = std::make_pair(500, false);
+	f.Race({ IP6("2001:db8::1"), IP4("192.0.2.1") });
+	f.loop.Advance(2000);
+	EXPECT_EQ(2u, f.started.size());
+	EXPECT_EQ(std::vector<int>({ -111 }), f.failures);
+	EXPECT_EQ(-1, f.won);
+
+	f.outcome.clear(); // nothing answers, and the connect is given up on
+	f.Race({ IP6("2001:db8::1"), IP4("192.0.2.1"), IP4("192.0.2.2") });
+	f.loop.Advance(300);
+	f.racer.Cancel();
+	f.loop.Advance(1000);
+	EXPECT_EQ(4u, f.started.size());
+	EXPECT_EQ(std::vector<int>({ 0, 1 }), f.abandoned);
+	EXPECT_EQ(1u, f.failures.size());
+}
@@ -0,0 +1,146 @@
+#include <chrono>
+#include <random>
+#include <gtest/gtest.h>
+
+#include "CommonTypes.h"
+#include "UCLowerHeaders.h"
+#include "connector/HTTPCnxLayer.h"
+
+/*
+ * the encoder as it was, a byte at a time into a new[] buffer, to check against and to race
+ */
+static std::string
+ByteAtATimeEncode(const std::string& s)
+{
+	static const char hex[] = "0123456789abcdef";
+	char *buf = new char[s.size() * 3 + 1];
+	char *p = buf;
+	for (char c: s) {
+		if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+			*p++ = c;
+		} else if (c == ' ') {
+			*p++ = '+';
+		} else {
+			*p++ = '%';
+			*p++ = hex[(c >> 4) & 15];
+			*p++ = hex[c & 15];
+		}
+	}
+	std::string r(buf, p-buf);
+	delete []buf;
+	return r;
+}
+
+/*
+ * upcs as UnionBridge::SendUPC makes them: room messages with a bit of chat, attribute updates, joins
+ */
+static std::vector<std::string>
+SomeUPCs(int n)
+{
+	std::mt19937 rng(44);
+	const char* words[] = { "hello", "there", "game", "on", "gg", "ready?", "brb", "<b>nice</b>", "100%", "&", "ok", "münchen" };
+	std::vector<std::string> upcs;
+	for (int i=0; i<n; i++) {
+		std::string chat;
+		for (int w=rng()%12; w>=0; w--) chat += std::string(words[rng()%12]) + " ";
+		switch (i % 3) {
+		case 0: upcs.push_back("<U><M>u1</M><L><A>CHAT_MESSAGE</A><A>examples.chat</A><A>false</A><A></A><A><![CDATA[" + chat + "]]></A></L></U>"); break;
+		case 1: upcs.push_back("<U><M>u3</M><L><A>" + std_to_string(1000+i) + "</A><A></A><A>score</A><A>" + std_to_string((int)(rng()%100000)) + "</A><A>examples.chat</A><A>4</A></L></U>"); break;
+		case 2: upcs.push_back("<U><M>u4</M><L><A>examples.lobby</A><A></A><A>the password is " + chat + "</A></L></U>"); break;
+		}
+	}
+	return upcs;
+}
+
+TEST(Encode, MatchesByteAtATime) {
+	for (int c=0; c<256; c++) {
+		std::string s(1, (char)c);
+		EXPECT_EQ(ByteAtATimeEncode(s), Url::Encode(s)) << "byte " << c;
+	}
+	std::mt19937 rng(7);
+	const char* mix[] = { "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-_.~", " <>&=%+/:\"'", "\x80\xff\xc3\xa9" };
+	for (int i=0; i<2000; i++) {
+		std::string s;
+		size_t len = rng()%100;
+		int bias = rng()%3;
+		for (size_t j=0; j<len; j++) {
+			const char* from = mix[(rng()%4 == 0)? rng()%3 : bias];
+			s += from[rng()%strlen(from)];
+		}
+		ASSERT_EQ(ByteAtATimeEncode(s), Url::Encode(s)) << s;
+		char out[300];
+		size_t n = Url::Encode(s.data(), s.size(), out);
+		ASSERT_EQ(ByteAtATimeEncode(s), std::string(out, n));
+		ASSERT_EQ(s, Url::Decode(Url::Encode(s)));
+	}
+	std::string prefix = "data=";
+	Url::AppendEncoded(prefix, "a b<");
+	EXPECT_EQ("data=a+b%3c", prefix);
+}
+
+TEST(Encode, RequestsAsMessageMakesThem) {
+	HTTPRequestBuilder b;
+	CnxChunk chunks[HTTPRequestBuilder::kMaxChunks];
+	HTTP::Headers none;
+	HTTP::Headers typed = { { HTTP_HEADER_CONTENT_TYPE, "application/x-www-form-urlencoded" } };
+	HTTP::Headers sized = { { HTTP_HEADER_CONTENT_LENGTH, "5" }, { "Connection", "close" } };
+	for (auto h: { none, typed, sized }) {
+		b.Invalidate();
+		for (std::string body: { "mode=d&data=hello", "", "x" }) {
+			size_t n = b.Build(HTTP_METHOD_POST, "union.example.com", "/", h, body.data(), body.size(), chunks);
+			EXPECT_EQ(HTTP::Message(HTTP_METHOD_POST, "union.example.com", "/", h, body), HTTPRequestBuilder::Gather(chunks, n));
+		}
+	}
+	EXPECT_EQ(3u, b.GetHeadBuilds()); // once for each set of headers, not for each request
+}
+
+TEST(Encode, Benchmark) {
+	std::vector<std::string> upcs = SomeUPCs(3000);
+	size_t upcBytes = 0;
+	for (auto& u: upcs) upcBytes += u.size();
+	const int rounds = 20;
+	size_t sink = 0;
+	HTTP::Headers headers = { { HTTP_HEADER_CONTENT_TYPE, "application/x-www-form-urlencoded" } };
+	typedef std::chrono::steady_clock clock;
+
+	auto start = clock::now();
+	for (int r=0; r<rounds; r++) {
+		for (auto& u: upcs) {
+			std::string body = "mode=s&rid=" + std_to_string(r) + "&sid=" + ByteAtATimeEncode("abc-123") + "&data=" + ByteAtATimeEncode(u);
+			std::string msg = HTTP::Message(HTTP_METHOD_POST, "union.example.com", "/", headers, body);
+			sink += msg.size();
+		}
+	}
+	double before = std::chrono::duration<double, std::nano>(clock::now() - start).count()/(rounds*upcs.size());
+
+	HTTPRequestBuilder b;
+	CnxChunk chunks[HTTPRequestBuilder::kMaxChunks];
+	std::string body;
+	start = clock::now();
+	for (int r=0; r<rounds; r++) {
+		for (auto& u: upcs) {
+			body.clear();
+			body.append("mode=s&rid=").append(std_to_string(r)).append("&sid=");
+			Url::AppendEncoded(body, "abc-123");
+			body.append("&data=");
+			Url::AppendEncoded(body, u);
+			size_t n = b.Build(HTTP_METHOD_POST, "union.example.com", "/", headers, body.data(), body.size(), chunks);
+			for (size_t i=0; i<n; i++) sink += chunks[i].len;
+		}
+	}
+	double after = std::chrono::duration<double, std::nano>(clock::now() - start).count()/(rounds*upcs.size());
+
+	std::string all;
+	for (auto& u: upcs) all += u;
+	std::string out(Url::MaxEncodedLength(all.size()), '\0');
+	start = clock::now();
+	for (int r=0; r<rounds; r++) sink += Url::Encode(all.data(), all.size(), &out[0]);
+	double encodeMBs = rounds*all.size()/(1024.0*1024.0)/std::chrono::duration<double>(clock::now() - start).count();
+	start = clock::now();
+	for (int r=0; r<rounds; r++) sink += ByteAtATimeEncode(all).size();
+	double oldMBs = rounds*all.size()/(1024.0*1024.0)/std::chrono::duration<double>(clock::now() - start).count();
+
+	std::cout << upcs.size() << " upcs, " << upcBytes/upcs.size() << " bytes each: request " << before << "ns before, " << after << "ns after. encoding "
+			<< oldMBs << "MB/s before, " << encodeMBs << "MB/s after" << std::endl;
+	EXPECT_GT(sink, 0u);
+}
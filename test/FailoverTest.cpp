@@ -0,0 +1,271 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <gtest/gtest.h>
+
+#include "uv.h"
+#include "CommonTypes.h"
+#include "UCLowerHeaders.h"
+#include "connector/UVConnection.h"
+#include "UVEventLoop.h"
+
+extern UVEventLoop worker;
+
+/*
+ * stands in for a distant union server, on loopback, with a loop and thread of its own. the websocket upgrade is answered upgradeMS after
+ * it comes in, as a far away server behind a tls handshake would be, and the hello answerMS after that. Kill() drops whichever socket said
+ * hello last, which is the session's, and leaves any other (the standby) alone
+ */
+struct StandInServer {
+	struct Client {
+		uv_tcp_t tcp;
+		StandInServer* server;
+		std::string in;
+		bool upgraded = false;
+		bool closed = false;
+	};
+	struct Later {
+		uv_timer_t timer;
+		Client* client;
+		std::string bytes;
+	};
+
+	StandInServer(int upgradeMS, int answerMS)
+		: upgradeMS(upgradeMS), answerMS(answerMS) {
+		uv_loop_init(&loop);
+		uv_tcp_init(&loop, &tcp);
+		sockaddr_in a;
+		uv_ip4_addr("127.0.0.1", 0, &a);
+		uv_tcp_bind(&tcp, (sockaddr*)&a, 0);
+		tcp.data = this;
+		uv_listen((uv_stream_t*)&tcp, 16, OnConnection);
+		int n = sizeof(a);
+		uv_tcp_getsockname(&tcp, (sockaddr*)&a, &n);
+		port = ntohs(a.sin_port);
+		uv_async_init(&loop, &kill, [](uv_async_t* h) {
+			StandInServer* s = (StandInServer*)h->data;
+			if (s->session != nullptr) {
+				s->Close(s->session);
+				s->session = nullptr;
+			}
+		});
+		kill.data = this;
+		uv_async_init(&loop, &stop, [](uv_async_t* h) {
+			uv_stop(h->loop);
+		});
+		runner = std::thread([this]() {
+			uv_run(&loop, UV_RUN_DEFAULT);
+		});
+	}
+	~StandInServer() {
+		uv_async_send(&stop);
+		runner.join();
+	}
+
+	void Kill() {
+		uv_async_send(&kill);
+	}
+
+	static void OnConnection(uv_stream_t* listener, int status) {
+		if (status < 0) return;
+		Client* c = new Client();
+		c->server = (StandInServer*)listener->data;
+		uv_tcp_init(listener->loop, &c->tcp);
+		uv_tcp_nodelay(&c->tcp, 1);
+		c->tcp.data = c;
+		if (uv_accept(listener, (uv_stream_t*)&c->tcp) == 0) {
+			c->server->open++;
+			uv_read_start((uv_stream_t*)&c->tcp, [](uv_handle_t*, size_t suggested, uv_buf_t* buf) {
+				*buf = uv_buf_init(new char[suggested], (unsigned)suggested);
+			}, OnRead);
+		}
+	}
+	static void OnRead(uv_stream_t* stream, ssize_t n, const uv_buf_t* buf) {
+		Client* c = (Client*)stream->data;
+		if (n > 0) {
+			c->in.append(buf->base, n);
+			c->server->Process(c);
+		}
+		delete[] buf->base;
+		if (n < 0) c->server->Close(c);
+	}
+
+	/** the upgrade, then masked client frames. a text frame is taken as the hello, and anything else as goodbye */
+	void Process(Client* c) {
+		if (!c->upgraded) {
+			size_t end = c->in.find("\r\n\r\n");
+			if (end == std::string::npos) return;
+			c->in.erase(0, end+4);
+			c->upgraded = true;
+			After(c, upgradeMS, "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n\r\n");
+		}
+		while (c->in.size() >= 6) {
+			const unsigned char *p = (const unsigned char*)c->in.data();
+			int op = p[0] & 0x0f;
+			size_t len = p[1] & 0x7f, h = 2;
+			if (len == 126) {
+				len = (p[2] << 8) | p[3];
+				h = 4;
+			}
+			if (c->in.size() < h+4+len) return;
+			c->in.erase(0, h+4+len);
+			if (op != 0x1) {
+				Close(c);
+				return;
+			}
+			session = c;
+			std::string answer = "<U><M>u66</M><L><A>stand in</A></L></U>";
+			After(c, answerMS, std::string("\x81", 1) + (char)answer.size() + answer);
+		}
+	}
+	void After(Client* c, int ms, const std::string& bytes) {
+		Later* l = new Later();
+		l->client = c;
+		l->bytes = bytes;
+		l->timer.data = l;
+		uv_timer_init(&loop, &l->timer);
+		uv_timer_start(&l->timer, [](uv_timer_t* t) {
+			Later* l = (Later*)t->data;
+			if (!l->client->closed) {
+				uv_write_t* w = new uv_write_t();
+				char* data = new char[l->bytes.size()];
+				memcpy(data, l->bytes.data(), l->bytes.size());
+				uv_buf_t b = uv_buf_init(data, (unsigned)l->bytes.size());
+				w->data = data;
+				uv_write(w, (uv_stream_t*)&l->client->tcp, &b, 1, [](uv_write_t* w, int) {
+					delete[] (char*)w->data;
+					delete w;
+				});
+			}
+			uv_close((uv_handle_t*)t, [](uv_handle_t* h) {
+				delete (Later*)h->data;
+			});
+		}, ms, 0);
+	}
+	void Close(Client* c) {
+		if (c->closed) return;
+		c->closed = true;
+		open--;
+		if (session == c) session = nullptr;
+		uv_close((uv_handle_t*)&c->tcp, nullptr); // the client itself is left for the process to clean up, as a late timer may still look at it
+	}
+
+	int upgradeMS;
+	int answerMS;
+	uv_loop_t loop;
+	uv_tcp_t tcp;
+	uv_async_t kill;
+	uv_async_t stop;
+	std::thread runner;
+	int port;
+	Client* session = nullptr;
+	std::atomic<int> open { 0 };
+};
+
+static bool
+WaitFor(std::function<bool()> done, int ms=20000)
+{
+	auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+	while (!done()) {
+		if (std::chrono::steady_clock::now() > end) return false;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return true;
+}
+
+/**
+ * run f on the worker thread, where everything the connector does happens, and wait for it
+ */
+static void
+OnWorker(std::function<void()> f)
+{
+	std::atomic<bool> done(false);
+	worker.Schedule(0, 0, [&]() {
+		f();
+		done = true;
+	});
+	WaitFor([&]() { return done.load(); });
+}
+
+/*
+ * a connector with a web socket to the stand in, and a listener playing the bridge and the monitor: the hello on CONNECTED, and a
+ * reconnect on the next tick after any failure
+ */
+struct FailoverClient {
+	FailoverClient(int port)
+		: ws(new UVWSConnection(std::to_string(port), "127.0.0.1")) {
+		connector.AddConnection(ws);
+		connector.SetEventLoop(&worker);
+		listener = std::make_shared<CBConnection>([this](EventType e, const CnxRef& cr, const std::string& data, const ConnectionStatus& s) {
+			switch (e) {
+			case Event::CONNECTED:
+				connector.Send("<U><M>u65</M></U>");
+				break;
+			case Event::RECEIVE_DATA:
+				answers++;
+				break;
+			case Event::CONNECT_FAILURE:
+				if (s == UPC::Status::CONNECTION_FAILOVER) failovers++;
+				worker.Schedule(0, 0, [this]() {
+					connector.Connect();
+				});
+				break;
+			}
+		});
+		for (EventType e: { Event::CONNECTED, Event::RECEIVE_DATA, Event::CONNECT_FAILURE }) {
+			connector.AddListener(e, listener);
+		}
+	}
+	~FailoverClient() {
+		OnWorker([this]() {
+			connector.SetEventLoop(nullptr);
+			connector.Disconnect();
+		});
+		std::this_thread::sleep_for(std::chrono::milliseconds(200)); // for the close callbacks on the worker
+	}
+
+	StandardConnector connector;
+	UVWSConnection* ws;
+	CBConnectionRef listener;
+	std::atomic<int> answers { 0 };
+	std::atomic<int> failovers { 0 };
+};
+
+TEST(Failover, KillPrimarySocket) {
+	const int rounds = 5;
+	StandInServer server(300, 20);
+	{
+		FailoverClient client(server.port);
+		client.connector.SetWarmStandby(true, 60000);
+		OnWorker([&]() { client.connector.Connect(); });
+		ASSERT_TRUE(WaitFor([&]() { return client.answers == 1 && client.connector.IsStandbyReady(); }));
+		EXPECT_EQ(2, server.open.load()); // the session and its standby
+
+		for (int i=0; i<rounds; i++) {
+			int was = client.answers;
+			server.Kill();
+			ASSERT_TRUE(WaitFor([&]() { return client.answers > was && client.connector.IsStandbyReady(); })) << "warm round " << i;
+		}
+		EXPECT_EQ(rounds, client.failovers.load());
+		EXPECT_EQ((uint64_t)rounds, client.connector.GetStandbyStats().promotions);
+
+		OnWorker([&]() { client.connector.SetWarmStandby(false); });
+		EXPECT_TRUE(WaitFor([&]() { return server.open == 1; }));
+		for (int i=0; i<rounds; i++) {
+			int was = client.answers;
+			server.Kill();
+			ASSERT_TRUE(WaitFor([&]() { return client.answers > was; })) << "cold round " << i;
+		}
+		EXPECT_EQ(rounds, client.failovers.load());
+
+		const Histogram& warm = client.connector.GetFailoverGap(true);
+		const Histogram& cold = client.connector.GetFailoverGap(false);
+		std::cout << "failover gap over " << rounds << " kills, warm standby: mean " << warm.GetMean() << "ms, max " << warm.GetMax()
+				<< "ms. cold reconnect: mean " << cold.GetMean() << "ms, max " << cold.GetMax() << "ms" << std::endl;
+		EXPECT_EQ((uint64_t)rounds, warm.GetCount());
+		EXPECT_EQ((uint64_t)rounds, cold.GetCount());
+		EXPECT_LT(warm.GetMax(), 300u); // the hello and its answer, with no handshake in between
+		EXPECT_GE(cold.GetMean(), 320.0);
+	}
+	EXPECT_TRUE(WaitFor([&]() { return server.open == 0; }));
+}
@@ -0,0 +1,272 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <gtest/gtest.h>
+
+#include "uv.h"
+#include "CommonTypes.h"
+#include "UCLowerHeaders.h"
+#include "connector/UVConnection.h"
+#include "UVEventLoop.h"
+
+extern UVEventLoop worker;
+
+/*
+ * stands in for a union server a long way off, on loopback, with a loop and thread of its own. everything is answered latencyMS after it
+ * comes in: the upgrade with a 101, the hello with u66, and a join with u6. a strict server, like some proxies, won't have frames before it
+ * has answered the upgrade, and answers those with a 400 and a hang up
+ */
+struct LaggyServer {
+	struct Client {
+		uv_tcp_t tcp;
+		LaggyServer* server;
+		std::string in;
+		bool upgraded = false;
+		bool answered = false;
+		bool refused = false;
+		bool closed = false;
+	};
+	struct Later {
+		uv_timer_t timer;
+		Client* client;
+		std::string bytes;
+		bool hangUp;
+	};
+
+	LaggyServer(int latencyMS, bool strict)
+		: latencyMS(latencyMS), strict(strict) {
+		uv_loop_init(&loop);
+		uv_tcp_init(&loop, &tcp);
+		sockaddr_in a;
+		uv_ip4_addr("127.0.0.1", 0, &a);
+		uv_tcp_bind(&tcp, (sockaddr*)&a, 0);
+		tcp.data = this;
+		uv_listen((uv_stream_t*)&tcp, 16, OnConnection);
+		int n = sizeof(a);
+		uv_tcp_getsockname(&tcp, (sockaddr*)&a, &n);
+		port = ntohs(a.sin_port);
+		uv_async_init(&loop, &stop, [](uv_async_t* h) {
+			uv_stop(h->loop);
+		});
+		runner = std::thread([this]() {
+			uv_run(&loop, UV_RUN_DEFAULT);
+		});
+	}
+	~LaggyServer() {
+		uv_async_send(&stop);
+		runner.join();
+	}
+
+	static void OnConnection(uv_stream_t* listener, int status) {
+		if (status < 0) return;
+		Client* c = new Client();
+		c->server = (LaggyServer*)listener->data;
+		uv_tcp_init(listener->loop, &c->tcp);
+		uv_tcp_nodelay(&c->tcp, 1);
+		c->tcp.data = c;
+		if (uv_accept(listener, (uv_stream_t*)&c->tcp) == 0) {
+			c->server->connections++;
+			uv_read_start((uv_stream_t*)&c->tcp, [](uv_handle_t*, size_t suggested, uv_buf_t* buf) {
+				*buf = uv_buf_init(new char[suggested], (unsigned)suggested);
+			}, OnRead);
+		}
+	}
+	static void OnRead(uv_stream_t* stream, ssize_t n, const uv_buf_t* buf) {
+		Client* c = (Client*)stream->data;
+		if (n > 0) {
+			c->in.append(buf->base, n);
+			c->server->Process(c);
+		}
+		delete[] buf->base;
+		if (n < 0) c->server->Close(c);
+	}
+
+	void Process(Client* c) {
+		if (!c->upgraded) {
+			size_t end = c->in.find("\r\n\r\n");
+			if (end == std::string::npos) return;
+			c->in.erase(0, end+4);
+			c->upgraded = true;
+			After(c, "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n\r\n", false);
+		}
+		if (!c->in.empty() && strict && !c->answered) {
+			if (!c->refused) {
+				early++;
+				c->refused = true;
+				After(c, "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n", true);
+			}
+			c->in.clear();
+			return;
+		}
+		while (c->in.size() >= 6) {
+			const unsigned char *p = (const unsigned char*)c->in.data();
+			size_t len = p[1] & 0x7f, h = 2;
+			if (len == 126) {
+				len = (p[2] << 8) | p[3];
+				h = 4;
+			}
+			if (c->in.size() < h+4+len) return;
+			std::string payload = c->in.substr(h+4, len);
+			for (size_t i=0; i<len; i++) payload[i] ^= c->in[h+(i%4)];
+			c->in.erase(0, h+4+len);
+			std::string answer;
+			if (payload.find("<M>u65</M>") != std::string::npos) {
+				answer = "<U><M>u66</M><L><A>stand in</A></L></U>";
+			} else if (payload.find("<M>u4</M>") != std::string::npos) {
+				answer = "<U><M>u6</M><L><A>game.table1</A></L></U>";
+			} else {
+				continue;
+			}
+			After(c, std::string("\x81", 1) + (char)answer.size() + answer, false);
+		}
+	}
+	/** send the bytes latencyMS from now, and hang up after them if need be */
+	void After(Client* c, const std::string& bytes, bool hangUp) {
+		Later* l = new Later();
+		l->client = c;
+		l->bytes = bytes;
+		l->hangUp = hangUp;
+		l->timer.data = l;
+		uv_timer_init(&loop, &l->timer);
+		uv_timer_start(&l->timer, [](uv_timer_t* t) {
+			Later* l = (Later*)t->data;
+			if (!l->client->closed && (l->hangUp || !l->client->refused)) {
+				l->client->answered = true;
+				uv_write_t* w = new uv_write_t();
+				char* data = new char[l->bytes.size()];
+				memcpy(data, l->bytes.data(), l->bytes.size());
+				uv_buf_t b = uv_buf_init(data, (unsigned)l->bytes.size());
+				w->data = data;
+				uv_write(w, (uv_stream_t*)&l->client->tcp, &b, 1, [](uv_write_t* w, int) {
+					delete[] (char*)w->data;
+					delete w;
+				});
+				if (l->hangUp) l->client->server->Close(l->client);
+			}
+			uv_close((uv_handle_t*)t, [](uv_handle_t* h) {
+				delete (Later*)h->data;
+			});
+		}, latencyMS, 0);
+	}
+	void Close(Client* c) {
+		if (c->closed) return;
+		c->closed = true;
+		uv_close((uv_handle_t*)&c->tcp, nullptr); // the client itself is left for the process to clean up, as a late timer may still look at it
+	}
+
+	int latencyMS;
+	bool strict;
+	uv_loop_t loop;
+	uv_tcp_t tcp;
+	uv_async_t stop;
+	std::thread runner;
+	int port;
+	std::atomic<int> connections { 0 };
+	std::atomic<int> early { 0 };
+};
+
+static bool
+WaitFor(std::function<bool()> done, int ms=20000)
+{
+	auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+	while (!done()) {
+		if (std::chrono::steady_clock::now() > end) return false;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return true;
+}
+
+static void
+OnWorker(std::function<void()> f)
+{
+	std::atomic<bool> done(false);
+	worker.Schedule(0, 0, [&]() {
+		f();
+		done = true;
+	});
+	WaitFor([&]() { return done.load(); });
+}
+
+/*
+ * a web socket to the server, and a listener playing a client that has a join queued up: the hello and the join on CONNECTED, and a
+ * reconnect on the next tick after a failure. joinedMS is from the first connect to the join's answer
+ */
+struct FastOpenClient {
+	FastOpenClient(int port, bool fastOpen)
+		: ws(new UVWSConnection(std::to_string(port), "127.0.0.1")) {
+		ws->SetFastOpen(fastOpen);
+		connector.AddConnection(ws);
+		connector.SetEventLoop(&worker);
+		listener = std::make_shared<CBConnection>([this](EventType e, const CnxRef& cr, const std::string& data, const ConnectionStatus& s) {
+			switch (e) {
+			case Event::CONNECTED:
+				connector.Send("<U><M>u65</M></U>");
+				connector.Send("<U><M>u4</M><L><A>game.table1</A><A></A></L></U>");
+				break;
+			case Event::RECEIVE_DATA:
+				if (data.find("<M>u6</M>") != std::string::npos) {
+					joinedMS = (int)((uv_hrtime() - started)/1000000);
+				}
+				break;
+			case Event::CONNECT_FAILURE:
+				failures++;
+				worker.Schedule(0, 0, [this]() {
+					connector.Connect();
+				});
+				break;
+			}
+		});
+		for (EventType e: { Event::CONNECTED, Event::RECEIVE_DATA, Event::CONNECT_FAILURE }) {
+			connector.AddListener(e, listener);
+		}
+		OnWorker([this]() {
+			started = uv_hrtime();
+			connector.Connect();
+		});
+	}
+	~FastOpenClient() {
+		OnWorker([this]() {
+			connector.SetEventLoop(nullptr);
+			connector.Disconnect();
+		});
+		std::this_thread::sleep_for(std::chrono::milliseconds(200)); // for the close callbacks on the worker
+	}
+
+	StandardConnector connector;
+	UVWSConnection* ws;
+	CBConnectionRef listener;
+	uint64_t started = 0;
+	std::atomic<int> joinedMS { -1 };
+	std::atomic<int> failures { 0 };
+};
+
+TEST(FastOpen, TimeToJoinedRoom) {
+	const int latency = 150;
+	LaggyServer server(latency, false);
+	int slow, fast;
+	{
+		FastOpenClient client(server.port, false);
+		ASSERT_TRUE(WaitFor([&]() { return client.joinedMS >= 0; }));
+		slow = client.joinedMS;
+	}
+	{
+		FastOpenClient client(server.port, true);
+		ASSERT_TRUE(WaitFor([&]() { return client.joinedMS >= 0; }));
+		fast = client.joinedMS;
+		EXPECT_TRUE(client.ws->IsFastOpen());
+		EXPECT_EQ(0, client.failures.load());
+	}
+	std::cout << "time to joined room with " << latency << "ms round trips: upgrade first " << slow << "ms, fast open " << fast << "ms" << std::endl;
+	EXPECT_GE(slow, 2*latency);
+	EXPECT_LT(fast, 2*latency); // the upgrade, hello and join all in one round trip
+}
+
+TEST(FastOpen, FallsBackWhenRefused) {
+	LaggyServer server(50, true);
+	FastOpenClient client(server.port, true);
+	ASSERT_TRUE(WaitFor([&]() { return client.joinedMS >= 0; }));
+	EXPECT_EQ(1, client.failures.load());
+	EXPECT_EQ(1, server.early.load());
+	EXPECT_EQ(2, server.connections.load());
+	EXPECT_FALSE(client.ws->IsFastOpen());
+}
@@ -0,0 +1,210 @@
+#include <deque>
+#include <memory>
+#include <zlib.h>
+#include <gtest/gtest.h>
+
+#include "CommonTypes.h"
+#include "UCLowerHeaders.h"
+#include "connector/UVConnection.h"
+#include "SimLoop.h"
+
+/*
+ * a snapshot sized answer to a poll: a room's worth of occupants and attributes
+ */
+static std::string
+Snapshot(int n)
+{
+	std::string s;
+	for (int i=0; i<n; i++) {
+		s += "<U><M>u" + std::to_string(i) + "</M><L><A>examples.lobby</A><A>" + std::to_string(1000+i) + "</A><A>user" + std::to_string(i)
+				+ "</A><A>score|" + std::to_string(i*37 % 1000) + "|avatar|robot</A></L></U>";
+	}
+	return s;
+}
+
+/**
+ * @param windowBits 31 for gzip, 15 for zlib deflate, -15 for raw deflate
+ */
+static std::string
+Compress(const std::string& s, int windowBits)
+{
+	z_stream z;
+	memset(&z, 0, sizeof(z));
+	deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY);
+	std::string out(deflateBound(&z, s.size()), '\0');
+	z.next_in = (Bytef*)s.data();
+	z.avail_in = (uInt)s.size();
+	z.next_out = (Bytef*)&out[0];
+	z.avail_out = (uInt)out.size();
+	deflate(&z, Z_FINISH);
+	out.resize(z.total_out);
+	deflateEnd(&z);
+	return out;
+}
+
+struct Fixture {
+	std::string encoding;
+	std::string body;
+};
+
+/*
+ * stands in for a poll's socket, and plays the server: each request gets the next fixture, in sliceBytes pieces as a slow link would
+ * hand them over, and once they're all gone, requests wait for ever
+ */
+class ZipServerLayer: public CnxLayer {
+public:
+	ZipServerLayer(SimLoop& loop, std::deque<Fixture>& fixtures, std::vector<std::string>& requests)
+		: CnxLayer(nullptr, nullptr), loop(loop), fixtures(fixtures), requests(requests) {
+		connectState = ConnectionState::NOT_CONNECTED;
+	}
+
+	virtual int Open() override {
+		loop.Schedule(5, 0, [this]() {
+			connectState = ConnectionState::READY;
+			upper->OnOpen();
+		});
+		return 0;
+	}
+	virtual int Close() override {
+		if (connectState != ConnectionState::NOT_CONNECTED) {
+			connectState = ConnectionState::NOT_CONNECTED;
+			loop.Schedule(0, 0, [this]() {
+				upper->OnClose();
+			});
+		}
+		return 0;
+	}
+	virtual int Write(const char *data, const size_t len) override {
+		requests.emplace_back(data, len);
+		if (fixtures.empty()) {
+			return (int)len;
+		}
+		Fixture f = fixtures.front();
+		fixtures.pop_front();
+		std::string r = "HTTP/1.1 200 OK\r\n";
+		if (f.encoding != "") r += "Content-Encoding: " + f.encoding + "\r\n";
+		r += "Content-Length: " + std::to_string(f.body.size()) + "\r\n\r\n" + f.body;
+		for (size_t i=0; i<r.size(); i+=sliceBytes) {
+			std::string slice = r.substr(i, sliceBytes);
+			loop.Schedule(10 + i/sliceBytes, 0, [this, slice]() {
+				if (connectState == ConnectionState::READY) upper->Receive(slice.data(), slice.size());
+			});
+		}
+		return (int)len;
+	}
+
+	SimLoop& loop;
+	std::deque<Fixture>& fixtures;
+	std::vector<std::string>& requests;
+	size_t sliceBytes = 97;
+};
+
+class ZipConnection: public UPCHTTPConnection {
+public:
+	ZipConnection(SimLoop& loop, std::deque<Fixture>& fixtures, std::vector<std::string>& requests,
+			std::vector<std::unique_ptr<ZipServerLayer>>& servers)
+		: loop(loop), fixtures(fixtures), requests(requests), servers(servers) {}
+protected:
+	virtual UVHTTPCnxUpper* NewPollLayer(CnxLayerUpper* poll) override {
+		UVHTTPCnxUpper* l = UPCHTTPConnection::NewPollLayer(poll);
+		ZipServerLayer* s = new ZipServerLayer(loop, fixtures, requests);
+		servers.emplace_back(s);
+		l->SetTransport(s);
+		l->SetEventLoop(&loop);
+		return l;
+	}
+	SimLoop& loop;
+	std::deque<Fixture>& fixtures;
+	std::vector<std::string>& requests;
+	std::vector<std::unique_ptr<ZipServerLayer>>& servers; // the base class closes them as it goes
+};
+
+struct ZipFixture {
+	ZipFixture(std::deque<Fixture> f)
+		: fixtures(f)
+		, http(new ZipConnection(loop, fixtures, requests, servers)) {
+		connector.AddConnection(http);
+		receiver = std::make_shared<CBConnection>([this](EventType e, const CnxRef& cr, const std::string& data, const ConnectionStatus& s) {
+			received.push_back(data);
+		});
+		failer = std::make_shared<CBConnection>([this](EventType e, const CnxRef& cr, const std::string& data, const ConnectionStatus& s) {
+			failures++;
+		});
+		connector.AddListener(Event::RECEIVE_DATA, receiver);
+		connector.AddListener(Event::CONNECT_FAILURE, failer);
+		connector.Connect();
+		connector.SetActiveConnectionSessionID("s1");
+	}
+
+	SimLoop loop;
+	std::deque<Fixture> fixtures;
+	std::vector<std::string> requests;
+	std::vector<std::unique_ptr<ZipServerLayer>> servers;
+	StandardConnector connector;
+	ZipConnection* http;
+	CBConnectionRef receiver;
+	CBConnectionRef failer;
+	std::vector<std::string> received;
+	int failures = 0;
+};
+
+TEST(HTTPGzip, DecodesAsItArrives) {
+	std::string snapshot = Snapshot(400);
+	std::string small = Snapshot(3);
+	ZipFixture f({ { "gzip", Compress(snapshot, 31) }, { "deflate", Compress(small, 15) }, { "deflate", Compress(snapshot, -15) },
+			{ "", small }, { "GZip ", Compress(small, 31) } });
+	f.loop.Advance(60000);
+	ASSERT_EQ(5u, f.received.size());
+	EXPECT_EQ(snapshot, f.received[0]);
+	EXPECT_EQ(small, f.received[1]);
+	EXPECT_EQ(snapshot, f.received[2]);
+	EXPECT_EQ(small, f.received[3]);
+	EXPECT_EQ(small, f.received[4]);
+	EXPECT_EQ(0, f.failures);
+	for (auto& r: f.requests) {
+		EXPECT_NE(std::string::npos, r.find("\r\n" HTTP_HEADER_ACCEPT_ENCODING ": gzip, deflate\r\n"));
+	}
+
+	HTTPCnxLayer::CompressionStats s = f.http->GetCompressionStats();
+	EXPECT_EQ(4u, s.responsesInflated);
+	EXPECT_EQ(2*snapshot.size() + 3*small.size(), s.rawBytesIn);
+	std::cout << "snapshot of " << snapshot.size() << " bytes, wire/decoded over all responses " << s.GetRatioIn() << ", "
+			<< s.inflateNanos/1000 << "us inflating" << std::endl;
+	EXPECT_LT(s.GetRatioIn(), 0.25);
+}
+
+TEST(HTTPGzip, BadBodiesFail) {
+	std::string snapshot = Snapshot(50);
+	std::string broken = Compress(snapshot, 31);
+	broken[broken.size()/2] ^= 0x55;
+	std::string cut = Compress(snapshot, 31);
+	cut.resize(cut.size() - 10);
+	for (Fixture bad: { Fixture { "gzip", broken }, Fixture { "gzip", cut }, Fixture { "br", snapshot } }) {
+		ZipFixture f(std::deque<Fixture> { bad });
+		f.loop.Advance(10000);
+		EXPECT_TRUE(f.received.empty()) << bad.encoding;
+		EXPECT_EQ(1, f.failures) << bad.encoding;
+	}
+}
+
+TEST(HTTPGzip, BombsStopAtTheLimit) {
+	std::string zeros(HTTPCnxLayer::kDefaultMaxBodySize + 1, '\0');
+	std::string bomb = Compress(zeros, 31);
+	zeros.clear();
+	ZipFixture f(std::deque<Fixture> { { "gzip", bomb } });
+	f.loop.Advance(10000);
+	EXPECT_TRUE(f.received.empty());
+	EXPECT_EQ(1, f.failures);
+	EXPECT_LE(f.http->GetCompressionStats().rawBytesIn, HTTPCnxLayer::kDefaultMaxBodySize);
+}
+
+TEST(HTTPGzip, CanBeTurnedOff) {
+	ZipFixture f(std::deque<Fixture> { { "", "<U><M>u1</M></U>" } });
+	f.http->SetCompression(false); // the poll is out, but its request isn't made till the socket opens
+	f.loop.Advance(10000);
+	ASSERT_EQ(1u, f.received.size());
+	ASSERT_EQ(2u, f.requests.size());
+	for (auto& r: f.requests) {
+		EXPECT_EQ(std::string::npos, r.find(HTTP_HEADER_ACCEPT_ENCODING));
+	}
+}
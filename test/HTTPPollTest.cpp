@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <gtest/gtest.h>
+#include <uv.h>
+
+#include "CommonTypes.h"
+#include "UCLowerHeaders.h"
+#include "connector/UVConnection.h"
+#include "SimLoop.h"
+
+class StandInLayer;
+
+/*
+ * plays the union server's end of the mode c polls. a poll reaches it setupMS (the tcp handshake) plus oneWayMS after it is sent. the
+ * oldest waiting poll takes whatever has been pushed, as soon as there is something, or goes back empty after timeoutMS. the next
+ * few to arrive, as many as resets, have their connections reset instead
+ */
+struct PollServer {
+	PollServer(SimLoop& loop, int oneWayMS, int setupMS, int timeoutMS)
+		: loop(loop), oneWayMS(oneWayMS), setupMS(setupMS), timeoutMS(timeoutMS) {}
+
+	void Arrive(StandInLayer* l);
+	void Answer(StandInLayer* l, const std::string body);
+	void Push(int n) {
+		pushedAt.push_back(loop.nowMS);
+		queued += "<U><M>u7</M><L><A>" + std::to_string(n) + "</A></L></U>";
+		if (!parked.empty()) {
+			StandInLayer* l = parked.front();
+			parked.pop_front();
+			Answer(l, queued);
+			queued = "";
+		}
+	}
+
+	SimLoop& loop;
+	int oneWayMS;
+	int setupMS;
+	int timeoutMS;
+	std::deque<StandInLayer*> parked;
+	std::string queued;
+	std::vector<uint64_t> pushedAt;
+	int requests = 0;
+	int resets = 0;
+};
+
+/*
+ * stands in for a poll's http transport, with extraMS more on the way back than the others get
+ */
+class StandInLayer: public UVHTTPCnxUpper {
+public:
+	StandInLayer(CnxLayerUpper* upper, PollServer& server, int extraMS)
+		: UVHTTPCnxUpper(upper), server(server), extraMS(extraMS) {}
+
+	virtual int Write(const char *data, const size_t len) override {
+		server.requests++;
+		server.loop.Schedule(server.setupMS + server.oneWayMS, 0, [this]() {
+			if (open) server.Arrive(this);
+		});
+		open = true;
+		return 0;
+	}
+	virtual int Close() override {
+		open = false;
+		return 0;
+	}
+	void Reset() {
+		server.loop.Schedule(server.oneWayMS, 0, [this]() {
+			if (open) {
+				open = false;
+				upper->OnIOError("connection reset", UV_ECONNRESET);
+			}
+		});
+	}
+	void Respond(const std::string body) {
+		server.loop.Schedule(server.oneWayMS + extraMS, 0, [this, body]() {
+			if (open) {
+				open = false;
+				upper->Receive(body.data(), body.size());
+			}
+		});
+	}
+
+	PollServer& server;
+	int extraMS;
+	bool open = false;
+};
+
+void
+PollServer::Arrive(StandInLayer* l)
+{
+	if (resets > 0) {
+		resets--;
+		l->Reset();
+		return;
+	}
+	if (queued.size() > 0) {
+		Answer(l, queued);
+		queued = "";
+		return;
+	}
+	parked.push_back(l);
+	loop.Schedule(timeoutMS, 0, [this, l]() {
+		auto it = std::find(parked.begin(), parked.end(), l);
+		if (it != parked.end()) {
+			parked.erase(it);
+			Answer(l, "");
+		}
+	});
+}
+
+void
+PollServer::Answer(StandInLayer* l, const std::string body)
+{
+	l->Respond(body);
+}
+
+class StandInHTTPConnection: public UPCHTTPConnection {
+public:
+	StandInHTTPConnection(PollServer& server, std::vector<int> extraMS)
+		: server(server), extraMS(extraMS) {}
+protected:
+	virtual UVHTTPCnxUpper* NewPollLayer(CnxLayerUpper* poll) override {
+		size_t i = made++;
+		return new StandInLayer(poll, server, i < extraMS.size()? extraMS[i] : 0);
+	}
+	PollServer& server;
+	std::vector<int> extraMS;
+	size_t made = 0;
+};
+
+/*
+ * an http connection, past the handshake and polling, with the latency of everything the server pushes kept track of
+ */
+struct PollFixture {
+	PollFixture(int depth, int timeoutMS=30000, std::vector<int> extraMS={})
+		: server(loop, 20, 40, timeoutMS)
+		, http(new StandInHTTPConnection(server, extraMS)) {
+		connector.AddConnection(http);
+		listener = std::make_shared<CBConnection>([this](EventType e, const CnxRef& cr, const std::string& data, const ConnectionStatus& s) {
+			for (size_t i=data.find("<A>"); i!=std::string::npos; i=data.find("<A>", i+1)) {
+				int n = atoi(data.c_str()+i+3);
+				order.push_back(n);
+				latency.push_back(loop.nowMS - server.pushedAt[n]);
+			}
+		});
+		connector.AddListener(Event::RECEIVE_DATA, listener);
+		http->SetPollDepth(depth);
+		connector.Connect();
+		connector.SetActiveConnectionSessionID("s1");
+	}
+	double MeanLatency() {
+		double sum = 0;
+		for (auto it: latency) sum += it;
+		return latency.empty()? 0 : sum/latency.size();
+	}
+
+	SimLoop loop;
+	PollServer server;
+	StandardConnector connector;
+	StandInHTTPConnection* http;
+	CBConnectionRef listener;
+	std::vector<int> order;
+	std::vector<uint64_t> latency;
+};
+
+/** pushes with random gaps, averaging gapMS */
+static void
+PushAtRandom(PollFixture& f, int n, int gapMS)
+{
+	std::mt19937 rng(7);
+	std::exponential_distribution<double> gap(1.0/gapMS);
+	for (int i=0; i<n; i++) {
+		f.loop.Advance(1 + (uint64_t)gap(rng));
+		f.server.Push(i);
+	}
+	f.loop.Advance(1000);
+}
+
+TEST(HTTPPoll, SecondPollCutsLatency) {
+	PollFixture single(1);
+	PushAtRandom(single, 500, 100);
+	PollFixture dual(2);
+	PushAtRandom(dual, 500, 100);
+	std::cout << "mean push to delivery, 20ms each way, 40ms connect: 1 poll " << single.MeanLatency() << "ms, 2 polls "
+			<< dual.MeanLatency() << "ms" << std::endl;
+	ASSERT_EQ(500u, single.latency.size());
+	ASSERT_EQ(500u, dual.latency.size());
+	EXPECT_LT(dual.MeanLatency(), single.MeanLatency()*0.75);
+	for (int i=0; i<500; i++) {
+		EXPECT_EQ(i, dual.order[i]);
+	}
+}
+
+TEST(HTTPPoll, ResponsesKeptInOrder) {
+	PollFixture f(2, 30000, { 200, 0 }); // the first poll's socket is slow on the way back
+	f.loop.Advance(100); // both waiting at the server
+	ASSERT_EQ(2u, f.server.parked.size());
+	f.server.Push(0); // on the slow one
+	f.loop.Advance(5);
+	f.server.Push(1); // on the quick one, so it gets back first ...
+	f.loop.Advance(100);
+	EXPECT_TRUE(f.order.empty()); // ... and waits
+	f.loop.Advance(200);
+	ASSERT_EQ(2u, f.order.size());
+	EXPECT_EQ(0, f.order[0]);
+	EXPECT_EQ(1, f.order[1]);
+	EXPECT_EQ(f.latency[0] - 5, f.latency[1]); // both passed on together
+}
+
+TEST(HTTPPoll, ResetPollAskedAgain) {
+	PollFixture f(1, 10000);
+	f.server.resets = 1;
+	f.loop.Advance(200);
+	EXPECT_EQ(2, f.server.requests); // the one that was reset goes again
+	EXPECT_EQ(1u, f.server.parked.size());
+	for (int i=0; i<5; i++) {
+		f.server.Push(i);
+		f.loop.Advance(200);
+	}
+	ASSERT_EQ(5u, f.order.size()); // and nothing after it is held up
+	for (int i=0; i<5; i++) {
+		EXPECT_EQ(i, f.order[i]);
+	}
+	EXPECT_TRUE(f.http->GetConnectState() == ConnectionState::READY);
+
+	f.server.resets = UPCHTTPConnection::kMaxPollRetries + 1;
+	f.loop.Advance(12000); // the next after the waiting one times out never gets there
+	EXPECT_TRUE(f.http->GetConnectState() == ConnectionState::NOT_CONNECTED);
+}
+
+TEST(HTTPPoll, DrainTillEmpty) {
+	PollFixture f(2, 10000);
+	f.loop.Advance(100); // both waiting at the server
+	EXPECT_FALSE(f.http->Drain());
+	f.server.Push(0);
+	f.loop.Advance(200); // one takes it, and isn't replaced
+	EXPECT_EQ(1u, f.order.size());
+	EXPECT_EQ(1u, f.server.parked.size());
+	EXPECT_FALSE(f.http->Drain());
+	f.loop.Advance(10000); // the other comes back empty
+	EXPECT_TRUE(f.server.parked.empty());
+	EXPECT_EQ(2, f.server.requests);
+	EXPECT_TRUE(f.http->Drain());
+
+	f.server.Push(1); // too late for this session, unless we change our minds
+	f.loop.Advance(20000);
+	EXPECT_EQ(1u, f.order.size());
+	f.http->Drain(false);
+	f.loop.Advance(200);
+	EXPECT_EQ(2u, f.order.size());
+}
+
+TEST(HTTPPoll, IdleDropsToOnePoll) {
+	PollFixture f(2, 10000);
+	f.loop.Advance(60050); // two go out and time out together, then just the one, every 10060ms
+	EXPECT_EQ(7, f.server.requests);
+	EXPECT_EQ(1u, f.server.parked.size());
+	f.server.Push(0);
+	f.loop.Advance(200); // something came, so back up to two
+	EXPECT_EQ(2u, f.server.parked.size());
+	EXPECT_EQ(1u, f.order.size());
+}
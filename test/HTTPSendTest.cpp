@@ -0,0 +1,185 @@
+#include <chrono>
+#include <gtest/gtest.h>
+
+#include "CommonTypes.h"
+#include "UCLowerHeaders.h"
+#include "connector/UVConnection.h"
+#include "SimLoop.h"
+
+/*
+ * stands in for the socket under httpTx, and plays the server's end of the mode s requests. connecting takes setupMS, and the empty
+ * answer comes back rttMS after the request goes out. the first refuse opens fail outright
+ */
+class SendServerLayer: public CnxLayer {
+public:
+	SendServerLayer(SimLoop& loop, int setupMS, int rttMS)
+		: CnxLayer(nullptr, nullptr), loop(loop), setupMS(setupMS), rttMS(rttMS) {
+		connectState = ConnectionState::NOT_CONNECTED;
+	}
+
+	virtual int Open() override {
+		opens++;
+		if (refuse > 0) {
+			refuse--;
+			return -1;
+		}
+		loop.Schedule(setupMS, 0, [this]() {
+			connectState = ConnectionState::READY;
+			upper->OnOpen();
+		});
+		return 0;
+	}
+	virtual int Close() override {
+		if (connectState != ConnectionState::NOT_CONNECTED) {
+			connectState = ConnectionState::NOT_CONNECTED;
+			loop.Schedule(0, 0, [this]() {
+				upper->OnClose();
+			});
+		}
+		return 0;
+	}
+	virtual int Write(const char *data, const size_t len) override {
+		std::string request(data, len);
+		std::string body = request.substr(request.find("\r\n\r\n") + 4);
+		bodies.push_back(body);
+		std::string upcs = Url::Decode(body.substr(body.find("data=") + 5));
+		for (size_t i=upcs.find("<L><A>"); i!=std::string::npos; i=upcs.find("<L><A>", i+1)) {
+			received.push_back(atoi(upcs.c_str()+i+6));
+		}
+		loop.Schedule(rttMS, 0, [this]() {
+			std::string r = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+			upper->Receive(r.data(), r.size());
+		});
+		return (int)len;
+	}
+
+	SimLoop& loop;
+	int setupMS;
+	int rttMS;
+	int refuse = 0;
+	int opens = 0;
+	std::vector<std::string> bodies;
+	std::vector<int> received;
+};
+
+/*
+ * polls that go nowhere, so only the sends are seen
+ */
+class NullPollLayer: public UVHTTPCnxUpper {
+public:
+	NullPollLayer(CnxLayerUpper* upper)
+		: UVHTTPCnxUpper(upper) {}
+	virtual int Write(const char *data, const size_t len) override { return 0; }
+	virtual int Close() override { return 0; }
+};
+
+class StandInSendConnection: public UPCHTTPConnection {
+public:
+	StandInSendConnection(SimLoop& loop, CnxLayer* server) {
+		httpTx.SetTransport(server);
+		httpTx.SetEventLoop(&loop);
+	}
+	const UVHTTPCnxUpper& Tx() const { return httpTx; }
+protected:
+	virtual UVHTTPCnxUpper* NewPollLayer(CnxLayerUpper* poll) override {
+		return new NullPollLayer(poll);
+	}
+};
+
+struct SendFixture {
+	SendFixture()
+		: server(loop, 40, 40)
+		, http(new StandInSendConnection(loop, &server)) {
+		connector.AddConnection(http);
+		listener = std::make_shared<CBConnection>([this](EventType e, const CnxRef& cr, const std::string& data, const ConnectionStatus& s) {
+			failures++;
+		});
+		connector.AddListener(Event::CONNECT_FAILURE, listener);
+		connector.Connect();
+		connector.SetActiveConnectionSessionID("s1");
+	}
+	void Send(int n) {
+		connector.Send("<U><M>u1</M><L><A>" + std::to_string(n) + "</A><A>CHAT</A><A>lobby</A><A>false</A><A></A><A>hello there</A></L></U>");
+	}
+	/** run until the server has had n, or a simulated hour has gone, and say how long it took */
+	uint64_t RunUntil(size_t n) {
+		uint64_t start = loop.nowMS;
+		while (server.received.size() < n && loop.nowMS - start < 3600*1000) {
+			loop.Advance(10);
+		}
+		return loop.nowMS - start;
+	}
+
+	SimLoop loop;
+	SendServerLayer server;
+	StandardConnector connector;
+	StandInSendConnection* http;
+	CBConnectionRef listener;
+	int failures = 0;
+};
+
+TEST(HTTPSend, Batches10k) {
+	const int n = 10000;
+	uint64_t requests[2], simMS[2];
+	double wallMS[2];
+	for (int batched=0; batched<2; batched++) {
+		SendFixture f;
+		f.http->SetMaxSendBatch(batched? UVHTTPCnxUpper::kDfltMaxBatchBytes : 0);
+		f.http->GetSendQueue().SetLimits(SendQueue::kDfltMaxBytes, n); // the whole burst is in before the loop runs
+		auto start = std::chrono::steady_clock::now();
+		for (int i=0; i<n; i++) {
+			f.Send(i);
+		}
+		simMS[batched] = f.RunUntil(n);
+		wallMS[batched] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		requests[batched] = f.http->Tx().GetRequestCount();
+		ASSERT_EQ((size_t)n, f.server.received.size());
+		for (int i=0; i<n; i++) {
+			ASSERT_EQ(i, f.server.received[i]);
+		}
+		f.loop.Advance(100); // for the last answer
+		EXPECT_TRUE(f.http->IsIdle());
+	}
+	std::cout << n << " upcs, one per request: " << requests[0] << " requests, " << simMS[0] << "ms simulated, " << wallMS[0] << "ms wall"
+			<< std::endl;
+	std::cout << n << " upcs, batched: " << requests[1] << " requests, " << simMS[1] << "ms simulated, " << wallMS[1] << "ms wall"
+			<< std::endl;
+	EXPECT_EQ((uint64_t)n, requests[0]);
+	EXPECT_LT(requests[1], 50u);
+	EXPECT_LT(simMS[1]*100, simMS[0]);
+}
+
+TEST(HTTPSend, BatchSizeBounded) {
+	SendFixture f;
+	f.http->SetMaxSendBatch(1000);
+	for (int i=0; i<100; i++) {
+		f.Send(i);
+	}
+	f.RunUntil(100);
+	ASSERT_EQ(100u, f.server.received.size());
+	ASSERT_GT(f.server.bodies.size(), 10u);
+	for (size_t i=1; i<f.server.bodies.size(); i++) { // the first went on its own, and took the rid
+		EXPECT_NE(std::string::npos, f.server.bodies[i].find("rid=" + std::to_string(i+1) + "&"));
+		EXPECT_LE(f.server.bodies[i].size() - f.server.bodies[i].find("data=") - 5, 1000u);
+	}
+}
+
+TEST(HTTPSend, RetryBacksOff) {
+	SendFixture f;
+	f.server.refuse = 3;
+	f.Send(0);
+	EXPECT_EQ(1, f.server.opens);
+	f.loop.Advance(1749); // 250, 500 and 1000 ms between tries
+	EXPECT_EQ(3, f.server.opens);
+	f.loop.Advance(1);
+	EXPECT_EQ(4, f.server.opens);
+	f.RunUntil(1);
+	EXPECT_EQ(1u, f.server.received.size());
+	EXPECT_EQ(0, f.failures);
+
+	f.server.refuse = 100; // and on the next, we give up
+	f.Send(1);
+	f.loop.Advance(60000);
+	EXPECT_EQ(4 + 1 + UVHTTPCnxUpper::kMaxRetries, f.server.opens);
+	EXPECT_EQ(1, f.failures);
+}
@@ -0,0 +1,191 @@
+#include <deque>
+#include <gtest/gtest.h>
+
+#include "UnionClient.h"
+#include "SimLoop.h"
+
+/*
+ * plays a server that answers hello with client metadata and ready. heartbeats are kept, with the time they went out, for the test to answer
+ */
+class HeartbeatConnector: public AbstractConnector {
+public:
+	HeartbeatConnector(const SimLoop& loop)
+		: loop(loop) {}
+
+	virtual bool IsReady() const override { return connected; }
+	virtual int Connect() override {
+		connected = true;
+		NotifyListeners(Event::BEGIN_CONNECT, nullptr, "", UPC::Status::SUCCESS);
+		NotifyListeners(Event::CONNECTED, nullptr, "", UPC::Status::SUCCESS);
+		return 0;
+	}
+	virtual int Disconnect() override {
+		connected = false;
+		disconnects++;
+		NotifyListeners(Event::DISCONNECTED, nullptr, "", UPC::Status::SUCCESS);
+		return 0;
+	}
+	virtual int Send(const std::string msg) override {
+		if (msg.find("<M>u65</M>") != std::string::npos) {
+			Receive("<U><M>u29</M><L><A>3</A></L></U>");
+			Receive("<U><M>u63</M><L></L></U>");
+		} else if (msg.find("CLIENT_HEARTBEAT") != std::string::npos) {
+			size_t a = msg.rfind("<A>") + 3;
+			heartbeats.push_back(std::make_pair(atoi(msg.substr(a, msg.find("</A>", a) - a).c_str()), loop.nowMS));
+			sent.push_back(loop.nowMS);
+		} else if (msg.find("_PING") != std::string::npos) {
+			pings++;
+		}
+		return 0;
+	}
+	virtual void SetActiveConnectionSessionID(std::string) override {}
+	virtual void SetConnectionAffinity(std::string host, int durationSec) override {}
+
+	void Receive(const std::string upc) {
+		NotifyListeners(Event::RECEIVE_DATA, nullptr, upc, UPC::Status::SUCCESS);
+	}
+	/** answer heartbeats that have been out for at least rtt ms, or rtt+jitter for odd numbered ones */
+	void AnswerDue(uint64_t rtt, uint64_t jitter) {
+		while (!heartbeats.empty()) {
+			int id = heartbeats.front().first;
+			if (heartbeats.front().second + rtt + (id%2 == 1? jitter : 0) > loop.nowMS) {
+				break;
+			}
+			Receive("<U><M>u7</M><L><A>CLIENT_HEARTBEAT</A><A>0</A><A>3</A><A></A><A>" + std::to_string(id) + "</A></L></U>");
+			heartbeats.pop_front();
+			answered++;
+		}
+	}
+	void Chatter() {
+		Receive("<U><M>u7</M><L><A>CHAT</A><A>0</A><A>5</A><A></A><A>hi</A></L></U>");
+	}
+
+	const SimLoop& loop;
+	bool connected = false;
+	int disconnects = 0;
+	int pings = 0;
+	size_t answered = 0;
+	std::deque<std::pair<int, uint64_t>> heartbeats;
+	std::vector<uint64_t> sent;
+};
+
+struct HeartbeatFixture {
+	HeartbeatFixture() {
+		ConnectionMonitor& m = client.GetConnectionMonitor();
+		m.SetEventLoop(&loop);
+		m.SetClock([this]() { return loop.NowNanos(); });
+		m.SetHeartbeatFrequency(1000);
+		m.SetConnectionTimeout(10000);
+		m.SetAutoReconnectFrequency(-1);
+	}
+	ConnectionMonitor& Monitor() { return client.GetConnectionMonitor(); }
+
+	/** run for ms, a server answering heartbeats after rtt ms, with odd numbered ones taking jitter ms more */
+	void Serve(uint64_t ms, uint64_t rtt, uint64_t jitter=0) {
+		for (uint64_t t=0; t<ms; t+=10) {
+			loop.Advance(10);
+			connector.AnswerDue(rtt, jitter);
+		}
+	}
+
+	SimLoop loop;
+	HeartbeatConnector connector{loop};
+	UnionClient client{connector};
+};
+
+TEST(Heartbeat, FixedIgnoresTraffic) {
+	HeartbeatFixture f;
+	f.client.Connect();
+	ASSERT_TRUE(f.client.IsReady());
+	for (int i=0; i<10; i++) {
+		f.connector.Chatter();
+		f.Serve(1000, 20);
+	}
+	EXPECT_EQ(10u, f.connector.sent.size());
+	EXPECT_EQ(0, f.connector.disconnects);
+	EXPECT_NEAR(20000, f.Monitor().GetMeanRTT(), 1);
+}
+
+TEST(Heartbeat, AdaptiveQuietWhileBusy) {
+	HeartbeatFixture f;
+	f.Monitor().SetAdaptiveHeartbeat(true, 1000, 1000);
+	f.client.Connect();
+	for (int i=0; i<100; i++) { // something in every 300ms, so the link is never quiet for a whole second
+		f.connector.Chatter();
+		f.Serve(300, 20);
+	}
+	EXPECT_TRUE(f.connector.sent.empty());
+
+	// goes quiet. the first heartbeat is within two intervals, as traffic is only noticed on the tick
+	uint64_t quiet = f.loop.nowMS - 300;
+	f.Serve(2000, 20);
+	ASSERT_EQ(1u, f.connector.sent.size());
+	EXPECT_GE(f.connector.sent[0], quiet + 1000);
+	EXPECT_LE(f.connector.sent[0], quiet + 2000);
+	// after that, one for each interval of quiet after a reply, as the replies are timed exactly
+	f.Serve(10200, 20);
+	ASSERT_EQ(11u, f.connector.sent.size());
+	for (size_t i=1; i<f.connector.sent.size(); i++) {
+		EXPECT_EQ(1020u, f.connector.sent[i] - f.connector.sent[i-1]);
+	}
+	EXPECT_EQ(0, f.connector.disconnects);
+}
+
+TEST(Heartbeat, AdaptiveStillTimesOut) {
+	HeartbeatFixture f;
+	f.Monitor().SetAdaptiveHeartbeat(true, 1000, 1000);
+	f.client.Connect();
+	f.loop.Advance(1000);
+	ASSERT_EQ(1u, f.connector.sent.size());
+	for (int i=0; i<9; i++) { // chatter keeps the heartbeat from repeating, but the unanswered one still counts
+		f.connector.Chatter();
+		f.loop.Advance(1000);
+	}
+	EXPECT_EQ(1u, f.connector.sent.size());
+	EXPECT_EQ(0, f.connector.disconnects);
+	f.connector.Chatter();
+	f.loop.Advance(1000);
+	f.connector.Chatter();
+	f.loop.Advance(1000);
+	EXPECT_EQ(1, f.connector.disconnects);
+	EXPECT_FALSE(f.client.IsReady());
+
+	f.loop.Advance(20000); // and stopped
+	EXPECT_EQ(1u, f.connector.sent.size());
+}
+
+TEST(Heartbeat, AdaptiveIntervalFollowsJitter) {
+	HeartbeatFixture f;
+	f.Monitor().SetAdaptiveHeartbeat(true, 1000, 4000);
+	f.client.Connect();
+	EXPECT_EQ(1000, f.Monitor().GetHeartbeatInterval());
+	f.Serve(60000, 50); // steady
+	EXPECT_EQ(4000, f.Monitor().GetHeartbeatInterval());
+	EXPECT_NEAR(50000, f.Monitor().GetSmoothedRTT(), 1000);
+
+	f.Serve(30000, 50, 800); // all over the place
+	EXPECT_EQ(1000, f.Monitor().GetHeartbeatInterval());
+
+	f.Monitor().SetConnectionTimeout(3000); // the interval is kept within half the timeout
+	f.Serve(60000, 50);
+	EXPECT_EQ(1500, f.Monitor().GetHeartbeatInterval());
+	EXPECT_EQ(0, f.connector.disconnects);
+}
+
+TEST(Heartbeat, PingPublishedOnChange) {
+	HeartbeatFixture f;
+	f.Monitor().SetPingPublishThreshold(20, 30000);
+	f.client.Connect();
+	f.Serve(10000, 10);
+	EXPECT_EQ(1, f.connector.pings); // the first, then nothing worth saying
+	f.Serve(30000, 200);
+	int moved = f.connector.pings;
+	EXPECT_GT(moved, 2);
+	EXPECT_LT(moved, 11);
+	f.Serve(30000, 200); // steady, but the interval brings one out
+	EXPECT_EQ(moved+1, f.connector.pings);
+
+	f.Monitor().SetPingPublishThreshold(20, 0); // on every reply, as it used to be
+	f.Serve(5000, 200);
+	EXPECT_EQ(moved+6, f.connector.pings);
+}
@@ -0,0 +1,143 @@
+#include <chrono>
+#include <gtest/gtest.h>
+
+#include "CommonTypes.h"
+#include "MessageNotifier.h"
+
+/*
+ * NotifyMessageListeners() is protected, as the UnionBridge is normally the only thing driving it
+ */
+class TestMessageNotifier: public MessageNotifier {
+public:
+	void Notify(const UserMessageID& message, const std::vector<ClientID>& clients, const std::vector<RoomID>& rooms, const StringArgs& msg) {
+		NotifyMessageListeners(message, clients, rooms, msg);
+	}
+	size_t Keys(const UserMessageID& message) {
+		MsgRoute& route = msgListeners[message];
+		return route.byRoom.size() + route.byClient.size();
+	}
+	size_t Registrations(const UserMessageID& message) {
+		return msgListeners[message].listeners.size();
+	}
+};
+
+TEST(MessageNotifier, RoutesByRoom) {
+	TestMessageNotifier notifier;
+	int inA=0, inB=0, anyRoom=0;
+	auto a = notifier.AddMessageListener("CHAT", {}, {"lobby.a"}, [&inA](const UserMessageID&, const StringArgs&) { inA++; });
+	auto b = notifier.AddMessageListener("CHAT", {}, {"lobby.b"}, [&inB](const UserMessageID&, const StringArgs&) { inB++; });
+	auto any = notifier.AddMessageListener("CHAT", [&anyRoom](const UserMessageID&, const StringArgs&) { anyRoom++; });
+
+	notifier.Notify("CHAT", {}, {"lobby.a"}, {"hi"});
+	EXPECT_EQ(1, inA);
+	EXPECT_EQ(0, inB);
+	EXPECT_EQ(1, anyRoom);
+
+	notifier.Notify("CHAT", {}, {}, {"everyone"});
+	EXPECT_EQ(2, inA);
+	EXPECT_EQ(1, inB);
+	EXPECT_EQ(2, anyRoom);
+
+	notifier.Notify("OTHER", {}, {"lobby.a"}, {});
+	EXPECT_EQ(2, inA);
+}
+
+TEST(MessageNotifier, FiltersByClient) {
+	TestMessageNotifier notifier;
+	int from3=0, from4=0;
+	auto l3 = notifier.AddMessageListener("CHAT", {"3"}, {}, [&from3](const UserMessageID&, const StringArgs&) { from3++; });
+	auto l4 = notifier.AddMessageListener("CHAT", {"4"}, {}, [&from4](const UserMessageID&, const StringArgs&) { from4++; });
+
+	notifier.Notify("CHAT", {"3"}, {}, {});
+	EXPECT_EQ(1, from3);
+	EXPECT_EQ(0, from4);
+
+	notifier.Notify("CHAT", {}, {"lobby"}, {});
+	EXPECT_EQ(1, from3);
+	EXPECT_EQ(0, from4);
+}
+
+TEST(MessageNotifier, DeliversOnceAcrossKeys) {
+	TestMessageNotifier notifier;
+	int calls=0;
+	auto l = notifier.AddMessageListener("CHAT", {"3"}, {"a", "b"}, [&calls](const UserMessageID&, const StringArgs&) { calls++; });
+
+	notifier.Notify("CHAT", {"3"}, {"a", "b"}, {});
+	EXPECT_EQ(1, calls);
+}
+
+TEST(MessageNotifier, RemovesAndExpires) {
+	TestMessageNotifier notifier;
+	int calls=0;
+	auto l = notifier.AddMessageListener("CHAT", {}, {"a"}, [&calls](const UserMessageID&, const StringArgs&) { calls++; });
+	EXPECT_TRUE(notifier.HasMessageListener("CHAT", l));
+	notifier.RemoveMessageListener("CHAT", l);
+	EXPECT_FALSE(notifier.HasMessageListener("CHAT", l));
+	notifier.Notify("CHAT", {}, {"a"}, {});
+	EXPECT_EQ(0, calls);
+
+	auto m = notifier.AddMessageListener("CHAT", {}, {"a"}, [&calls](const UserMessageID&, const StringArgs&) { calls++; });
+	m = nullptr;
+	notifier.Notify("CHAT", {}, {"a"}, {});
+	notifier.Notify("CHAT", {}, {}, {});
+	EXPECT_EQ(0, calls);
+}
+
+TEST(MessageNotifier, PrunesKeysThatGoQuiet) {
+	TestMessageNotifier notifier;
+	int calls=0;
+	auto l = notifier.AddMessageListener("CHAT", {"3"}, {"a", "b"}, [&calls](const UserMessageID&, const StringArgs&) { calls++; });
+	auto m = notifier.AddMessageListener("CHAT", {}, {"c"}, [&calls](const UserMessageID&, const StringArgs&) { calls++; });
+	EXPECT_EQ(4u, notifier.Keys("CHAT"));
+	notifier.RemoveMessageListener("CHAT", l);
+	EXPECT_EQ(1u, notifier.Keys("CHAT"));
+
+	m = nullptr; // "c" never hears another message, but a broadcast still clears it out
+	notifier.Notify("CHAT", {}, {}, {});
+	EXPECT_EQ(0u, notifier.Keys("CHAT"));
+	EXPECT_EQ(0u, notifier.Registrations("CHAT"));
+
+	CBModMsgRef n;
+	n = notifier.AddMessageListener("CHAT", {}, {"d"}, [&notifier, &n, &calls](const UserMessageID&, const StringArgs&) {
+		calls++;
+		notifier.RemoveMessageListener("CHAT", n); // from inside a notification, so the key goes once it's over
+	});
+	notifier.Notify("CHAT", {}, {"d"}, {});
+	notifier.Notify("CHAT", {}, {"d"}, {});
+	EXPECT_EQ(1, calls);
+	EXPECT_EQ(0u, notifier.Keys("CHAT"));
+}
+
+/*
+ * benchmark: 1000 rooms, one listener on each, plus a message to a random room per iteration. the index should make each delivery cost about
+ * the same as a lookup, where a scan of every listener costs a thousand filter checks
+ */
+TEST(MessageNotifier, BenchmarkRoomRouting) {
+	static const int kRooms = 1000;
+	static const int kMessages = 200000;
+	TestMessageNotifier notifier;
+	std::vector<RoomID> roomIDs;
+	std::vector<CBModMsgRef> handles;
+	long delivered = 0;
+	for (int i=0; i<kRooms; i++) {
+		roomIDs.push_back("meeting." + std_to_string(i));
+		handles.push_back(notifier.AddMessageListener("CHAT_MESSAGE", {}, {roomIDs.back()}, [&delivered](const UserMessageID&, const StringArgs&) {
+			delivered++;
+		}));
+	}
+	StringArgs body = {"a chat message of about the usual sort of length for the benchmark"};
+	std::vector<std::vector<RoomID>> targets;
+	for (int i=0; i<kRooms; i++) {
+		targets.push_back({roomIDs[i]});
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i=0; i<kMessages; i++) {
+		notifier.Notify("CHAT_MESSAGE", {}, targets[(i*7919)%kRooms], body);
+	}
+	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+	EXPECT_EQ(kMessages, delivered);
+	std::cout << "[ BENCHMARK] " << kMessages << " room messages over " << kRooms << " listeners/rooms: " << elapsed << "us, "
+			<< (elapsed*1000.0/kMessages) << "ns per message" << std::endl;
+}
@@ -14,3 +14,94 @@ TEST(Notifier, NotifyLambdaInHandle) {
 
 	ASSERT_TRUE(called);
 }
+
+/*
+ * counts its copies and moves, to check how the notifiers hand their parameters about
+ */
+struct Counted {
+	Counted() { }
+	Counted(const Counted&) { copies++; }
+	Counted(Counted&&) { moves++; }
+	Counted& operator=(const Counted&) { copies++; return *this; }
+	Counted& operator=(Counted&&) { moves++; return *this; }
+
+	static void Reset() { copies = 0; moves = 0; }
+	static int copies;
+	static int moves;
+};
+int Counted::copies = 0;
+int Counted::moves = 0;
+
+TEST(Notifier, NotifyPassesByReference) {
+	Notifier<Counted> notifier;
+	int calls = 0;
+	std::vector<std::shared_ptr<NXR<Counted>::CB>> handles;
+	for (int i=0; i<10; i++) {
+		handles.push_back(notifier.AddEventListener(1, [&calls](EventType, const Counted&) {
+			calls++;
+		}));
+	}
+	Counted payload;
+	Counted::Reset();
+	notifier.NotifyListeners(1, payload);
+
+	EXPECT_EQ(10, calls);
+	EXPECT_EQ(0, Counted::copies);
+	EXPECT_EQ(0, Counted::moves);
+}
+
+TEST(Notifier, DispatchMovesPayloadOnce) {
+	Dispatcher<Counted> dispatcher;
+	int calls = 0;
+	std::vector<std::shared_ptr<NXR<Counted>::CB>> handles;
+	for (int i=0; i<10; i++) {
+		handles.push_back(dispatcher.AddEventListener(1, [&calls](EventType, const Counted&) {
+			calls++;
+		}));
+	}
+	dispatcher.pending.reserve(1);
+	Counted::Reset();
+	dispatcher.DispatchEvent(1, Counted());
+	EXPECT_EQ(0, Counted::copies);
+	EXPECT_EQ(1, Counted::moves);
+
+	dispatcher.ProcessDispatches();
+	EXPECT_EQ(10, calls);
+	EXPECT_EQ(0, Counted::copies);
+	EXPECT_EQ(1, Counted::moves);
+}
+
+TEST(Notifier, DispatchInOrder) {
+	Dispatcher<int> dispatcher;
+	std::vector<int> seen;
+	auto l = dispatcher.AddEventListener(1, [&seen](EventType, int v) {
+		seen.push_back(v);
+	});
+	dispatcher.DispatchEvent(1, 1);
+	dispatcher.DispatchEvent(1, 2);
+	dispatcher.DispatchEvent(2, 99);
+	dispatcher.DispatchEvent(1, 3);
+	dispatcher.ProcessDispatches();
+
+	ASSERT_EQ(3u, seen.size());
+	EXPECT_EQ(1, seen[0]);
+	EXPECT_EQ(2, seen[1]);
+	EXPECT_EQ(3, seen[2]);
+}
+
+TEST(Notifier, DispatchGoesToListenersAtQueueTime) {
+	Dispatcher<int> dispatcher;
+	std::vector<int> early, late, gone;
+	auto e = dispatcher.AddEventListener(1, [&early](EventType, int v) { early.push_back(v); });
+	auto g = dispatcher.AddEventListener(1, [&gone](EventType, int v) { gone.push_back(v); });
+	dispatcher.DispatchEvent(1, 1);
+	auto l = dispatcher.AddEventListener(1, [&late](EventType, int v) { late.push_back(v); });
+	g.reset();
+	dispatcher.DispatchEvent(1, 2);
+	dispatcher.ProcessDispatches();
+
+	EXPECT_EQ(std::vector<int>({ 1, 2 }), early);
+	EXPECT_EQ(std::vector<int>({ 2 }), late); // added after the first was queued
+	EXPECT_TRUE(gone.empty()); // its handle went before the queue was processed
+	EXPECT_EQ(2u, dispatcher.listeners.size()); // and the second dispatch dropped it
+}
@@ -0,0 +1,202 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+#include <gtest/gtest.h>
+
+#include "uv.h"
+#include "CommonTypes.h"
+#include "UCLowerHeaders.h"
+#include "connector/UVConnection.h"
+#include "UVEventLoop.h"
+
+/*
+ * a local echo server, on a loop and thread of its own, listening on loopback tcp and on a unix domain socket
+ */
+struct EchoServer {
+	EchoServer() {
+		path = "/tmp/unionclient-echo-" + std::to_string(getpid()) + ".sock";
+		unlink(path.c_str());
+		uv_loop_init(&loop);
+		uv_tcp_init(&loop, &tcp);
+		sockaddr_in a;
+		uv_ip4_addr("127.0.0.1", 0, &a);
+		uv_tcp_bind(&tcp, (sockaddr*)&a, 0);
+		tcp.data = this;
+		uv_listen((uv_stream_t*)&tcp, 16, OnConnection);
+		int n = sizeof(a);
+		uv_tcp_getsockname(&tcp, (sockaddr*)&a, &n);
+		port = ntohs(a.sin_port);
+		uv_pipe_init(&loop, &pipe, 0);
+		uv_pipe_bind(&pipe, path.c_str());
+		pipe.data = this;
+		uv_listen((uv_stream_t*)&pipe, 16, OnConnection);
+		uv_async_init(&loop, &stop, [](uv_async_t* h) {
+			uv_stop(h->loop);
+		});
+		runner = std::thread([this]() {
+			uv_run(&loop, UV_RUN_DEFAULT);
+		});
+	}
+	~EchoServer() {
+		uv_async_send(&stop);
+		runner.join();
+		unlink(path.c_str());
+	}
+
+	static void OnConnection(uv_stream_t* server, int status) {
+		if (status < 0) return;
+		uv_stream_t* client;
+		if (server->type == UV_NAMED_PIPE) {
+			uv_pipe_t* p = new uv_pipe_t();
+			uv_pipe_init(server->loop, p, 0);
+			client = (uv_stream_t*)p;
+		} else {
+			uv_tcp_t* t = new uv_tcp_t();
+			uv_tcp_init(server->loop, t);
+			uv_tcp_nodelay(t, 1);
+			client = (uv_stream_t*)t;
+		}
+		if (uv_accept(server, client) == 0) {
+			uv_read_start(client, [](uv_handle_t*, size_t suggested, uv_buf_t* buf) {
+				*buf = uv_buf_init(new char[suggested], (unsigned)suggested);
+			}, OnRead);
+		}
+	}
+	static void OnRead(uv_stream_t* client, ssize_t n, const uv_buf_t* buf) {
+		if (n > 0) {
+			uv_write_t* w = new uv_write_t();
+			uv_buf_t b = uv_buf_init(buf->base, (unsigned)n);
+			w->data = buf->base;
+			uv_write(w, client, &b, 1, [](uv_write_t* w, int) {
+				delete[] (char*)w->data;
+				delete w;
+			});
+			return;
+		}
+		delete[] buf->base;
+		if (n < 0) uv_close((uv_handle_t*)client, nullptr); // the handle itself is left for the process to clean up
+	}
+
+	uv_loop_t loop;
+	uv_tcp_t tcp;
+	uv_pipe_t pipe;
+	uv_async_t stop;
+	std::thread runner;
+	std::string path;
+	int port;
+};
+
+/*
+ * the top of the stack, counting what comes back
+ */
+struct EchoUpper: public CnxLayerUpper {
+	virtual int Receive(const char *data, const size_t len) override {
+		received += len;
+		if (onReceive) onReceive();
+		return 0;
+	}
+	virtual void OnOpen() override { open = true; }
+	virtual void OnClose() override { open = false; }
+	virtual void OnOpenFailure(const std::string msg, const int status) override { failed = true; }
+	std::atomic<bool> open { false };
+	std::atomic<bool> failed { false };
+	std::atomic<size_t> received { 0 };
+	std::function<void()> onReceive;
+};
+
+static bool
+WaitFor(std::function<bool()> done, int ms=20000)
+{
+	auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+	while (!done()) {
+		if (std::chrono::steady_clock::now() > end) return false;
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+	return true;
+}
+
+struct EchoResult {
+	double meanRTTMicros;
+	double mbPerSec;
+};
+
+/**
+ * ping pong 64 byte messages, then stream a lot through, over the given layer
+ */
+static EchoResult
+Measure(CnxLayer& layer, EchoUpper& upper)
+{
+	EchoResult r = { 0, 0 };
+	layer.Open();
+	EXPECT_TRUE(WaitFor([&]() { return upper.open || upper.failed; }));
+	EXPECT_TRUE(upper.open);
+	if (!upper.open) return r;
+
+	const int pings = 2000;
+	std::string ping(64, 'p');
+	std::atomic<int> pongs(0);
+	upper.received = 0;
+	upper.onReceive = [&]() {
+		while (upper.received >= (size_t)(pongs+1)*ping.size()) {
+			if (++pongs < pings) layer.Write(ping.data(), ping.size());
+		}
+	};
+	auto start = std::chrono::steady_clock::now();
+	layer.Write(ping.data(), ping.size());
+	EXPECT_TRUE(WaitFor([&]() { return pongs >= pings; }));
+	r.meanRTTMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count()/pings;
+
+	upper.onReceive = nullptr;
+	upper.received = 0;
+	const size_t chunk = 64*1024;
+	const size_t total = 64*1024*1024;
+	std::string block(chunk, 'b');
+	start = std::chrono::steady_clock::now();
+	for (size_t sent=0; sent<total; sent+=chunk) {
+		layer.Write(block.data(), block.size());
+	}
+	EXPECT_TRUE(WaitFor([&]() { return upper.received >= total; }));
+	double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	r.mbPerSec = total/(1024.0*1024.0)/s;
+
+	layer.Close();
+	WaitFor([&]() { return !upper.open; }, 2000);
+	return r;
+}
+
+TEST(Pipe, EndpointParsing) {
+	EXPECT_TRUE(UVPipeCnxLayer::IsPipeEndpoint("unix:/var/run/union.sock"));
+	EXPECT_FALSE(UVPipeCnxLayer::IsPipeEndpoint("union.example.com"));
+	EXPECT_EQ("/var/run/union.sock", UVPipeCnxLayer::PipePath("unix:/var/run/union.sock"));
+
+	StandardUVConnector connector("union.example.com", "80");
+	UVWSConnection* local = connector.AddLocalConnection("/var/run/union.sock");
+	EXPECT_EQ(local, connector.Connection(0));
+	EXPECT_EQ("ws+unix:/var/run/union.sock", static_cast<AbstractConnection*>(local)->ShortName());
+	EXPECT_TRUE(local->HasProperties({ CONNECTION_LOCAL, CONNECTION_PERSISTENT }));
+}
+
+TEST(Pipe, AgainstLoopbackTCP) {
+	EchoServer server;
+	EchoUpper tcpUpper;
+	UVCnxLayer tcp(&tcpUpper, std::to_string(server.port), "127.0.0.1");
+	EchoResult t = Measure(tcp, tcpUpper);
+
+	EchoUpper pipeUpper;
+	UVPipeCnxLayer pipe(&pipeUpper, server.path);
+	EchoResult p = Measure(pipe, pipeUpper);
+
+	std::cout << "loopback tcp: " << t.meanRTTMicros << "us round trip, " << t.mbPerSec << "MB/s" << std::endl;
+	std::cout << "unix socket:  " << p.meanRTTMicros << "us round trip, " << p.mbPerSec << "MB/s" << std::endl;
+	EXPECT_GT(p.mbPerSec, 0);
+	EXPECT_GT(t.mbPerSec, 0);
+}
+
+TEST(Pipe, NobodyThere) {
+	EchoUpper upper;
+	UVPipeCnxLayer pipe(&upper, "/tmp/unionclient-nobody-" + std::to_string(getpid()) + ".sock");
+	pipe.Open();
+	EXPECT_TRUE(WaitFor([&]() { return upper.failed.load(); }, 5000));
+	EXPECT_FALSE(upper.open);
+}
@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <gtest/gtest.h>
+
+#include "CommonTypes.h"
+#include "UCUpperHeaders.h"
+#include "UCLowerHeaders.h"
+
+TEST(Reconnect, UniformStaysInRange) {
+	UniformReconnectPolicy p(7);
+	for (int i=0; i<1000; i++) {
+		int d = p.NextDelay(1500, 1600, i);
+		EXPECT_GE(d, 1500);
+		EXPECT_LE(d, 1600);
+	}
+	EXPECT_EQ(2000, p.NextDelay(2000, 2000, 3));
+}
+
+TEST(Reconnect, BackoffGrowsToCap) {
+	BackoffReconnectPolicy p(20000, 7);
+	int first = p.NextDelay(1500, 1600, 0);
+	EXPECT_GE(first, 1500);
+	EXPECT_LE(first, 1600);
+	int top = 0;
+	for (int i=1; i<200; i++) {
+		int d = p.NextDelay(1500, 1600, i);
+		EXPECT_GE(d, 1500);
+		EXPECT_LE(d, 20000);
+		top = std::max(top, d);
+	}
+	EXPECT_GT(top, 15000);
+
+	double early = 0, late = 0; // averaged over many clients, each step is further out
+	for (unsigned seed=0; seed<1000; seed++) {
+		BackoffReconnectPolicy c(30000, seed);
+		for (int i=0; i<6; i++) {
+			int d = c.NextDelay(1000, 1000, i);
+			if (i == 1) early += d;
+			if (i == 5) late += d;
+		}
+	}
+	EXPECT_GT(late, early*2);
+
+	p.Reset();
+	first = p.NextDelay(1500, 1600, 0);
+	EXPECT_LE(first, 1600);
+}
+
+/*
+ * every client loses the server within the same 100ms, and it stays down for outageMS. each tries at once, as the monitor does, then
+ * again after whatever its policy picks. counts attempts landing in each second, and each client's time until it gets back in
+ */
+struct Outage {
+	std::vector<int> perSecond;
+	uint64_t attempts = 0;
+	Histogram downtime;
+
+	int Peak(size_t from) const {
+		int peak = 0;
+		for (size_t s=from; s<perSecond.size(); s++) {
+			peak = std::max(peak, perSecond[s]);
+		}
+		return peak;
+	}
+};
+
+static Outage
+SimulateOutage(std::function<std::shared_ptr<ReconnectPolicy>(unsigned)> policy, int clients, int outageMS)
+{
+	Outage o;
+	for (int c=0; c<clients; c++) {
+		std::shared_ptr<ReconnectPolicy> p = policy(c);
+		int dropped = c%100;
+		int t = dropped;
+		for (int attempt=0; ; attempt++) {
+			o.attempts++;
+			if ((size_t)t/1000 >= o.perSecond.size()) {
+				o.perSecond.resize(t/1000 + 1);
+			}
+			o.perSecond[t/1000]++;
+			if (t >= outageMS) {
+				break;
+			}
+			t += p->NextDelay(ConnectionMonitor::kDefltARMinMS, ConnectionMonitor::kDefltARMaxMS, attempt);
+		}
+		o.downtime.Add(t - dropped);
+	}
+	return o;
+}
+
+TEST(Reconnect, ThunderingHerd) {
+	const int clients = 10000;
+	const int outage = 60000;
+	Outage uniform = SimulateOutage([](unsigned seed) { return std::make_shared<UniformReconnectPolicy>(seed); }, clients, outage);
+	Outage backoff = SimulateOutage([](unsigned seed) { return std::make_shared<BackoffReconnectPolicy>(30000, seed); }, clients, outage);
+
+	std::cout << "attempts per second, " << clients << " clients, server down " << outage/1000 << "s" << std::endl;
+	std::cout << "    s  uniform  backoff" << std::endl;
+	size_t n = std::max(uniform.perSecond.size(), backoff.perSecond.size());
+	for (size_t s=0; s<n; s+=5) {
+		int u = 0, b = 0;
+		for (size_t i=s; i<s+5 && i<n; i++) {
+			if (i < uniform.perSecond.size()) u += uniform.perSecond[i];
+			if (i < backoff.perSecond.size()) b += backoff.perSecond[i];
+		}
+		printf("%5d %8.0f %8.0f\n", (int)s, u/5.0, b/5.0);
+	}
+	std::cout << "total attempts " << uniform.attempts << " / " << backoff.attempts
+			<< ", peak after restart " << uniform.Peak(outage/1000) << " / " << backoff.Peak(outage/1000)
+			<< ", p99 downtime " << uniform.downtime.GetPercentile(99) << " / " << backoff.downtime.GetPercentile(99) << "ms" << std::endl;
+
+	EXPECT_LT(backoff.attempts*4, uniform.attempts);
+	EXPECT_LT(backoff.Peak(outage/1000)*4, uniform.Peak(outage/1000));
+	EXPECT_LT(backoff.Peak(20), 1500); // the steady load while down, once the first waves have spread out
+	EXPECT_LE(backoff.downtime.GetMax(), (uint64_t)outage + 30000 + 100);
+}
@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <deque>
+#include <gtest/gtest.h>
+
+#include "UnionClient.h"
+
+/*
+ * plays a union server for one session after another, each with a new client id. what's sent is kept per session, and while hold is
+ * set, the answers are kept back till Answer(), so that a test can see everything that went out before anything came back
+ */
+class SessionConnector: public AbstractConnector {
+public:
+	virtual bool IsReady() const { return true; }
+	virtual int Connect() {
+		session++;
+		sent.clear();
+		NotifyListeners(Event::BEGIN_CONNECT, nullptr, "", UPC::Status::SUCCESS);
+		NotifyListeners(Event::CONNECTED, nullptr, "", UPC::Status::SUCCESS);
+		Receive("u29", { Self() });
+		Receive("u63", {});
+		return 0;
+	}
+	virtual int Disconnect() {
+		NotifyListeners(Event::DISCONNECTED, nullptr, "", UPC::Status::SUCCESS);
+		return 0;
+	}
+	virtual int Send(const std::string msg) {
+		std::string method = Method(msg);
+		StringArgs args = Args(msg);
+		sent.push_back(method);
+		if (method == "u4") {
+			if (refused.count(args[0]) != 0) {
+				Answer("u72", { args[0], "PERMISSION_DENIED" });
+			} else {
+				Answer("u54", { "", args[0], "2", "0", "topic|cards", "7", "", "0", "", "", Self(), "", "0", "", "" });
+				Answer("u6", { args[0] });
+				Answer("u72", { args[0], "SUCCESS" });
+			}
+		} else if (method == "u10") {
+			Answer("u44", { args[0] });
+			Answer("u76", { args[0], "SUCCESS" });
+		} else if (method == "u58") {
+			Answer("u54", { "", args[0], "1", "1", "", "7", "", "0", "", "", Self(), "", "1", "", "" });
+			Answer("u59", { args[0] });
+			Answer("u77", { args[0], "SUCCESS" });
+		} else if (method == "u26") {
+			Answer("u42", { args[0], args[1], "SUCCESS" });
+		} else if (method == "u3") {
+			Answer("u8", { args[4], args[0], "", args[2], args[3], args[5] });
+			Answer("u73", { args[4], args[0], "", args[2], args[5], "SUCCESS" });
+		}
+		return 0;
+	}
+	virtual void SetConnectionAttributes(ConnectionAttributes) {}
+	virtual void SetActiveConnectionSessionID(std::string) {}
+	virtual void SetConnectionAffinity(std::string host, int durationSec) {}
+
+	void Answer() {
+		while (!held.empty()) {
+			std::string upc = held.front();
+			held.pop_front();
+			NotifyListeners(Event::RECEIVE_DATA, nullptr, upc, UPC::Status::SUCCESS);
+		}
+	}
+	int Count(const std::string& method) const {
+		return (int) std::count(sent.begin(), sent.end(), method);
+	}
+	ClientID Self() const {
+		return std::to_string(100 + session);
+	}
+
+	int session = 0;
+	bool hold = false;
+	std::vector<std::string> sent;
+	std::deque<std::string> held;
+	std::unordered_set<RoomID> refused;
+
+protected:
+	void Answer(const std::string& method, const StringArgs& args) {
+		held.push_back(UPC(method, args));
+		if (!hold) Answer();
+	}
+	void Receive(const std::string& method, const StringArgs& args) {
+		NotifyListeners(Event::RECEIVE_DATA, nullptr, UPC(method, args), UPC::Status::SUCCESS);
+	}
+	static std::string UPC(const std::string& method, const StringArgs& args) {
+		std::string upc = "<U><M>" + method + "</M><L>";
+		for (auto& a: args) upc += "<A>" + a + "</A>";
+		return upc + "</L></U>";
+	}
+	static std::string Method(const std::string& upc) {
+		size_t at = upc.find("<M>") + 3;
+		return upc.substr(at, upc.find("</M>") - at);
+	}
+	static StringArgs Args(const std::string& upc) {
+		StringArgs args;
+		for (size_t at = upc.find("<A>"); at != std::string::npos; at = upc.find("<A>", at)) {
+			at += 3;
+			args.push_back(upc.substr(at, upc.find("</A>", at) - at));
+		}
+		return args;
+	}
+};
+
+TEST(Restore, PipelinedReplay) {
+	SessionConnector server;
+	UnionClient client(server);
+	client.SetAutoReconnectFrequency(-1);
+	SessionRestorer& restorer = client.GetUnionBridge().GetSessionRestorer();
+	uint64_t now = 0;
+	restorer.SetClock([&now]() { return now; });
+	RoomManager& rooms = client.GetRoomManager();
+
+	client.Connect();
+	ASSERT_TRUE(client.IsReady());
+	EXPECT_EQ(0u, restorer.GetRestoreStats().restores); // a first session has nothing to put back
+	rooms.JoinRoom("game.table1", "secret", 31);
+	rooms.JoinRoom("game.table2");
+	rooms.ObserveRoom("game.lobby");
+	rooms.WatchForRooms("game");
+	client.Self()->SetAttribute("nick", "dak");
+	RoomRef table1 = rooms.Get("game.table1");
+	ASSERT_TRUE(table1 != nullptr);
+	EXPECT_TRUE(table1->ClientIsInRoom());
+	EXPECT_EQ("cards", table1->GetAttribute("topic"));
+	EXPECT_TRUE(table1->GetOccupantList().Contains("101"));
+
+	int leaves = 0;
+	RoomRef table2 = rooms.Get("game.table2");
+	CBStatusRef leaveListener = std::make_shared<CBStatus>([&leaves](EventType, const UPCStatus&) { leaves++; });
+	table2->NXStatus::AddListener(Event::LEAVE, leaveListener);
+
+	server.Disconnect();
+	now += 1500*1000000ull;
+	server.refused.insert("game.table2");
+	server.hold = true;
+	client.Connect();
+	ASSERT_TRUE(client.IsReady());
+
+	// the whole lot went out on READY, with nothing back yet
+	EXPECT_TRUE(restorer.IsRestoring());
+	EXPECT_EQ(1, server.Count("u3"));
+	EXPECT_EQ(1, server.Count("u64"));
+	EXPECT_EQ(2, server.Count("u4"));
+	EXPECT_EQ(1, server.Count("u58"));
+	EXPECT_EQ(1, server.Count("u26"));
+	EXPECT_FALSE(server.held.empty());
+	// ... and the cache kept what it had in the meantime
+	EXPECT_EQ(table1, rooms.Get("game.table1"));
+	EXPECT_EQ("cards", table1->GetAttribute("topic"));
+
+	now += 40*1000000ull;
+	server.Answer();
+	EXPECT_FALSE(restorer.IsRestoring());
+	const SessionRestorer::RestoreStats& stats = restorer.GetRestoreStats();
+	EXPECT_EQ(1u, stats.restores);
+	EXPECT_EQ(6u, stats.requests);
+	EXPECT_EQ(1u, stats.failures);
+	EXPECT_EQ(40u, stats.sinceReady.GetMax());
+	EXPECT_EQ(1540u, stats.sinceLost.GetMax());
+
+	// the snapshot reconciled the room we kept: our old self is gone, our new one is in
+	EXPECT_EQ(table1, rooms.Get("game.table1"));
+	EXPECT_TRUE(table1->ClientIsInRoom());
+	EXPECT_FALSE(table1->GetOccupantList().Contains("101"));
+	EXPECT_TRUE(table1->GetOccupantList().Contains("102"));
+	EXPECT_TRUE(table1->GetOccupantList().Contains("7"));
+	EXPECT_TRUE(rooms.HasObservedRoom("game.lobby"));
+	EXPECT_TRUE(rooms.IsWatchingQualifier("game"));
+	EXPECT_EQ("dak", client.Self()->GetAttribute("nick"));
+	// the room we couldn't get back into is dropped, as if we'd left it
+	EXPECT_FALSE(rooms.HasOccupiedRoom("game.table2"));
+	EXPECT_EQ(1, leaves);
+
+	// and a third session puts back the same, less what was refused
+	server.Disconnect();
+	server.hold = false;
+	client.Connect();
+	EXPECT_EQ(1, server.Count("u4"));
+	EXPECT_EQ(2u, stats.restores);
+	EXPECT_EQ(1u, stats.failures);
+	EXPECT_TRUE(table1->GetOccupantList().Contains("103"));
+	EXPECT_FALSE(table1->GetOccupantList().Contains("102"));
+}
+
+TEST(Restore, LeavingForgetsUpdateLevels) {
+	SessionConnector server;
+	UnionClient client(server);
+	client.SetAutoReconnectFrequency(-1);
+	RoomManager& rooms = client.GetRoomManager();
+
+	client.Connect();
+	rooms.JoinRoom("game.table1", "secret", 31);
+	EXPECT_EQ(1, server.Count("u64"));
+	rooms.Get("game.table1")->Leave();
+	EXPECT_FALSE(rooms.HasOccupiedRoom("game.table1"));
+	rooms.ObserveRoom("game.table1");
+
+	server.Disconnect();
+	client.Connect();
+	EXPECT_EQ(0, server.Count("u4"));
+	EXPECT_EQ(1, server.Count("u58"));
+	EXPECT_EQ(0, server.Count("u64")); // they went with the room we left
+}
+
+TEST(Restore, NotAfterDisconnecting) {
+	SessionConnector server;
+	UnionClient client(server);
+	client.SetAutoReconnectFrequency(-1);
+	RoomManager& rooms = client.GetRoomManager();
+
+	client.Connect();
+	rooms.JoinRoom("game.table1", "secret");
+	rooms.ObserveRoom("game.lobby");
+	client.Disconnect();
+	client.Connect();
+	EXPECT_EQ(0, server.Count("u4"));
+	EXPECT_EQ(0, server.Count("u58"));
+	EXPECT_EQ(0u, client.GetUnionBridge().GetSessionRestorer().GetRestoreStats().restores);
+}
+
+TEST(Restore, CanBeTurnedOff) {
+	SessionConnector server;
+	UnionClient client(server);
+	client.SetAutoReconnectFrequency(-1);
+	client.GetUnionBridge().GetSessionRestorer().SetEnabled(false);
+
+	client.Connect();
+	client.GetRoomManager().JoinRoom("game.table1");
+	server.Disconnect();
+	client.Connect();
+	EXPECT_EQ(0, server.Count("u4"));
+	EXPECT_EQ(0u, client.GetUnionBridge().GetSessionRestorer().GetRestoreStats().restores);
+}
@@ -418,3 +418,26 @@ TEST_F(RoomTest, MessageOK) {
 //	EXPECT_EQ(clientId, "6");
 //	EXPECT_EQ(status, UPC::Status::SUCCESS);
 }
+
+class BroadcastConnector: public ConnectingConnector {
+public:
+	void Broadcast(const ClientID from, const RoomID room) {
+		NotifyListeners(Event::RECEIVE_DATA, nullptr, "<U><M>u7</M><L><A>CHAT</A><A>1</A><A>" + from + "</A><A>" + room + "</A><A>hi</A></L></U>",
+				UPC::Status::SUCCESS);
+	}
+};
+
+TEST(RoomBroadcast, RoutesBySender) {
+	BroadcastConnector connector;
+	UnionClient client(connector);
+	client.Connect();
+	int from6=0, from7=0, inRoom=0;
+	CBModMsgRef l6 = client.GetUnionBridge().AddMessageListener("CHAT", {"6"}, {}, [&from6](const UserMessageID&, const StringArgs&) { from6++; });
+	CBModMsgRef l7 = client.GetUnionBridge().AddMessageListener("CHAT", {"7"}, {}, [&from7](const UserMessageID&, const StringArgs&) { from7++; });
+	CBModMsgRef lr = client.GetUnionBridge().AddMessageListener("CHAT", {"6"}, {"theRoom"}, [&inRoom](const UserMessageID&, const StringArgs&) { inRoom++; });
+
+	connector.Broadcast("6", "theRoom");
+	EXPECT_EQ(1, from6);
+	EXPECT_EQ(0, from7);
+	EXPECT_EQ(1, inRoom); // filed under the room and the sender, and heard once
+}
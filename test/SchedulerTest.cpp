@@ -0,0 +1,202 @@
+#include <map>
+#include <random>
+#include <gtest/gtest.h>
+
+#include "CommonTypes.h"
+#include "UCUpperHeaders.h"
+#include "UCLowerHeaders.h"
+
+/*
+ * a DispatchUPC with the same scheduling stage as the UnionBridge, recording the order things get handled in
+ */
+class SchedulingDispatcher: public DispatchUPC {
+public:
+	UPCScheduler scheduler;
+	std::vector<std::pair<int, StringArgs>> seen;
+	std::vector<CBUPCRef> handles;
+
+	void Listen(std::vector<int> methods) {
+		for (int m: methods) {
+			handles.push_back(AddEventListener(m, [this](EventType t, const StringArgs& a, UPCStatus) {
+				seen.push_back(std::make_pair(t, a));
+			}));
+		}
+	}
+protected:
+	virtual void PrepareDispatches(std::vector<ER>& batch) override {
+		scheduler.Schedule(batch);
+	}
+	virtual void WillDispatch(const ER& event) override {
+		scheduler.WillDispatch(event);
+	}
+};
+
+TEST(Scheduler, ControlOvertakesBulk) {
+	SchedulingDispatcher d;
+	d.Listen({8, 72, 7});
+	for (int i=0; i<100; i++) {
+		d.DispatchEvent(8, {"", "c1", "", "a", std::to_string(i), "0"}, 0);
+	}
+	d.DispatchEvent(7, {"CHAT", "0", "c2", ""}, 0);
+	d.DispatchEvent(72, {"lobby", "SUCCESS"}, 0);
+	d.ProcessDispatches();
+
+	ASSERT_EQ(102u, d.seen.size());
+	EXPECT_EQ(72, d.seen[0].first);
+	EXPECT_EQ(7, d.seen[1].first);
+	for (int i=0; i<100; i++) {
+		EXPECT_EQ(std::to_string(i), d.seen[i+2].second[4]);
+	}
+}
+
+TEST(Scheduler, KeepsRoomOrder) {
+	SchedulingDispatcher d;
+	d.Listen({131, 36, 72});
+	d.DispatchEvent(131, {"r2", "1"}, 0);
+	d.DispatchEvent(131, {"r1", "1"}, 0);
+	d.DispatchEvent(36, {"r1", "c1", "", ""}, 0);
+	d.DispatchEvent(131, {"r2", "2"}, 0);
+	d.DispatchEvent(72, {"r1", "SUCCESS"}, 0);
+	d.ProcessDispatches();
+
+	ASSERT_EQ(5u, d.seen.size());
+	EXPECT_EQ(131, d.seen[0].first); // r1 traffic ahead of the join result is promoted with it
+	EXPECT_EQ("r1", d.seen[0].second[0]);
+	EXPECT_EQ(36, d.seen[1].first);
+	EXPECT_EQ(72, d.seen[2].first);
+	EXPECT_EQ("1", d.seen[3].second[1]);
+	EXPECT_EQ("r2", d.seen[3].second[0]);
+	EXPECT_EQ("2", d.seen[4].second[1]);
+}
+
+TEST(Scheduler, KeepsClientAndUserOrder) {
+	SchedulingDispatcher d;
+	d.Listen({8, 88, 49, 102, 7});
+	d.DispatchEvent(8, {"", "c9", "", "a", "1", "0"}, 0);
+	d.DispatchEvent(88, {"c1", "alice", "", ""}, 0);
+	d.DispatchEvent(102, {"c2"}, 0);
+	d.DispatchEvent(7, {"CHAT", "0", "c2", ""}, 0);
+	d.DispatchEvent(49, {"alice", "SUCCESS"}, 0);
+	d.ProcessDispatches();
+
+	ASSERT_EQ(5u, d.seen.size());
+	EXPECT_EQ(88, d.seen[0].first); // promoted with the login result, rather than overtaken by it
+	EXPECT_EQ(49, d.seen[1].first);
+	EXPECT_EQ(102, d.seen[2].first); // the client is added before its message is
+	EXPECT_EQ(7, d.seen[3].first);
+	EXPECT_EQ(8, d.seen[4].first);
+}
+
+TEST(Scheduler, EventsAreBarriers) {
+	const int connected = Event::CONNECTED;
+	SchedulingDispatcher d;
+	d.Listen({8, 72, connected});
+	d.DispatchEvent(8, {"", "c1", "", "a", "1", "0"}, 0);
+	d.DispatchEvent(connected, {}, 0);
+	d.DispatchEvent(8, {"", "c1", "", "a", "2", "0"}, 0);
+	d.DispatchEvent(72, {"lobby", "SUCCESS"}, 0);
+	d.ProcessDispatches();
+
+	ASSERT_EQ(4u, d.seen.size());
+	EXPECT_EQ(8, d.seen[0].first);
+	EXPECT_EQ(connected, d.seen[1].first);
+	EXPECT_EQ(72, d.seen[2].first);
+	EXPECT_EQ(8, d.seen[3].first);
+}
+
+TEST(Scheduler, Overrides) {
+	SchedulingDispatcher d;
+	d.Listen({7, 8});
+	d.scheduler.SetPriority(7, UPCScheduler::kPriorityBulk);
+	d.scheduler.SetPriority(8, UPCScheduler::kPriorityControl);
+	EXPECT_EQ(UPCScheduler::kPriorityControl, d.scheduler.GetPriority(8));
+	d.DispatchEvent(7, {"CHAT", "0", "c2", ""}, 0);
+	d.DispatchEvent(8, {"", "c1", "", "a", "1", "0"}, 0);
+	d.ProcessDispatches();
+
+	ASSERT_EQ(2u, d.seen.size());
+	EXPECT_EQ(8, d.seen[0].first);
+
+	d.scheduler.ResetPriorities();
+	EXPECT_EQ(UPCScheduler::kPriorityBulk, d.scheduler.GetPriority(8));
+	EXPECT_EQ(UPCScheduler::kPriorityNormal, d.scheduler.GetPriority(7));
+}
+
+/*
+ * random batches: whatever the reordering, each room's, each client's, and each class's messages must come out in the order they went in
+ */
+TEST(Scheduler, StressKeepsOrdering) {
+	static const int methods[] = { 6, 7, 8, 9, 29, 36, 37, 54, 72, 131, 132, 161 };
+	static const char* rooms[] = { "", "r1", "r2", "r3", "r4" };
+	SchedulingDispatcher d;
+	d.Listen(std::vector<int>(std::begin(methods), std::end(methods)));
+	std::mt19937 rng(99);
+	int total = 0;
+	for (int round=0; round<50; round++) {
+		d.seen.clear();
+		int n = rng()%200;
+		for (int i=0; i<n; i++) {
+			int m = methods[rng()%12];
+			std::string room = rooms[rng()%5];
+			std::string seq = std::to_string(i);
+			switch (m) {
+			case 7: d.DispatchEvent(m, {"CHAT", "0", "c1", room, seq}, 0); break;
+			case 8: d.DispatchEvent(m, {room, "c1", "", "a", seq, "0", seq}, 0); break;
+			case 54: d.DispatchEvent(m, {"", room, "0", "0", seq}, 0); break;
+			default: d.DispatchEvent(m, {room, seq}, 0); break;
+			}
+		}
+		d.ProcessDispatches();
+		ASSERT_EQ((size_t)n, d.seen.size());
+		total += n;
+
+		std::map<std::string, int> lastInRoom;
+		std::map<std::string, int> lastFromClient;
+		int lastInClass[UPCScheduler::kNumPriorities] = { -1, -1, -1 };
+		for (auto& it: d.seen) {
+			int seq = atoi(it.second.back().c_str());
+			const std::string* room = UPCScheduler::RoomKey(it.first, it.second);
+			const std::string* client = UPCScheduler::ClientKey(it.first, it.second);
+			if (room != nullptr) {
+				auto r = lastInRoom.find(*room);
+				if (r != lastInRoom.end()) {
+					EXPECT_LT(r->second, seq);
+				}
+				lastInRoom[*room] = seq;
+			}
+			if (client != nullptr) { // may go with a room's traffic, but never past the client's own
+				auto c = lastFromClient.find(*client);
+				if (c != lastFromClient.end()) {
+					EXPECT_LT(c->second, seq);
+				}
+				lastFromClient[*client] = seq;
+			}
+			if (room == nullptr && client == nullptr) {
+				int p = d.scheduler.GetPriority(it.first);
+				EXPECT_LT(lastInClass[p], seq);
+				lastInClass[p] = seq;
+			}
+		}
+	}
+	uint64_t waited = 0;
+	for (int p=0; p<UPCScheduler::kNumPriorities; p++) {
+		waited += d.scheduler.GetWaitHistogram(p).GetCount();
+		EXPECT_EQ(50u, d.scheduler.GetDepthHistogram(p).GetCount());
+	}
+	EXPECT_EQ((uint64_t)total, waited);
+}
+
+TEST(Scheduler, Histogram) {
+	Histogram h;
+	for (int i=1; i<=100; i++) {
+		h.Add(i);
+	}
+	h.Add(0);
+	EXPECT_EQ(101u, h.GetCount());
+	EXPECT_EQ(1u, h.GetBucket(0));
+	EXPECT_EQ(1u, h.GetBucket(1));
+	EXPECT_EQ(2u, h.GetBucket(2));
+	EXPECT_EQ(100u, h.GetMax());
+	EXPECT_EQ(63u, h.GetPercentile(50));
+	EXPECT_EQ(100u, h.GetPercentile(99));
+}
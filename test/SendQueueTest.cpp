@@ -0,0 +1,345 @@
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <gtest/gtest.h>
+
+#include "uv.h"
+#include "CommonTypes.h"
+#include "UCLowerHeaders.h"
+#include "connector/UVConnection.h"
+#include "UVEventLoop.h"
+
+extern UVEventLoop worker;
+
+/** a upc of the given method, padded out to len bytes */
+static std::string
+Upc(int method, size_t len)
+{
+	std::string head = "<U><M>u" + std::to_string(method) + "</M><L><A>";
+	std::string tail = "</A></L></U>";
+	return head + std::string(len - head.size() - tail.size(), 'x') + tail;
+}
+
+/*
+ * a transport that only takes bytes off its hands when Read() says so, standing in for a socket to a reader that can't keep up
+ */
+struct SlowTransport {
+	SlowTransport(size_t maxBytes, size_t maxCount, size_t window) {
+		q.Attach([this](const std::string& msg) {
+			std::lock_guard<std::mutex> g(lock);
+			got.push_back(msg);
+			pending += msg.size();
+			return 0;
+		}, [this]() {
+			std::lock_guard<std::mutex> g(lock);
+			return pending;
+		});
+		q.SetLimits(maxBytes, maxCount);
+		q.SetWriteWindow(window);
+		q.SetWatermarkCallback([this](const bool high, const size_t, const size_t) {
+			if (high) highs++; else drains++;
+		});
+	}
+	void Read(size_t n) {
+		{
+			std::lock_guard<std::mutex> g(lock);
+			pending -= std::min(n, pending);
+		}
+		q.Flush();
+	}
+	size_t Got() {
+		std::lock_guard<std::mutex> g(lock);
+		return got.size();
+	}
+
+	SendQueue q;
+	std::mutex lock;
+	std::vector<std::string> got;
+	size_t pending = 0;
+	std::atomic<int> highs { 0 };
+	std::atomic<int> drains { 0 };
+};
+
+TEST(SendQueue, WatermarksAndReject) {
+	SlowTransport t(1000, 100, 100);
+	t.q.SetPolicy(SendQueue::kPriorityNormal, SendQueue::kPolicyReject);
+	EXPECT_EQ(0, t.q.Send(Upc(2, 100))); // straight through, and that's the window full
+	EXPECT_EQ(0u, t.q.GetBytes());
+	for (int i=0; i<10; i++) {
+		EXPECT_EQ(0, t.q.Send(Upc(2, 100)));
+		EXPECT_EQ(i >= 7? 1 : 0, t.highs.load());
+	}
+	EXPECT_TRUE(t.q.IsHigh());
+	EXPECT_EQ(1000u, t.q.GetBytes());
+	EXPECT_EQ(SendQueue::kErrQueueFull, t.q.Send(Upc(2, 100)));
+	EXPECT_EQ(1u, t.q.GetStats().rejected);
+
+	// the reader picks up, a message at a time, and we drain back down past the low watermark
+	for (int i=0; i<10; i++) {
+		t.Read(100);
+		EXPECT_EQ(i >= 7? 1 : 0, t.drains.load());
+	}
+	EXPECT_FALSE(t.q.IsHigh());
+	EXPECT_EQ(0u, t.q.GetCount());
+	EXPECT_EQ(11u, t.Got());
+	const SendQueue::Stats& stats = t.q.GetStats();
+	EXPECT_EQ(11u, stats.sent);
+	EXPECT_EQ(1000u, stats.peakBytes);
+}
+
+TEST(SendQueue, DropsOldestBulk) {
+	SlowTransport t(10*100, 1000, 100);
+	t.q.Send(Upc(2, 100));
+	for (int i=0; i<50; i++) {
+		std::string m = Upc(1, 100);
+		m[20] = (char)('A' + i%26);
+		EXPECT_EQ(0, t.q.Send(m));
+		EXPECT_LE(t.q.GetBytes(), 1000u);
+	}
+	// a join still gets in, in place of the oldest broadcast, rather than waiting
+	EXPECT_EQ(0, t.q.Send(Upc(4, 100)));
+	const SendQueue::Stats& stats = t.q.GetStats();
+	EXPECT_EQ(41u, stats.dropped);
+	EXPECT_EQ(0u, stats.blocked);
+	EXPECT_EQ(10u, t.q.GetCount());
+	while (t.q.GetCount() > 0) {
+		t.Read(100000);
+	}
+	ASSERT_EQ(11u, t.Got());
+	EXPECT_EQ('A' + 41%26, t.got[1][20]); // the newest broadcasts are the ones that went
+	EXPECT_NE(std::string::npos, t.got.back().find("<M>u4</M>"));
+	EXPECT_EQ(1000u, stats.peakBytes);
+}
+
+TEST(SendQueue, PrioritiesFromUPCIds) {
+	SendQueue q;
+	EXPECT_EQ(4, UPC::ID::ToCode(UPC::ID::JOIN_ROOM));
+	EXPECT_EQ(-1, UPC::ID::ToCode("4"));
+	EXPECT_EQ(SendQueue::kPriorityBulk, q.GetPriority(UPC::ID::ToCode(UPC::ID::SEND_MESSAGE_TO_ROOMS)));
+	EXPECT_EQ(SendQueue::kPriorityControl, q.GetPriority(UPC::ID::ToCode(UPC::ID::LOGOFF)));
+	EXPECT_EQ(SendQueue::kPriorityControl, q.GetPriority(UPC::ID::ToCode(UPC::ID::SET_ROOM_UPDATE_LEVELS)));
+	EXPECT_EQ(SendQueue::kPriorityNormal, q.GetPriority(UPC::ID::ToCode(UPC::ID::SEND_MESSAGE_TO_CLIENTS)));
+}
+
+TEST(SendQueue, BlocksOffLoopThreadOnly) {
+	SlowTransport t(500, 100, 100);
+	for (int i=0; i<6; i++) {
+		t.q.Send(Upc(2, 100));
+	}
+	EXPECT_EQ(500u, t.q.GetBytes());
+
+	// off the loop thread, a normal upc waits for the reader
+	std::thread reader([&t]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		t.Read(200);
+	});
+	EXPECT_EQ(0, t.q.Send(Upc(2, 100)));
+	reader.join();
+	SendQueue::Stats stats = t.q.GetStats();
+	EXPECT_EQ(1u, stats.blocked);
+	EXPECT_GE(stats.blockedMS.GetMax(), 40u);
+	EXPECT_EQ(0u, stats.rejected);
+
+	// ... but no longer than it's allowed
+	t.q.SetPolicy(SendQueue::kPriorityNormal, SendQueue::kPolicyBlock, 20);
+	auto start = std::chrono::steady_clock::now();
+	EXPECT_EQ(SendQueue::kErrQueueFull, t.q.Send(Upc(2, 100)));
+	EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+
+	// and the loop thread, which would be waiting on itself, is turned away at once
+	t.q.SetPolicy(SendQueue::kPriorityNormal, SendQueue::kPolicyBlock, 5000);
+	t.q.SetLoopThreadCheck([]() { return true; });
+	start = std::chrono::steady_clock::now();
+	EXPECT_EQ(SendQueue::kErrQueueFull, t.q.Send(Upc(2, 100)));
+	EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(1000));
+	t.q.SetLoopThreadCheck(nullptr);
+
+	// a queue cleared under a blocked sender turns it away too
+	std::thread closer([&t]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		t.q.Clear();
+	});
+	EXPECT_EQ(SendQueue::kErrQueueFull, t.q.Send(Upc(2, 100)));
+	closer.join();
+	EXPECT_EQ(0u, t.q.GetCount());
+	EXPECT_EQ(3u, t.q.GetStats().rejected);
+}
+
+/*
+ * a web socket server on loopback that answers the upgrade and then stops reading, with a small receive buffer, till Resume(). after that
+ * it reads and throws away everything
+ */
+struct StalledServer {
+	StalledServer() {
+		uv_loop_init(&loop);
+		uv_tcp_init(&loop, &tcp);
+		sockaddr_in a;
+		uv_ip4_addr("127.0.0.1", 0, &a);
+		uv_tcp_bind(&tcp, (sockaddr*)&a, 0);
+		tcp.data = this;
+		uv_listen((uv_stream_t*)&tcp, 16, OnConnection);
+		int n = sizeof(a);
+		uv_tcp_getsockname(&tcp, (sockaddr*)&a, &n);
+		port = ntohs(a.sin_port);
+		uv_async_init(&loop, &stop, [](uv_async_t* h) {
+			uv_stop(h->loop);
+		});
+		uv_async_init(&loop, &resume, [](uv_async_t* h) {
+			StalledServer* s = (StalledServer*)h->data;
+			s->reading = true;
+			uv_read_start((uv_stream_t*)&s->client, Alloc, OnRead);
+		});
+		resume.data = this;
+		runner = std::thread([this]() {
+			uv_run(&loop, UV_RUN_DEFAULT);
+		});
+	}
+	~StalledServer() {
+		uv_async_send(&stop);
+		runner.join();
+	}
+	void Resume() {
+		uv_async_send(&resume);
+	}
+
+	static void Alloc(uv_handle_t*, size_t suggested, uv_buf_t* buf) {
+		*buf = uv_buf_init(new char[suggested], (unsigned)suggested);
+	}
+	static void OnConnection(uv_stream_t* listener, int status) {
+		StalledServer* s = (StalledServer*)listener->data;
+		if (status < 0 || s->accepted) return;
+		uv_tcp_init(listener->loop, &s->client);
+		s->client.data = s;
+		if (uv_accept(listener, (uv_stream_t*)&s->client) == 0) {
+			s->accepted = true;
+			int size = 16*1024;
+			uv_recv_buffer_size((uv_handle_t*)&s->client, &size);
+			uv_read_start((uv_stream_t*)&s->client, Alloc, OnRead);
+		}
+	}
+	static void OnRead(uv_stream_t* stream, ssize_t n, const uv_buf_t* buf) {
+		StalledServer* s = (StalledServer*)stream->data;
+		if (n > 0) {
+			s->received += n;
+			if (!s->upgraded) {
+				s->in.append(buf->base, n);
+				if (s->in.find("\r\n\r\n") != std::string::npos) {
+					s->upgraded = true;
+					static const char* answer = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n\r\n";
+					uv_write_t* w = new uv_write_t();
+					uv_buf_t b = uv_buf_init((char*)answer, (unsigned)strlen(answer));
+					uv_write(w, stream, &b, 1, [](uv_write_t* w, int) {
+						delete w;
+					});
+					if (!s->reading) uv_read_stop(stream);
+				}
+			}
+		}
+		delete[] buf->base;
+	}
+
+	uv_loop_t loop;
+	uv_tcp_t tcp;
+	uv_tcp_t client;
+	uv_async_t stop;
+	uv_async_t resume;
+	std::thread runner;
+	int port;
+	bool accepted = false;
+	bool upgraded = false;
+	bool reading = false;
+	std::string in;
+	std::atomic<size_t> received { 0 };
+};
+
+static bool
+WaitFor(std::function<bool()> done, int ms=20000)
+{
+	auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+	while (!done()) {
+		if (std::chrono::steady_clock::now() > end) return false;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return true;
+}
+
+static void
+OnWorker(std::function<void()> f)
+{
+	std::atomic<bool> done(false);
+	worker.Schedule(0, 0, [&]() {
+		f();
+		done = true;
+	});
+	WaitFor([&]() { return done.load(); });
+}
+
+TEST(SendQueue, SlowReaderOverWebSocket) {
+	const size_t maxBytes = 256*1024;
+	StalledServer server;
+	UVWSConnection* ws = new UVWSConnection(std::to_string(server.port), "127.0.0.1");
+	SendQueue& q = ws->GetSendQueue();
+	q.SetLimits(maxBytes, 1024);
+	StandardConnector connector;
+	connector.AddConnection(ws);
+	connector.SetEventLoop(&worker);
+	std::atomic<bool> connected(false);
+	std::atomic<int> highs(0), drains(0);
+	CBConnectionRef listener = std::make_shared<CBConnection>([&](EventType e, const CnxRef&, const std::string& data, const ConnectionStatus& count) {
+		switch (e) {
+		case Event::CONNECTED: connected = true; break;
+		case Event::SEND_QUEUE_HIGH: highs++; break;
+		case Event::SEND_QUEUE_DRAINED: drains++; break;
+		}
+	});
+	for (EventType e: { Event::CONNECTED, Event::SEND_QUEUE_HIGH, Event::SEND_QUEUE_DRAINED }) {
+		connector.AddListener(e, listener);
+	}
+	OnWorker([&]() {
+		connector.Connect();
+	});
+	ASSERT_TRUE(WaitFor([&]() { return connected.load(); }));
+
+	// broadcast flat out, a bit at a time so the kernel buffers get the chance to fill, till we've been told to ease off
+	const std::string broadcast = Upc(1, 4096);
+	size_t sent = 0, maxUnsent = 0;
+	for (int i=0; i<32000 && highs == 0; i++) {
+		OnWorker([&]() {
+			for (int j=0; j<8; j++) {
+				EXPECT_EQ(0, connector.Send(broadcast));
+			}
+			sent += 8*broadcast.size();
+			maxUnsent = std::max(maxUnsent, ws->GetUnsentBytes());
+		});
+	}
+	ASSERT_EQ(1, highs.load());
+	for (int i=0; i<20; i++) { // and some more, which have to push out what's queued
+		OnWorker([&]() {
+			for (int j=0; j<64; j++) {
+				connector.Send(broadcast);
+			}
+			maxUnsent = std::max(maxUnsent, ws->GetUnsentBytes());
+		});
+	}
+	SendQueue::Stats stats = q.GetStats();
+	std::cout << "stalled after " << sent/1024 << "K, " << stats.dropped << " dropped, peak queue "
+			<< stats.peakBytes/1024 << "K, most unsent " << maxUnsent/1024 << "K" << std::endl;
+	EXPECT_GT(stats.dropped, 0u);
+	EXPECT_LE(stats.peakBytes, maxBytes);
+	EXPECT_LE(maxUnsent, SendQueue::kDfltWriteWindow + broadcast.size() + 16);
+	EXPECT_EQ(0, drains.load());
+
+	// the reader wakes up, and everything queued goes
+	server.Resume();
+	ASSERT_TRUE(WaitFor([&]() { return drains.load() == 1; }));
+	ASSERT_TRUE(WaitFor([&]() { return q.GetCount() == 0 && ws->GetUnsentBytes() == 0; }));
+	EXPECT_FALSE(q.IsHigh());
+	EXPECT_EQ(1, highs.load());
+
+	OnWorker([&]() {
+		connector.SetEventLoop(nullptr);
+		connector.Disconnect();
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(200)); // for the close callbacks on the worker
+}
@@ -0,0 +1,79 @@
+/*
+ * SimLoop.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: dak
+ */
+
+#ifndef SIMLOOP_H_
+#define SIMLOOP_H_
+
+#include <list>
+
+/*
+ * an EventLoop on a simulated clock. timers only fire from Advance(), on the test's thread
+ */
+class SimLoop: public EventLoop {
+public:
+	struct Entry {
+		Timer timer;
+		uint64_t due;
+		bool live;
+	};
+
+	virtual TimerRef Schedule(uint64_t delayMS, uint64_t repeatMs, TimerCB cb) override {
+		timers.push_back(Entry());
+		Entry& e = timers.back();
+		e.timer.tikCB = std::move(cb);
+		e.timer.delayMS = delayMS;
+		e.timer.repeatMs = repeatMs;
+		e.timer.generation = ++generations;
+		e.due = nowMS + delayMS;
+		e.live = true;
+		return &e.timer;
+	}
+	virtual void CancelTimer(TimerRef r) override {
+		for (auto& e: timers) {
+			if (r.Is(&e.timer)) e.live = false;
+		}
+	}
+	virtual WorkerRef Worker(WorkerCB w, WorkerCB aw) override {
+		w();
+		if (aw) aw();
+		return nullptr;
+	}
+	virtual void CancelWorker(WorkerRef) override {}
+	virtual void Lock() override {}
+	virtual void Unlock() override {}
+
+	void Advance(uint64_t ms) {
+		uint64_t end = nowMS + ms;
+		for (;;) {
+			Entry* next = nullptr;
+			for (auto it=timers.begin(); it!=timers.end(); ) {
+				if (!it->live) { // fired or cancelled, so nobody should still be holding it
+					it = timers.erase(it);
+					continue;
+				}
+				if (it->due <= end && (next == nullptr || it->due < next->due)) next = &*it;
+				++it;
+			}
+			if (next == nullptr) break;
+			nowMS = next->due;
+			if (next->timer.repeatMs > 0) {
+				next->due += next->timer.repeatMs;
+			} else {
+				next->live = false;
+			}
+			next->timer.tikCB();
+		}
+		nowMS = end;
+	}
+	uint64_t NowNanos() const { return nowMS*1000000; }
+
+	uint64_t nowMS = 1000;
+	std::list<Entry> timers;
+	uint64_t generations = 0;
+};
+
+#endif /* SIMLOOP_H_ */
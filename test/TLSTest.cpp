@@ -0,0 +1,266 @@
+#include <gtest/gtest.h>
+
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/x509v3.h>
+
+#include "CommonTypes.h"
+#include "UCLowerHeaders.h"
+#include "connector/TLSCnxLayer.h"
+#include "SimLoop.h"
+
+/*
+ * a self signed certificate for cn, made up on the spot
+ */
+struct SelfSigned {
+	SelfSigned(const std::string cn) {
+		EVP_PKEY_CTX* kc = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+		EVP_PKEY_keygen_init(kc);
+		EVP_PKEY_CTX_set_ec_paramgen_curve_nid(kc, NID_X9_62_prime256v1);
+		EVP_PKEY_keygen(kc, &key);
+		EVP_PKEY_CTX_free(kc);
+
+		cert = X509_new();
+		X509_set_version(cert, 2);
+		ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+		X509_gmtime_adj(X509_getm_notBefore(cert), -60);
+		X509_gmtime_adj(X509_getm_notAfter(cert), 24*3600);
+		X509_set_pubkey(cert, key);
+		X509_NAME* name = X509_get_subject_name(cert);
+		X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)cn.c_str(), -1, -1, 0);
+		X509_set_issuer_name(cert, name);
+		X509_EXTENSION* san = X509V3_EXT_conf_nid(nullptr, nullptr, NID_subject_alt_name, (char*)("DNS:" + cn).c_str());
+		X509_add_ext(cert, san, -1);
+		X509_EXTENSION_free(san);
+		X509_sign(cert, key, EVP_sha256());
+
+		BIO* b = BIO_new(BIO_s_mem());
+		PEM_write_bio_X509(b, cert);
+		char* p;
+		long n = BIO_get_mem_data(b, &p);
+		pem.assign(p, n);
+		BIO_free(b);
+	}
+	~SelfSigned() {
+		X509_free(cert);
+		EVP_PKEY_free(key);
+	}
+	EVP_PKEY* key = nullptr;
+	X509* cert = nullptr;
+	std::string pem;
+};
+
+/*
+ * plays an s_server with the given certificate at the other end of the socket, echoing whatever it is sent with a '>' in front of the first. each way
+ * takes oneWayMS, and so does the tcp handshake
+ */
+class StandInTLSServer: public CnxLayer {
+public:
+	StandInTLSServer(SimLoop& loop, const SelfSigned& id, int oneWayMS, int maxVersion=0)
+		: CnxLayer(nullptr, nullptr), loop(loop), oneWayMS(oneWayMS) {
+		connectState = ConnectionState::NOT_CONNECTED;
+		ctx = SSL_CTX_new(TLS_server_method());
+		SSL_CTX_use_certificate(ctx, id.cert);
+		SSL_CTX_use_PrivateKey(ctx, id.key);
+		if (maxVersion) SSL_CTX_set_max_proto_version(ctx, maxVersion);
+	}
+	~StandInTLSServer() {
+		if (ssl) SSL_free(ssl);
+		SSL_CTX_free(ctx);
+	}
+
+	virtual int Open() override {
+		opens++;
+		loop.Schedule(2*oneWayMS, 0, [this]() {
+			if (ssl) SSL_free(ssl);
+			ssl = SSL_new(ctx);
+			SSL_set_bio(ssl, BIO_new(BIO_s_mem()), BIO_new(BIO_s_mem()));
+			SSL_set_accept_state(ssl);
+			echoed = false;
+			connectState = ConnectionState::READY;
+			openedAt = loop.nowMS;
+			upper->OnOpen();
+		});
+		return 0;
+	}
+	virtual int Close() override {
+		if (connectState != ConnectionState::NOT_CONNECTED) {
+			connectState = ConnectionState::NOT_CONNECTED;
+			loop.Schedule(0, 0, [this]() {
+				upper->OnClose();
+			});
+		}
+		return 0;
+	}
+	virtual int Write(const char *data, const size_t len) override {
+		std::string bytes(data, len);
+		loop.Schedule(oneWayMS, 0, [this, bytes]() {
+			if (connectState == ConnectionState::READY) Arrive(bytes);
+		});
+		return (int)len;
+	}
+
+	void Arrive(const std::string bytes) {
+		BIO_write(SSL_get_rbio(ssl), bytes.data(), (int)bytes.size());
+		if (!SSL_is_init_finished(ssl)) {
+			if (SSL_do_handshake(ssl) == 1) {
+				handshakes++;
+				if (SSL_session_reused(ssl)) resumed++;
+			}
+		}
+		if (SSL_is_init_finished(ssl)) {
+			char buf[4096];
+			int n;
+			while ((n = SSL_read(ssl, buf, sizeof(buf))) > 0) {
+				std::string echo = (echoed? "" : ">") + std::string(buf, n);
+				echoed = true;
+				SSL_write(ssl, echo.data(), (int)echo.size());
+			}
+		}
+		std::string out;
+		char buf[4096];
+		int n;
+		while ((n = BIO_read(SSL_get_wbio(ssl), buf, sizeof(buf))) > 0) {
+			out.append(buf, n);
+		}
+		if (out.size() > 0) {
+			loop.Schedule(oneWayMS, 0, [this, out]() {
+				if (connectState == ConnectionState::READY) upper->Receive(out.data(), out.size());
+			});
+		}
+	}
+
+	SimLoop& loop;
+	int oneWayMS;
+	SSL_CTX* ctx;
+	SSL* ssl = nullptr;
+	bool echoed = false;
+	int opens = 0;
+	int handshakes = 0;
+	int resumed = 0;
+	uint64_t openedAt = 0;
+};
+
+/*
+ * the protocol layer's end
+ */
+struct TLSUpper: public CnxLayerUpper {
+	TLSUpper(SimLoop& loop)
+		: loop(loop) {}
+	virtual int Receive(const char *data, const size_t len) override {
+		received.append(data, len);
+		return 0;
+	}
+	virtual void OnOpen() override { opens++; openedAt = loop.nowMS; }
+	virtual void OnClose() override { closes++; }
+	virtual void OnOpenFailure(const std::string msg, const int status) override { failures++; failure = msg; failStatus = status; }
+	SimLoop& loop;
+	std::string received;
+	int opens = 0;
+	int closes = 0;
+	int failures = 0;
+	int failStatus = 0;
+	uint64_t openedAt = 0;
+	std::string failure;
+};
+
+struct TLSFixture {
+	TLSFixture(int maxVersion=0)
+		: id("union.example.com")
+		, server(loop, id, 20, maxVersion)
+		, context(std::make_shared<TLSContext>())
+		, upper(loop)
+		, tls(&upper, &server, context) {
+		server.upper = &tls;
+		context->AddTrustedCertificate(id.pem);
+		tls.SetHost("union.example.com");
+		tls.SetService("443");
+	}
+	/** connect, say hello, and hang up. @return the simulated ms the tls handshake took */
+	uint64_t Session(const std::string msg="hello") {
+		int opens = upper.opens;
+		tls.Open();
+		loop.Advance(1000);
+		EXPECT_EQ(opens + 1, upper.opens);
+		uint64_t ms = upper.openedAt - server.openedAt;
+		upper.received.clear();
+		tls.Write(msg.data(), msg.size());
+		loop.Advance(100);
+		EXPECT_EQ(">" + msg, upper.received);
+		tls.Close();
+		loop.Advance(10);
+		return ms;
+	}
+
+	SimLoop loop;
+	SelfSigned id;
+	StandInTLSServer server;
+	std::shared_ptr<TLSContext> context;
+	TLSUpper upper;
+	TLSCnxLayer tls;
+};
+
+TEST(TLS, HandshakeAndEcho) {
+	TLSFixture f;
+	f.Session();
+	EXPECT_EQ(1, f.upper.opens);
+	EXPECT_EQ(1, f.upper.closes);
+	EXPECT_EQ(0, f.upper.failures);
+	EXPECT_EQ(1u, f.context->GetStats().handshakes);
+	EXPECT_EQ(0u, f.context->GetStats().resumed);
+	EXPECT_EQ(1u, f.context->GetSessionCount());
+
+	std::string big(100000, 'x'); // more than a record, and more than a read
+	f.Session(big);
+}
+
+TEST(TLS, ResumesAcrossReconnects) {
+	const int n = 20;
+	const char* names[] = { "tls 1.2", "tls 1.3" };
+	int versions[] = { TLS1_2_VERSION, 0 };
+	for (int v=0; v<2; v++) {
+		TLSFixture f(versions[v]);
+		uint64_t fullMS = f.Session();
+		uint64_t resumedMS = 0;
+		for (int i=1; i<n; i++) {
+			resumedMS += f.Session();
+		}
+		const TLSContext::Stats& s = f.context->GetStats();
+		std::cout << names[v] << ": " << s.handshakes << " handshakes, resumption rate " << s.GetResumptionRate()
+				<< ", full " << fullMS << "ms simulated / " << s.fullMicros.GetMean() << "us crypto at both ends, resumed "
+				<< resumedMS/(n-1) << "ms simulated / " << s.resumedMicros.GetMean() << "us" << std::endl;
+		EXPECT_EQ((uint64_t)n, s.handshakes);
+		EXPECT_EQ((uint64_t)n-1, s.resumed);
+		EXPECT_EQ(n-1, f.server.resumed);
+		if (versions[v] == TLS1_2_VERSION) {
+			EXPECT_LT(resumedMS/(n-1), fullMS); // a round trip less
+		}
+	}
+
+	TLSFixture f; // and with it off, every one is a full handshake
+	f.context->SetSessionResumption(false);
+	for (int i=0; i<3; i++) f.Session();
+	EXPECT_EQ(0u, f.context->GetStats().resumed);
+	EXPECT_EQ(0, f.server.resumed);
+}
+
+TEST(TLS, UntrustedCertificateFails) {
+	TLSFixture f;
+	std::shared_ptr<TLSContext> strict = std::make_shared<TLSContext>(); // doesn't know our self signed one
+	f.tls.SetContext(strict);
+	f.tls.Open();
+	f.loop.Advance(1000);
+	EXPECT_EQ(0, f.upper.opens);
+	EXPECT_EQ(1, f.upper.failures);
+	EXPECT_EQ(TLSCnxLayer::kErrHandshake, f.upper.failStatus);
+	EXPECT_EQ(0, f.upper.closes); // the socket's close stays with us
+	EXPECT_EQ(1u, strict->GetStats().failures);
+
+	f.tls.SetContext(f.context); // right certificate, wrong name
+	f.tls.SetHost("elsewhere.example.com");
+	f.tls.Open();
+	f.loop.Advance(1000);
+	EXPECT_EQ(0, f.upper.opens);
+	EXPECT_EQ(2, f.upper.failures);
+	EXPECT_NE(std::string::npos, f.upper.failure.find("mismatch"));
+}
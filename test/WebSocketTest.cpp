@@ -0,0 +1,378 @@
+#include <cstring>
+#include <zlib.h>
+#include <gtest/gtest.h>
+
+#include "CommonTypes.h"
+#include "UCLowerHeaders.h"
+
+/*
+ * stands in for the socket under a WSCnxLayer, and plays a websocket echo server: answers the upgrade, unmasks and (if the frame is
+ * compressed) inflates what it is sent, then sends it back, compressed if the deflate extension was agreed and the message is big enough.
+ * pings are ponged, and pongs and closes are kept for the test to look at
+ */
+class EchoServerLayer: public CnxLayer {
+public:
+	EchoServerLayer()
+		: CnxLayer(nullptr, nullptr) {
+		memset(&inf, 0, sizeof(inf));
+		memset(&def, 0, sizeof(def));
+		inflateInit2(&inf, -15);
+		deflateInit2(&def, Z_BEST_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+	}
+	virtual ~EchoServerLayer() {
+		inflateEnd(&inf);
+		deflateEnd(&def);
+	}
+
+	virtual int Open() override {
+		upper->OnOpen();
+		return 0;
+	}
+	virtual int Close() override {
+		upper->OnClose();
+		return 0;
+	}
+	virtual int Write(const char *data, const size_t len) override {
+		if (!upgraded) {
+			request.assign(data, len);
+			upgraded = true;
+			std::string r = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n";
+			if (acceptDeflate && request.find("permessage-deflate") != std::string::npos) {
+				r += "Sec-WebSocket-Extensions: permessage-deflate" + acceptParams + "\r\n";
+			}
+			r += "\r\n";
+			upper->Receive(r.data(), r.size());
+			return (int)len;
+		}
+		const unsigned char *p = (const unsigned char*)data;
+		bool rsv1 = (p[0] & 0x40) != 0;
+		int op = p[0] & 0x0f;
+		size_t n = p[1] & 0x7f, h = 2;
+		if (n == 126) {
+			n = (p[2] << 8) | p[3];
+			h = 4;
+		} else if (n == 127) {
+			n = 0;
+			for (int i=0; i<8; i++) n = (n << 8) | p[2+i];
+			h = 10;
+		}
+		std::string payload(data+h+4, n);
+		for (size_t i=0; i<n; i++) payload[i] ^= data[h+(i%4)];
+		if (op == 0x9) {
+			if (answerPings) {
+				Send(Frame(0xa, payload, true, false));
+			}
+			return (int)len;
+		}
+		if (op == 0xa) {
+			pongs.push_back(payload);
+			return (int)len;
+		}
+		if (op != 0x1) {
+			if (op == 0x8) closes.push_back(payload);
+			return (int)len;
+		}
+		compressedIn.push_back(rsv1);
+		if (rsv1) {
+			payload = Inflate(payload);
+		}
+		received.push_back(payload);
+		Echo(payload);
+		return (int)len;
+	}
+
+	std::string Inflate(std::string in) {
+		in.append("\x00\x00\xff\xff", 4);
+		std::string out;
+		char buf[4096];
+		inf.next_in = (Bytef*)&in[0];
+		inf.avail_in = (uInt)in.size();
+		do {
+			inf.next_out = (Bytef*)buf;
+			inf.avail_out = sizeof(buf);
+			inflate(&inf, Z_SYNC_FLUSH);
+			out.append(buf, sizeof(buf) - inf.avail_out);
+		} while (inf.avail_out == 0);
+		return out;
+	}
+
+	void Echo(const std::string& payload) {
+		std::string body = payload;
+		bool compress = acceptDeflate && payload.size() >= 64;
+		if (compress) {
+			std::string out(payload.size() + 1024, '\0');
+			def.next_in = (Bytef*)&body[0];
+			def.avail_in = (uInt)body.size();
+			def.next_out = (Bytef*)&out[0];
+			def.avail_out = (uInt)out.size();
+			deflate(&def, Z_SYNC_FLUSH);
+			out.resize(out.size() - def.avail_out - 4);
+			body = out;
+		}
+		// echo it in two fragments, and hand it up a few bytes at a time, to exercise reassembly
+		size_t half = body.size()/2;
+		Send(Frame(0x1, body.substr(0, half), false, compress) + Frame(0x0, body.substr(half), true, false));
+	}
+
+	void Send(const std::string& frames) {
+		for (size_t i=0; i<frames.size(); i+=7) {
+			upper->Receive(frames.data()+i, std::min<size_t>(7, frames.size()-i));
+		}
+	}
+
+	static std::string Frame(int op, const std::string& body, bool fin, bool rsv1) {
+		std::string f;
+		f.push_back((char)(op | (fin? 0x80 : 0) | (rsv1? 0x40 : 0)));
+		if (body.size() < 126) {
+			f.push_back((char)body.size());
+		} else {
+			f.push_back((char)126);
+			f.push_back((char)(body.size() >> 8));
+			f.push_back((char)(body.size() & 0xff));
+		}
+		return f + body;
+	}
+
+	bool acceptDeflate = true;
+	bool answerPings = true;
+	std::string acceptParams;
+	bool upgraded = false;
+	std::string request;
+	std::vector<std::string> received;
+	std::vector<bool> compressedIn;
+	std::vector<std::string> pongs;
+	std::vector<std::string> closes;
+	z_stream inf;
+	z_stream def;
+};
+
+class RecordingUpper: public CnxLayerUpper {
+public:
+	virtual int Receive(const char *data, const size_t len) override {
+		messages.push_back(std::string(data, len));
+		return 0;
+	}
+	virtual void OnOpen() override { open = true; }
+	virtual void OnIOError(const std::string msg, const int status) override { errors.push_back(msg); }
+	virtual void OnServerDisconnect(const std::string msg, const int status) override {
+		hangup = msg;
+		hangupStatus = status;
+	}
+
+	bool open = false;
+	std::string hangup;
+	int hangupStatus = 0;
+	std::vector<std::string> messages;
+	std::vector<std::string> errors;
+};
+
+static std::string
+Snapshot(int clients)
+{
+	std::string s = "<U><M>u54</M><L><A>1</A><A>lobby</A>";
+	for (int i=0; i<clients; i++) {
+		s += "<A>client" + std::to_string(i) + "|user" + std::to_string(i) + "|_NICK|Guest " + std::to_string(i) + "</A>";
+	}
+	return s + "</L></U>";
+}
+
+struct WSFixture {
+	WSFixture()
+		: ws(&top, &server) {
+		server.upper = &ws;
+		ws.SetHost("localhost");
+		ws.SetResource("/");
+	}
+	RecordingUpper top;
+	EchoServerLayer server;
+	WSCnxLayer ws;
+};
+
+TEST(WebSocket, DeflateRoundTrip) {
+	WSFixture f;
+	f.ws.SetCompression(true, 64);
+	f.ws.Open();
+	ASSERT_TRUE(f.top.open);
+	EXPECT_NE(std::string::npos, f.server.request.find("Sec-WebSocket-Extensions: permessage-deflate; client_max_window_bits"));
+	EXPECT_TRUE(f.ws.IsCompressing());
+
+	std::string big = Snapshot(200);
+	std::string small = "<U><M>u2</M></U>";
+	for (int i=0; i<3; i++) { // context takeover means later copies compress better than the first
+		f.ws.Write(big.data(), big.size());
+		f.ws.Write(small.data(), small.size());
+	}
+
+	ASSERT_EQ(6u, f.server.received.size());
+	ASSERT_EQ(6u, f.top.messages.size());
+	for (int i=0; i<3; i++) {
+		EXPECT_EQ(big, f.server.received[2*i]);
+		EXPECT_TRUE(f.server.compressedIn[2*i]);
+		EXPECT_EQ(small, f.server.received[2*i+1]);
+		EXPECT_FALSE(f.server.compressedIn[2*i+1]);
+		EXPECT_EQ(big, f.top.messages[2*i]);
+		EXPECT_EQ(small, f.top.messages[2*i+1]);
+	}
+	EXPECT_TRUE(f.top.errors.empty());
+
+	const WSCnxLayer::CompressionStats& stats = f.ws.GetCompressionStats();
+	EXPECT_EQ(3u, stats.messagesDeflated);
+	EXPECT_EQ(3u, stats.messagesInflated);
+	EXPECT_EQ(3u, stats.messagesUnderThreshold);
+	EXPECT_EQ(3*big.size(), stats.rawBytesOut);
+	EXPECT_LT(stats.GetRatioOut(), 0.2);
+	EXPECT_LT(stats.GetRatioIn(), 0.2);
+	EXPECT_GT(stats.deflateNanos, 0u);
+}
+
+TEST(WebSocket, NoContextTakeover) {
+	WSFixture f;
+	f.ws.SetCompression(true, 0);
+	f.ws.SetNoContextTakeover(true, false);
+	f.ws.SetCompressionWindowBits(10);
+	f.server.acceptParams = "; client_no_context_takeover; client_max_window_bits=10";
+	f.ws.Open();
+	EXPECT_NE(std::string::npos, f.server.request.find("client_max_window_bits=10; client_no_context_takeover"));
+
+	std::string big = Snapshot(50);
+	f.ws.Write(big.data(), big.size());
+	uint64_t first = f.ws.GetCompressionStats().wireBytesOut;
+	f.ws.Write(big.data(), big.size());
+	uint64_t second = f.ws.GetCompressionStats().wireBytesOut - first;
+	EXPECT_EQ(first, second); // no shared window, so each copy compresses exactly the same
+	ASSERT_EQ(2u, f.server.received.size());
+	EXPECT_EQ(big, f.server.received[1]);
+}
+
+TEST(WebSocket, ServerDeclinesDeflate) {
+	WSFixture f;
+	f.ws.SetCompression(true, 0);
+	f.server.acceptDeflate = false;
+	f.ws.Open();
+	EXPECT_FALSE(f.ws.IsCompressing());
+
+	std::string big = Snapshot(50);
+	f.ws.Write(big.data(), big.size());
+	ASSERT_EQ(1u, f.server.received.size());
+	EXPECT_FALSE(f.server.compressedIn[0]);
+	ASSERT_EQ(1u, f.top.messages.size());
+	EXPECT_EQ(big, f.top.messages[0]);
+	EXPECT_EQ(0u, f.ws.GetCompressionStats().messagesDeflated);
+}
+
+TEST(WebSocket, BareClientWindowBits) {
+	WSFixture f;
+	f.ws.SetCompression(true, 0);
+	f.server.acceptParams = "; client_max_window_bits"; // no value, so we keep our own 15
+	f.ws.Open();
+	EXPECT_TRUE(f.ws.IsCompressing());
+
+	std::string big = Snapshot(50);
+	f.ws.Write(big.data(), big.size());
+	ASSERT_EQ(1u, f.server.received.size());
+	EXPECT_TRUE(f.server.compressedIn[0]);
+	EXPECT_EQ(big, f.server.received[0]);
+}
+
+TEST(WebSocket, InflateTooBig) {
+	WSFixture f;
+	f.ws.SetCompression(true, 0);
+	f.ws.SetMaxMessageSize(1024);
+	f.ws.Open();
+
+	std::string big = Snapshot(200); // it is what this inflates to that counts, not what came over the wire
+	f.ws.Write(big.data(), big.size());
+	EXPECT_TRUE(f.top.messages.empty());
+	EXPECT_FALSE(f.top.errors.empty());
+	ASSERT_FALSE(f.server.closes.empty());
+	EXPECT_EQ(std::string("\x03\xf1", 2), f.server.closes[0]); // 1009, message too big
+}
+
+TEST(WebSocket, NotOfferedByDefault) {
+	WSFixture f;
+	f.ws.Open();
+	EXPECT_EQ(std::string::npos, f.server.request.find("permessage-deflate"));
+	EXPECT_FALSE(f.ws.IsCompressing());
+}
+
+TEST(WebSocket, PingRoundTrip) {
+	WSFixture f;
+	EXPECT_LT(f.ws.SendPing(), 0); // not open yet
+	f.ws.Open();
+	for (int i=0; i<5; i++) {
+		EXPECT_GT(f.ws.SendPing(), 0);
+	}
+	const RTTStats& rtt = f.ws.GetRTTStats();
+	EXPECT_EQ(5u, rtt.GetCount());
+	EXPECT_LE((double)rtt.GetMin(), rtt.GetMean());
+	EXPECT_LE(rtt.GetMin(), rtt.GetP99());
+
+	f.server.answerPings = false;
+	f.ws.SendPing();
+	f.server.Send(EchoServerLayer::Frame(0xa, "abc", true, false)); // unsolicited, and not one of our stamps
+	f.server.Send(EchoServerLayer::Frame(0xa, std::string(8, '\xff'), true, false)); // a stamp from the future
+	EXPECT_EQ(5u, rtt.GetCount());
+	EXPECT_TRUE(f.top.errors.empty());
+}
+
+TEST(WebSocket, ControlFrames) {
+	WSFixture f;
+	f.ws.Open();
+	f.server.Send(EchoServerLayer::Frame(0x9, "hello", true, false));
+	ASSERT_EQ(1u, f.server.pongs.size());
+	EXPECT_EQ("hello", f.server.pongs[0]);
+	f.server.Send(EchoServerLayer::Frame(0x9, "", true, false));
+	ASSERT_EQ(2u, f.server.pongs.size());
+	EXPECT_EQ("", f.server.pongs[1]);
+	EXPECT_TRUE(f.top.errors.empty());
+
+	f.server.Send(EchoServerLayer::Frame(0x8, std::string("\x03\xe9going away", 12), true, false));
+	EXPECT_EQ(1001, f.top.hangupStatus);
+	EXPECT_EQ("going away", f.top.hangup);
+	ASSERT_EQ(1u, f.server.closes.size());
+	EXPECT_EQ(std::string("\x03\xe9going away", 12), f.server.closes[0]);
+}
+
+TEST(WebSocket, BadControlFrames) {
+	WSFixture f;
+	f.ws.Open();
+	f.server.Send(EchoServerLayer::Frame(0x9, "part", false, false)); // control frames can't be fragmented
+	EXPECT_FALSE(f.top.errors.empty());
+	EXPECT_TRUE(f.server.pongs.empty());
+	ASSERT_EQ(1u, f.server.closes.size());
+	EXPECT_EQ(std::string("\x03\xea", 2), f.server.closes[0]); // 1002, protocol error
+
+	WSFixture g;
+	g.ws.Open();
+	g.server.Send(EchoServerLayer::Frame(0x9, std::string(200, 'x'), true, false));
+	EXPECT_FALSE(g.top.errors.empty());
+	EXPECT_TRUE(g.server.pongs.empty());
+}
+
+TEST(WebSocket, RTTStats) {
+	RTTStats rtt;
+	EXPECT_EQ(0u, rtt.GetP99());
+	for (int i=1; i<=1000; i++) {
+		rtt.Add(i);
+	}
+	EXPECT_EQ(1u, rtt.GetMin());
+	EXPECT_DOUBLE_EQ(500.5, rtt.GetMean());
+	EXPECT_EQ(1000u, rtt.GetLast());
+	EXPECT_EQ(998u, rtt.GetP99()); // over the last 256 only, 745..1000
+	EXPECT_EQ(872u, rtt.GetPercentile(50));
+}
+
+TEST(WebSocket, RTTSmoothing) {
+	RTTStats rtt;
+	rtt.Add(800);
+	EXPECT_DOUBLE_EQ(800, rtt.GetSmoothed());
+	EXPECT_DOUBLE_EQ(400, rtt.GetVariation());
+	rtt.Add(1600);
+	EXPECT_DOUBLE_EQ(900, rtt.GetSmoothed());
+	EXPECT_DOUBLE_EQ(500, rtt.GetVariation());
+	for (int i=0; i<200; i++) {
+		rtt.Add(i%2 == 0? 1000 : 1200);
+	}
+	EXPECT_NEAR(1100, rtt.GetSmoothed(), 20);
+	EXPECT_NEAR(100, rtt.GetVariation(), 20);
+}